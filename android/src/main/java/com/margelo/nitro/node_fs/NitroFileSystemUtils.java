@@ -1,7 +1,9 @@
 package com.margelo.nitro.node_fs;
 
+import android.content.ComponentCallbacks2;
 import android.content.ContentResolver;
 import android.content.Context;
+import android.content.res.Configuration;
 import android.content.res.AssetManager;
 import android.database.Cursor;
 import android.net.Uri;
@@ -30,11 +32,34 @@ public class NitroFileSystemUtils {
     private static Context context;
     private static ReactApplicationContext reactContext;
     private static final String TAG = "NitroFileSystemUtils";
+    private static boolean trimCallbacksRegistered = false;
 
     public static void initialize(ReactApplicationContext ctx) {
         reactContext = ctx;
         context = ctx.getApplicationContext();
         nSetAssetManager(ctx.getAssets());
+        if (trimCallbacksRegistered) {
+            return;
+        }
+        trimCallbacksRegistered = true;
+        // Give pooled read buffers back to the system when memory gets tight.
+        context.registerComponentCallbacks(new ComponentCallbacks2() {
+            @Override
+            public void onTrimMemory(int level) {
+                if (level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW) {
+                    nTrimBufferPool();
+                }
+            }
+
+            @Override
+            public void onLowMemory() {
+                nTrimBufferPool();
+            }
+
+            @Override
+            public void onConfigurationChanged(Configuration newConfig) {
+            }
+        });
     }
 
     private static ContentResolver getContentResolver() {
@@ -605,4 +630,5 @@ public class NitroFileSystemUtils {
     }
 
     private static native void nSetAssetManager(AssetManager assetManager);
+    private static native void nTrimBufferPool();
 }
@@ -0,0 +1,28 @@
+#pragma once
+// Host-only stand-in for the nitrogen-generated spec of
+// src/specs/HybridLogWriter.nitro.ts, so HybridLogWriter.cpp builds on the
+// host.
+#include <NitroModules/ArrayBuffer.hpp>
+#include <NitroModules/HybridObject.hpp>
+#include <NitroModules/Promise.hpp>
+#include <memory>
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+using namespace margelo::nitro;
+
+class HybridHybridLogWriterSpec : public virtual HybridObject {
+public:
+  static constexpr auto TAG = "HybridLogWriter";
+
+  HybridHybridLogWriterSpec() : HybridObject(TAG) {}
+  ~HybridHybridLogWriterSpec() override = default;
+
+  virtual void append(const std::string &data) = 0;
+  virtual void appendBuffer(const std::shared_ptr<ArrayBuffer> &buffer) = 0;
+  virtual std::shared_ptr<Promise<void>> flush() = 0;
+  virtual std::shared_ptr<Promise<void>> close() = 0;
+};
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,59 @@
+#pragma once
+// Host-only stand-in for react-native-nitro-modules' ArrayBuffer, so the
+// portable C++ layer can be built and benchmarked without a JS runtime.
+// Mirrors the subset of the real API used under cpp/.
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace margelo::nitro {
+
+using DeleteFn = std::function<void()>;
+
+class ArrayBuffer {
+public:
+  ArrayBuffer(uint8_t *data, size_t size, DeleteFn &&deleteFunc)
+      : _data(data), _size(size), _deleteFunc(std::move(deleteFunc)) {}
+  ArrayBuffer(const ArrayBuffer &) = delete;
+  ArrayBuffer &operator=(const ArrayBuffer &) = delete;
+  ~ArrayBuffer() {
+    if (_deleteFunc) {
+      _deleteFunc();
+    }
+  }
+
+  uint8_t *data() { return _data; }
+  size_t size() const { return _size; }
+  bool isOwner() const noexcept { return true; }
+
+  static std::shared_ptr<ArrayBuffer> wrap(uint8_t *data, size_t size,
+                                           DeleteFn &&deleteFunc) {
+    return std::make_shared<ArrayBuffer>(data, size, std::move(deleteFunc));
+  }
+
+  static std::shared_ptr<ArrayBuffer> allocate(size_t size) {
+    uint8_t *data = new uint8_t[size];
+    return wrap(data, size, [data]() { delete[] data; });
+  }
+
+  static std::shared_ptr<ArrayBuffer> copy(const uint8_t *data, size_t size) {
+    auto buffer = allocate(size);
+    if (size > 0) {
+      std::memcpy(buffer->data(), data, size);
+    }
+    return buffer;
+  }
+
+  static std::shared_ptr<ArrayBuffer> copy(const std::vector<uint8_t> &data) {
+    return copy(data.data(), data.size());
+  }
+
+private:
+  uint8_t *_data;
+  size_t _size;
+  DeleteFn _deleteFunc;
+};
+
+} // namespace margelo::nitro
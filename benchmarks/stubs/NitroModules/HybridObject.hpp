@@ -0,0 +1,18 @@
+#pragma once
+// Host-only stand-in for react-native-nitro-modules' HybridObject: just the
+// base class that generated specs derive from, without any JS bindings.
+
+namespace margelo::nitro {
+
+class HybridObject {
+public:
+  explicit HybridObject(const char *name) : _name(name) {}
+  virtual ~HybridObject() = default;
+
+  const char *getName() const { return _name; }
+
+private:
+  const char *_name;
+};
+
+} // namespace margelo::nitro
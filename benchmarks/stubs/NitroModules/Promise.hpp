@@ -0,0 +1,43 @@
+#pragma once
+// Host-only stand-in for react-native-nitro-modules' Promise. Settled from
+// any thread; await() hands the result to a blocking std::future.
+#include <exception>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace margelo::nitro {
+
+template <typename TResult> class Promise {
+public:
+  static std::shared_ptr<Promise> create() {
+    return std::make_shared<Promise>();
+  }
+
+  void resolve(TResult result) { _promise.set_value(std::move(result)); }
+  void reject(const std::exception_ptr &error) {
+    _promise.set_exception(error);
+  }
+  std::future<TResult> await() { return _promise.get_future(); }
+
+private:
+  std::promise<TResult> _promise;
+};
+
+template <> class Promise<void> {
+public:
+  static std::shared_ptr<Promise> create() {
+    return std::make_shared<Promise>();
+  }
+
+  void resolve() { _promise.set_value(); }
+  void reject(const std::exception_ptr &error) {
+    _promise.set_exception(error);
+  }
+  std::future<void> await() { return _promise.get_future(); }
+
+private:
+  std::promise<void> _promise;
+};
+
+} // namespace margelo::nitro
@@ -0,0 +1,61 @@
+#include "AtomicWrite.hpp"
+#include "TestUtil.hpp"
+#include <sys/stat.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+size_t entryCount(const std::string &dir) {
+  size_t count = 0;
+  for ([[maybe_unused]] const auto &entry :
+       std::filesystem::directory_iterator(dir)) {
+    count++;
+  }
+  return count;
+}
+
+TEST_F(FsTest, AtomicWriteReplacesEveryFileAndKeepsMode) {
+  writeBytes(path("a"), bytes("old"));
+  ASSERT_EQ(::chmod(path("a").c_str(), 0600), 0);
+  ASSERT_TRUE(rn_fs_mkdir(path("sub").c_str(), 0755, false));
+  auto big = payload(1 << 20);
+
+  for (SyncLevel level : {SyncLevel::None, SyncLevel::Data, SyncLevel::Full}) {
+    atomicWriteFiles({{path("a"), reinterpret_cast<const uint8_t *>("new"), 3},
+                      {path("sub/b"), big.data(), big.size()},
+                      {path("empty"), kEmpty, 0}},
+                     level);
+    EXPECT_EQ(readText(path("a")), "new");
+    EXPECT_EQ(readBytes(path("sub/b")), big);
+    EXPECT_TRUE(readBytes(path("empty")).empty());
+  }
+  struct stat st;
+  ASSERT_EQ(::stat(path("a").c_str(), &st), 0);
+  EXPECT_EQ(st.st_mode & 07777, 0600u);
+  // No temp files left behind.
+  EXPECT_EQ(entryCount(dir()), 3u);
+  EXPECT_EQ(entryCount(path("sub")), 1u);
+}
+
+TEST_F(FsTest, AtomicWriteFailureLeavesTargetsUntouched) {
+  writeBytes(path("a"), bytes("old"));
+  EXPECT_THROW(
+      atomicWriteFiles({{path("a"), reinterpret_cast<const uint8_t *>("new"), 3},
+                        {path("missing/b"), kEmpty, 0}},
+                       SyncLevel::Data),
+      std::runtime_error);
+  EXPECT_EQ(readText(path("a")), "old");
+  EXPECT_EQ(entryCount(dir()), 1u);
+}
+
+TEST(AtomicWriteTest, TempPathIsAUniqueHiddenSibling) {
+  std::string first = tempPathFor("/data/dir/file.json");
+  std::string second = tempPathFor("/data/dir/file.json");
+  EXPECT_EQ(first.rfind("/data/dir/.file.json.tmp-", 0), 0u);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(tempPathFor("file").rfind(".file.tmp-", 0), 0u);
+}
+
+} // namespace
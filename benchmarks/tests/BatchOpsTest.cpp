@@ -0,0 +1,82 @@
+#include "BatchOps.hpp"
+#include "TestUtil.hpp"
+#include <cerrno>
+
+using namespace margelo::nitro;
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+BatchRequest request(BatchKind kind, const std::string &path) {
+  BatchRequest request;
+  request.kind = kind;
+  request.path = path;
+  return request;
+}
+
+TEST_F(FsTest, ParallelBatchWritesAndReadsEveryFile) {
+  constexpr size_t kFiles = 64;
+  std::vector<BatchRequest> writes;
+  std::vector<BatchRequest> reads;
+  for (size_t i = 0; i < kFiles; i++) {
+    std::string name = path("f" + std::to_string(i));
+    BatchRequest write = request(BatchKind::WriteFile, name);
+    auto data = payload(i * 1000, static_cast<uint32_t>(i));
+    write.data = ArrayBuffer::copy(data);
+    writes.push_back(std::move(write));
+    reads.push_back(request(BatchKind::ReadFile, name));
+  }
+  BatchConfig config;
+  config.parallel = true;
+  config.parallelism = 4;
+
+  auto written = runBatch(writes, config);
+  ASSERT_EQ(written.size(), kFiles);
+  for (size_t i = 0; i < kFiles; i++) {
+    EXPECT_EQ(written[i].error, 0) << written[i].message;
+    EXPECT_EQ(readBytes(writes[i].path), payload(i * 1000, i));
+  }
+
+  auto read = runBatch(reads, config);
+  for (size_t i = 0; i < kFiles; i++) {
+    ASSERT_TRUE(read[i].data) << read[i].message;
+    const uint8_t *data = read[i].data->data();
+    EXPECT_EQ(std::vector<uint8_t>(data, data + read[i].data->size()),
+              payload(i * 1000, i));
+  }
+}
+
+TEST_F(FsTest, SequentialBatchReportsErrorsPerOperation) {
+  BatchRequest mkdir = request(BatchKind::Mkdir, path("dir"));
+  mkdir.mode = 0755;
+  BatchRequest write = request(BatchKind::WriteFile, path("dir/a"));
+  write.data = ArrayBuffer::copy(bytes("a"));
+  std::vector<BatchRequest> requests = {
+      mkdir,
+      write,
+      request(BatchKind::Stat, path("missing")),
+      request(BatchKind::Exists, path("dir/a")),
+      request(BatchKind::Readdir, path("dir")),
+  };
+
+  auto outcomes = runBatch(requests, BatchConfig());
+  EXPECT_EQ(outcomes[0].error, 0);
+  EXPECT_EQ(outcomes[1].error, 0);
+  EXPECT_EQ(outcomes[2].error, ENOENT);
+  EXPECT_EQ(outcomes[2].message, "ENOENT: no such file or directory, stat '" +
+                                     path("missing") + "'");
+  EXPECT_EQ(outcomes[3].exists, true);
+  EXPECT_EQ(outcomes[4].entries, std::vector<std::string>{"a"});
+
+  BatchConfig stop;
+  stop.stopOnError = true;
+  outcomes = runBatch({request(BatchKind::Unlink, path("missing")),
+                       request(BatchKind::Unlink, path("dir/a"))},
+                      stop);
+  EXPECT_EQ(outcomes[0].error, ENOENT);
+  EXPECT_EQ(outcomes[1].error, ECANCELED);
+  EXPECT_TRUE(pathExists(path("dir/a")));
+}
+
+} // namespace
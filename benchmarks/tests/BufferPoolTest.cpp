@@ -0,0 +1,76 @@
+#include "BufferPool.hpp"
+#include "TestUtil.hpp"
+#include <cstring>
+
+using namespace margelo::nitro;
+using namespace margelo::nitro::node_fs;
+
+namespace {
+
+// The pool is process-wide, so each test starts from an empty cache and
+// checks deltas.
+class BufferPoolTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    _pool.setLimit(BufferPool::kDefaultLimit);
+    _pool.trim();
+  }
+  void TearDown() override {
+    _pool.setLimit(BufferPool::kDefaultLimit);
+    _pool.trim();
+  }
+
+  BufferPool &_pool = BufferPool::shared();
+};
+
+TEST_F(BufferPoolTest, LeasesArePageAlignedAndRecycledOnDestruction) {
+  BufferPool::Stats before = _pool.stats();
+  auto buffer = _pool.lease(10000);
+  ASSERT_EQ(buffer->size(), 10000u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer->data()) % 4096, 0u);
+  BufferPool::Stats leased = _pool.stats();
+  EXPECT_EQ(leased.activeLeases, before.activeLeases + 1);
+  EXPECT_EQ(leased.leasedBytes, before.leasedBytes + (16 << 10));
+
+  uint8_t *data = buffer->data();
+  buffer.reset();
+  BufferPool::Stats returned = _pool.stats();
+  EXPECT_EQ(returned.activeLeases, before.activeLeases);
+  EXPECT_EQ(returned.cachedBytes, size_t{16 << 10});
+
+  // Same size class on the same thread: served from the cache.
+  auto again = _pool.lease(16 << 10);
+  EXPECT_EQ(again->data(), data);
+  EXPECT_EQ(_pool.stats().hits, before.hits + 1);
+}
+
+TEST_F(BufferPoolTest, LiveLeasesSurviveTrimAndAreNeverHandedOutTwice) {
+  auto held = _pool.lease(64 << 10);
+  std::memset(held->data(), 0xAB, held->size());
+  _pool.trim();
+  std::vector<std::shared_ptr<ArrayBuffer>> others;
+  for (int i = 0; i < 16; i++) {
+    others.push_back(_pool.lease(64 << 10));
+    EXPECT_NE(others.back()->data(), held->data());
+    std::memset(others.back()->data(), 0, others.back()->size());
+    others.pop_back(); // recycled right away, so the next lease reuses it
+  }
+  for (size_t i = 0; i < held->size(); i++) {
+    ASSERT_EQ(held->data()[i], 0xAB) << "byte " << i;
+  }
+}
+
+TEST_F(BufferPoolTest, LimitAndOversizedSlabsBypassTheCache) {
+  _pool.setLimit(0);
+  _pool.lease(4096).reset();
+  EXPECT_EQ(_pool.stats().cachedBytes, 0u);
+
+  _pool.setLimit(BufferPool::kDefaultLimit);
+  auto huge = _pool.lease(BufferPool::kMaxClassSize + 1);
+  EXPECT_EQ(huge->size(), BufferPool::kMaxClassSize + 1);
+  huge.reset();
+  EXPECT_EQ(_pool.stats().cachedBytes, 0u);
+  EXPECT_EQ(_pool.stats().limitBytes, BufferPool::kDefaultLimit);
+}
+
+} // namespace
@@ -0,0 +1,124 @@
+#include "BulkIo.hpp"
+#include "TestUtil.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+// Every engine that can run here; IoUring resolves to ThreadPool when the
+// kernel or sandbox does not allow it.
+const IoEngine kEngines[] = {IoEngine::ThreadPool, IoEngine::IoUring};
+
+TEST(BulkIoTest, EngineResolution) {
+  EXPECT_EQ(resolveIoEngine(IoEngine::ThreadPool), IoEngine::ThreadPool);
+  IoEngine resolved = resolveIoEngine(IoEngine::Auto);
+  EXPECT_NE(resolved, IoEngine::Auto);
+  EXPECT_EQ(resolveIoEngine(IoEngine::IoUring), resolved);
+  EXPECT_STREQ(ioEngineName(IoEngine::ThreadPool), "threadpool");
+}
+
+TEST_F(FsTest, StatManyReportsEveryPathInOrder) {
+  writeBytes(path("a"), payload(1234));
+  ASSERT_TRUE(rn_fs_mkdir(path("dir").c_str(), 0755, false));
+  ASSERT_EQ(rn_fs_symlink("a", path("link").c_str()), 0);
+  std::vector<std::string> paths = {path("a"), path("missing"), path("dir"),
+                                    path("link")};
+
+  for (IoEngine engine : kEngines) {
+    SCOPED_TRACE(ioEngineName(engine));
+    auto followed = statMany(paths, true, engine);
+    ASSERT_EQ(followed.size(), 4u);
+    ASSERT_TRUE(followed[0].stats);
+    EXPECT_EQ(followed[0].stats->size, 1234u);
+    EXPECT_EQ(followed[1].error, ENOENT);
+    ASSERT_TRUE(followed[2].stats);
+    EXPECT_TRUE(S_ISDIR(followed[2].stats->mode));
+    ASSERT_TRUE(followed[3].stats);
+    EXPECT_EQ(followed[3].stats->size, 1234u);
+
+    auto links = statMany({path("link")}, false, engine);
+    ASSERT_TRUE(links[0].stats);
+    EXPECT_TRUE(S_ISLNK(links[0].stats->mode));
+  }
+}
+
+TEST_F(FsTest, ReadFileManyReadsWholeFiles) {
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < 20; i++) {
+    paths.push_back(path("f" + std::to_string(i)));
+    writeBytes(paths.back(), payload(i * 7000, static_cast<uint32_t>(i)));
+  }
+  paths.push_back(path("missing"));
+
+  for (IoEngine engine : kEngines) {
+    SCOPED_TRACE(ioEngineName(engine));
+    auto outcomes = readFileMany(paths, engine);
+    ASSERT_EQ(outcomes.size(), paths.size());
+    for (size_t i = 0; i < 20; i++) {
+      ASSERT_TRUE(outcomes[i].data) << outcomes[i].message;
+      const uint8_t *data = outcomes[i].data->data();
+      EXPECT_EQ(std::vector<uint8_t>(data, data + outcomes[i].data->size()),
+                payload(i * 7000, static_cast<uint32_t>(i)));
+    }
+    EXPECT_EQ(outcomes.back().error, ENOENT);
+  }
+}
+
+TEST(BulkIoTest, PlanMergesOverlappingTouchingAndNearbyRanges) {
+  std::vector<ByteRange> ranges = {
+      {100, 50}, {120, 50}, {170, 10}, {1000, 20}, {4090, 100}, {7, 0}};
+  RangeReadPlan plan = planRangeRead(ranges);
+  ASSERT_EQ(plan.spans.size(), 3u);
+  EXPECT_EQ(plan.spans[0].position, 100u);
+  EXPECT_EQ(plan.spans[0].length, 80u);
+  EXPECT_EQ(plan.totalSize, 200u);
+  EXPECT_EQ(plan.offsets, (std::vector<size_t>{0, 20, 70, 80, 100, 0}));
+
+  RangeReadPlan gapped = planRangeRead(ranges, 1000);
+  ASSERT_EQ(gapped.spans.size(), 2u);
+  EXPECT_EQ(gapped.spans[0].length, 920u);
+  EXPECT_EQ(gapped.offsets[3], 900u);
+}
+
+TEST_F(FsTest, ReadRangesFillsEveryRange) {
+  auto data = payload(4100);
+  writeBytes(path("f"), data);
+  int fd = ::open(path("f").c_str(), O_RDONLY | O_CLOEXEC);
+  ASSERT_GE(fd, 0);
+  // Unsorted, overlapping, and one range running past the end of the file.
+  std::vector<ByteRange> ranges = {
+      {1000, 20}, {100, 50}, {120, 50}, {4090, 100}, {3000, 0}, {2000, 30}};
+
+  for (IoEngine engine : kEngines) {
+    SCOPED_TRACE(ioEngineName(engine));
+    for (size_t maxGap : {size_t{0}, size_t{4096}}) {
+      RangeReadPlan plan = planRangeRead(ranges, maxGap);
+      std::vector<uint8_t> dest(plan.totalSize);
+      RangeReadResult result =
+          readRanges(fd, ranges, plan, dest.data(), engine);
+      ASSERT_EQ(result.lengths.size(), ranges.size());
+      for (size_t i = 0; i < ranges.size(); i++) {
+        size_t expected =
+            ranges[i].position >= data.size()
+                ? 0
+                : std::min<size_t>(ranges[i].length,
+                                   data.size() - ranges[i].position);
+        ASSERT_EQ(result.lengths[i], expected) << "range " << i;
+        EXPECT_TRUE(std::equal(dest.begin() + plan.offsets[i],
+                               dest.begin() + plan.offsets[i] + expected,
+                               data.begin() + ranges[i].position))
+            << "range " << i;
+      }
+    }
+  }
+  ::close(fd);
+  EXPECT_THROW(readRanges(-1, ranges, planRangeRead(ranges), nullptr),
+               std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,63 @@
+#include "ChunkStore.hpp"
+#include "TestUtil.hpp"
+#include <cstring>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+TEST_F(FsTest, ChunkStoreDeduplicatesAndRestores) {
+  ChunkStoreConfig config;
+  config.averageChunkSize = 4 << 10;
+  config.level = SyncLevel::None;
+  auto base = payload(1 << 20);
+  auto edited = base;
+  std::memcpy(edited.data() + (600 << 10), "changed", 7);
+  writeBytes(path("base"), base);
+  writeBytes(path("edited"), edited);
+  std::string root = path("store");
+
+  StoredFileInfo first = storeFile(root, path("base"), "base", config);
+  EXPECT_EQ(first.size, base.size());
+  EXPECT_EQ(first.newChunks, first.chunks);
+  EXPECT_GE(first.writtenBytes, base.size());
+
+  StoredFileInfo again = storeFile(root, path("base"), "copy", config);
+  EXPECT_EQ(again.newChunks, 0u);
+  EXPECT_EQ(again.writtenBytes, 0u);
+
+  StoredFileInfo next = storeFile(root, path("edited"), "edited", config);
+  EXPECT_GT(next.newChunks, 0u);
+  EXPECT_LE(next.newChunks, 3u);
+
+  restoreFile(root, "edited", path("restored"));
+  EXPECT_EQ(readBytes(path("restored")), edited);
+  EXPECT_EQ(listStoredFiles(root),
+            (std::vector<std::string>{"base", "copy", "edited"}));
+
+  EXPECT_TRUE(removeStoredFile(root, "edited"));
+  EXPECT_FALSE(removeStoredFile(root, "edited"));
+  ChunkGcSummary gc = collectChunkGarbage(root);
+  EXPECT_EQ(gc.files, 2u);
+  EXPECT_EQ(gc.removedChunks, next.newChunks);
+  EXPECT_EQ(gc.liveChunks, first.chunks);
+
+  restoreFile(root, "copy", path("copy"));
+  EXPECT_EQ(readBytes(path("copy")), base);
+}
+
+TEST_F(FsTest, ChunkStoreRejectsBadNamesAndMissingFiles) {
+  writeBytes(path("f"), bytes("data"));
+  ChunkStoreConfig config;
+  config.level = SyncLevel::None;
+  for (const char *name : {"", ".hidden", "a/b", ".."}) {
+    SCOPED_TRACE(name);
+    EXPECT_THROW(storeFile(path("store"), path("f"), name, config),
+                 std::runtime_error);
+  }
+  EXPECT_THROW(restoreFile(path("store"), "missing", path("out")),
+               std::runtime_error);
+}
+
+} // namespace
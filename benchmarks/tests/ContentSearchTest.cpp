@@ -0,0 +1,66 @@
+#include "ContentSearch.hpp"
+#include "TestUtil.hpp"
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+TEST_F(FsTest, SearchTruncatesOnlyWhenMoreHitsExist) {
+  writeBytes(path("log"), bytes("hit 1\nmiss\nhit 2\n"));
+  SearchConfig config;
+  config.maxResults = 2;
+  SearchSummary exact = searchFiles({path("log")}, "hit", config);
+  EXPECT_EQ(exact.hits.size(), 2u);
+  EXPECT_FALSE(exact.truncated);
+
+  config.maxResults = 1;
+  SearchSummary cut = searchFiles({path("log")}, "hit", config);
+  ASSERT_EQ(cut.hits.size(), 1u);
+  EXPECT_EQ(cut.hits[0].line, 1u);
+  EXPECT_TRUE(cut.truncated);
+}
+
+TEST_F(FsTest, RegexSearchHandlesVeryLongLines) {
+  // Matched in one go, this line needs more than 8 MiB of stack.
+  std::string line(16 << 10, 'a');
+  line += "c\n^start\n";
+  writeBytes(path("long"), bytes(line));
+  SearchConfig config;
+  config.regex = true;
+  SearchSummary summary = searchFiles({path("long")}, "(a|b)*c", config);
+  ASSERT_EQ(summary.hits.size(), 1u);
+  EXPECT_EQ(summary.hits[0].line, 1u);
+  // ^ does not match where a later window starts.
+  EXPECT_TRUE(searchFiles({path("long")}, "^a{3}c", config).hits.empty());
+}
+
+TEST_F(FsTest, RegexSearchFindsMatchesAtEveryOffsetOfALongLine) {
+  SearchConfig config;
+  config.regex = true;
+  std::string match = "<" + std::string(200, 'b') + ">";
+  for (size_t at : {0, 300, 400, 500, 511, 512, 700, 1000, 1800}) {
+    SCOPED_TRACE(at);
+    std::string line(2000, 'x');
+    line.replace(at, match.size(), match);
+    writeBytes(path("long"), bytes("short\n" + line + "\n"));
+    SearchSummary summary = searchFiles({path("long")}, "<b+>", config);
+    ASSERT_EQ(summary.hits.size(), 1u);
+    EXPECT_EQ(summary.hits[0].line, 2u);
+    EXPECT_EQ(summary.hits[0].column, at);
+  }
+}
+
+TEST_F(FsTest, RegexAssertionsDoNotMatchAtWindowEdges) {
+  SearchConfig config;
+  config.regex = true;
+  // "foo" ends exactly where the first window does, inside "foobar".
+  std::string line = std::string(509, ' ') + "foobar" + std::string(600, ' ');
+  writeBytes(path("edge"), bytes(line + "\n"));
+  EXPECT_TRUE(searchFiles({path("edge")}, "foo\\b", config).hits.empty());
+  EXPECT_TRUE(searchFiles({path("edge")}, "foo$", config).hits.empty());
+  EXPECT_EQ(searchFiles({path("edge")}, "foobar\\b", config).hits.size(), 1u);
+  EXPECT_EQ(searchFiles({path("edge")}, " $", config).hits.size(), 1u);
+}
+
+} // namespace
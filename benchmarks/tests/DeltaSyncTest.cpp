@@ -0,0 +1,55 @@
+#include "DeltaSync.hpp"
+#include "TestUtil.hpp"
+#include <cstring>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+TEST_F(FsTest, DeltaPatchRebuildsTarget) {
+  auto base = payload(1 << 20);
+  auto target = base;
+  std::memcpy(target.data() + 1000, "edited", 6);
+  target.insert(target.begin() + 500000, 333, 0x5A);
+  target.resize(target.size() - 4096);
+  writeBytes(path("base"), base);
+  writeBytes(path("target"), target);
+
+  auto signature = fileSignature(path("base"), 4096);
+  DeltaResult result = fileDelta(path("target"), signature.data(),
+                                 signature.size(), path("patch"));
+  EXPECT_EQ(result.targetSize, target.size());
+  EXPECT_EQ(result.copiedBytes + result.literalBytes, target.size());
+  EXPECT_LT(result.literalBytes, 4u * 4096);
+  EXPECT_LT(result.patchSize, target.size() / 10);
+
+  applyPatch(path("base"), path("patch"), path("rebuilt"));
+  EXPECT_EQ(readBytes(path("rebuilt")), target);
+
+  // In place: destPath may be the base itself.
+  applyPatch(path("base"), path("patch"), path("base"));
+  EXPECT_EQ(readBytes(path("base")), target);
+}
+
+TEST_F(FsTest, DeltaPatchRejectsWrongBase) {
+  auto base = payload(64 << 10, 1);
+  auto target = base;
+  target[100] ^= 0xFF;
+  writeBytes(path("base"), base);
+  writeBytes(path("target"), target);
+  writeBytes(path("other"), payload(64 << 10, 2));
+  writeBytes(path("shorter"), payload(1000, 1));
+  auto signature = fileSignature(path("base"));
+  fileDelta(path("target"), signature.data(), signature.size(), path("patch"));
+
+  // Same size, different blocks: the rebuilt file fails its checksum.
+  EXPECT_THROW(applyPatch(path("other"), path("patch"), path("out")),
+               std::runtime_error);
+  EXPECT_THROW(applyPatch(path("shorter"), path("patch"), path("out")),
+               std::runtime_error);
+  EXPECT_FALSE(pathExists(path("out")));
+  EXPECT_THROW(fileSignature(path("base"), 1), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,64 @@
+#include "DiskUsage.hpp"
+#include "TestUtil.hpp"
+#include <unistd.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+TEST_F(FsTest, DiskUsageTotalsAndPerChild) {
+  ASSERT_TRUE(rn_fs_mkdir(path("root/a/deep").c_str(), 0755, true));
+  ASSERT_TRUE(rn_fs_mkdir(path("root/b").c_str(), 0755, false));
+  writeBytes(path("root/a/one"), payload(1000));
+  writeBytes(path("root/a/deep/two"), payload(20000));
+  writeBytes(path("root/b/three"), payload(300));
+  writeBytes(path("root/top"), payload(5));
+  // A hard link to a file already counted under a/.
+  ASSERT_EQ(::link(path("root/a/one").c_str(), path("root/b/again").c_str()),
+            0);
+  ASSERT_EQ(rn_fs_symlink("a", path("root/link").c_str()), 0);
+
+  for (size_t parallelism : {size_t{1}, size_t{0}}) {
+    DiskUsageConfig config;
+    config.parallelism = parallelism;
+    config.perChild = true;
+    DiskUsageSummary usage = diskUsage(path("root"), config);
+    // Files: one, two, three, top, the symlink itself; dirs: root a deep b.
+    EXPECT_EQ(usage.total.files, 5u);
+    EXPECT_EQ(usage.total.dirs, 4u);
+    EXPECT_EQ(usage.total.size, 21305u + 1); // the symlink's target "a"
+    EXPECT_GT(usage.total.allocated, 0u);
+    EXPECT_EQ(usage.skipped, 0u);
+
+    ASSERT_EQ(usage.children.size(), 4u);
+    EXPECT_EQ(usage.children[0].first, "a");
+    EXPECT_EQ(usage.children[0].second.size, 21000u);
+    EXPECT_EQ(usage.children[0].second.dirs, 2u);
+    EXPECT_EQ(usage.children[1].first, "b");
+    EXPECT_EQ(usage.children[1].second.size, 300u);
+    EXPECT_EQ(usage.children[3].first, "top");
+  }
+
+  DiskUsageConfig every;
+  every.countHardlinksOnce = false;
+  EXPECT_EQ(diskUsage(path("root"), every).total.size, 22306u);
+}
+
+TEST_F(FsTest, DiskUsageFollowsLinkedDirectoriesOnce) {
+  ASSERT_TRUE(rn_fs_mkdir(path("root/dir").c_str(), 0755, true));
+  writeBytes(path("root/dir/f"), payload(100));
+  ASSERT_EQ(rn_fs_symlink("..", path("root/dir/up").c_str()), 0);
+
+  DiskUsageConfig config;
+  config.followSymlinks = true;
+  DiskUsageSummary usage = diskUsage(path("root"), config);
+  EXPECT_EQ(usage.total.size, 100u);
+  EXPECT_EQ(usage.total.files, 1u);
+
+  EXPECT_EQ(diskUsage(path("root/dir/f"), DiskUsageConfig()).total.files, 1u);
+  EXPECT_THROW(diskUsage(path("missing"), DiskUsageConfig()),
+               std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,76 @@
+#include "FileAdvice.hpp"
+#include "FileIO.hpp"
+#include "TestUtil.hpp"
+#include <cstdint>
+#include <fcntl.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+constexpr FileAdvice kAllAdvice[] = {FileAdvice::Normal, FileAdvice::Sequential,
+                                     FileAdvice::Random, FileAdvice::WillNeed,
+                                     FileAdvice::DontNeed};
+
+TEST_F(FsTest, AdviseFdAcceptsEveryHint) {
+  writeBytes(path("f"), payload(64 * 1024, 1));
+  UniqueFd fd = openForRead(path("f").c_str());
+  ASSERT_TRUE(fd);
+  for (FileAdvice advice : kAllAdvice) {
+    EXPECT_NO_THROW(adviseFd(fd.get(), 0, 0, advice));
+    EXPECT_NO_THROW(adviseFd(fd.get(), 4096, 8192, advice));
+  }
+  // Hinting does not change what is read.
+  EXPECT_EQ(readBytes(path("f")), payload(64 * 1024, 1));
+}
+
+TEST_F(FsTest, AdviseRejectsRangesBeyondOffT) {
+  writeBytes(path("f"), bytes("data"));
+  UniqueFd fd = openForRead(path("f").c_str());
+  ASSERT_TRUE(fd);
+  EXPECT_THROW(adviseFd(fd.get(), UINT64_MAX, 0, FileAdvice::WillNeed),
+               std::runtime_error);
+  EXPECT_THROW(adviseFd(fd.get(), 1, UINT64_MAX, FileAdvice::DontNeed),
+               std::runtime_error);
+  EXPECT_THROW(
+      advisePath(path("f"), uint64_t{1} << 63, 0, FileAdvice::WillNeed),
+      std::runtime_error);
+}
+
+TEST_F(FsTest, AdvisePathOnlyTakesPerFileHints) {
+  writeBytes(path("f"), bytes("data"));
+  EXPECT_NO_THROW(advisePath(path("f"), 0, 0, FileAdvice::WillNeed));
+  EXPECT_NO_THROW(advisePath(path("f"), 0, 0, FileAdvice::DontNeed));
+  EXPECT_NO_THROW(advisePath(path("f"), 0, 0, FileAdvice::Normal));
+  EXPECT_THROW(advisePath(path("f"), 0, 0, FileAdvice::Sequential),
+               std::runtime_error);
+  EXPECT_THROW(advisePath(path("f"), 0, 0, FileAdvice::Random),
+               std::runtime_error);
+  EXPECT_THROW(advisePath(path("missing"), 0, 0, FileAdvice::WillNeed),
+               std::runtime_error);
+}
+
+TEST_F(FsTest, PrefetchCountsFilesAndFailures) {
+  std::vector<std::string> paths;
+  uint64_t expectedBytes = 0;
+  for (int i = 0; i < 16; i++) {
+    size_t size = static_cast<size_t>(i) * 1000;
+    writeBytes(path("f" + std::to_string(i)), payload(size, i));
+    paths.push_back(path("f" + std::to_string(i)));
+    expectedBytes += size;
+  }
+  paths.push_back(path("missing"));
+  paths.push_back(dir()); // not a regular file
+
+  PrefetchSummary summary = prefetchFiles(paths, 4);
+  EXPECT_EQ(summary.files, 16u);
+  EXPECT_EQ(summary.bytes, expectedBytes);
+  EXPECT_EQ(summary.failed, 2u);
+
+  summary = prefetchFiles({}, 0);
+  EXPECT_EQ(summary.files, 0u);
+  EXPECT_EQ(summary.failed, 0u);
+}
+
+} // namespace
@@ -0,0 +1,109 @@
+#include "FileCompression.hpp"
+#include "TestUtil.hpp"
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+std::vector<uint8_t> gzipBytes(const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> out;
+  Compressor compressor(CompressionCodec::Gzip, -1,
+                        [&](const uint8_t *chunk, size_t size) {
+                          out.insert(out.end(), chunk, chunk + size);
+                        });
+  compressor.write(data.empty() ? kEmpty : data.data(), data.size());
+  compressor.finish();
+  return out;
+}
+
+std::string decompress(const std::vector<std::vector<uint8_t>> &writes) {
+  std::string out;
+  Decompressor decompressor([&](const uint8_t *data, size_t size) {
+    out.append(reinterpret_cast<const char *>(data), size);
+  });
+  for (const auto &chunk : writes) {
+    decompressor.write(chunk.empty() ? kEmpty : chunk.data(), chunk.size());
+  }
+  decompressor.finish();
+  return out;
+}
+
+TEST(GzipStreamTest, MembersSplitAtAnyWriteBoundary) {
+  auto first = gzipBytes(bytes("hello "));
+  auto second = gzipBytes(bytes("world"));
+  std::vector<uint8_t> both = first;
+  both.insert(both.end(), second.begin(), second.end());
+
+  EXPECT_EQ(decompress({both}), "hello world");
+  // A member that ends exactly at the end of a write.
+  EXPECT_EQ(decompress({first, second}), "hello world");
+  for (size_t cut = 1; cut < both.size(); cut++) {
+    std::vector<uint8_t> head(both.begin(), both.begin() + cut);
+    std::vector<uint8_t> tail(both.begin() + cut, both.end());
+    ASSERT_EQ(decompress({head, tail}), "hello world") << "cut at " << cut;
+  }
+}
+
+TEST(GzipStreamTest, TrailingGarbageAndTruncationThrow) {
+  auto first = gzipBytes(bytes("hello "));
+  auto second = gzipBytes(bytes("world"));
+  EXPECT_THROW(decompress({first, bytes("junk")}), std::runtime_error);
+  std::vector<uint8_t> cut(second.begin(), second.begin() + 12);
+  EXPECT_THROW(decompress({first, cut}), std::runtime_error);
+  std::vector<uint8_t> half(first.begin(), first.begin() + first.size() / 2);
+  EXPECT_THROW(decompress({half}), std::runtime_error);
+}
+
+TEST_F(FsTest, CompressFileRoundTripsEveryCodec) {
+  auto data = payload(600 << 10);
+  data.resize(data.size() + (400 << 10), 'x'); // something to compress
+  writeBytes(path("src"), data);
+  for (CompressionCodec codec : {CompressionCodec::Gzip, CompressionCodec::Zlib,
+                                 CompressionCodec::Zstd}) {
+    if (!isCodecAvailable(codec)) {
+      continue;
+    }
+    SCOPED_TRACE(static_cast<int>(codec));
+    compressFile(path("src"), path("packed"), codec, -1);
+    EXPECT_LT(readBytes(path("packed")).size(), data.size());
+    decompressFile(path("packed"), path("unpacked"));
+    EXPECT_EQ(readBytes(path("unpacked")), data);
+  }
+}
+
+TEST_F(FsTest, DecompressFileReadsConcatenatedMembers) {
+  auto big = payload(3 << 20);
+  auto data = gzipBytes(big);
+  auto tail = gzipBytes(bytes("tail"));
+  data.insert(data.end(), tail.begin(), tail.end());
+  writeBytes(path("multi.gz"), data);
+
+  decompressFile(path("multi.gz"), path("multi"));
+  auto expected = big;
+  expected.insert(expected.end(), {'t', 'a', 'i', 'l'});
+  EXPECT_EQ(readBytes(path("multi")), expected);
+}
+
+TEST_F(FsTest, FileStreamingRejectsSameFile) {
+  auto data = gzipBytes(bytes("keep me"));
+  writeBytes(path("a.gz"), data);
+  ASSERT_EQ(rn_fs_symlink(path("a.gz").c_str(), path("alias").c_str()), 0);
+
+  EXPECT_THROW(compressFile(path("a.gz"), path("a.gz"), CompressionCodec::Gzip,
+                            -1),
+               std::runtime_error);
+  EXPECT_THROW(decompressFile(path("a.gz"), path("alias")),
+               std::runtime_error);
+  EXPECT_EQ(readBytes(path("a.gz")), data);
+}
+
+TEST_F(FsTest, FailedDecompressRemovesPartialOutput) {
+  writeBytes(path("bad.gz"), bytes("not compressed"));
+  writeBytes(path("out"), bytes("old"));
+  EXPECT_THROW(decompressFile(path("bad.gz"), path("out")),
+               std::runtime_error);
+  EXPECT_FALSE(pathExists(path("out")));
+}
+
+} // namespace
@@ -0,0 +1,74 @@
+#include "BatchOps.hpp"
+#include "FileCopy.hpp"
+#include "TestUtil.hpp"
+#include <cerrno>
+#include <sys/stat.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+mode_t permsOf(const std::string &file) {
+  struct stat st;
+  return ::stat(file.c_str(), &st) == 0 ? st.st_mode & 07777 : 0;
+}
+
+TEST_F(FsTest, FailedForcedCloneKeepsDestination) {
+  writeBytes(path("src"), bytes("source"));
+  writeBytes(path("dest"), bytes("existing destination"));
+  try {
+    copyRegularFile(path("src"), path("dest"), kCopyFileCloneForce, false);
+    EXPECT_EQ(readText(path("dest")), "source"); // the filesystem can clone
+  } catch (const CopyFileError &e) {
+    EXPECT_NE(e.error(), 0);
+    EXPECT_EQ(readText(path("dest")), "existing destination");
+  }
+  EXPECT_TRUE(
+      copyRegularFile(path("src"), path("dest"), kCopyFileClone, false));
+  EXPECT_EQ(readText(path("dest")), "source");
+}
+
+TEST_F(FsTest, CopyGivesExistingDestinationTheSourceMode) {
+  writeBytes(path("src"), bytes("source"));
+  writeBytes(path("dest"), bytes("existing destination"));
+  ASSERT_EQ(::chmod(path("src").c_str(), 0640), 0);
+  ASSERT_EQ(::chmod(path("dest").c_str(), 0666), 0);
+
+  EXPECT_TRUE(copyRegularFile(path("src"), path("dest"), 0, false));
+  EXPECT_EQ(readText(path("dest")), "source");
+  EXPECT_EQ(permsOf(path("dest")), 0640u);
+}
+
+TEST_F(FsTest, CopyOntoItselfFailsWithEinval) {
+  writeBytes(path("src"), bytes("source"));
+  try {
+    copyRegularFile(path("src"), path("src"), 0, false);
+    ADD_FAILURE() << "copying a file onto itself succeeded";
+  } catch (const CopyFileError &e) {
+    EXPECT_EQ(e.error(), EINVAL);
+  }
+  EXPECT_EQ(readText(path("src")), "source");
+}
+
+TEST_F(FsTest, BatchCopyReportsTheErrnoOfTheFailedCall) {
+  writeBytes(path("src"), bytes("source"));
+  writeBytes(path("dest"), bytes("existing destination"));
+  BatchRequest excl;
+  excl.kind = BatchKind::CopyFile;
+  excl.path = path("src");
+  excl.dest = path("dest");
+  excl.mode = kCopyFileExcl;
+  BatchRequest same = excl;
+  same.dest = path("src");
+  same.mode = 0;
+
+  auto outcomes = runBatch({excl, same}, BatchConfig{});
+  ASSERT_EQ(outcomes.size(), 2u);
+  EXPECT_EQ(outcomes[0].error, EEXIST) << outcomes[0].message;
+  EXPECT_EQ(outcomes[1].error, EINVAL) << outcomes[1].message;
+  EXPECT_EQ(readText(path("dest")), "existing destination");
+  EXPECT_EQ(readText(path("src")), "source");
+}
+
+} // namespace
@@ -0,0 +1,102 @@
+#include "FileTail.hpp"
+#include "TestUtil.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <unistd.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+// Collects what a FileTail delivers on its thread.
+class Collector {
+public:
+  FileTail::Sink sink() {
+    return [this](TailChunk &&chunk) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _bytes.insert(_bytes.end(), chunk.bytes.begin(), chunk.bytes.end());
+      _lines.insert(_lines.end(), chunk.lines.begin(), chunk.lines.end());
+      if (chunk.change != TailChange::None) {
+        _changes.push_back(chunk.change);
+      }
+      _changed.notify_all();
+    };
+  }
+
+  // Waits up to 5 s for `done` to hold; the watcher usually wakes the tail
+  // at once, the short poll interval covers it otherwise.
+  template <typename Predicate> bool waitFor(Predicate done) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _changed.wait_for(lock, std::chrono::seconds(5),
+                             [&] { return done(*this); });
+  }
+
+  std::vector<uint8_t> _bytes;
+  std::vector<std::string> _lines;
+  std::vector<TailChange> _changes;
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _changed;
+};
+
+TailConfig fastPoll() {
+  TailConfig config;
+  config.pollIntervalMs = 20;
+  return config;
+}
+
+void appendText(const std::string &path, const std::string &text) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+  ASSERT_GE(fd, 0) << path;
+  EXPECT_TRUE(writeFully(fd, reinterpret_cast<const uint8_t *>(text.data()),
+                         text.size()));
+  ::close(fd);
+}
+
+TEST_F(FsTest, FileTailDeliversCompleteLinesAsTheFileGrows) {
+  writeBytes(path("app.log"), bytes("old\npart"));
+  TailConfig config = fastPoll();
+  config.fromEnd = false;
+  config.lines = true;
+  Collector out;
+  FileTail tail(path("app.log"), config, out.sink());
+
+  ASSERT_TRUE(out.waitFor([](Collector &c) { return c._lines.size() == 1; }));
+  EXPECT_EQ(out._lines[0], "old");
+  appendText(path("app.log"), "ial\r\nnext\n");
+  ASSERT_TRUE(out.waitFor([](Collector &c) { return c._lines.size() == 3; }));
+  EXPECT_EQ(out._lines, (std::vector<std::string>{"old", "partial", "next"}));
+  tail.close();
+  EXPECT_EQ(tail.offset(), 18u);
+}
+
+TEST_F(FsTest, FileTailFollowsTruncationAndRotation) {
+  writeBytes(path("app.log"), bytes("existing"));
+  Collector out;
+  FileTail tail(path("app.log"), fastPoll(), out.sink());
+
+  appendText(path("app.log"), "+new");
+  ASSERT_TRUE(out.waitFor([](Collector &c) { return c._bytes.size() == 4; }));
+  EXPECT_EQ(std::string(out._bytes.begin(), out._bytes.end()), "+new");
+
+  writeBytes(path("app.log"), bytes("t"));
+  ASSERT_TRUE(out.waitFor([](Collector &c) { return c._bytes.size() == 5; }));
+  EXPECT_EQ(out._changes, std::vector<TailChange>{TailChange::Truncated});
+
+  ASSERT_EQ(rn_fs_rename(path("app.log").c_str(), path("app.log.1").c_str()),
+            0);
+  writeBytes(path("app.log"), bytes("rotated"));
+  ASSERT_TRUE(out.waitFor([](Collector &c) { return c._bytes.size() == 12; }));
+  EXPECT_EQ(std::string(out._bytes.begin(), out._bytes.end()),
+            "+newtrotated");
+  EXPECT_EQ(out._changes, (std::vector<TailChange>{TailChange::Truncated,
+                                                   TailChange::Rotated}));
+  tail.close();
+  tail.close();
+}
+
+} // namespace
@@ -0,0 +1,17 @@
+#include "TestUtil.hpp"
+
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+TEST_F(FsTest, ScratchDirectoryRoundTripsFiles) {
+  auto data = payload(100 << 10);
+  writeBytes(path("a.bin"), data);
+  writeBytes(path("empty"), {});
+  EXPECT_EQ(readBytes(path("a.bin")), data);
+  EXPECT_TRUE(readBytes(path("empty")).empty());
+  EXPECT_FALSE(pathExists(path("missing")));
+  EXPECT_THROW(readBytes(path("missing")), std::runtime_error);
+}
+
+} // namespace
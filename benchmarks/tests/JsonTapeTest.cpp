@@ -0,0 +1,66 @@
+#include "JsonTape.hpp"
+#include "TestUtil.hpp"
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+TEST(JsonTapeTest, ParsesIntoPreorderTape) {
+  auto tape = parseJson(bytes(
+      R"({"a":[1,-2.5e3,true,null],"s":"x\"é😀","a2":{}})"));
+  const auto &nodes = tape->nodes();
+  ASSERT_EQ(nodes.size(), 11u);
+  EXPECT_EQ(nodes[0].kind, JsonTape::Kind::Object);
+  EXPECT_EQ(nodes[0].length, 3u);
+  EXPECT_EQ(nodes[1].kind, JsonTape::Kind::Key);
+  EXPECT_EQ(tape->key(nodes[1].offset), "a");
+  EXPECT_EQ(nodes[2].kind, JsonTape::Kind::Array);
+  EXPECT_EQ(nodes[2].length, 4u);
+  EXPECT_EQ(nodes[3].number, 1);
+  EXPECT_EQ(nodes[4].number, -2500);
+  EXPECT_EQ(nodes[5].kind, JsonTape::Kind::True);
+  EXPECT_EQ(nodes[6].kind, JsonTape::Kind::Null);
+  EXPECT_EQ(tape->key(nodes[7].offset), "s");
+  EXPECT_EQ(nodes[8].kind, JsonTape::Kind::String);
+  EXPECT_TRUE(nodes[8].flags & JsonTape::kEscaped);
+  EXPECT_FALSE(nodes[8].flags & JsonTape::kAscii);
+  EXPECT_EQ(tape->string(nodes[8]), "x\"\xC3\xA9\xF0\x9F\x98\x80");
+  EXPECT_EQ(nodes[10].kind, JsonTape::Kind::Object);
+  EXPECT_EQ(nodes[10].length, 0u);
+}
+
+TEST(JsonTapeTest, InternsRepeatedKeys) {
+  auto tape = parseJson(bytes(R"([{"id":1,"v":2},{"id":3,"v":4},{"id":5}])"));
+  EXPECT_EQ(tape->keyCount(), 2u);
+}
+
+TEST(JsonTapeTest, LoneSurrogateBecomesReplacementCharacter) {
+  auto tape = parseJson(bytes(R"("\ud800x")"));
+  EXPECT_EQ(tape->string(tape->nodes()[0]), "\xEF\xBF\xBDx");
+}
+
+TEST(JsonTapeTest, SyntaxErrorsThrow) {
+  for (const char *bad : {"", "[1,]", "{\"a\" 1}", "[1 2]", "\"open", "tru",
+                          "[1] x", "01", "{\"a\":1,}", "\"\x01\""}) {
+    SCOPED_TRACE(bad);
+    EXPECT_THROW(parseJson(bytes(bad)), std::runtime_error);
+  }
+}
+
+TEST(JsonTapeTest, WritersRoundTrip) {
+  std::string out;
+  appendJsonString(out, "q\"\\\n\x01\xC3\xA9");
+  out += ',';
+  appendJsonNumber(out, 0.1);
+  out += ',';
+  appendJsonNumber(out, 1.0 / 0.0);
+  auto tape = parseJson(bytes("[" + out + "]"));
+  const auto &nodes = tape->nodes();
+  ASSERT_EQ(nodes.size(), 4u);
+  EXPECT_EQ(tape->string(nodes[1]), "q\"\\\n\x01\xC3\xA9");
+  EXPECT_EQ(nodes[2].number, 0.1);
+  EXPECT_EQ(nodes[3].kind, JsonTape::Kind::Null);
+}
+
+} // namespace
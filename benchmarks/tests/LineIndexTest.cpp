@@ -0,0 +1,83 @@
+#include "LineIndex.hpp"
+#include "TestUtil.hpp"
+#include <algorithm>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+std::string lineAt(size_t i) {
+  return "line " + std::to_string(i) + std::string(i % 37, '.');
+}
+
+// Lines 0..count-1, every third one ending in "\r\n".
+std::string textLines(size_t from, size_t count) {
+  std::string text;
+  for (size_t i = from; i < from + count; i++) {
+    text += lineAt(i) + (i % 3 == 0 ? "\r\n" : "\n");
+  }
+  return text;
+}
+
+TEST(LineIndexTest, CountNewlinesMatchesStdCount) {
+  auto data = payload(100003);
+  for (size_t i = 0; i < data.size(); i += 7) {
+    data[i] = '\n';
+  }
+  for (size_t size : {size_t{0}, size_t{1}, size_t{15}, size_t{16},
+                      size_t{17}, data.size()}) {
+    EXPECT_EQ(countNewlines(data.data(), size),
+              static_cast<size_t>(std::count(data.begin(),
+                                             data.begin() + size, '\n')))
+        << size;
+  }
+}
+
+TEST_F(FsTest, ReadLinesReturnsAnyRange) {
+  std::string text = textLines(0, 1000) + "last without newline";
+  writeBytes(path("log"), bytes(text));
+  LineIndexConfig config;
+  config.stride = 64;
+
+  LineIndexStats stats = buildLineIndex(path("log"), config);
+  EXPECT_EQ(stats.lines, 1001u);
+  EXPECT_EQ(stats.size, text.size());
+  EXPECT_EQ(stats.scannedBytes, text.size());
+  EXPECT_GE(stats.checkpoints, 1000u / 64);
+
+  for (uint64_t start : {0, 1, 63, 64, 65, 500, 999}) {
+    auto lines = readLines(path("log"), start, 3, config);
+    ASSERT_EQ(lines.size(), start == 999 ? 2u : 3u) << start;
+    EXPECT_EQ(lines[0], lineAt(start));
+  }
+  EXPECT_EQ(readLines(path("log"), 1000, 5, config),
+            std::vector<std::string>{"last without newline"});
+  EXPECT_TRUE(readLines(path("log"), 5000, 5, config).empty());
+}
+
+TEST_F(FsTest, LineIndexScansOnlyAppendedBytesAndRescansTruncation) {
+  std::string text = textLines(0, 500);
+  writeBytes(path("log"), bytes(text));
+  LineIndexConfig config;
+  config.stride = 16;
+  config.indexPath = path("log.idx");
+  buildLineIndex(path("log"), config);
+
+  std::string more = textLines(500, 100);
+  writeBytes(path("log"), bytes(text + more));
+  LineIndexStats grown = buildLineIndex(path("log"), config);
+  EXPECT_EQ(grown.lines, 600u);
+  EXPECT_EQ(grown.scannedBytes, more.size());
+  EXPECT_EQ(readLines(path("log"), 550, 1, config)[0], lineAt(550));
+  EXPECT_TRUE(pathExists(path("log.idx")));
+
+  std::string shorter = textLines(0, 10);
+  writeBytes(path("log"), bytes(shorter));
+  LineIndexStats shrunk = buildLineIndex(path("log"), config);
+  EXPECT_EQ(shrunk.lines, 10u);
+  EXPECT_EQ(shrunk.scannedBytes, shorter.size());
+  EXPECT_THROW(buildLineIndex(path("missing"), config), std::runtime_error);
+}
+
+} // namespace
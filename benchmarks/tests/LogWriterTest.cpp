@@ -0,0 +1,78 @@
+#include "HybridLogWriter.hpp"
+#include "TestUtil.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+uint64_t fileSize(const std::string &path) {
+  RNStats st;
+  return rn_fs_stat(path.c_str(), &st) == 0 ? st.size : 0;
+}
+
+TEST_F(FsTest, LogWriterKeepsOrderAcrossRingWraps) {
+  LogWriterConfig config;
+  config.bufferSize = 4096;
+  config.flushBytes = 1000;
+  auto writer = std::make_shared<HybridLogWriter>(path("app.log"), config);
+
+  auto data = payload(1 << 20);
+  for (size_t offset = 0; offset < data.size(); offset += 3000) {
+    size_t size = std::min<size_t>(3000, data.size() - offset);
+    writer->appendBuffer(ArrayBuffer::copy(data.data() + offset, size));
+  }
+  writer->close()->await().get();
+  EXPECT_EQ(readBytes(path("app.log")), data);
+  EXPECT_THROW(writer->append("late"), std::runtime_error);
+}
+
+TEST_F(FsTest, LogWriterFlushesAtThresholdWithoutTimer) {
+  LogWriterConfig config;
+  config.flushIntervalMs = 0;
+  config.flushBytes = 10;
+  writeBytes(path("app.log"), bytes("old\n"));
+  auto writer = std::make_shared<HybridLogWriter>(path("app.log"), config);
+
+  writer->append("abc");
+  writer->flush()->await().get();
+  EXPECT_EQ(readText(path("app.log")), "old\nabc");
+
+  // Crossing flushBytes wakes the flusher even though no timer runs.
+  writer->append("0123456789");
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (fileSize(path("app.log")) < 17 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(readText(path("app.log")), "old\nabc0123456789");
+  writer->close()->await().get();
+}
+
+TEST_F(FsTest, LogWriterRotatesBySize) {
+  LogWriterConfig config;
+  config.maxFileSize = 100;
+  config.maxFiles = 2;
+  auto writer = std::make_shared<HybridLogWriter>(path("app.log"), config);
+
+  for (char c : std::string("abcd")) {
+    writer->append(std::string(100, c));
+    writer->flush()->await().get();
+  }
+  writer->append("tail");
+  writer->close()->await().get();
+
+  EXPECT_EQ(readText(path("app.log")), "tail");
+  EXPECT_EQ(readText(path("app.log.1")), std::string(100, 'd'));
+  EXPECT_EQ(readText(path("app.log.2")), std::string(100, 'c'));
+  EXPECT_FALSE(pathExists(path("app.log.3")));
+}
+
+TEST_F(FsTest, LogWriterRejectsUnopenablePath) {
+  EXPECT_THROW(HybridLogWriter(path("missing/app.log"), LogWriterConfig()),
+               std::runtime_error);
+}
+
+} // namespace
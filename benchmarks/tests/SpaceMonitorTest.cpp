@@ -0,0 +1,55 @@
+#include "SpaceMonitor.hpp"
+#include "TestUtil.hpp"
+#include <atomic>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+TEST_F(FsTest, VolumeStatsDescribeTheScratchVolume) {
+  portable::VolumeStats stats = portable::statfs(dir());
+  EXPECT_GT(stats.bsize, 0u);
+  EXPECT_GT(stats.blocks, 0u);
+  EXPECT_LE(stats.bavail, stats.blocks);
+  EXPECT_EQ(stats.availableBytes(), stats.bavail * stats.bsize);
+  EXPECT_THROW(portable::statfs(path("missing")), std::runtime_error);
+}
+
+TEST_F(FsTest, SpaceMonitorReportsAVolumeThatStartsLowOnce) {
+  std::atomic<int> lowReports{0};
+  std::atomic<int> okReports{0};
+  SpaceMonitorConfig config;
+  config.thresholdBytes = UINT64_MAX; // no volume has this much free
+  config.intervalMs = 100;
+  SpaceMonitor monitor(dir(), config,
+                       [&](bool low, const portable::VolumeStats &stats) {
+                         EXPECT_GT(stats.blocks, 0u);
+                         (low ? lowReports : okReports)++;
+                       });
+  monitor.check();
+  EXPECT_TRUE(monitor.isLow());
+  monitor.check();
+  monitor.close();
+  monitor.close();
+  EXPECT_EQ(lowReports.load(), 1);
+  EXPECT_EQ(okReports.load(), 0);
+}
+
+TEST_F(FsTest, SpaceMonitorStaysQuietAboveThreshold) {
+  std::atomic<int> reports{0};
+  SpaceMonitorConfig config;
+  config.thresholdBytes = 1;
+  SpaceMonitor monitor(dir(), config,
+                       [&](bool, const portable::VolumeStats &) { reports++; });
+  monitor.check();
+  EXPECT_FALSE(monitor.isLow());
+  monitor.close();
+  EXPECT_EQ(reports.load(), 0);
+
+  EXPECT_THROW(SpaceMonitor(path("missing"), config,
+                            [](bool, const portable::VolumeStats &) {}),
+               std::runtime_error);
+}
+
+} // namespace
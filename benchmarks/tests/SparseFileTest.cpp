@@ -0,0 +1,65 @@
+#include "FileIO.hpp"
+#include "SparseFile.hpp"
+#include "TestUtil.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+uint64_t sizeOf(int fd) {
+  struct stat st;
+  return ::fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+TEST_F(FsTest, FallocateGrowsOrKeepsTheSize) {
+  UniqueFd fd(::open(path("f").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+  ASSERT_TRUE(fd);
+  fallocateRange(fd.get(), 0, 1 << 20, false, false);
+  EXPECT_EQ(sizeOf(fd.get()), uint64_t{1} << 20);
+  EXPECT_EQ(readBytes(path("f")), std::vector<uint8_t>(1 << 20, 0));
+
+  fallocateRange(fd.get(), 1 << 20, 1 << 20, true, false);
+  EXPECT_EQ(sizeOf(fd.get()), uint64_t{1} << 20);
+  fallocateRange(fd.get(), 0, 0, false, false); // empty: nothing to do
+
+  EXPECT_THROW(fallocateRange(fd.get(), UINT64_MAX - 10, 100, false, false),
+               std::runtime_error);
+  EXPECT_THROW(fallocateRange(fd.get(), uint64_t{1} << 63, 1, true, false),
+               std::runtime_error);
+  EXPECT_THROW(fallocateRange(-1, 0, 1, false, false), std::runtime_error);
+}
+
+TEST_F(FsTest, PunchedHolesReadAsZerosAndAreSkippedBySeekData) {
+  constexpr uint64_t kMiB = 1 << 20;
+  auto data = payload(3 * kMiB);
+  writeBytes(path("f"), data);
+  UniqueFd fd(::open(path("f").c_str(), O_RDWR | O_CLOEXEC));
+  ASSERT_TRUE(fd);
+  EXPECT_EQ(seekData(fd.get(), 0), 0);
+  EXPECT_EQ(seekHole(fd.get(), 4 * kMiB), -1);
+
+  try {
+    fallocateRange(fd.get(), kMiB, kMiB, false, true);
+  } catch (const std::runtime_error &) {
+    GTEST_SKIP() << "this filesystem cannot punch holes";
+  }
+  EXPECT_EQ(sizeOf(fd.get()), 3 * kMiB);
+  std::fill(data.begin() + kMiB, data.begin() + 2 * kMiB, 0);
+  EXPECT_EQ(readBytes(path("f")), data);
+
+  // Filesystems that do not track holes report everything as data.
+  int64_t hole = seekHole(fd.get(), 0);
+  int64_t next = seekData(fd.get(), kMiB);
+  if (hole == static_cast<int64_t>(3 * kMiB)) {
+    EXPECT_EQ(next, static_cast<int64_t>(kMiB));
+  } else {
+    EXPECT_EQ(hole, static_cast<int64_t>(kMiB));
+    EXPECT_EQ(next, static_cast<int64_t>(2 * kMiB));
+  }
+}
+
+} // namespace
@@ -0,0 +1,122 @@
+#include "TarArchive.hpp"
+#include "TestUtil.hpp"
+#include <cstdio>
+#include <cstring>
+#include <optional>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+// One ustar header block for `name`, followed by `data` padded to 512.
+// `size` overrides the size field for archives that lie about it.
+void appendTarEntry(std::vector<uint8_t> &out, const std::string &name,
+                    const std::string &data, char type = '0',
+                    std::optional<uint64_t> size = {}) {
+  uint8_t header[512] = {};
+  std::memcpy(header, name.data(), std::min<size_t>(name.size(), 100));
+  std::snprintf(reinterpret_cast<char *>(header + 100), 8, "%07o", 0644);
+  std::snprintf(reinterpret_cast<char *>(header + 108), 8, "%07o", 0);
+  std::snprintf(reinterpret_cast<char *>(header + 116), 8, "%07o", 0);
+  std::snprintf(reinterpret_cast<char *>(header + 124), 12, "%011llo",
+                static_cast<unsigned long long>(size.value_or(data.size())));
+  std::snprintf(reinterpret_cast<char *>(header + 136), 12, "%011o", 0);
+  header[156] = static_cast<uint8_t>(type);
+  std::memcpy(header + 257, "ustar", 6);
+  std::memcpy(header + 263, "00", 2);
+  std::memset(header + 148, ' ', 8);
+  unsigned sum = 0;
+  for (uint8_t b : header) {
+    sum += b;
+  }
+  std::snprintf(reinterpret_cast<char *>(header + 148), 8, "%06o", sum);
+  out.insert(out.end(), header, header + 512);
+  out.insert(out.end(), data.begin(), data.end());
+  out.resize(out.size() + (512 - data.size() % 512) % 512, 0);
+}
+
+TEST_F(FsTest, TarRoundTripsPlainAndGzip) {
+  auto big = payload(300 << 10);
+  ASSERT_TRUE(rn_fs_mkdir(path("src/sub").c_str(), 0755, true));
+  writeBytes(path("src/a.txt"), bytes("alpha"));
+  writeBytes(path("src/sub/big.bin"), big);
+  writeBytes(path("src/empty"), {});
+  ASSERT_EQ(rn_fs_symlink("a.txt", path("src/link").c_str()), 0);
+
+  for (bool gzip : {false, true}) {
+    SCOPED_TRACE(gzip ? "gzip" : "plain");
+    std::string archive = path(gzip ? "t.tar.gz" : "t.tar");
+    std::string out = path(gzip ? "out-gz" : "out");
+    TarCreateConfig config;
+    config.gzip = gzip;
+    tarCreate(path("src"), archive, config);
+    tarExtract(archive, out);
+
+    EXPECT_EQ(readText(out + "/a.txt"), "alpha");
+    EXPECT_EQ(readBytes(out + "/sub/big.bin"), big);
+    EXPECT_TRUE(readBytes(out + "/empty").empty());
+    char *target = rn_fs_readlink((out + "/link").c_str());
+    ASSERT_NE(target, nullptr);
+    EXPECT_STREQ(target, "a.txt");
+    rn_fs_free_string(target);
+  }
+}
+
+TEST_F(FsTest, TarRejectsEscapingNames) {
+  std::vector<uint8_t> tar;
+  appendTarEntry(tar, "ok.txt", "fine");
+  appendTarEntry(tar, "../evil.txt", "bad");
+  tar.resize(tar.size() + 1024, 0);
+  writeBytes(path("evil.tar"), tar);
+
+  EXPECT_THROW(tarExtract(path("evil.tar"), path("out")), std::runtime_error);
+  EXPECT_FALSE(pathExists(path("evil.txt")));
+}
+
+TEST_F(FsTest, TarRejectsTruncatedArchive) {
+  std::vector<uint8_t> tar;
+  appendTarEntry(tar, "a.txt", std::string(2000, 'a'));
+  tar.resize(1024); // header plus half the data
+  writeBytes(path("cut.tar"), tar);
+
+  EXPECT_THROW(tarExtract(path("cut.tar"), path("out")), std::runtime_error);
+}
+
+TEST_F(FsTest, TarAppliesPaxAndGnuLongNames) {
+  std::string longName = std::string(150, 'd') + "/file.txt";
+  std::string record = "path=" + longName + "\n";
+  // The length prefix counts itself and the separating space.
+  std::string pax = std::to_string(record.size() + 4) + " " + record;
+  ASSERT_EQ(pax.size(), record.size() + 4);
+
+  std::vector<uint8_t> tar;
+  appendTarEntry(tar, "PaxHeader", pax, 'x');
+  appendTarEntry(tar, "short1", "pax");
+  appendTarEntry(tar, "././@LongLink", "gnu/" + longName + '\0', 'L');
+  appendTarEntry(tar, "short2", "gnu");
+  tar.resize(tar.size() + 1024, 0);
+  writeBytes(path("long.tar"), tar);
+
+  tarExtract(path("long.tar"), path("out"));
+  EXPECT_EQ(readText(path("out/" + longName)), "pax");
+  EXPECT_EQ(readText(path("out/gnu/" + longName)), "gnu");
+  EXPECT_FALSE(pathExists(path("out/short1")));
+}
+
+TEST_F(FsTest, TarRejectsOversizedMetadataBeforeReadingIt) {
+  for (char type : {'x', 'g', 'L', 'K'}) {
+    SCOPED_TRACE(type);
+    // Claims ~8 GiB of header data but holds none.
+    std::vector<uint8_t> tar;
+    appendTarEntry(tar, "meta", "", type, 077777777777ULL);
+    appendTarEntry(tar, "a.txt", "data");
+    tar.resize(tar.size() + 1024, 0);
+    writeBytes(path("huge.tar"), tar);
+
+    EXPECT_THROW(tarExtract(path("huge.tar"), path("out")),
+                 std::runtime_error);
+  }
+}
+
+} // namespace
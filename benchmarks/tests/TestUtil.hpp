@@ -0,0 +1,85 @@
+#pragma once
+// Shared helpers for the host GoogleTest suite in this directory.
+#include "rust_c_file_system.h"
+#include <cstdint>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs::test {
+
+// Never hand rn_fs_* a null pointer, even for empty writes.
+inline const uint8_t kEmpty[1] = {0};
+
+inline std::vector<uint8_t> bytes(const std::string &text) {
+  return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// Deterministic pseudo-random bytes.
+inline std::vector<uint8_t> payload(size_t size, uint32_t seed = 7) {
+  std::vector<uint8_t> data(size);
+  uint32_t x = seed;
+  for (size_t i = 0; i < size; i++) {
+    x = x * 1103515245u + 12345u;
+    data[i] = static_cast<uint8_t>(x >> 16);
+  }
+  return data;
+}
+
+inline void writeBytes(const std::string &path,
+                       const std::vector<uint8_t> &data) {
+  ASSERT_EQ(rn_fs_write_file(path.c_str(),
+                             data.empty() ? kEmpty : data.data(), data.size()),
+            0)
+      << path;
+}
+
+inline std::vector<uint8_t> readBytes(const std::string &path) {
+  size_t len = 0;
+  uint8_t *data = rn_fs_read_file(path.c_str(), &len);
+  if (data == nullptr) {
+    throw std::runtime_error("read failed: " + path);
+  }
+  std::vector<uint8_t> result(data, data + len);
+  rn_fs_read_file_free(data, len);
+  return result;
+}
+
+inline std::string readText(const std::string &path) {
+  auto data = readBytes(path);
+  return std::string(data.begin(), data.end());
+}
+
+inline bool pathExists(const std::string &path) {
+  RNStats st;
+  return rn_fs_stat(path.c_str(), &st) == 0;
+}
+
+// Gives each test a fresh scratch directory, removed afterwards.
+class FsTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::string templ =
+        (std::filesystem::temp_directory_path() / "nitro-fs-test-").string();
+    char *created = rn_fs_mkdtemp(templ.c_str());
+    ASSERT_NE(created, nullptr);
+    _dir = created;
+    rn_fs_free_string(created);
+  }
+
+  void TearDown() override {
+    if (!_dir.empty()) {
+      rn_fs_rm(_dir.c_str(), true);
+    }
+  }
+
+  const std::string &dir() const { return _dir; }
+  std::string path(const std::string &name) const { return _dir + "/" + name; }
+
+private:
+  std::string _dir;
+};
+
+} // namespace margelo::nitro::node_fs::test
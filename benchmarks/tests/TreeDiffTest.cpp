@@ -0,0 +1,60 @@
+#include "TestUtil.hpp"
+#include "TreeDiff.hpp"
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+using Names = std::vector<std::string>;
+
+TEST_F(FsTest, FilesEqualComparesContents) {
+  auto data = payload(300 << 10);
+  writeBytes(path("a"), data);
+  writeBytes(path("b"), data);
+  data[200 << 10] ^= 1;
+  writeBytes(path("c"), data);
+  writeBytes(path("short"), payload(10));
+
+  EXPECT_TRUE(filesEqual(path("a"), path("b")));
+  EXPECT_TRUE(filesEqual(path("a"), path("a")));
+  EXPECT_FALSE(filesEqual(path("a"), path("c")));
+  EXPECT_FALSE(filesEqual(path("a"), path("short")));
+  EXPECT_THROW(filesEqual(path("a"), path("missing")), std::runtime_error);
+  EXPECT_THROW(filesEqual(path("a"), dir()), std::runtime_error);
+}
+
+TEST_F(FsTest, DiffTreesListsAddedRemovedAndChanged) {
+  for (const char *root : {"a", "b"}) {
+    std::string base = path(root);
+    ASSERT_TRUE(rn_fs_mkdir((base + "/sub").c_str(), 0755, true));
+    writeBytes(base + "/same", bytes("same"));
+    writeBytes(base + "/sub/size", bytes(root));
+  }
+  writeBytes(path("a/sub/size"), bytes("longer"));
+  writeBytes(path("a/content"), bytes("aaaa"));
+  writeBytes(path("b/content"), bytes("bbbb"));
+  ASSERT_TRUE(rn_fs_mkdir(path("a/gone/deep").c_str(), 0755, true));
+  writeBytes(path("a/gone/deep/f"), bytes("f"));
+  writeBytes(path("b/new"), bytes("new"));
+  writeBytes(path("a/kind"), bytes("file"));
+  ASSERT_TRUE(rn_fs_mkdir(path("b/kind").c_str(), 0755, false));
+
+  for (size_t parallelism : {size_t{1}, size_t{0}}) {
+    TreeDiffConfig config;
+    config.parallelism = parallelism;
+    config.compare = TreeCompare::Content;
+    TreeDiffSummary diff = diffTrees(path("a"), path("b"), config);
+    EXPECT_EQ(diff.added, Names{"new"});
+    EXPECT_EQ(diff.removed, (Names{"gone", "gone/deep", "gone/deep/f"}));
+    EXPECT_EQ(diff.changed, (Names{"content", "kind", "sub/size"}));
+
+    config.compare = TreeCompare::Size;
+    diff = diffTrees(path("a"), path("b"), config);
+    EXPECT_EQ(diff.changed, (Names{"kind", "sub/size"}));
+  }
+  EXPECT_THROW(diffTrees(path("a"), path("missing"), TreeDiffConfig()),
+               std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,164 @@
+#include "FileCompression.hpp"
+#include "TestUtil.hpp"
+#include "ZipReader.hpp"
+#include <optional>
+#include <zlib.h>
+
+using namespace margelo::nitro::node_fs;
+using namespace margelo::nitro::node_fs::test;
+
+namespace {
+
+void putLe(std::vector<uint8_t> &out, uint64_t value, int size) {
+  for (int i = 0; i < size; i++) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// Minimal zip writer: stored or raw-deflated entries, no ZIP64. The declared
+// uncompressed size can be overridden to build archives that lie about it.
+class ZipBuilder {
+public:
+  void add(const std::string &name, const std::vector<uint8_t> &data,
+           bool deflate, std::optional<uint32_t> declaredSize = {}) {
+    std::vector<uint8_t> stored = deflate ? rawDeflate(data) : data;
+    uint32_t crc = static_cast<uint32_t>(
+        crc32(0, data.empty() ? kEmpty : data.data(),
+              static_cast<uInt>(data.size())));
+    uint32_t size = declaredSize.value_or(static_cast<uint32_t>(data.size()));
+    uint16_t method = deflate ? 8 : 0;
+    uint32_t offset = static_cast<uint32_t>(_out.size());
+
+    putLe(_out, 0x04034b50, 4);
+    putLe(_out, 20, 2); // version needed
+    putLe(_out, 0, 2);  // flags
+    putLe(_out, method, 2);
+    putLe(_out, 0, 2);      // time
+    putLe(_out, 0x21, 2);   // 1980-01-01
+    putLe(_out, crc, 4);
+    putLe(_out, stored.size(), 4);
+    putLe(_out, size, 4);
+    putLe(_out, name.size(), 2);
+    putLe(_out, 0, 2); // extra
+    _out.insert(_out.end(), name.begin(), name.end());
+    _out.insert(_out.end(), stored.begin(), stored.end());
+
+    putLe(_central, 0x02014b50, 4);
+    putLe(_central, (3 << 8) | 20, 2); // made by Unix
+    putLe(_central, 20, 2);
+    putLe(_central, 0, 2);
+    putLe(_central, method, 2);
+    putLe(_central, 0, 2);
+    putLe(_central, 0x21, 2);
+    putLe(_central, crc, 4);
+    putLe(_central, stored.size(), 4);
+    putLe(_central, size, 4);
+    putLe(_central, name.size(), 2);
+    putLe(_central, 0, 2); // extra
+    putLe(_central, 0, 2); // comment
+    putLe(_central, 0, 2); // disk
+    putLe(_central, 0, 2); // internal attributes
+    putLe(_central, uint32_t{0100644} << 16, 4);
+    putLe(_central, offset, 4);
+    _central.insert(_central.end(), name.begin(), name.end());
+    _count++;
+  }
+
+  std::vector<uint8_t> finish() const {
+    std::vector<uint8_t> out = _out;
+    out.insert(out.end(), _central.begin(), _central.end());
+    putLe(out, 0x06054b50, 4);
+    putLe(out, 0, 2);
+    putLe(out, 0, 2);
+    putLe(out, _count, 2);
+    putLe(out, _count, 2);
+    putLe(out, _central.size(), 4);
+    putLe(out, _out.size(), 4);
+    putLe(out, 0, 2); // comment
+    return out;
+  }
+
+private:
+  static std::vector<uint8_t> rawDeflate(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> out;
+    Compressor compressor(CompressionCodec::RawDeflate, -1,
+                          [&](const uint8_t *chunk, size_t size) {
+                            out.insert(out.end(), chunk, chunk + size);
+                          });
+    compressor.write(data.empty() ? kEmpty : data.data(), data.size());
+    compressor.finish();
+    return out;
+  }
+
+  std::vector<uint8_t> _out;
+  std::vector<uint8_t> _central;
+  uint16_t _count = 0;
+};
+
+TEST_F(FsTest, ZipReadsStoredAndDeflatedEntries) {
+  auto big = payload(200 << 10);
+  ZipBuilder zip;
+  zip.add("hello.txt", bytes("hello zip"), false);
+  zip.add("dir/big.bin", big, true);
+  writeBytes(path("a.zip"), zip.finish());
+
+  ZipReader reader(path("a.zip"));
+  ASSERT_EQ(reader.entries().size(), 2u);
+  const ZipEntryInfo *hello = reader.find("hello.txt");
+  ASSERT_NE(hello, nullptr);
+  EXPECT_EQ(hello->uncompressedSize, 9u);
+  EXPECT_EQ(reader.find("missing"), nullptr);
+
+  std::vector<uint8_t> text(ZipReader::readSize(*hello));
+  reader.readInto(*hello, text.data(), text.size());
+  EXPECT_EQ(std::string(text.begin(), text.end()), "hello zip");
+
+  const ZipEntryInfo *entry = reader.find("dir/big.bin");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->method, 8);
+  std::vector<uint8_t> data(ZipReader::readSize(*entry));
+  reader.readInto(*entry, data.data(), data.size());
+  EXPECT_EQ(data, big);
+
+  reader.extractAll(path("out"), 2);
+  EXPECT_EQ(readText(path("out/hello.txt")), "hello zip");
+  EXPECT_EQ(readBytes(path("out/dir/big.bin")), big);
+}
+
+TEST_F(FsTest, ZipRejectsUntrustedSizes) {
+  ZipBuilder zip;
+  zip.add("huge", bytes("tiny"), true, 0xFFFFFFF0u);
+  zip.add("short", bytes("more than declared"), false, 4);
+  writeBytes(path("lying.zip"), zip.finish());
+
+  ZipReader reader(path("lying.zip"));
+  const ZipEntryInfo *huge = reader.find("huge");
+  ASSERT_NE(huge, nullptr);
+  // Checked before anything is allocated.
+  EXPECT_THROW(ZipReader::readSize(*huge), std::runtime_error);
+  EXPECT_THROW(ZipReader::readSize(*huge, 1 << 20), std::runtime_error);
+  // A declared size within the cap still has to match the data.
+  EXPECT_EQ(ZipReader::readSize(*huge, UINT64_MAX),
+            static_cast<size_t>(0xFFFFFFF0u));
+  std::vector<uint8_t> small(16);
+  EXPECT_THROW(reader.readInto(*huge, small.data(), small.size()),
+               std::runtime_error);
+
+  const ZipEntryInfo *shortEntry = reader.find("short");
+  ASSERT_NE(shortEntry, nullptr);
+  std::vector<uint8_t> buffer(ZipReader::readSize(*shortEntry));
+  EXPECT_THROW(reader.readInto(*shortEntry, buffer.data(), buffer.size()),
+               std::runtime_error);
+}
+
+TEST_F(FsTest, ZipRejectsEscapingNames) {
+  ZipBuilder zip;
+  zip.add("../evil.txt", bytes("x"), false);
+  writeBytes(path("evil.zip"), zip.finish());
+
+  ZipReader reader(path("evil.zip"));
+  EXPECT_THROW(reader.extractAll(path("out"), 1), std::runtime_error);
+  EXPECT_FALSE(pathExists(path("evil.txt")));
+}
+
+} // namespace
@@ -0,0 +1,157 @@
+#include "AtomicWrite.hpp"
+#include "FileIO.hpp"
+#include "rust_c_file_system.h"
+#include <atomic>
+#include <fcntl.h>
+#include <set>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace margelo::nitro::node_fs {
+
+std::string tempPathFor(const std::string &path) {
+  static std::atomic<uint64_t> counter{0};
+  size_t slash = path.find_last_of('/');
+  std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+  std::string base =
+      slash == std::string::npos ? path : path.substr(slash + 1);
+  return dir + "." + base + ".tmp-" + std::to_string(getpid()) + "-" +
+         std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+}
+
+namespace {
+
+struct PendingFile {
+  std::string target;
+  std::string temp;
+  int fd = -1;
+};
+
+std::string parentDirectory(const std::string &path) {
+  size_t slash = path.find_last_of('/');
+  if (slash == std::string::npos) {
+    return ".";
+  }
+  if (slash == 0) {
+    return "/";
+  }
+  return path.substr(0, slash);
+}
+
+// Flushes file contents to stable storage. On Apple platforms fsync only
+// reaches the drive cache; F_FULLFSYNC is reserved for the final directory
+// barrier so that a batch pays for one cache flush instead of one per file.
+bool syncData(int fd) {
+#if defined(__linux__)
+  return ::fdatasync(fd) == 0;
+#else
+  return ::fsync(fd) == 0;
+#endif
+}
+
+bool syncDirectory(const std::string &dir, bool fullBarrier) {
+  int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok;
+#ifdef __APPLE__
+  ok = fullBarrier ? ::fcntl(fd, F_FULLFSYNC) == 0 : ::fsync(fd) == 0;
+#else
+  (void)fullBarrier;
+  ok = ::fsync(fd) == 0;
+#endif
+  ::close(fd);
+  return ok;
+}
+
+void discard(std::vector<PendingFile> &files) {
+  for (auto &f : files) {
+    if (f.fd >= 0) {
+      ::close(f.fd);
+      f.fd = -1;
+    }
+    if (!f.temp.empty()) {
+      rn_fs_unlink(f.temp.c_str());
+    }
+  }
+}
+
+} // namespace
+
+void atomicWriteFiles(const std::vector<AtomicWriteItem> &items,
+                      SyncLevel level) {
+  std::vector<PendingFile> files;
+  files.reserve(items.size());
+
+  try {
+    // 1. Write every temp file. Keep the existing file's permissions so an
+    //    atomic replace does not silently reset them.
+    for (const auto &item : items) {
+      PendingFile f;
+      f.target = item.path;
+      f.temp = tempPathFor(item.path);
+
+      mode_t mode = 0666;
+      RNStats existing;
+      if (rn_fs_stat(item.path.c_str(), &existing) == 0) {
+        mode = existing.mode & 07777;
+      }
+      f.fd = ::open(f.temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                    mode);
+      if (f.fd < 0) {
+        f.temp.clear();
+        throw std::runtime_error("writeFileAtomic open failed: " + item.path);
+      }
+      files.push_back(f);
+      if (!writeFully(f.fd, item.data, item.size)) {
+        throw std::runtime_error("writeFileAtomic write failed: " + item.path);
+      }
+#if defined(__linux__) && (!defined(__ANDROID__) || __ANDROID_API__ >= 26)
+      // Start writeback now so the data of all files is in flight together
+      // and the fdatasync calls below mostly wait on I/O already issued.
+      if (level != SyncLevel::None && items.size() > 1) {
+        ::sync_file_range(f.fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+      }
+#endif
+    }
+
+    // 2. Make the contents durable before any of them become visible.
+    for (auto &f : files) {
+      if (level != SyncLevel::None && !syncData(f.fd)) {
+        throw std::runtime_error("writeFileAtomic fsync failed: " + f.target);
+      }
+      ::close(f.fd);
+      f.fd = -1;
+    }
+  } catch (...) {
+    discard(files);
+    throw;
+  }
+
+  // 3. Publish. Each rename atomically replaces one target.
+  std::set<std::string> directories;
+  for (size_t i = 0; i < files.size(); i++) {
+    if (rn_fs_rename(files[i].temp.c_str(), files[i].target.c_str()) != 0) {
+      std::vector<PendingFile> rest(files.begin() + i, files.end());
+      discard(rest);
+      throw std::runtime_error("writeFileAtomic rename failed: " +
+                               files[i].target);
+    }
+    directories.insert(parentDirectory(files[i].target));
+  }
+
+  // 4. One directory barrier per distinct parent (group commit).
+  if (level == SyncLevel::Full) {
+    size_t remaining = directories.size();
+    for (const auto &dir : directories) {
+      if (!syncDirectory(dir, --remaining == 0)) {
+        throw std::runtime_error("writeFileAtomic directory fsync failed: " +
+                                 dir);
+      }
+    }
+  }
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+// How much of the atomic write must survive a power loss.
+//   None: temp file + rename only (atomic against process crashes).
+//   Data: the new contents are fsynced before they become visible.
+//   Full: additionally fsync the parent directory so the rename is durable.
+enum class SyncLevel { None, Data, Full };
+
+struct AtomicWriteItem {
+  std::string path;
+  const uint8_t *data;
+  size_t size;
+};
+
+// Writes every item to a sibling temp file and renames it over the target.
+// All items of one call share the durability barriers: data writeback is
+// started for every file before the first one is waited on, and each
+// distinct parent directory is fsynced only once after all renames.
+//
+// Each file is replaced atomically, but the batch as a whole is not: if a
+// rename fails, the files renamed before it keep their new contents.
+void atomicWriteFiles(const std::vector<AtomicWriteItem> &items,
+                      SyncLevel level);
+
+// A unique hidden sibling of `path` to write before renaming over it.
+std::string tempPathFor(const std::string &path);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,281 @@
+#include "BatchOps.hpp"
+#include "FileCopy.hpp"
+#include "FsMetrics.hpp"
+#include "WorkerPool.hpp"
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace margelo::nitro::node_fs {
+
+const char *errnoName(int error) {
+  switch (error) {
+#define NITRO_FS_ERRNO(name)                                                   \
+  case name:                                                                   \
+    return #name;
+    NITRO_FS_ERRNO(EPERM)
+    NITRO_FS_ERRNO(ENOENT)
+    NITRO_FS_ERRNO(EIO)
+    NITRO_FS_ERRNO(EBADF)
+    NITRO_FS_ERRNO(EAGAIN)
+    NITRO_FS_ERRNO(ENOMEM)
+    NITRO_FS_ERRNO(EACCES)
+    NITRO_FS_ERRNO(EBUSY)
+    NITRO_FS_ERRNO(EEXIST)
+    NITRO_FS_ERRNO(EXDEV)
+    NITRO_FS_ERRNO(ENOTDIR)
+    NITRO_FS_ERRNO(EISDIR)
+    NITRO_FS_ERRNO(EINVAL)
+    NITRO_FS_ERRNO(EMFILE)
+    NITRO_FS_ERRNO(EFBIG)
+    NITRO_FS_ERRNO(ENOSPC)
+    NITRO_FS_ERRNO(EROFS)
+    NITRO_FS_ERRNO(EMLINK)
+    NITRO_FS_ERRNO(ENAMETOOLONG)
+    NITRO_FS_ERRNO(ENOTEMPTY)
+    NITRO_FS_ERRNO(ELOOP)
+    NITRO_FS_ERRNO(ENOTSUP)
+    NITRO_FS_ERRNO(ECANCELED)
+#undef NITRO_FS_ERRNO
+  default:
+    return "EUNKNOWN";
+  }
+}
+
+std::string errnoMessage(int error, const char *op) {
+  std::string description = std::strerror(error);
+  if (!description.empty()) {
+    description[0] = static_cast<char>(std::tolower(description[0]));
+  }
+  return std::string(errnoName(error)) + ": " + description + ", " + op;
+}
+
+std::string errnoMessage(int error, const char *op, const std::string &path,
+                         const std::string &dest) {
+  std::string message = errnoMessage(error, op) + " '" + path + "'";
+  if (!dest.empty()) {
+    message += " -> '" + dest + "'";
+  }
+  return message;
+}
+
+namespace {
+
+const char *kindName(BatchKind kind) {
+  switch (kind) {
+  case BatchKind::Stat:
+    return "stat";
+  case BatchKind::Lstat:
+    return "lstat";
+  case BatchKind::Exists:
+    return "exists";
+  case BatchKind::Access:
+    return "access";
+  case BatchKind::Mkdir:
+    return "mkdir";
+  case BatchKind::ReadFile:
+    return "readFile";
+  case BatchKind::WriteFile:
+    return "writeFile";
+  case BatchKind::Readdir:
+    return "readdir";
+  case BatchKind::Unlink:
+    return "unlink";
+  case BatchKind::Rmdir:
+    return "rmdir";
+  case BatchKind::Rm:
+    return "rm";
+  case BatchKind::Rename:
+    return "rename";
+  case BatchKind::CopyFile:
+    return "copyFile";
+  case BatchKind::Chmod:
+    return "chmod";
+  }
+  return "unknown";
+}
+
+void setError(BatchOutcome &outcome, int error, const BatchRequest &request) {
+  outcome.error = error;
+  outcome.message =
+      errnoMessage(error, kindName(request.kind), request.path, request.dest);
+}
+
+// errno as left by the failed rn_fs_* call. The Rust layer does not
+// always fail through a syscall, so fall back to EIO.
+int lastError() { return errno != 0 ? errno : EIO; }
+
+BatchOutcome runOne(const BatchRequest &request) {
+  BatchOutcome outcome;
+  const char *path = request.path.c_str();
+  bool ok = true;
+  errno = 0;
+
+  switch (request.kind) {
+  case BatchKind::Stat:
+  case BatchKind::Lstat: {
+    RNStats s;
+    ok = (request.kind == BatchKind::Stat ? rn_fs_stat(path, &s)
+                                          : rn_fs_lstat(path, &s)) == 0;
+    if (ok) {
+      outcome.stats = s;
+    }
+    break;
+  }
+  case BatchKind::Exists:
+    outcome.exists = rn_fs_access(path, F_OK) == 0;
+    break;
+  case BatchKind::Access:
+    ok = rn_fs_access(path, request.mode) == 0;
+    break;
+  case BatchKind::Mkdir:
+    ok = rn_fs_mkdir(path, static_cast<uint32_t>(request.mode),
+                     request.recursive);
+    break;
+  case BatchKind::ReadFile: {
+    size_t length = 0;
+    uint8_t *data = rn_fs_read_file(path, &length);
+    ok = data != nullptr;
+    if (ok) {
+      outcome.data = ArrayBuffer::copy(data, length);
+      rn_fs_read_file_free(data, length);
+    }
+    break;
+  }
+  case BatchKind::WriteFile: {
+    // Never hand rn_fs_* a null pointer, even for empty writes.
+    static const uint8_t kEmpty = 0;
+    const uint8_t *data = request.data ? request.data->data() : nullptr;
+    size_t size = request.data ? request.data->size() : 0;
+    ok = rn_fs_write_file(path, data != nullptr ? data : &kEmpty, size) == 0;
+    break;
+  }
+  case BatchKind::Readdir: {
+    DirIter *iter = rn_fs_readdir_open(path);
+    ok = iter != nullptr;
+    if (ok) {
+      std::vector<std::string> entries;
+      while (char *name = rn_fs_readdir_next(iter)) {
+        entries.emplace_back(name);
+        rn_fs_free_string(name);
+      }
+      rn_fs_readdir_close(iter);
+      outcome.entries = std::move(entries);
+    }
+    break;
+  }
+  case BatchKind::Unlink:
+    ok = rn_fs_unlink(path) == 0;
+    break;
+  case BatchKind::Rmdir:
+    ok = rn_fs_rmdir(path) == 0;
+    break;
+  case BatchKind::Rm:
+    ok = rn_fs_rm(path, request.recursive) == 0;
+    break;
+  case BatchKind::Rename:
+    ok = rn_fs_rename(path, request.dest.c_str()) == 0;
+    break;
+  case BatchKind::CopyFile:
+    try {
+      ok = copyRegularFile(path, request.dest, request.mode, false) ||
+           rn_fs_copy_file(path, request.dest.c_str(), request.mode) == 0;
+    } catch (const CopyFileError &e) {
+      ok = false;
+      errno = e.error();
+    } catch (const std::exception &) {
+      ok = false;
+      errno = EIO;
+    }
+    break;
+  case BatchKind::Chmod:
+    ok = rn_fs_chmod(path, request.mode) == 0;
+    break;
+  }
+
+  if (!ok) {
+    setError(outcome, lastError(), request);
+  }
+  return outcome;
+}
+
+FsOp metricsOpFor(BatchKind kind) {
+  switch (kind) {
+  case BatchKind::Stat:
+    return FsOp::Stat;
+  case BatchKind::Lstat:
+    return FsOp::Lstat;
+  case BatchKind::Exists:
+  case BatchKind::Access:
+    return FsOp::Access;
+  case BatchKind::Mkdir:
+    return FsOp::Mkdir;
+  case BatchKind::ReadFile:
+    return FsOp::ReadFile;
+  case BatchKind::WriteFile:
+    return FsOp::WriteFile;
+  case BatchKind::Readdir:
+    return FsOp::Readdir;
+  case BatchKind::Unlink:
+    return FsOp::Unlink;
+  case BatchKind::Rmdir:
+    return FsOp::Rmdir;
+  case BatchKind::Rm:
+    return FsOp::Rm;
+  case BatchKind::Rename:
+    return FsOp::Rename;
+  case BatchKind::CopyFile:
+    return FsOp::CopyFile;
+  case BatchKind::Chmod:
+    return FsOp::Chmod;
+  }
+  return FsOp::Batch;
+}
+
+// Each operation of a batch shows up in metrics and traces under its own
+// name, exactly as if it had been called directly.
+BatchOutcome runInstrumented(const BatchRequest &request) {
+#if NITRO_FS_METRICS
+  FsOpScope _fsOpScope(metricsOpFor(request.kind));
+  NITRO_FS_TRACE_PATH(request.path);
+  BatchOutcome outcome = runOne(request);
+  if (outcome.error != 0) {
+    NITRO_FS_FAIL();
+  }
+  if (outcome.data) {
+    NITRO_FS_BYTES(outcome.data->size());
+  } else if (request.kind == BatchKind::WriteFile && request.data) {
+    NITRO_FS_BYTES(request.data->size());
+  }
+  return outcome;
+#else
+  return runOne(request);
+#endif
+}
+
+} // namespace
+
+std::vector<BatchOutcome> runBatch(const std::vector<BatchRequest> &requests,
+                                   const BatchConfig &config) {
+  std::vector<BatchOutcome> outcomes(requests.size());
+  if (config.parallel) {
+    parallelFor(requests.size(), config.parallelism, [&](size_t i) {
+      outcomes[i] = runInstrumented(requests[i]);
+    });
+    return outcomes;
+  }
+
+  for (size_t i = 0; i < requests.size(); i++) {
+    outcomes[i] = runInstrumented(requests[i]);
+    if (config.stopOnError && outcomes[i].error != 0) {
+      for (size_t j = i + 1; j < requests.size(); j++) {
+        setError(outcomes[j], ECANCELED, requests[j]);
+      }
+      break;
+    }
+  }
+  return outcomes;
+}
+
+} // namespace margelo::nitro::node_fs
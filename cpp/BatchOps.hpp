@@ -0,0 +1,78 @@
+#pragma once
+#include "rust_c_file_system.h"
+#include <NitroModules/ArrayBuffer.hpp>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+enum class BatchKind {
+  Stat,
+  Lstat,
+  Exists,
+  Access,
+  Mkdir,
+  ReadFile,
+  WriteFile,
+  Readdir,
+  Unlink,
+  Rmdir,
+  Rm,
+  Rename,
+  CopyFile,
+  Chmod,
+};
+
+// One operation of a batch. Paths must already be normalized; `dest` is the
+// second path of rename/copyFile, `mode` applies to access/mkdir/chmod.
+struct BatchRequest {
+  BatchKind kind;
+  std::string path;
+  std::string dest;
+  std::shared_ptr<ArrayBuffer> data;
+  int mode = 0;
+  bool recursive = false;
+};
+
+// Outcome of one operation. `error` is the errno value (0 on success) and
+// `message` a Node-style description ("ENOENT: no such file or directory,
+// stat '/a'"). At most one of the value fields is set.
+struct BatchOutcome {
+  int error = 0;
+  std::string message;
+  std::optional<RNStats> stats;
+  std::shared_ptr<ArrayBuffer> data;
+  std::optional<std::vector<std::string>> entries;
+  std::optional<bool> exists;
+};
+
+struct BatchConfig {
+  // Run operations concurrently on the shared worker pool. Only valid when
+  // the operations do not depend on each other.
+  bool parallel = false;
+  size_t parallelism = 0; // 0: pool size
+  // Sequential mode only: after the first failure, the remaining operations
+  // are not run and report ECANCELED.
+  bool stopOnError = false;
+};
+
+/**
+ * Runs many operations in one call. Failures are reported per operation
+ * instead of being thrown, so one missing file does not abort the rest.
+ */
+std::vector<BatchOutcome> runBatch(const std::vector<BatchRequest> &requests,
+                                   const BatchConfig &config);
+
+// Symbolic name of an errno value ("ENOENT"), or "EUNKNOWN".
+const char *errnoName(int error);
+
+// Node-style error text: "ENOENT: no such file or directory, stat '/a'".
+std::string errnoMessage(int error, const char *op, const std::string &path,
+                         const std::string &dest = {});
+// Same for operations without a path: "EBADF: bad file descriptor, read".
+std::string errnoMessage(int error, const char *op);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,229 @@
+#include "BufferPool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+// Slabs a thread keeps per class before handing them to the depot.
+constexpr size_t kThreadCacheBytes = 256 << 10;
+constexpr size_t kThreadCacheMaxSlabs = 8;
+
+size_t pageSize() {
+  static const size_t kPageSize = []() {
+    long size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<size_t>(size) : size_t{4096};
+  }();
+  return kPageSize;
+}
+
+size_t classSize(size_t index) { return BufferPool::kMinClassSize << index; }
+
+// Smallest class holding `size` bytes; only valid up to kMaxClassSize.
+size_t classFor(size_t size) {
+  size_t index = 0;
+  while (classSize(index) < size) {
+    index++;
+  }
+  return index;
+}
+
+bool isClassSize(size_t capacity) {
+  return capacity >= BufferPool::kMinClassSize &&
+         capacity <= BufferPool::kMaxClassSize &&
+         (capacity & (capacity - 1)) == 0;
+}
+
+size_t threadCacheSlabs(size_t index) {
+  return std::clamp(kThreadCacheBytes / classSize(index), size_t{1},
+                    kThreadCacheMaxSlabs);
+}
+
+uint8_t *allocateSlab(size_t capacity) {
+  void *data = nullptr;
+  size_t alignment = std::max(pageSize(), sizeof(void *));
+  if (::posix_memalign(&data, alignment, capacity) != 0) {
+    throw std::bad_alloc();
+  }
+  return static_cast<uint8_t *>(data);
+}
+
+void freeSlab(uint8_t *data) { std::free(data); }
+
+// Set once this thread's cache is destroyed; buffers freed later during
+// thread exit go to the depot instead.
+thread_local bool threadCacheRetired = false;
+
+} // namespace
+
+struct BufferPool::ThreadCache {
+  std::mutex mutex;
+  std::vector<uint8_t *> slabs[kClassCount];
+
+  ThreadCache() {
+    BufferPool &pool = BufferPool::shared();
+    std::lock_guard<std::mutex> lock(pool._mutex);
+    pool._threadCaches.push_back(this);
+  }
+  ~ThreadCache() {
+    BufferPool::shared().retire(*this);
+    threadCacheRetired = true;
+  }
+};
+
+BufferPool &BufferPool::shared() {
+  // Leaked: leases and thread caches may outlive static destruction.
+  static BufferPool &pool = *new BufferPool();
+  return pool;
+}
+
+BufferPool::ThreadCache *BufferPool::threadCache() {
+  if (threadCacheRetired) {
+    return nullptr;
+  }
+  thread_local ThreadCache cache;
+  return &cache;
+}
+
+void BufferPool::retire(ThreadCache &cache) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _threadCaches.erase(
+      std::remove(_threadCaches.begin(), _threadCaches.end(), &cache),
+      _threadCaches.end());
+  for (size_t index = 0; index < kClassCount; index++) {
+    auto &depot = _depot[index];
+    depot.insert(depot.end(), cache.slabs[index].begin(),
+                 cache.slabs[index].end());
+    cache.slabs[index].clear();
+  }
+}
+
+uint8_t *BufferPool::acquire(size_t size, size_t &capacity) {
+  if (size > kMaxClassSize) {
+    capacity = (size + pageSize() - 1) / pageSize() * pageSize();
+    return allocateSlab(capacity);
+  }
+  size_t index = classFor(size);
+  capacity = classSize(index);
+
+  uint8_t *data = nullptr;
+  if (ThreadCache *cache = threadCache()) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (!cache->slabs[index].empty()) {
+      data = cache->slabs[index].back();
+      cache->slabs[index].pop_back();
+    }
+  }
+  if (data == nullptr) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_depot[index].empty()) {
+      data = _depot[index].back();
+      _depot[index].pop_back();
+    }
+  }
+  if (data != nullptr) {
+    _cachedBytes.fetch_sub(capacity, std::memory_order_relaxed);
+    _hits.fetch_add(1, std::memory_order_relaxed);
+    return data;
+  }
+  _misses.fetch_add(1, std::memory_order_relaxed);
+  return allocateSlab(capacity);
+}
+
+void BufferPool::recycle(uint8_t *data, size_t capacity) {
+  if (data == nullptr) {
+    return;
+  }
+  if (!isClassSize(capacity)) {
+    freeSlab(data);
+    return;
+  }
+  // Reserve room under the limit first so concurrent recycles cannot
+  // overshoot it together.
+  size_t cached = _cachedBytes.fetch_add(capacity, std::memory_order_relaxed);
+  if (cached + capacity > _limit.load(std::memory_order_relaxed)) {
+    _cachedBytes.fetch_sub(capacity, std::memory_order_relaxed);
+    freeSlab(data);
+    return;
+  }
+  size_t index = classFor(capacity);
+  if (ThreadCache *cache = threadCache()) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (cache->slabs[index].size() < threadCacheSlabs(index)) {
+      cache->slabs[index].push_back(data);
+      return;
+    }
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  _depot[index].push_back(data);
+}
+
+std::shared_ptr<ArrayBuffer> BufferPool::adopt(uint8_t *data, size_t size,
+                                               size_t capacity) {
+  _leasedBytes.fetch_add(capacity, std::memory_order_relaxed);
+  _activeLeases.fetch_add(1, std::memory_order_relaxed);
+  return ArrayBuffer::wrap(data, size, [this, data, capacity]() {
+    _leasedBytes.fetch_sub(capacity, std::memory_order_relaxed);
+    _activeLeases.fetch_sub(1, std::memory_order_relaxed);
+    recycle(data, capacity);
+  });
+}
+
+std::shared_ptr<ArrayBuffer> BufferPool::lease(size_t size) {
+  size_t capacity = 0;
+  uint8_t *data = acquire(size, capacity);
+  return adopt(data, size, capacity);
+}
+
+void BufferPool::trim() {
+  std::vector<uint8_t *> slabs;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (ThreadCache *cache : _threadCaches) {
+      std::lock_guard<std::mutex> cacheLock(cache->mutex);
+      for (size_t index = 0; index < kClassCount; index++) {
+        for (uint8_t *data : cache->slabs[index]) {
+          slabs.push_back(data);
+          _cachedBytes.fetch_sub(classSize(index), std::memory_order_relaxed);
+        }
+        cache->slabs[index].clear();
+      }
+    }
+    for (size_t index = 0; index < kClassCount; index++) {
+      for (uint8_t *data : _depot[index]) {
+        slabs.push_back(data);
+        _cachedBytes.fetch_sub(classSize(index), std::memory_order_relaxed);
+      }
+      _depot[index].clear();
+      _depot[index].shrink_to_fit();
+    }
+  }
+  for (uint8_t *data : slabs) {
+    freeSlab(data);
+  }
+  _trims.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BufferPool::setLimit(size_t bytes) {
+  _limit.store(bytes, std::memory_order_relaxed);
+  if (_cachedBytes.load(std::memory_order_relaxed) > bytes) {
+    trim();
+  }
+}
+
+BufferPool::Stats BufferPool::stats() const {
+  Stats s;
+  s.hits = _hits.load(std::memory_order_relaxed);
+  s.misses = _misses.load(std::memory_order_relaxed);
+  s.trims = _trims.load(std::memory_order_relaxed);
+  s.cachedBytes = _cachedBytes.load(std::memory_order_relaxed);
+  s.leasedBytes = _leasedBytes.load(std::memory_order_relaxed);
+  s.activeLeases = _activeLeases.load(std::memory_order_relaxed);
+  s.limitBytes = _limit.load(std::memory_order_relaxed);
+  return s;
+}
+
+} // namespace margelo::nitro::node_fs
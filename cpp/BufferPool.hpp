@@ -0,0 +1,79 @@
+#pragma once
+#include <NitroModules/ArrayBuffer.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * Recycles read buffers so that sustained I/O does not hit the allocator (and,
+ * for large sizes, mmap/munmap plus fresh page faults) once per operation.
+ *
+ * Memory is handed out in page-aligned slabs of power-of-two size classes
+ * from 4 KiB to 4 MiB. A freed slab goes to a small cache of the freeing
+ * thread, then to a shared depot. The total cached is capped by setLimit();
+ * slabs beyond it, and requests above the largest class, go straight back
+ * to the system. trim() drops everything cached, e.g. on a memory warning.
+ */
+class BufferPool {
+public:
+  static constexpr size_t kMinClassSize = 4 << 10;
+  static constexpr size_t kMaxClassSize = 4 << 20;
+  static constexpr size_t kClassCount = 11;
+  static constexpr size_t kDefaultLimit = 32 << 20;
+
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t trims;
+    size_t cachedBytes;
+    size_t leasedBytes;
+    size_t activeLeases;
+    size_t limitBytes;
+  };
+
+  static BufferPool &shared();
+
+  // A slab of at least `size` bytes. `capacity` receives its actual size,
+  // which recycle() needs back.
+  uint8_t *acquire(size_t size, size_t &capacity);
+  void recycle(uint8_t *data, size_t capacity);
+
+  // Wraps an acquired slab as an ArrayBuffer of its first `size` bytes; the
+  // slab is recycled when the buffer is destroyed, and never earlier, since
+  // JS may reach it until then.
+  std::shared_ptr<ArrayBuffer> adopt(uint8_t *data, size_t size,
+                                     size_t capacity);
+  // adopt(acquire(size)).
+  std::shared_ptr<ArrayBuffer> lease(size_t size);
+
+  void trim();
+  void setLimit(size_t bytes);
+  Stats stats() const;
+
+private:
+  struct ThreadCache;
+
+  BufferPool() = default;
+  // Null while this thread is exiting.
+  ThreadCache *threadCache();
+  void retire(ThreadCache &cache);
+
+  std::mutex _mutex; // _depot and _threadCaches
+  std::vector<uint8_t *> _depot[kClassCount];
+  std::vector<ThreadCache *> _threadCaches;
+
+  std::atomic<size_t> _limit{kDefaultLimit};
+  std::atomic<size_t> _cachedBytes{0};
+  std::atomic<size_t> _leasedBytes{0};
+  std::atomic<size_t> _activeLeases{0};
+  std::atomic<uint64_t> _hits{0};
+  std::atomic<uint64_t> _misses{0};
+  std::atomic<uint64_t> _trims{0};
+};
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,480 @@
+#include "BulkIo.hpp"
+#include "FileIO.hpp"
+#include "IoUring.hpp"
+#include "WorkerPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <deque>
+#include <fcntl.h>
+#include <numeric>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#if NITRO_FS_HAS_IO_URING
+#include <sys/sysmacros.h>
+#endif
+
+namespace margelo::nitro::node_fs {
+
+IoEngine resolveIoEngine(IoEngine requested) {
+#if NITRO_FS_HAS_IO_URING
+  if (requested != IoEngine::ThreadPool && IoUring::available()) {
+    return IoEngine::IoUring;
+  }
+#endif
+  (void)requested;
+  return IoEngine::ThreadPool;
+}
+
+const char *ioEngineName(IoEngine engine) {
+  switch (resolveIoEngine(engine)) {
+  case IoEngine::IoUring:
+    return "io_uring";
+  default:
+    return "threadpool";
+  }
+}
+
+namespace {
+
+std::vector<BatchOutcome> runOnPool(const std::vector<std::string> &paths,
+                                    BatchKind kind) {
+  std::vector<BatchRequest> requests(paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    requests[i].kind = kind;
+    requests[i].path = paths[i];
+  }
+  BatchConfig config;
+  config.parallel = true;
+  return runBatch(requests, config);
+}
+
+#if NITRO_FS_HAS_IO_URING
+
+constexpr unsigned kRingEntries = 256;
+// Reads larger than this are split; the SQE length field is 32 bits.
+constexpr size_t kMaxReadChunk = 1u << 30;
+// Read size for files whose size statx can't tell (procfs and the like).
+constexpr size_t kUnknownSizeChunk = 64 * 1024;
+
+// One ring per thread, created on first use. Null if this thread could not
+// get one (e.g. RLIMIT_MEMLOCK on older kernels); callers then fall back.
+IoUring *threadRing() {
+  thread_local std::unique_ptr<IoUring> ring = IoUring::create(kRingEntries);
+  return ring.get();
+}
+
+double toMs(const statx_timestamp &ts) {
+  return static_cast<double>(ts.tv_sec) * 1000.0 +
+         static_cast<double>(ts.tv_nsec) / 1e6;
+}
+
+RNStats toRNStats(const struct statx &sx) {
+  RNStats s{};
+  s.dev = makedev(sx.stx_dev_major, sx.stx_dev_minor);
+  s.ino = sx.stx_ino;
+  s.mode = sx.stx_mode;
+  s.nlink = sx.stx_nlink;
+  s.uid = sx.stx_uid;
+  s.gid = sx.stx_gid;
+  s.rdev = makedev(sx.stx_rdev_major, sx.stx_rdev_minor);
+  s.size = sx.stx_size;
+  s.blksize = sx.stx_blksize;
+  s.blocks = sx.stx_blocks;
+  s.atime_ms = toMs(sx.stx_atime);
+  s.mtime_ms = toMs(sx.stx_mtime);
+  s.ctime_ms = toMs(sx.stx_ctime);
+  s.birthtime_ms = (sx.stx_mask & STATX_BTIME) ? toMs(sx.stx_btime) : 0;
+  return s;
+}
+
+std::vector<BatchOutcome> statManyRing(IoUring &ring,
+                                       const std::vector<std::string> &paths,
+                                       bool followLinks) {
+  const char *opName = followLinks ? "stat" : "lstat";
+  int flags = followLinks ? 0 : AT_SYMLINK_NOFOLLOW;
+  unsigned capacity =
+      std::min(ring.submissionCapacity(), ring.completionCapacity());
+  std::vector<BatchOutcome> outcomes(paths.size());
+  std::vector<struct statx> buffers(paths.size());
+
+  size_t next = 0;
+  size_t done = 0;
+  unsigned inflight = 0;
+  while (done < paths.size()) {
+    while (next < paths.size() && inflight < capacity &&
+           ring.prepStatx(paths[next].c_str(), flags,
+                          STATX_BASIC_STATS | STATX_BTIME, &buffers[next],
+                          next)) {
+      next++;
+      inflight++;
+    }
+    ring.submitAndWait(1);
+    unsigned completed = ring.drain([&](uint64_t index, int result) {
+      BatchOutcome &outcome = outcomes[index];
+      if (result < 0) {
+        outcome.error = -result;
+        outcome.message = errnoMessage(-result, opName, paths[index]);
+      } else {
+        outcome.stats = toRNStats(buffers[index]);
+      }
+    });
+    inflight -= completed;
+    done += completed;
+  }
+  return outcomes;
+}
+
+// Per-file state machine: open and statx are issued together, then reads
+// until the statx size (or EOF for unsized files), then close.
+class RingFileReader {
+public:
+  RingFileReader(IoUring &ring, const std::vector<std::string> &paths)
+      : _ring(ring), _paths(paths), _jobs(paths.size()),
+        _outcomes(paths.size()) {}
+
+  std::vector<BatchOutcome> run() {
+    unsigned maxActive = _ring.submissionCapacity() / 2;
+    unsigned capacity =
+        std::min(_ring.submissionCapacity(), _ring.completionCapacity());
+    size_t next = 0;
+    while (_finished < _paths.size()) {
+      while (next < _paths.size() && _active < maxActive) {
+        _queue.push_back({next, kOpen});
+        _queue.push_back({next, kStat});
+        _jobs[next].pending = 2;
+        next++;
+        _active++;
+      }
+      while (!_queue.empty() && _inflight < capacity &&
+             _ring.submissionSpace() > 0) {
+        prep(_queue.front());
+        _queue.pop_front();
+        _inflight++;
+      }
+      _ring.submitAndWait(_inflight > 0 ? 1 : 0);
+      _inflight -= _ring.drain([this](uint64_t userData, int result) {
+        complete(static_cast<size_t>(userData >> 2),
+                 static_cast<Stage>(userData & 3), result);
+      });
+    }
+    return std::move(_outcomes);
+  }
+
+private:
+  enum Stage : uint8_t { kOpen = 0, kStat = 1, kRead = 2, kClose = 3 };
+
+  struct Job {
+    int fd = -1;
+    int error = 0;
+    unsigned pending = 0;
+    bool sizeKnown = false;
+    uint64_t size = 0;
+    size_t offset = 0;
+    std::vector<uint8_t> bytes;
+    struct statx sx;
+  };
+
+  struct Action {
+    size_t index;
+    Stage stage;
+  };
+
+  void prep(const Action &action) {
+    Job &job = _jobs[action.index];
+    const char *path = _paths[action.index].c_str();
+    uint64_t userData = (static_cast<uint64_t>(action.index) << 2) | action.stage;
+    switch (action.stage) {
+    case kOpen:
+      _ring.prepOpenat(path, O_RDONLY | O_CLOEXEC, 0, userData);
+      break;
+    case kStat:
+      _ring.prepStatx(path, 0, STATX_TYPE | STATX_SIZE, &job.sx, userData);
+      break;
+    case kRead:
+      _ring.prepRead(job.fd, job.bytes.data() + job.offset,
+                     std::min(job.bytes.size() - job.offset, kMaxReadChunk),
+                     job.offset, userData);
+      break;
+    case kClose:
+      _ring.prepClose(job.fd, userData);
+      break;
+    }
+  }
+
+  void fail(Job &job, int error) {
+    if (job.error == 0) {
+      job.error = error;
+    }
+  }
+
+  // Close if open, otherwise finish right away.
+  void close(size_t index) {
+    if (_jobs[index].fd >= 0) {
+      _queue.push_back({index, kClose});
+    } else {
+      finish(index);
+    }
+  }
+
+  void readMore(size_t index) {
+    Job &job = _jobs[index];
+    if (job.offset == job.bytes.size()) {
+      job.bytes.resize(job.offset + kUnknownSizeChunk);
+    }
+    _queue.push_back({index, kRead});
+  }
+
+  void complete(size_t index, Stage stage, int result) {
+    Job &job = _jobs[index];
+    switch (stage) {
+    case kOpen:
+    case kStat:
+      if (result < 0) {
+        fail(job, -result);
+      } else if (stage == kOpen) {
+        job.fd = result;
+      } else if (S_ISDIR(job.sx.stx_mode)) {
+        fail(job, EISDIR);
+      } else {
+        job.size = job.sx.stx_size;
+        job.sizeKnown = S_ISREG(job.sx.stx_mode) && job.size > 0;
+      }
+      if (--job.pending > 0) {
+        return;
+      }
+      if (job.error != 0) {
+        close(index);
+      } else if (job.sizeKnown) {
+        job.bytes.resize(job.size);
+        _queue.push_back({index, kRead});
+      } else {
+        readMore(index);
+      }
+      return;
+    case kRead:
+      if (result < 0) {
+        fail(job, -result);
+        close(index);
+        return;
+      }
+      job.offset += static_cast<size_t>(result);
+      if (result == 0 || (job.sizeKnown && job.offset == job.size)) {
+        // EOF, or everything statx promised. A file that grew meanwhile is
+        // returned as of the statx, like a single read of that size.
+        job.bytes.resize(job.offset);
+        close(index);
+      } else {
+        readMore(index);
+      }
+      return;
+    case kClose:
+      job.fd = -1;
+      finish(index);
+      return;
+    }
+  }
+
+  void finish(size_t index) {
+    Job &job = _jobs[index];
+    BatchOutcome &outcome = _outcomes[index];
+    if (job.error != 0) {
+      outcome.error = job.error;
+      outcome.message = errnoMessage(job.error, "readFile", _paths[index]);
+    } else {
+      outcome.data = ArrayBuffer::copy(job.bytes.data(), job.bytes.size());
+    }
+    std::vector<uint8_t>().swap(job.bytes);
+    _finished++;
+    _active--;
+  }
+
+  IoUring &_ring;
+  const std::vector<std::string> &_paths;
+  std::vector<Job> _jobs;
+  std::vector<BatchOutcome> _outcomes;
+  std::deque<Action> _queue;
+  size_t _finished = 0;
+  unsigned _active = 0;
+  unsigned _inflight = 0;
+};
+
+// Reads every span into place, resubmitting the rest of a short read until
+// EOF. Returns the first errno, after all in-flight reads have completed.
+int readSpansRing(IoUring &ring, int fd, const RangeReadPlan &plan,
+                  uint8_t *dest, std::vector<size_t> &got) {
+  unsigned capacity =
+      std::min(ring.submissionCapacity(), ring.completionCapacity());
+  std::deque<size_t> queue(plan.spans.size());
+  std::iota(queue.begin(), queue.end(), size_t{0});
+  int error = 0;
+  unsigned inflight = 0;
+  while (!queue.empty() || inflight > 0) {
+    while (!queue.empty() && inflight < capacity) {
+      size_t index = queue.front();
+      const RangeReadPlan::Span &span = plan.spans[index];
+      size_t done = got[index];
+      if (!ring.prepRead(fd, dest + span.destOffset + done,
+                         std::min(span.length - done, kMaxReadChunk),
+                         span.position + done, index)) {
+        break;
+      }
+      queue.pop_front();
+      inflight++;
+    }
+    ring.submitAndWait(1);
+    inflight -= ring.drain([&](uint64_t index, int result) {
+      if (result == -EINTR || result == -EAGAIN) {
+        queue.push_back(index);
+      } else if (result < 0) {
+        if (error == 0) {
+          error = -result;
+        }
+      } else {
+        got[index] += static_cast<size_t>(result);
+        if (result > 0 && got[index] < plan.spans[index].length) {
+          queue.push_back(index);
+        }
+      }
+    });
+    if (error != 0) {
+      queue.clear();
+    }
+  }
+  return error;
+}
+
+#endif
+
+int readSpansPool(int fd, const RangeReadPlan &plan, uint8_t *dest,
+                  std::vector<size_t> &got) {
+  std::atomic<int> error{0};
+  parallelFor(plan.spans.size(), 0, [&](size_t index) {
+    const RangeReadPlan::Span &span = plan.spans[index];
+    ssize_t r =
+        preadFully(fd, dest + span.destOffset, span.length, span.position);
+    if (r < 0) {
+      int expected = 0;
+      error.compare_exchange_strong(expected, errno);
+    } else {
+      got[index] = static_cast<size_t>(r);
+    }
+  });
+  return error.load();
+}
+
+} // namespace
+
+std::vector<BatchOutcome> statMany(const std::vector<std::string> &paths,
+                                   bool followLinks, IoEngine engine) {
+#if NITRO_FS_HAS_IO_URING
+  if (resolveIoEngine(engine) == IoEngine::IoUring) {
+    if (IoUring *ring = threadRing()) {
+      return statManyRing(*ring, paths, followLinks);
+    }
+  }
+#endif
+  (void)engine;
+  return runOnPool(paths, followLinks ? BatchKind::Stat : BatchKind::Lstat);
+}
+
+std::vector<BatchOutcome> readFileMany(const std::vector<std::string> &paths,
+                                       IoEngine engine) {
+#if NITRO_FS_HAS_IO_URING
+  if (resolveIoEngine(engine) == IoEngine::IoUring) {
+    if (IoUring *ring = threadRing()) {
+      return RingFileReader(*ring, paths).run();
+    }
+  }
+#endif
+  (void)engine;
+  return runOnPool(paths, BatchKind::ReadFile);
+}
+
+RangeReadPlan planRangeRead(const std::vector<ByteRange> &ranges,
+                            size_t maxGap) {
+  RangeReadPlan plan;
+  plan.offsets.assign(ranges.size(), 0);
+  std::vector<size_t> order;
+  order.reserve(ranges.size());
+  for (size_t i = 0; i < ranges.size(); i++) {
+    // Empty ranges need no bytes; they keep offset 0.
+    if (ranges[i].length > 0) {
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return ranges[a].position < ranges[b].position;
+  });
+
+  for (size_t index : order) {
+    const ByteRange &range = ranges[index];
+    if (!plan.spans.empty()) {
+      RangeReadPlan::Span &span = plan.spans.back();
+      uint64_t spanEnd = span.position + span.length;
+      if (range.position <= spanEnd || range.position - spanEnd <= maxGap) {
+        uint64_t end = range.position + range.length;
+        if (end > spanEnd) {
+          span.length = static_cast<size_t>(end - span.position);
+        }
+        plan.offsets[index] =
+            span.destOffset + static_cast<size_t>(range.position - span.position);
+        continue;
+      }
+      plan.totalSize = span.destOffset + span.length;
+    }
+    plan.spans.push_back({range.position, range.length, plan.totalSize});
+    plan.offsets[index] = plan.totalSize;
+  }
+  if (!plan.spans.empty()) {
+    plan.totalSize = plan.spans.back().destOffset + plan.spans.back().length;
+  }
+  return plan;
+}
+
+RangeReadResult readRanges(int fd, const std::vector<ByteRange> &ranges,
+                           const RangeReadPlan &plan, uint8_t *dest,
+                           IoEngine engine) {
+  std::vector<size_t> got(plan.spans.size(), 0);
+  int error = -1;
+#if NITRO_FS_HAS_IO_URING
+  // A single span is one pread either way; the ring pays off from two.
+  if (plan.spans.size() > 1 &&
+      resolveIoEngine(engine) == IoEngine::IoUring) {
+    if (IoUring *ring = threadRing()) {
+      error = readSpansRing(*ring, fd, plan, dest, got);
+    }
+  }
+#endif
+  (void)engine;
+  if (error < 0) {
+    error = readSpansPool(fd, plan, dest, got);
+  }
+  if (error != 0) {
+    throw std::runtime_error(errnoMessage(error, "read"));
+  }
+
+  RangeReadResult result;
+  result.bytesRead = std::accumulate(got.begin(), got.end(), size_t{0});
+  result.lengths.resize(ranges.size(), 0);
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (ranges[i].length == 0) {
+      continue;
+    }
+    // The span holding this range is the last one starting at or before it.
+    auto it = std::upper_bound(
+        plan.spans.begin(), plan.spans.end(), plan.offsets[i],
+        [](size_t offset, const RangeReadPlan::Span &span) {
+          return offset < span.destOffset;
+        });
+    size_t spanIndex = static_cast<size_t>(it - plan.spans.begin()) - 1;
+    size_t filledEnd = plan.spans[spanIndex].destOffset + got[spanIndex];
+    if (filledEnd > plan.offsets[i]) {
+      result.lengths[i] = std::min(ranges[i].length, filledEnd - plan.offsets[i]);
+    }
+  }
+  return result;
+}
+
+} // namespace margelo::nitro::node_fs
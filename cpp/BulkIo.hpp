@@ -0,0 +1,67 @@
+#pragma once
+#include "BatchOps.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+// How bulk operations are executed.
+//   IoUring:    one io_uring per worker thread; a whole batch costs a handful
+//               of io_uring_enter calls. Linux only; Android always uses
+//               ThreadPool.
+//   ThreadPool: blocking syscalls spread over the shared WorkerPool.
+// Auto picks io_uring when the runtime probe succeeds.
+enum class IoEngine { Auto, IoUring, ThreadPool };
+
+// The engine Auto (or an unavailable IoUring) resolves to.
+IoEngine resolveIoEngine(IoEngine requested);
+const char *ioEngineName(IoEngine engine);
+
+// stat/lstat of every path. Results are in input order; failures are
+// reported per path, as in runBatch().
+std::vector<BatchOutcome> statMany(const std::vector<std::string> &paths,
+                                   bool followLinks,
+                                   IoEngine engine = IoEngine::Auto);
+
+// Whole-file reads of every path.
+std::vector<BatchOutcome> readFileMany(const std::vector<std::string> &paths,
+                                       IoEngine engine = IoEngine::Auto);
+
+// A byte range of an open file.
+struct ByteRange {
+  uint64_t position = 0;
+  size_t length = 0;
+};
+
+// Destination layout for readRanges(). Ranges that overlap, touch, or lie at
+// most `maxGap` bytes apart are merged into one span; spans are packed back
+// to back in file order, so overlapping ranges share destination bytes and
+// every range is contiguous at offsets[i].
+struct RangeReadPlan {
+  struct Span {
+    uint64_t position;
+    size_t length;
+    size_t destOffset;
+  };
+  std::vector<Span> spans;
+  std::vector<size_t> offsets; // per input range
+  size_t totalSize = 0;
+};
+
+RangeReadPlan planRangeRead(const std::vector<ByteRange> &ranges,
+                            size_t maxGap = 0);
+
+struct RangeReadResult {
+  // Bytes available per input range; short only where the file ends early.
+  std::vector<size_t> lengths;
+  size_t bytesRead = 0;
+};
+
+// Positional reads of every span of `plan` into `dest` (plan.totalSize
+// bytes), all in flight at once. Throws std::runtime_error on read failure.
+RangeReadResult readRanges(int fd, const std::vector<ByteRange> &ranges,
+                           const RangeReadPlan &plan, uint8_t *dest,
+                           IoEngine engine = IoEngine::Auto);
+
+} // namespace margelo::nitro::node_fs
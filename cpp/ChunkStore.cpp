@@ -0,0 +1,534 @@
+#include "ChunkStore.hpp"
+#include "FileIO.hpp"
+#include "Sha256.hpp"
+#include "WorkerPool.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+// splitmix64, so the table is reproducible without shipping 2 KiB of data.
+constexpr std::array<uint64_t, 256> makeGearTable() {
+  std::array<uint64_t, 256> table{};
+  uint64_t state = 0x6a09e667f3bcc909ull;
+  for (auto &entry : table) {
+    state += 0x9e3779b97f4a7c15ull;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    entry = z ^ (z >> 31);
+  }
+  return table;
+}
+
+constexpr std::array<uint64_t, 256> kGear = makeGearTable();
+
+// Chunks are cut and hashed in batches of about this many bytes.
+constexpr size_t kBatchSize = 8 << 20;
+
+constexpr uint8_t kManifestVersion = 1;
+constexpr size_t kManifestHeaderSize = 24;
+constexpr size_t kManifestEntrySize = Sha256::kDigestSize + 4;
+
+// The top `bits` bits: they depend on the last 64 input bytes, where the
+// low bits of the gear hash would only see the last few.
+uint64_t topBits(unsigned bits) { return bits == 0 ? 0 : ~0ull << (64 - bits); }
+
+struct DigestHash {
+  size_t operator()(const Sha256::Digest &digest) const {
+    uint64_t value;
+    std::memcpy(&value, digest.data(), sizeof(value));
+    return static_cast<size_t>(value);
+  }
+};
+
+using DigestSet = std::unordered_set<Sha256::Digest, DigestHash>;
+
+struct ManifestEntry {
+  Sha256::Digest digest;
+  uint32_t length;
+};
+
+struct Manifest {
+  uint64_t size = 0;
+  std::vector<ManifestEntry> entries;
+};
+
+void putU32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = static_cast<uint8_t>(v >> (i * 8));
+  }
+}
+
+uint32_t getU32(const uint8_t *p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+         (uint32_t(p[3]) << 24);
+}
+
+std::string toHex(const Sha256::Digest &digest) {
+  static const char kDigits[] = "0123456789abcdef";
+  std::string hex(digest.size() * 2, '0');
+  for (size_t i = 0; i < digest.size(); i++) {
+    hex[i * 2] = kDigits[digest[i] >> 4];
+    hex[i * 2 + 1] = kDigits[digest[i] & 0xf];
+  }
+  return hex;
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+bool fromHex(const std::string &hex, Sha256::Digest &digest) {
+  if (hex.size() != digest.size() * 2) {
+    return false;
+  }
+  for (size_t i = 0; i < digest.size(); i++) {
+    int high = hexValue(hex[i * 2]);
+    int low = hexValue(hex[i * 2 + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    digest[i] = static_cast<uint8_t>(high << 4 | low);
+  }
+  return true;
+}
+
+std::string trimRoot(const std::string &root) {
+  std::string trimmed = root;
+  while (trimmed.size() > 1 && trimmed.back() == '/') {
+    trimmed.pop_back();
+  }
+  return trimmed;
+}
+
+std::string chunksDir(const std::string &root) { return root + "/chunks"; }
+std::string manifestsDir(const std::string &root) { return root + "/manifests"; }
+
+std::string chunkPath(const std::string &root, const Sha256::Digest &digest) {
+  std::string hex = toHex(digest);
+  return chunksDir(root) + "/" + hex.substr(0, 2) + "/" + hex.substr(2);
+}
+
+void checkName(const std::string &name, const char *op) {
+  if (name.empty() || name.size() > 255 || name[0] == '.' ||
+      name.find('/') != std::string::npos ||
+      name.find('\0') != std::string::npos) {
+    throw std::runtime_error(std::string(op) + " failed (invalid name): " +
+                             name);
+  }
+}
+
+// Stores and gc of one root exclude each other within this process.
+std::shared_ptr<std::shared_mutex> rootLock(const std::string &root) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<std::shared_mutex>>
+      locks;
+  std::lock_guard<std::mutex> guard(mutex);
+  std::shared_ptr<std::shared_mutex> lock = locks[root].lock();
+  if (!lock) {
+    lock = std::make_shared<std::shared_mutex>();
+    locks[root] = lock;
+  }
+  return lock;
+}
+
+// Entry names of `dir`, or nothing if it does not exist.
+std::vector<std::string> listDirectory(const std::string &dir,
+                                       const char *op) {
+  std::vector<std::string> names;
+  DirIter *iter = rn_fs_readdir_open(dir.c_str());
+  if (iter == nullptr) {
+    if (errno == ENOENT) {
+      return names;
+    }
+    throw std::runtime_error(std::string(op) + " failed (readdir): " + dir);
+  }
+  while (char *name = rn_fs_readdir_next(iter)) {
+    names.emplace_back(name);
+    rn_fs_free_string(name);
+  }
+  rn_fs_readdir_close(iter);
+  return names;
+}
+
+std::vector<uint8_t> encodeManifest(const Manifest &manifest,
+                                    size_t averageChunkSize) {
+  std::vector<uint8_t> data(kManifestHeaderSize +
+                            manifest.entries.size() * kManifestEntrySize);
+  uint8_t *p = data.data();
+  std::memcpy(p, "NFSM", 4);
+  p[4] = kManifestVersion;
+  putU32(p + 8, static_cast<uint32_t>(averageChunkSize));
+  putU32(p + 12, static_cast<uint32_t>(manifest.entries.size()));
+  putU32(p + 16, static_cast<uint32_t>(manifest.size));
+  putU32(p + 20, static_cast<uint32_t>(manifest.size >> 32));
+  p += kManifestHeaderSize;
+  for (const auto &entry : manifest.entries) {
+    std::memcpy(p, entry.digest.data(), entry.digest.size());
+    putU32(p + entry.digest.size(), entry.length);
+    p += kManifestEntrySize;
+  }
+  return data;
+}
+
+Manifest readManifest(const std::string &path, const char *op) {
+  UniqueFd fd = openForRead(path.c_str());
+  if (!fd) {
+    if (errno == ENOENT) {
+      throw std::runtime_error(std::string(op) + " failed (no such file): " +
+                               path);
+    }
+    throw std::runtime_error(std::string(op) + " failed (open): " + path);
+  }
+  struct stat st;
+  if (::fstat(fd.get(), &st) != 0) {
+    throw std::runtime_error(std::string(op) + " failed (stat): " + path);
+  }
+  std::vector<uint8_t> data(static_cast<size_t>(st.st_size));
+  ssize_t n = readFully(fd.get(), data.data(), data.size());
+  if (n < 0) {
+    throw std::runtime_error(std::string(op) + " failed (read): " + path);
+  }
+
+  auto invalid = [&]() {
+    return std::runtime_error(std::string(op) + " failed (invalid manifest): " +
+                              path);
+  };
+  if (static_cast<size_t>(n) != data.size() ||
+      data.size() < kManifestHeaderSize ||
+      std::memcmp(data.data(), "NFSM", 4) != 0 ||
+      data[4] != kManifestVersion) {
+    throw invalid();
+  }
+  const uint8_t *p = data.data();
+  size_t count = getU32(p + 12);
+  Manifest manifest;
+  manifest.size = uint64_t(getU32(p + 16)) | (uint64_t(getU32(p + 20)) << 32);
+  if (data.size() - kManifestHeaderSize != count * kManifestEntrySize) {
+    throw invalid();
+  }
+  manifest.entries.resize(count);
+  uint64_t total = 0;
+  p += kManifestHeaderSize;
+  for (auto &entry : manifest.entries) {
+    std::memcpy(entry.digest.data(), p, entry.digest.size());
+    entry.length = getU32(p + entry.digest.size());
+    total += entry.length;
+    p += kManifestEntrySize;
+  }
+  if (total != manifest.size) {
+    throw invalid();
+  }
+  return manifest;
+}
+
+void makeDirectory(const std::string &path, const char *op) {
+  if (::mkdir(path.c_str(), 0777) != 0 && errno != EEXIST) {
+    throw std::runtime_error(std::string(op) + " failed (mkdir): " + path);
+  }
+}
+
+} // namespace
+
+Chunker::Chunker(size_t averageSize) {
+  averageSize = std::clamp<size_t>(averageSize, 256, 4 << 20);
+  unsigned bits = 0;
+  while ((size_t{2} << bits) <= averageSize) {
+    bits++;
+  }
+  _averageSize = size_t{1} << bits;
+  _minSize = _averageSize / 4;
+  _maxSize = _averageSize * 4;
+  // Normalized chunking, level 2: two more bits make a cut less likely
+  // before the average size, two fewer more likely after it.
+  _maskSmall = topBits(bits + 2);
+  _maskLarge = topBits(bits - 2);
+}
+
+size_t Chunker::cut(const uint8_t *data, size_t size) const {
+  if (size <= _minSize) {
+    return size;
+  }
+  size_t end = std::min(size, _maxSize);
+  size_t normal = std::min(end, _averageSize);
+  uint64_t hash = 0;
+  size_t i = _minSize;
+  for (; i < normal; i++) {
+    hash = (hash << 1) + kGear[data[i]];
+    if ((hash & _maskSmall) == 0) {
+      return i + 1;
+    }
+  }
+  for (; i < end; i++) {
+    hash = (hash << 1) + kGear[data[i]];
+    if ((hash & _maskLarge) == 0) {
+      return i + 1;
+    }
+  }
+  return end;
+}
+
+StoredFileInfo storeFile(const std::string &rawRoot, const std::string &path,
+                         const std::string &name,
+                         const ChunkStoreConfig &config) {
+  checkName(name, "storeFile");
+  std::string root = trimRoot(rawRoot);
+  Chunker chunker(config.averageChunkSize);
+
+  UniqueFd in = openForRead(path.c_str());
+  if (!in) {
+    throw std::runtime_error("storeFile failed (open): " + path);
+  }
+  if (!rn_fs_mkdir(root.c_str(), 0777, true)) {
+    throw std::runtime_error("storeFile failed (mkdir): " + root);
+  }
+  makeDirectory(chunksDir(root), "storeFile");
+  makeDirectory(manifestsDir(root), "storeFile");
+
+  auto lock = rootLock(root);
+  std::shared_lock<std::shared_mutex> guard(*lock);
+
+  StoredFileInfo info;
+  Manifest manifest;
+  DigestSet handled;
+  bool createdShard[256] = {};
+
+  std::vector<uint8_t> buffer(kBatchSize + chunker.maxSize());
+  uint8_t *data = buffer.data();
+  size_t length = 0;
+  bool eof = false;
+  struct Span {
+    size_t offset;
+    size_t length;
+  };
+  std::vector<Span> spans;
+  std::vector<Sha256::Digest> digests;
+  std::vector<uint8_t> present;
+
+  while (!eof) {
+    ssize_t n = readFully(in.get(), data + length, buffer.size() - length);
+    if (n < 0) {
+      throw std::runtime_error("storeFile failed (read): " + path);
+    }
+    eof = static_cast<size_t>(n) < buffer.size() - length;
+    length += static_cast<size_t>(n);
+
+    // Cut only where a full maxSize() window is available, so chunk
+    // boundaries do not depend on how the file was read.
+    spans.clear();
+    size_t pos = 0;
+    while (pos < length && (eof || length - pos >= chunker.maxSize())) {
+      size_t size = chunker.cut(data + pos, length - pos);
+      spans.push_back({pos, size});
+      pos += size;
+    }
+
+    digests.resize(spans.size());
+    present.assign(spans.size(), 0);
+    parallelFor(spans.size(), config.parallelism, [&](size_t i) {
+      digests[i] = Sha256::hash(data + spans[i].offset, spans[i].length);
+      // A chunk of the wrong size (cut short by a crash before it was
+      // synced) is written again.
+      struct stat st;
+      present[i] = ::stat(chunkPath(root, digests[i]).c_str(), &st) == 0 &&
+                   static_cast<size_t>(st.st_size) == spans[i].length;
+    });
+
+    std::vector<std::string> paths;
+    std::vector<AtomicWriteItem> items;
+    for (size_t i = 0; i < spans.size(); i++) {
+      manifest.entries.push_back(
+          {digests[i], static_cast<uint32_t>(spans[i].length)});
+      if (present[i] || !handled.insert(digests[i]).second) {
+        continue;
+      }
+      uint8_t shard = digests[i][0];
+      if (!createdShard[shard]) {
+        std::string dir = chunksDir(root) + "/" + toHex(digests[i]).substr(0, 2);
+        makeDirectory(dir, "storeFile");
+        createdShard[shard] = true;
+      }
+      items.push_back({chunkPath(root, digests[i]), data + spans[i].offset,
+                       spans[i].length});
+      info.newChunks++;
+      info.writtenBytes += spans[i].length;
+    }
+    if (!items.empty()) {
+      atomicWriteFiles(items, config.level);
+    }
+    info.chunks += spans.size();
+    info.size += pos;
+
+    std::memmove(data, data + pos, length - pos);
+    length -= pos;
+  }
+
+  manifest.size = info.size;
+  std::vector<uint8_t> encoded =
+      encodeManifest(manifest, chunker.averageSize());
+  atomicWriteFiles(
+      {{manifestsDir(root) + "/" + name, encoded.data(), encoded.size()}},
+      config.level);
+  return info;
+}
+
+void restoreFile(const std::string &rawRoot, const std::string &name,
+                 const std::string &dest, size_t parallelism) {
+  checkName(name, "restoreFile");
+  std::string root = trimRoot(rawRoot);
+  auto lock = rootLock(root);
+  std::shared_lock<std::shared_mutex> guard(*lock);
+
+  Manifest manifest =
+      readManifest(manifestsDir(root) + "/" + name, "restoreFile");
+
+  std::string temp = tempPathFor(dest);
+  UniqueFd out = openForWrite(temp.c_str());
+  if (!out) {
+    throw std::runtime_error("restoreFile failed (open): " + dest);
+  }
+  try {
+    std::vector<uint8_t> buffer;
+    std::vector<size_t> offsets;
+    size_t next = 0;
+    while (next < manifest.entries.size()) {
+      // A batch of consecutive chunks, read and verified in parallel.
+      size_t first = next;
+      size_t batchBytes = 0;
+      offsets.clear();
+      while (next < manifest.entries.size() &&
+             (next == first ||
+              batchBytes + manifest.entries[next].length <= kBatchSize)) {
+        offsets.push_back(batchBytes);
+        batchBytes += manifest.entries[next].length;
+        next++;
+      }
+      buffer.resize(batchBytes);
+      parallelFor(next - first, parallelism, [&](size_t i) {
+        const ManifestEntry &entry = manifest.entries[first + i];
+        std::string path = chunkPath(root, entry.digest);
+        UniqueFd fd = openForRead(path.c_str());
+        if (!fd) {
+          throw std::runtime_error("restoreFile failed (missing chunk): " +
+                                   path);
+        }
+        uint8_t *chunk = buffer.data() + offsets[i];
+        ssize_t n = readFully(fd.get(), chunk, entry.length);
+        if (n < 0) {
+          throw std::runtime_error("restoreFile failed (read): " + path);
+        }
+        if (static_cast<size_t>(n) != entry.length ||
+            Sha256::hash(chunk, entry.length) != entry.digest) {
+          throw std::runtime_error("restoreFile failed (corrupt chunk): " +
+                                   path);
+        }
+      });
+      if (!writeFully(out.get(), buffer.data(), batchBytes)) {
+        throw std::runtime_error("restoreFile failed (write): " + dest);
+      }
+    }
+    if (::close(out.release()) != 0) {
+      throw std::runtime_error("restoreFile failed (write): " + dest);
+    }
+    if (rn_fs_rename(temp.c_str(), dest.c_str()) != 0) {
+      throw std::runtime_error("restoreFile failed (rename): " + dest);
+    }
+  } catch (...) {
+    out.reset();
+    rn_fs_unlink(temp.c_str());
+    throw;
+  }
+}
+
+bool removeStoredFile(const std::string &rawRoot, const std::string &name) {
+  checkName(name, "removeStoredFile");
+  std::string path = manifestsDir(trimRoot(rawRoot)) + "/" + name;
+  if (::unlink(path.c_str()) != 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    throw std::runtime_error("removeStoredFile failed (unlink): " + path);
+  }
+  return true;
+}
+
+std::vector<std::string> listStoredFiles(const std::string &rawRoot) {
+  std::vector<std::string> names =
+      listDirectory(manifestsDir(trimRoot(rawRoot)), "listStoredFiles");
+  // Hidden entries are temp files of manifests being written.
+  names.erase(std::remove_if(names.begin(), names.end(),
+                             [](const std::string &name) {
+                               return name.empty() || name[0] == '.';
+                             }),
+              names.end());
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+ChunkGcSummary collectChunkGarbage(const std::string &rawRoot) {
+  std::string root = trimRoot(rawRoot);
+  auto lock = rootLock(root);
+  std::unique_lock<std::shared_mutex> guard(*lock);
+
+  // An unreadable manifest aborts the collection: its chunks cannot be told
+  // apart from garbage.
+  ChunkGcSummary summary;
+  DigestSet live;
+  for (const auto &name : listStoredFiles(root)) {
+    Manifest manifest =
+        readManifest(manifestsDir(root) + "/" + name, "gcChunkStore");
+    for (const auto &entry : manifest.entries) {
+      live.insert(entry.digest);
+    }
+    summary.files++;
+  }
+  summary.liveChunks = live.size();
+
+  std::string chunks = chunksDir(root);
+  for (const auto &shard : listDirectory(chunks, "gcChunkStore")) {
+    if (shard.size() != 2 || hexValue(shard[0]) < 0 || hexValue(shard[1]) < 0) {
+      continue;
+    }
+    std::string dir = chunks + "/" + shard;
+    for (const auto &file : listDirectory(dir, "gcChunkStore")) {
+      Sha256::Digest digest;
+      // Hidden files are temp files left behind by an interrupted store.
+      bool stale = !file.empty() && file[0] == '.';
+      if (!stale && (!fromHex(shard + file, digest) || live.count(digest))) {
+        continue;
+      }
+      std::string path = dir + "/" + file;
+      struct stat st;
+      if (::lstat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        continue;
+      }
+      if (::unlink(path.c_str()) != 0) {
+        throw std::runtime_error("gcChunkStore failed (unlink): " + path);
+      }
+      if (!stale) {
+        summary.removedChunks++;
+      }
+      summary.freedBytes += static_cast<uint64_t>(st.st_size);
+    }
+  }
+  return summary;
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,87 @@
+#pragma once
+#include "AtomicWrite.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * FastCDC content-defined chunker (Xia et al., USENIX ATC '16) with
+ * normalized chunking. A gear hash over the last 64 bytes picks cut points,
+ * so an edit only moves the boundaries next to it and the chunks of
+ * near-duplicate files mostly coincide. The gear table is fixed: changing it
+ * would stop new chunks from matching the ones already stored.
+ */
+class Chunker {
+public:
+  // averageSize is rounded to a power of two in [256, 4 MiB]. Chunks are
+  // between a quarter and four times that size.
+  explicit Chunker(size_t averageSize);
+
+  size_t minSize() const { return _minSize; }
+  size_t averageSize() const { return _averageSize; }
+  size_t maxSize() const { return _maxSize; }
+
+  // Length of the chunk starting at data[0]. Only a final chunk (size <=
+  // maxSize() at end of input) may end without a cut point.
+  size_t cut(const uint8_t *data, size_t size) const;
+
+private:
+  size_t _minSize;
+  size_t _averageSize;
+  size_t _maxSize;
+  uint64_t _maskSmall; // stricter, before averageSize
+  uint64_t _maskLarge; // looser, after it
+};
+
+struct ChunkStoreConfig {
+  size_t averageChunkSize = 64 << 10;
+  SyncLevel level = SyncLevel::Full;
+  size_t parallelism = 0; // 0 = worker pool size
+};
+
+struct StoredFileInfo {
+  uint64_t size = 0;
+  size_t chunks = 0;
+  size_t newChunks = 0;
+  uint64_t writtenBytes = 0; // bytes of new chunks
+};
+
+struct ChunkGcSummary {
+  size_t files = 0;
+  size_t liveChunks = 0;
+  size_t removedChunks = 0;
+  uint64_t freedBytes = 0;
+};
+
+/**
+ * Content-addressed, deduplicating store of files under `root`:
+ *
+ *   root/chunks/ab/cdef...  chunk named by the hex SHA-256 of its bytes
+ *   root/manifests/<name>   chunk list of one stored file
+ *
+ * Storing streams the file through the chunker, hashes the chunks of each
+ * batch on the worker pool and writes only chunks not already present, as
+ * one atomic group commit per batch. The manifest is replaced last, so a
+ * name always refers to a complete file. gc() removes chunks no manifest
+ * references; it waits for stores under the same root in this process, but
+ * must not run while another process writes to the store.
+ *
+ * Names are single path components and may not start with '.'. Errors are
+ * reported by throwing std::runtime_error.
+ */
+StoredFileInfo storeFile(const std::string &root, const std::string &path,
+                         const std::string &name,
+                         const ChunkStoreConfig &config);
+// Chunks are verified against their hash while reading; `dest` is written
+// through a temp file and renamed into place.
+void restoreFile(const std::string &root, const std::string &name,
+                 const std::string &dest, size_t parallelism = 0);
+// False if there is no such file. Its chunks stay until gc().
+bool removeStoredFile(const std::string &root, const std::string &name);
+std::vector<std::string> listStoredFiles(const std::string &root);
+ChunkGcSummary collectChunkGarbage(const std::string &root);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,444 @@
+#include "ContentSearch.hpp"
+#include "FileIO.hpp"
+#include "WorkerPool.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define NITRO_FS_SEARCH_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NITRO_FS_SEARCH_NEON 1
+#endif
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+constexpr size_t kReadChunkSize = 256 << 10;
+// A line longer than this is searched in pieces; a match across a piece
+// boundary is missed.
+constexpr size_t kMaxLineBuffer = 16 << 20;
+constexpr size_t kBinarySniffSize = 8 << 10;
+constexpr size_t kMaxLineText = 1024;
+// std::regex matches recursively, using up to ~1 KiB of stack per input
+// character for patterns like (a|b)*, so long lines are handed to it in
+// windows of this size that also fit 512 KiB thread stacks. Windows overlap
+// by kRegexOverlap, so every match up to that long lies wholly inside one.
+constexpr size_t kRegexWindow = 512;
+constexpr size_t kRegexOverlap = kRegexWindow / 2;
+
+inline uint8_t lowerAscii(uint8_t c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<uint8_t>(c + 32) : c;
+}
+
+inline uint8_t upperAscii(uint8_t c) {
+  return c >= 'a' && c <= 'z' ? static_cast<uint8_t>(c - 32) : c;
+}
+
+} // namespace
+
+SubstringFinder::SubstringFinder(const std::string &needle, bool ignoreCase)
+    : _needle(needle), _ignoreCase(ignoreCase) {
+  if (_ignoreCase) {
+    for (auto &c : _needle) {
+      c = static_cast<char>(lowerAscii(static_cast<uint8_t>(c)));
+    }
+  }
+  uint8_t first = _needle.empty() ? 0 : static_cast<uint8_t>(_needle.front());
+  uint8_t last = _needle.empty() ? 0 : static_cast<uint8_t>(_needle.back());
+  _first[0] = first;
+  _last[0] = last;
+  _first[1] = _ignoreCase ? upperAscii(first) : first;
+  _last[1] = _ignoreCase ? upperAscii(last) : last;
+}
+
+bool SubstringFinder::matchesAt(const uint8_t *data) const {
+  const auto *needle = reinterpret_cast<const uint8_t *>(_needle.data());
+  if (!_ignoreCase) {
+    return std::memcmp(data, needle, _needle.size()) == 0;
+  }
+  for (size_t i = 0; i < _needle.size(); i++) {
+    if (lowerAscii(data[i]) != needle[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t SubstringFinder::find(const uint8_t *data, size_t size) const {
+  const size_t length = _needle.size();
+  if (length == 0) {
+    return 0;
+  }
+  if (size < length) {
+    return std::string::npos;
+  }
+  const size_t last = length - 1;
+  size_t i = 0;
+
+#if defined(NITRO_FS_SEARCH_SSE2)
+  const __m128i first0 = _mm_set1_epi8(static_cast<char>(_first[0]));
+  const __m128i first1 = _mm_set1_epi8(static_cast<char>(_first[1]));
+  const __m128i last0 = _mm_set1_epi8(static_cast<char>(_last[0]));
+  const __m128i last1 = _mm_set1_epi8(static_cast<char>(_last[1]));
+  for (; i + last + 16 <= size; i += 16) {
+    __m128i head =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i tail =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + last));
+    __m128i headHit = _mm_or_si128(_mm_cmpeq_epi8(head, first0),
+                                   _mm_cmpeq_epi8(head, first1));
+    __m128i tailHit = _mm_or_si128(_mm_cmpeq_epi8(tail, last0),
+                                   _mm_cmpeq_epi8(tail, last1));
+    unsigned mask =
+        static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(headHit, tailHit)));
+    while (mask != 0) {
+      unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+      if (matchesAt(data + i + bit)) {
+        return i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+#elif defined(NITRO_FS_SEARCH_NEON)
+  const uint8x16_t first0 = vdupq_n_u8(_first[0]);
+  const uint8x16_t first1 = vdupq_n_u8(_first[1]);
+  const uint8x16_t last0 = vdupq_n_u8(_last[0]);
+  const uint8x16_t last1 = vdupq_n_u8(_last[1]);
+  for (; i + last + 16 <= size; i += 16) {
+    uint8x16_t head = vld1q_u8(data + i);
+    uint8x16_t tail = vld1q_u8(data + i + last);
+    uint8x16_t hit = vandq_u8(
+        vorrq_u8(vceqq_u8(head, first0), vceqq_u8(head, first1)),
+        vorrq_u8(vceqq_u8(tail, last0), vceqq_u8(tail, last1)));
+    // NEON has no movemask: narrowing by 4 leaves one nibble per byte lane;
+    // keeping one bit of each makes the mask iterable like SSE2's.
+    uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+    mask &= 0x8888888888888888ull;
+    while (mask != 0) {
+      unsigned bit = static_cast<unsigned>(__builtin_ctzll(mask)) >> 2;
+      if (matchesAt(data + i + bit)) {
+        return i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  for (; i + last < size; i++) {
+    if ((data[i] == _first[0] || data[i] == _first[1]) && matchesAt(data + i)) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+namespace {
+
+// Stops files that come after the point where the hits of all earlier
+// files already reach maxResults, so the result is the first maxResults
+// hits in input order whatever the scheduling.
+class SearchProgress {
+public:
+  SearchProgress(size_t files, size_t maxResults)
+      : _counts(files, 0), _done(files, false), _maxResults(maxResults) {}
+
+  bool cancelled(size_t file) const {
+    return file > _cutoff.load(std::memory_order_relaxed);
+  }
+
+  void finish(size_t file, size_t hits) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _counts[file] = hits;
+    _done[file] = true;
+    while (_prefix < _done.size() && _done[_prefix]) {
+      _prefixHits += _counts[_prefix];
+      if (_prefixHits >= _maxResults &&
+          _cutoff.load(std::memory_order_relaxed) == SIZE_MAX) {
+        _cutoff.store(_prefix, std::memory_order_relaxed);
+      }
+      _prefix++;
+    }
+  }
+
+private:
+  std::mutex _mutex;
+  std::vector<size_t> _counts;
+  std::vector<bool> _done;
+  size_t _prefix = 0;
+  size_t _prefixHits = 0;
+  size_t _maxResults;
+  std::atomic<size_t> _cutoff{SIZE_MAX};
+};
+
+enum class FileOutcome { Searched, Skipped, Cancelled };
+
+struct Matcher {
+  std::optional<SubstringFinder> literal;
+  std::optional<std::regex> regex;
+};
+
+size_t lineEndFrom(const uint8_t *data, size_t from, size_t size) {
+  const void *newline = std::memchr(data + from, '\n', size - from);
+  return newline == nullptr
+             ? size
+             : static_cast<size_t>(static_cast<const uint8_t *>(newline) - data);
+}
+
+std::string lineText(const uint8_t *data, size_t start, size_t end) {
+  if (end > start && data[end - 1] == '\r') {
+    end--;
+  }
+  end = std::min(end, start + kMaxLineText);
+  return std::string(reinterpret_cast<const char *>(data + start), end - start);
+}
+
+// Scans data[0, size), which starts at a line start at file offset `base`.
+// `line` is the number of that line and is advanced past the region.
+// Returns false once `hits` holds maxResults entries.
+bool scanRegion(const std::string &path, const Matcher &matcher,
+                const uint8_t *data, size_t size, uint64_t base,
+                uint64_t &line, size_t maxResults,
+                std::vector<SearchHit> &hits) {
+  auto report = [&](size_t lineStart, size_t lineEnd, size_t at) {
+    hits.push_back({path, base + at, line, at - lineStart,
+                    lineText(data, lineStart, lineEnd)});
+    return hits.size() < maxResults;
+  };
+
+  size_t pos = 0;
+  if (matcher.literal.has_value()) {
+    while (pos < size) {
+      size_t found = matcher.literal->find(data + pos, size - pos);
+      if (found == std::string::npos) {
+        line += static_cast<uint64_t>(std::count(data + pos, data + size, '\n'));
+        return true;
+      }
+      size_t at = pos + found;
+      size_t lineStart = pos;
+      for (size_t k = at; k > pos; k--) {
+        if (data[k - 1] == '\n') {
+          lineStart = k;
+          break;
+        }
+      }
+      line += static_cast<uint64_t>(std::count(data + pos, data + lineStart, '\n'));
+      size_t lineEnd = lineEndFrom(data, at, size);
+      if (!report(lineStart, lineEnd, at)) {
+        return false;
+      }
+      if (lineEnd == size) {
+        return true;
+      }
+      pos = lineEnd + 1;
+      line++;
+    }
+    return true;
+  }
+
+  const char *text = reinterpret_cast<const char *>(data);
+  while (pos < size) {
+    size_t lineEnd = lineEndFrom(data, pos, size);
+    for (size_t window = pos;; window += kRegexWindow - kRegexOverlap) {
+      size_t windowEnd = std::min(lineEnd, window + kRegexWindow);
+      auto flags = std::regex_constants::match_default;
+      if (window > pos) {
+        // ^ and \b must see that this is not the start of the line.
+        flags |= std::regex_constants::match_not_bol |
+                 std::regex_constants::match_prev_avail;
+      }
+      if (windowEnd < lineEnd) {
+        // Nor may $ or \b match where the window, not the line, ends.
+        flags |= std::regex_constants::match_not_eol |
+                 std::regex_constants::match_not_eow;
+      }
+      std::cmatch match;
+      if (std::regex_search(text + window, text + windowEnd, match,
+                            *matcher.regex, flags)) {
+        size_t at = window + static_cast<size_t>(match.position(0));
+        if (!report(pos, lineEnd, at)) {
+          return false;
+        }
+        break;
+      }
+      if (windowEnd == lineEnd) {
+        break;
+      }
+    }
+    if (lineEnd == size) {
+      break;
+    }
+    pos = lineEnd + 1;
+    line++;
+  }
+  return true;
+}
+
+FileOutcome searchFile(const std::string &path, size_t index,
+                       const Matcher &matcher, size_t maxResults,
+                       const SearchProgress &progress,
+                       std::vector<SearchHit> &hits) {
+  UniqueFd fd = openForRead(path.c_str());
+  if (!fd) {
+    return FileOutcome::Skipped;
+  }
+  std::vector<uint8_t> buffer(kReadChunkSize);
+  size_t length = 0;
+  uint64_t base = 0;
+  uint64_t line = 1;
+  bool first = true;
+  while (true) {
+    if (progress.cancelled(index)) {
+      return FileOutcome::Cancelled;
+    }
+    if (length == buffer.size()) {
+      buffer.resize(buffer.size() * 2); // a line longer than the buffer
+    }
+    size_t want = buffer.size() - length;
+    ssize_t n = readFully(fd.get(), buffer.data() + length, want);
+    if (n < 0) {
+      return first ? FileOutcome::Skipped : FileOutcome::Searched;
+    }
+    bool eof = static_cast<size_t>(n) < want;
+    length += static_cast<size_t>(n);
+    if (first) {
+      first = false;
+      if (std::memchr(buffer.data(), 0, std::min(length, kBinarySniffSize))) {
+        return FileOutcome::Skipped;
+      }
+    }
+
+    // Only whole lines, unless the file ends or a line outgrows the buffer.
+    size_t end = length;
+    if (!eof) {
+      while (end > 0 && buffer[end - 1] != '\n') {
+        end--;
+      }
+      if (end == 0) {
+        if (buffer.size() < kMaxLineBuffer) {
+          continue;
+        }
+        end = length;
+      }
+    }
+    if (!scanRegion(path, matcher, buffer.data(), end, base, line, maxResults,
+                    hits)) {
+      return FileOutcome::Searched;
+    }
+    std::memmove(buffer.data(), buffer.data() + end, length - end);
+    base += end;
+    length -= end;
+    if (eof) {
+      return FileOutcome::Searched;
+    }
+  }
+}
+
+void collectFiles(const std::string &path, bool explicitPath,
+                  std::vector<std::string> &files) {
+  struct stat st;
+  // Paths given by the caller may be symlinks; the walk does not follow them.
+  int result = explicitPath ? ::stat(path.c_str(), &st)
+                            : ::lstat(path.c_str(), &st);
+  if (result != 0) {
+    if (explicitPath) {
+      throw std::runtime_error("searchFiles failed (stat): " + path);
+    }
+    return;
+  }
+  if (S_ISREG(st.st_mode)) {
+    files.push_back(path);
+    return;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    return;
+  }
+  DirIter *iter = rn_fs_readdir_open(path.c_str());
+  if (iter == nullptr) {
+    if (explicitPath) {
+      throw std::runtime_error("searchFiles failed (readdir): " + path);
+    }
+    return;
+  }
+  std::vector<std::string> names;
+  while (char *name = rn_fs_readdir_next(iter)) {
+    names.emplace_back(name);
+    rn_fs_free_string(name);
+  }
+  rn_fs_readdir_close(iter);
+  std::sort(names.begin(), names.end());
+  std::string prefix = path.back() == '/' ? path : path + "/";
+  for (const auto &name : names) {
+    collectFiles(prefix + name, false, files);
+  }
+}
+
+} // namespace
+
+SearchSummary searchFiles(const std::vector<std::string> &paths,
+                          const std::string &pattern,
+                          const SearchConfig &config) {
+  Matcher matcher;
+  if (config.regex) {
+    auto flags = std::regex::ECMAScript | std::regex::optimize;
+    if (config.ignoreCase) {
+      flags |= std::regex::icase;
+    }
+    try {
+      matcher.regex.emplace(pattern, flags);
+    } catch (const std::regex_error &error) {
+      throw std::runtime_error(std::string("searchFiles failed (invalid regex): ") +
+                               error.what());
+    }
+  } else {
+    matcher.literal.emplace(pattern, config.ignoreCase);
+  }
+
+  std::vector<std::string> files;
+  for (const auto &path : paths) {
+    collectFiles(path, true, files);
+  }
+
+  SearchSummary summary;
+  size_t maxResults = std::max<size_t>(config.maxResults, 1);
+  // One hit past the limit tells whether the result is really truncated.
+  size_t limit = maxResults == SIZE_MAX ? maxResults : maxResults + 1;
+  SearchProgress progress(files.size(), limit);
+  std::vector<std::vector<SearchHit>> hits(files.size());
+  std::vector<FileOutcome> outcomes(files.size(), FileOutcome::Cancelled);
+  parallelFor(files.size(), config.parallelism, [&](size_t i) {
+    if (progress.cancelled(i)) {
+      return;
+    }
+    outcomes[i] = searchFile(files[i], i, matcher, limit, progress, hits[i]);
+    progress.finish(i, hits[i].size());
+  });
+
+  for (size_t i = 0; i < files.size(); i++) {
+    if (outcomes[i] == FileOutcome::Searched) {
+      summary.filesSearched++;
+    } else if (outcomes[i] == FileOutcome::Skipped) {
+      summary.filesSkipped++;
+    }
+    for (auto &hit : hits[i]) {
+      if (summary.hits.size() == maxResults) {
+        summary.truncated = true;
+        break;
+      }
+      summary.hits.push_back(std::move(hit));
+    }
+  }
+  return summary;
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * Substring search that tests 16 candidate positions per step (SSE2 or
+ * NEON): the first and last needle bytes are compared against two shifted
+ * loads, and only positions where both match are compared in full.
+ * Case-insensitive search folds ASCII letters only.
+ */
+class SubstringFinder {
+public:
+  SubstringFinder(const std::string &needle, bool ignoreCase);
+
+  // Offset of the first occurrence in data[0, size), or std::string::npos.
+  size_t find(const uint8_t *data, size_t size) const;
+  size_t length() const { return _needle.size(); }
+
+private:
+  bool matchesAt(const uint8_t *data) const;
+
+  std::string _needle; // lowercased when ignoring case
+  bool _ignoreCase;
+  uint8_t _first[2]; // both cases of the first byte
+  uint8_t _last[2];  // and of the last
+};
+
+struct SearchConfig {
+  bool regex = false; // ECMAScript syntax, matched line by line
+  bool ignoreCase = false;
+  size_t maxResults = 1000;
+  size_t parallelism = 0; // 0 = worker pool size
+};
+
+struct SearchHit {
+  std::string path;
+  uint64_t offset = 0; // of the match in the file
+  uint64_t line = 0;   // 1-based
+  size_t column = 0;   // byte offset of the match in the line
+  std::string text;    // the line, without its terminator, capped at 1 KiB
+};
+
+struct SearchSummary {
+  std::vector<SearchHit> hits;
+  size_t filesSearched = 0;
+  size_t filesSkipped = 0; // binary or unreadable
+  bool truncated = false;  // more than maxResults hits exist
+};
+
+/**
+ * Searches every file in `paths`; directories are walked recursively
+ * without following symlinks. Files are streamed in chunks on the worker
+ * pool. A file whose first 8 KiB contain a NUL byte is treated as binary and
+ * skipped. Each matching line is reported once, at its first match. Hits are
+ * ordered by input order, then offset; with maxResults they are the first
+ * ones in that order. Throws std::runtime_error for a missing path or an
+ * invalid regex.
+ */
+SearchSummary searchFiles(const std::vector<std::string> &paths,
+                          const std::string &pattern,
+                          const SearchConfig &config);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,621 @@
+#include "DeltaSync.hpp"
+#include "AtomicWrite.hpp"
+#include "FileCompression.hpp"
+#include "FileIO.hpp"
+#include "Sha256.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+constexpr uint8_t kFormatVersion = 1;
+constexpr size_t kStrongSize = 16;
+constexpr size_t kEntrySize = 4 + kStrongSize;
+constexpr size_t kSignatureHeaderSize = 24;
+constexpr size_t kPatchHeaderSize = 28 + Sha256::kDigestSize;
+constexpr uint8_t kOpCopy = 'C';
+constexpr uint8_t kOpLiteral = 'L';
+constexpr uint8_t kOpEnd = 'E';
+
+void putU32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = static_cast<uint8_t>(v >> (i * 8));
+  }
+}
+
+void putU64(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    p[i] = static_cast<uint8_t>(v >> (i * 8));
+  }
+}
+
+uint32_t getU32(const uint8_t *p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+         (uint32_t(p[3]) << 24);
+}
+
+uint64_t getU64(const uint8_t *p) {
+  return uint64_t(getU32(p)) | (uint64_t(getU32(p + 4)) << 32);
+}
+
+// rsync's rolling checksum: a is the byte sum and b the sum of the running
+// values of a, both mod 2^16. Sliding the window by one byte is O(1).
+struct RollingChecksum {
+  uint32_t a = 0;
+  uint32_t b = 0;
+  uint32_t length = 0;
+
+  void reset(const uint8_t *data, size_t size) {
+    a = 0;
+    b = 0;
+    for (size_t i = 0; i < size; i++) {
+      a += data[i];
+      b += a;
+    }
+    length = static_cast<uint32_t>(size);
+  }
+
+  void roll(uint8_t out, uint8_t in) {
+    a += uint32_t(in) - uint32_t(out);
+    b += a - length * uint32_t(out);
+  }
+
+  uint32_t digest() const { return (a & 0xffff) | (b << 16); }
+};
+
+uint32_t weakChecksum(const uint8_t *data, size_t size) {
+  RollingChecksum sum;
+  sum.reset(data, size);
+  return sum.digest();
+}
+
+void strongHash(const uint8_t *data, size_t size, uint8_t *out) {
+  Sha256::Digest digest = Sha256::hash(data, size);
+  std::memcpy(out, digest.data(), kStrongSize);
+}
+
+void checkBlockSize(size_t blockSize, const char *op) {
+  if (blockSize < kMinDeltaBlockSize || blockSize > kMaxDeltaBlockSize) {
+    throw std::runtime_error(std::string(op) +
+                             " failed (block size must be between " +
+                             std::to_string(kMinDeltaBlockSize) + " and " +
+                             std::to_string(kMaxDeltaBlockSize) + ")");
+  }
+}
+
+uint64_t fileSizeOf(int fd, const std::string &path, const char *op) {
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    throw std::runtime_error(std::string(op) + " failed (stat): " + path);
+  }
+  return static_cast<uint64_t>(st.st_size);
+}
+
+struct Signature {
+  size_t blockSize;
+  uint64_t fileSize;
+  uint32_t blockCount;
+  const uint8_t *entries;
+
+  uint32_t weak(uint32_t block) const {
+    return getU32(entries + size_t(block) * kEntrySize);
+  }
+  const uint8_t *strong(uint32_t block) const {
+    return entries + size_t(block) * kEntrySize + 4;
+  }
+  size_t blockLength(uint32_t block) const {
+    uint64_t start = uint64_t(block) * blockSize;
+    return static_cast<size_t>(std::min<uint64_t>(blockSize, fileSize - start));
+  }
+  // Blocks of exactly blockSize bytes; only the last one may be shorter.
+  uint32_t fullBlocks() const {
+    return static_cast<uint32_t>(fileSize / blockSize);
+  }
+};
+
+Signature parseSignature(const uint8_t *data, size_t size) {
+  auto invalid = []() {
+    return std::runtime_error("fileDelta failed (invalid signature)");
+  };
+  if (data == nullptr || size < kSignatureHeaderSize ||
+      std::memcmp(data, "NFSS", 4) != 0 || data[4] != kFormatVersion ||
+      data[5] != kStrongSize) {
+    throw invalid();
+  }
+  Signature sig;
+  sig.blockSize = getU32(data + 8);
+  sig.blockCount = getU32(data + 12);
+  sig.fileSize = getU64(data + 16);
+  sig.entries = data + kSignatureHeaderSize;
+  if (sig.blockSize < kMinDeltaBlockSize ||
+      sig.blockSize > kMaxDeltaBlockSize ||
+      (sig.fileSize + sig.blockSize - 1) / sig.blockSize != sig.blockCount ||
+      size - kSignatureHeaderSize != size_t(sig.blockCount) * kEntrySize) {
+    throw invalid();
+  }
+  return sig;
+}
+
+// Chained hash table from weak checksum to the full blocks having it.
+class BlockIndex {
+public:
+  explicit BlockIndex(const Signature &sig) : _sig(sig) {
+    uint32_t count = sig.fullBlocks();
+    _bits = 4;
+    while ((size_t{1} << _bits) < size_t(count) * 2) {
+      _bits++;
+    }
+    _heads.assign(size_t{1} << _bits, -1);
+    _next.resize(count);
+    // Inserted backwards so that every chain lists blocks in file order.
+    for (uint32_t block = count; block-- > 0;) {
+      int32_t &head = _heads[bucket(sig.weak(block))];
+      _next[block] = head;
+      head = static_cast<int32_t>(block);
+    }
+  }
+
+  // A full block equal to `window`, preferring `preferred` so that runs of
+  // consecutive blocks coalesce into one copy op. -1 if there is none.
+  int64_t find(uint32_t weak, const uint8_t *window, uint32_t preferred) const {
+    int64_t found = -1;
+    bool hashed = false;
+    uint8_t strong[kStrongSize];
+    for (int32_t block = _heads[bucket(weak)]; block >= 0;
+         block = _next[block]) {
+      uint32_t candidate = static_cast<uint32_t>(block);
+      if (_sig.weak(candidate) != weak) {
+        continue;
+      }
+      if (!hashed) {
+        strongHash(window, _sig.blockSize, strong);
+        hashed = true;
+      }
+      if (std::memcmp(_sig.strong(candidate), strong, kStrongSize) != 0) {
+        continue;
+      }
+      if (candidate == preferred) {
+        return candidate;
+      }
+      if (found < 0) {
+        found = candidate;
+      }
+    }
+    return found;
+  }
+
+private:
+  size_t bucket(uint32_t weak) const {
+    return (weak * 0x9e3779b1u) >> (32 - _bits);
+  }
+
+  const Signature &_sig;
+  unsigned _bits;
+  std::vector<int32_t> _heads;
+  std::vector<int32_t> _next;
+};
+
+class PatchWriter {
+public:
+  PatchWriter(int fd, const std::string &path) : _fd(fd), _path(path) {
+    _buffer.reserve(kCompressionChunkSize);
+  }
+
+  void write(const uint8_t *data, size_t size) {
+    _size += size;
+    if (_buffer.size() + size > kCompressionChunkSize) {
+      flush();
+      if (size >= kCompressionChunkSize) {
+        writeOut(data, size);
+        return;
+      }
+    }
+    _buffer.insert(_buffer.end(), data, data + size);
+  }
+
+  void flush() {
+    writeOut(_buffer.data(), _buffer.size());
+    _buffer.clear();
+  }
+
+  uint64_t size() const { return _size; }
+
+private:
+  void writeOut(const uint8_t *data, size_t size) {
+    if (!writeFully(_fd, data, size)) {
+      throw std::runtime_error("fileDelta failed (write): " + _path);
+    }
+  }
+
+  int _fd;
+  const std::string &_path;
+  std::vector<uint8_t> _buffer;
+  uint64_t _size = 0;
+};
+
+class PatchReader {
+public:
+  PatchReader(int fd, const std::string &path)
+      : _fd(fd), _path(path), _buffer(kCompressionChunkSize) {}
+
+  void read(uint8_t *dest, size_t size) {
+    while (size > 0) {
+      if (_pos == _end) {
+        ssize_t n = readFully(_fd, _buffer.data(), _buffer.size());
+        if (n < 0) {
+          throw std::runtime_error("applyPatch failed (read): " + _path);
+        }
+        if (n == 0) {
+          throw std::runtime_error("applyPatch failed (truncated patch)");
+        }
+        _pos = 0;
+        _end = static_cast<size_t>(n);
+      }
+      size_t take = std::min(size, _end - _pos);
+      std::memcpy(dest, _buffer.data() + _pos, take);
+      _pos += take;
+      dest += take;
+      size -= take;
+    }
+  }
+
+  uint32_t readU32() {
+    uint8_t bytes[4];
+    read(bytes, sizeof(bytes));
+    return getU32(bytes);
+  }
+
+private:
+  int _fd;
+  const std::string &_path;
+  std::vector<uint8_t> _buffer;
+  size_t _pos = 0;
+  size_t _end = 0;
+};
+
+} // namespace
+
+size_t defaultDeltaBlockSize(uint64_t fileSize) {
+  size_t root = static_cast<size_t>(std::sqrt(static_cast<double>(fileSize)));
+  return std::clamp<size_t>((root + 63) & ~size_t{63}, 1 << 10, 64 << 10);
+}
+
+std::vector<uint8_t> fileSignature(const std::string &path,
+                                   size_t blockSize) {
+  UniqueFd fd = openForRead(path.c_str());
+  if (!fd) {
+    throw std::runtime_error("fileSignature failed (open): " + path);
+  }
+  uint64_t expectedSize = fileSizeOf(fd.get(), path, "fileSignature");
+  if (blockSize == 0) {
+    blockSize = defaultDeltaBlockSize(expectedSize);
+  }
+  checkBlockSize(blockSize, "fileSignature");
+
+  std::vector<uint8_t> signature(kSignatureHeaderSize);
+  signature.reserve(kSignatureHeaderSize +
+                    (expectedSize + blockSize - 1) / blockSize * kEntrySize);
+  // Whole blocks per read, so only the final read can end mid-block.
+  size_t chunkSize =
+      std::max(blockSize, kCompressionChunkSize / blockSize * blockSize);
+  std::vector<uint8_t> chunk(chunkSize);
+  uint64_t fileSize = 0;
+  uint64_t blockCount = 0;
+  while (true) {
+    ssize_t n = readFully(fd.get(), chunk.data(), chunk.size());
+    if (n < 0) {
+      throw std::runtime_error("fileSignature failed (read): " + path);
+    }
+    size_t size = static_cast<size_t>(n);
+    for (size_t offset = 0; offset < size; offset += blockSize) {
+      size_t length = std::min(blockSize, size - offset);
+      uint8_t entry[kEntrySize];
+      putU32(entry, weakChecksum(chunk.data() + offset, length));
+      strongHash(chunk.data() + offset, length, entry + 4);
+      signature.insert(signature.end(), entry, entry + kEntrySize);
+      blockCount++;
+    }
+    fileSize += size;
+    if (size < chunk.size()) {
+      break;
+    }
+  }
+  if (blockCount > UINT32_MAX) {
+    throw std::runtime_error("fileSignature failed (too many blocks): " +
+                             path);
+  }
+
+  uint8_t *header = signature.data();
+  std::memcpy(header, "NFSS", 4);
+  header[4] = kFormatVersion;
+  header[5] = kStrongSize;
+  header[6] = 0;
+  header[7] = 0;
+  putU32(header + 8, static_cast<uint32_t>(blockSize));
+  putU32(header + 12, static_cast<uint32_t>(blockCount));
+  putU64(header + 16, fileSize);
+  return signature;
+}
+
+DeltaResult fileDelta(const std::string &path, const uint8_t *signature,
+                      size_t signatureSize, const std::string &patchPath) {
+  Signature sig = parseSignature(signature, signatureSize);
+  const size_t blockSize = sig.blockSize;
+  UniqueFd in = openForRead(path.c_str());
+  if (!in) {
+    throw std::runtime_error("fileDelta failed (open): " + path);
+  }
+  UniqueFd out = openForWrite(patchPath.c_str());
+  if (!out) {
+    throw std::runtime_error("fileDelta failed (open): " + patchPath);
+  }
+
+  DeltaResult result;
+  try {
+    BlockIndex index(sig);
+    PatchWriter writer(out.get(), patchPath);
+    uint8_t header[kPatchHeaderSize] = {};
+    writer.write(header, sizeof(header)); // filled in at the end
+
+    uint32_t copyFirst = 0;
+    uint32_t copyCount = 0;
+    auto flushCopy = [&]() {
+      if (copyCount == 0) {
+        return;
+      }
+      uint8_t op[9] = {kOpCopy};
+      putU32(op + 1, copyFirst);
+      putU32(op + 5, copyCount);
+      writer.write(op, sizeof(op));
+      copyCount = 0;
+    };
+    auto emitCopy = [&](uint32_t block) {
+      if (copyCount > 0 && block == copyFirst + copyCount) {
+        copyCount++;
+      } else {
+        flushCopy();
+        copyFirst = block;
+        copyCount = 1;
+      }
+      result.copiedBytes += sig.blockLength(block);
+    };
+    auto emitLiteral = [&](const uint8_t *data, size_t size) {
+      if (size == 0) {
+        return;
+      }
+      flushCopy();
+      uint8_t op[5] = {kOpLiteral};
+      putU32(op + 1, static_cast<uint32_t>(size));
+      writer.write(op, sizeof(op));
+      writer.write(data, size);
+      result.literalBytes += size;
+    };
+
+    // buffer[literal, pos) is unmatched input, buffer[pos, pos + blockSize)
+    // the window. Refilling flushes the literal and keeps the window.
+    std::vector<uint8_t> buffer(blockSize + kCompressionChunkSize);
+    uint8_t *data = buffer.data();
+    size_t length = 0;
+    size_t pos = 0;
+    size_t literal = 0;
+    bool eof = false;
+    Sha256 targetHash;
+    auto refill = [&]() {
+      emitLiteral(data + literal, pos - literal);
+      std::memmove(data, data + pos, length - pos);
+      length -= pos;
+      pos = 0;
+      literal = 0;
+      ssize_t n = readFully(in.get(), data + length, buffer.size() - length);
+      if (n < 0) {
+        throw std::runtime_error("fileDelta failed (read): " + path);
+      }
+      if (static_cast<size_t>(n) < buffer.size() - length) {
+        eof = true;
+      }
+      targetHash.update(data + length, static_cast<size_t>(n));
+      result.targetSize += static_cast<uint64_t>(n);
+      length += static_cast<size_t>(n);
+    };
+
+    RollingChecksum sum;
+    bool summed = false;
+    while (true) {
+      // Rolling needs the byte after the window too.
+      if (!eof && length - pos <= blockSize) {
+        refill();
+      }
+      if (length - pos < blockSize) {
+        break;
+      }
+      if (!summed) {
+        sum.reset(data + pos, blockSize);
+        summed = true;
+      }
+      uint32_t preferred = copyCount > 0 ? copyFirst + copyCount : UINT32_MAX;
+      int64_t block = index.find(sum.digest(), data + pos, preferred);
+      if (block >= 0) {
+        emitLiteral(data + literal, pos - literal);
+        emitCopy(static_cast<uint32_t>(block));
+        pos += blockSize;
+        literal = pos;
+        summed = false;
+        continue;
+      }
+      if (length - pos == blockSize) {
+        pos++; // last window of the file
+        break;
+      }
+      sum.roll(data[pos], data[pos + blockSize]);
+      pos++;
+    }
+
+    // A short final base block can only match the very end of the input.
+    uint32_t tailBlock = sig.blockCount - 1;
+    size_t tailLength = sig.blockCount > sig.fullBlocks()
+                            ? sig.blockLength(tailBlock)
+                            : 0;
+    size_t end = length;
+    if (tailLength > 0 && length - literal >= tailLength) {
+      const uint8_t *tail = data + length - tailLength;
+      uint8_t strong[kStrongSize];
+      if (weakChecksum(tail, tailLength) == sig.weak(tailBlock)) {
+        strongHash(tail, tailLength, strong);
+        if (std::memcmp(strong, sig.strong(tailBlock), kStrongSize) == 0) {
+          end = length - tailLength;
+        }
+      }
+    }
+    emitLiteral(data + literal, end - literal);
+    if (end < length) {
+      emitCopy(tailBlock);
+    }
+    flushCopy();
+    uint8_t endOp = kOpEnd;
+    writer.write(&endOp, 1);
+    writer.flush();
+    result.patchSize = writer.size();
+
+    std::memcpy(header, "NFSP", 4);
+    header[4] = kFormatVersion;
+    putU32(header + 8, static_cast<uint32_t>(blockSize));
+    putU64(header + 12, sig.fileSize);
+    putU64(header + 20, result.targetSize);
+    Sha256::Digest digest = targetHash.finish();
+    std::memcpy(header + 28, digest.data(), digest.size());
+    if (::pwrite(out.get(), header, sizeof(header), 0) !=
+        static_cast<ssize_t>(sizeof(header))) {
+      throw std::runtime_error("fileDelta failed (write): " + patchPath);
+    }
+  } catch (...) {
+    out.reset();
+    rn_fs_unlink(patchPath.c_str());
+    throw;
+  }
+  return result;
+}
+
+void applyPatch(const std::string &basePath, const std::string &patchPath,
+                const std::string &destPath) {
+  UniqueFd base = openForRead(basePath.c_str());
+  if (!base) {
+    throw std::runtime_error("applyPatch failed (open): " + basePath);
+  }
+  struct stat baseStat;
+  if (::fstat(base.get(), &baseStat) != 0) {
+    throw std::runtime_error("applyPatch failed (stat): " + basePath);
+  }
+  UniqueFd patch = openForRead(patchPath.c_str());
+  if (!patch) {
+    throw std::runtime_error("applyPatch failed (open): " + patchPath);
+  }
+
+  PatchReader reader(patch.get(), patchPath);
+  uint8_t header[kPatchHeaderSize];
+  reader.read(header, sizeof(header));
+  if (std::memcmp(header, "NFSP", 4) != 0 || header[4] != kFormatVersion) {
+    throw std::runtime_error("applyPatch failed (invalid patch): " +
+                             patchPath);
+  }
+  const size_t blockSize = getU32(header + 8);
+  const uint64_t baseSize = getU64(header + 12);
+  const uint64_t targetSize = getU64(header + 20);
+  checkBlockSize(blockSize, "applyPatch");
+  if (baseSize != static_cast<uint64_t>(baseStat.st_size)) {
+    throw std::runtime_error("applyPatch failed (base does not match patch): " +
+                             basePath);
+  }
+  const uint64_t baseBlocks = (baseSize + blockSize - 1) / blockSize;
+
+  std::string temp = tempPathFor(destPath);
+  UniqueFd out = openForWrite(temp.c_str());
+  if (!out) {
+    throw std::runtime_error("applyPatch failed (open): " + destPath);
+  }
+  try {
+    // The rebuilt file is a new version of the base; it keeps its mode.
+    ::fchmod(out.get(), baseStat.st_mode & 07777);
+    Sha256 hash;
+    uint64_t written = 0;
+    auto emit = [&](const uint8_t *data, size_t size) {
+      written += size;
+      if (written > targetSize) {
+        throw std::runtime_error("applyPatch failed (invalid patch): " +
+                                 patchPath);
+      }
+      if (!writeFully(out.get(), data, size)) {
+        throw std::runtime_error("applyPatch failed (write): " + destPath);
+      }
+      hash.update(data, size);
+    };
+
+    std::vector<uint8_t> chunk(kCompressionChunkSize);
+    while (true) {
+      uint8_t op;
+      reader.read(&op, 1);
+      if (op == kOpEnd) {
+        break;
+      }
+      if (op == kOpCopy) {
+        uint64_t first = reader.readU32();
+        uint64_t count = reader.readU32();
+        if (count == 0 || first + count > baseBlocks) {
+          throw std::runtime_error("applyPatch failed (invalid patch): " +
+                                   patchPath);
+        }
+        uint64_t offset = first * blockSize;
+        uint64_t end = std::min((first + count) * blockSize, baseSize);
+        while (offset < end) {
+          size_t size =
+              static_cast<size_t>(std::min<uint64_t>(chunk.size(), end - offset));
+          ssize_t n = preadFully(base.get(), chunk.data(), size, offset);
+          if (n < 0) {
+            throw std::runtime_error("applyPatch failed (read): " + basePath);
+          }
+          if (static_cast<size_t>(n) < size) {
+            throw std::runtime_error(
+                "applyPatch failed (base does not match patch): " + basePath);
+          }
+          emit(chunk.data(), size);
+          offset += size;
+        }
+      } else if (op == kOpLiteral) {
+        size_t remaining = reader.readU32();
+        while (remaining > 0) {
+          size_t size = std::min(chunk.size(), remaining);
+          reader.read(chunk.data(), size);
+          emit(chunk.data(), size);
+          remaining -= size;
+        }
+      } else {
+        throw std::runtime_error("applyPatch failed (invalid patch): " +
+                                 patchPath);
+      }
+    }
+
+    Sha256::Digest digest = hash.finish();
+    if (written != targetSize ||
+        std::memcmp(digest.data(), header + 28, digest.size()) != 0) {
+      throw std::runtime_error(
+          "applyPatch failed (base does not match patch): " + basePath);
+    }
+    if (::close(out.release()) != 0) {
+      throw std::runtime_error("applyPatch failed (write): " + destPath);
+    }
+    if (rn_fs_rename(temp.c_str(), destPath.c_str()) != 0) {
+      throw std::runtime_error("applyPatch failed (rename): " + destPath);
+    }
+  } catch (...) {
+    out.reset();
+    rn_fs_unlink(temp.c_str());
+    throw;
+  }
+}
+
+} // namespace margelo::nitro::node_fs
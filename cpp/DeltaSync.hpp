@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * rsync-style delta transfer of single files.
+ *
+ * The side holding the old copy (the base) computes fileSignature(): a weak
+ * rolling checksum and a truncated SHA-256 per fixed-size block. The side
+ * holding the new copy runs fileDelta() with that signature; it slides a
+ * window over the new file byte by byte and writes a patch of base block
+ * references and literal bytes. applyPatch() rebuilds the new file from the
+ * base and the patch. Every step streams through fixed-size buffers.
+ *
+ * Signature: "NFSS", version, strong hash size, 2 reserved bytes, u32 block
+ * size, u32 block count, u64 file size, then per block a u32 weak checksum
+ * and the strong hash.
+ * Patch: "NFSP", version, 3 reserved bytes, u32 block size, u64 base size,
+ * u64 target size, SHA-256 of the target, then a sequence of ops ending in
+ * 'E': 'C' u32 first block, u32 block count | 'L' u32 length, bytes.
+ * Integers are little-endian.
+ */
+
+constexpr size_t kMinDeltaBlockSize = 64;
+constexpr size_t kMaxDeltaBlockSize = 1 << 20;
+
+// About sqrt(fileSize), as rsync picks it, clamped to [1 KiB, 64 KiB]; this
+// balances signature size against the literal bytes a change costs.
+size_t defaultDeltaBlockSize(uint64_t fileSize);
+
+// blockSize 0 picks defaultDeltaBlockSize(). Throws std::runtime_error.
+std::vector<uint8_t> fileSignature(const std::string &path,
+                                   size_t blockSize = 0);
+
+struct DeltaResult {
+  uint64_t targetSize = 0;
+  uint64_t copiedBytes = 0;  // referenced from the base
+  uint64_t literalBytes = 0; // carried in the patch
+  uint64_t patchSize = 0;
+};
+
+// Writes the patch turning the signature's file into `path` to `patchPath`.
+DeltaResult fileDelta(const std::string &path, const uint8_t *signature,
+                      size_t signatureSize, const std::string &patchPath);
+
+// Rebuilds the patch target from `basePath` into a temp file that is renamed
+// over `destPath`, so destPath may be basePath itself. Throws if the base is
+// not the file the patch was made against or the result fails its checksum.
+void applyPatch(const std::string &basePath, const std::string &patchPath,
+                const std::string &destPath);
+
+} // namespace margelo::nitro::node_fs
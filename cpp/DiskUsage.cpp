@@ -0,0 +1,205 @@
+#include "DiskUsage.hpp"
+#include "PathUtils.hpp"
+#include "WorkerPool.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unordered_set>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+constexpr uint64_t kBlockSize = 512; // st_blocks unit on every platform
+
+struct FileId {
+  uint64_t dev;
+  uint64_t ino;
+  bool operator==(const FileId &other) const {
+    return dev == other.dev && ino == other.ino;
+  }
+};
+
+struct FileIdHash {
+  size_t operator()(const FileId &id) const {
+    return std::hash<uint64_t>()(id.ino * 0x9e3779b97f4a7c15ull ^ id.dev);
+  }
+};
+
+struct PendingDir {
+  std::string path;
+  size_t child; // index into the per-child totals
+  FileId id;
+  uint64_t allocated;
+};
+
+// A file with more than one link, counted once the whole level is merged.
+struct LinkedFile {
+  FileId id;
+  size_t child;
+  DiskUsageTotals totals;
+};
+
+struct DirScan {
+  DiskUsageTotals totals;
+  std::vector<PendingDir> subdirs;
+  std::vector<LinkedFile> linked;
+  uint64_t skipped = 0;
+};
+
+bool listNames(const std::string &dir, std::vector<std::string> &names) {
+  DirIter *iter = rn_fs_readdir_open(dir.c_str());
+  if (iter == nullptr) {
+    return false;
+  }
+  while (char *name = rn_fs_readdir_next(iter)) {
+    names.emplace_back(name);
+    rn_fs_free_string(name);
+  }
+  rn_fs_readdir_close(iter);
+  return true;
+}
+
+bool statEntry(const std::string &path, bool follow, RNStats &st) {
+  if (follow && rn_fs_stat(path.c_str(), &st) == 0) {
+    return true;
+  }
+  // A dangling symlink still counts as the link itself.
+  return rn_fs_lstat(path.c_str(), &st) == 0;
+}
+
+// Tallies one entry into `scan`.
+void scanEntry(const std::string &path, size_t child, const RNStats &st,
+               const DiskUsageConfig &config, DirScan &scan) {
+  if ((st.mode & S_IFMT) == S_IFDIR) {
+    // Directories are counted when they are dequeued, so a linked
+    // directory reached twice is not counted twice.
+    scan.subdirs.push_back(
+        {path, child, {st.dev, st.ino}, st.blocks * kBlockSize});
+    return;
+  }
+  DiskUsageTotals entry;
+  entry.allocated = st.blocks * kBlockSize;
+  entry.files = 1;
+  entry.size = st.size;
+  if (config.countHardlinksOnce && st.nlink > 1) {
+    scan.linked.push_back({{st.dev, st.ino}, child, entry});
+  } else {
+    scan.totals.add(entry);
+  }
+}
+
+DirScan scanDir(const PendingDir &dir, const DiskUsageConfig &config) {
+  DirScan scan;
+  std::vector<std::string> names;
+  if (!listNames(dir.path, names)) {
+    scan.skipped++;
+    return scan;
+  }
+  for (const auto &name : names) {
+    std::string path = joinPath(dir.path, name);
+    RNStats st;
+    if (!statEntry(path, config.followSymlinks, st)) {
+      scan.skipped++; // removed while walking
+      continue;
+    }
+    scanEntry(path, dir.child, st, config, scan);
+  }
+  return scan;
+}
+
+} // namespace
+
+DiskUsageSummary diskUsage(const std::string &path,
+                           const DiskUsageConfig &config) {
+  RNStats rootStat;
+  if (rn_fs_stat(path.c_str(), &rootStat) != 0) {
+    throw std::runtime_error("du failed (stat): " + path);
+  }
+
+  DiskUsageSummary summary;
+  // Slot 0 is the root itself; top-level entries get their own slot when
+  // perChild is set and share slot 0 otherwise.
+  std::vector<DiskUsageTotals> slots(1);
+  std::unordered_set<FileId, FileIdHash> seenFiles;
+  std::unordered_set<FileId, FileIdHash> seenDirs;
+  std::vector<PendingDir> level;
+
+  auto merge = [&](DirScan &scan, size_t slot, std::vector<PendingDir> &next) {
+    slots[slot].add(scan.totals);
+    for (auto &file : scan.linked) {
+      if (seenFiles.insert(file.id).second) {
+        slots[file.child].add(file.totals);
+      }
+    }
+    for (auto &dir : scan.subdirs) {
+      if (!config.followSymlinks || seenDirs.insert(dir.id).second) {
+        next.push_back(std::move(dir));
+      }
+    }
+    summary.skipped += scan.skipped;
+  };
+
+  if ((rootStat.mode & S_IFMT) != S_IFDIR) {
+    DirScan scan;
+    scanEntry(path, 0, rootStat, config, scan);
+    merge(scan, 0, level);
+  } else {
+    seenDirs.insert({rootStat.dev, rootStat.ino});
+    uint64_t rootAllocated = rootStat.blocks * kBlockSize;
+    if (!config.perChild) {
+      level.push_back({path, 0, {rootStat.dev, rootStat.ino}, rootAllocated});
+    } else {
+      // The root is read here so that each top-level entry gets a slot.
+      slots[0].dirs = 1;
+      slots[0].allocated = rootAllocated;
+      DirScan scan;
+      std::vector<std::string> names;
+      if (!listNames(path, names)) {
+        scan.skipped++;
+      }
+      std::sort(names.begin(), names.end());
+      for (const auto &name : names) {
+        std::string childPath = joinPath(path, name);
+        RNStats st;
+        if (!statEntry(childPath, config.followSymlinks, st)) {
+          scan.skipped++;
+          continue;
+        }
+        summary.children.emplace_back(name, DiskUsageTotals());
+        slots.emplace_back();
+        scanEntry(childPath, slots.size() - 1, st, config, scan);
+        // Regular files land in scan.totals; move them to their slot.
+        slots.back().add(scan.totals);
+        scan.totals = DiskUsageTotals();
+      }
+      merge(scan, 0, level);
+    }
+  }
+
+  while (!level.empty()) {
+    for (const auto &dir : level) {
+      slots[dir.child].dirs++;
+      slots[dir.child].allocated += dir.allocated;
+    }
+    std::vector<DirScan> scans(level.size());
+    parallelFor(level.size(), config.parallelism,
+                [&](size_t i) { scans[i] = scanDir(level[i], config); });
+    std::vector<PendingDir> next;
+    for (size_t i = 0; i < level.size(); i++) {
+      merge(scans[i], level[i].child, next);
+    }
+    level = std::move(next);
+  }
+
+  for (size_t i = 0; i < slots.size(); i++) {
+    summary.total.add(slots[i]);
+    if (i > 0) {
+      summary.children[i - 1].second = slots[i];
+    }
+  }
+  return summary;
+}
+
+} // namespace margelo::nitro::node_fs
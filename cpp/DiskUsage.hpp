@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+struct DiskUsageConfig {
+  bool followSymlinks = false;
+  bool countHardlinksOnce = true; // by (dev, ino), like du
+  bool perChild = false;          // break the totals down per top-level entry
+  size_t parallelism = 0;         // 0 = worker pool size
+};
+
+struct DiskUsageTotals {
+  uint64_t size = 0;      // st_size of everything but directories
+  uint64_t allocated = 0; // st_blocks * 512 of every entry
+  uint64_t files = 0;     // non-directory entries
+  uint64_t dirs = 0;
+
+  void add(const DiskUsageTotals &other) {
+    size += other.size;
+    allocated += other.allocated;
+    files += other.files;
+    dirs += other.dirs;
+  }
+};
+
+struct DiskUsageSummary {
+  DiskUsageTotals total;
+  // Top-level entries of the root in name order, if perChild.
+  std::vector<std::pair<std::string, DiskUsageTotals>> children;
+  uint64_t skipped = 0; // entries that could not be stat'ed or read
+};
+
+/**
+ * Disk usage of `path` (a directory, counted in `dirs`, or a single file).
+ * The tree is walked level by level; the directories of each level are read
+ * and stat'ed in parallel on the worker pool. With followSymlinks, linked
+ * directories are entered once each, so cycles terminate. A hard-linked file
+ * reached again is attributed to the first top-level entry that reached it.
+ * Unreadable entries are counted in `skipped` rather than failing the walk;
+ * throws std::runtime_error only if `path` itself cannot be stat'ed.
+ */
+DiskUsageSummary diskUsage(const std::string &path,
+                           const DiskUsageConfig &config);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,143 @@
+#include "FileAdvice.hpp"
+#include "FileIO.hpp"
+#include "WorkerPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace margelo::nitro::node_fs {
+
+#if defined(__APPLE__)
+
+// F_RDADVISE takes an int count, so large ranges are issued in pieces.
+static bool readAdvise(int fd, uint64_t offset, uint64_t length) {
+  while (length > 0) {
+    uint64_t count = std::min<uint64_t>(length, INT_MAX & ~0xfffu);
+    struct radvisory advisory = {};
+    advisory.ra_offset = static_cast<off_t>(offset);
+    advisory.ra_count = static_cast<int>(count);
+    if (::fcntl(fd, F_RDADVISE, &advisory) != 0) {
+      return false;
+    }
+    offset += count;
+    length -= count;
+  }
+  return true;
+}
+
+#endif
+
+void adviseFd(int fd, uint64_t offset, uint64_t length, FileAdvice advice) {
+  if (!fitsFileRange(offset, length)) {
+    throw std::runtime_error("advise failed (range too large)");
+  }
+#if defined(__APPLE__)
+  bool ok = true;
+  switch (advice) {
+  case FileAdvice::Normal:
+  case FileAdvice::Sequential:
+    ok = ::fcntl(fd, F_RDAHEAD, 1) != -1;
+    break;
+  case FileAdvice::Random:
+    ok = ::fcntl(fd, F_RDAHEAD, 0) != -1;
+    break;
+  case FileAdvice::WillNeed: {
+    struct stat st;
+    ok = ::fstat(fd, &st) == 0;
+    uint64_t size = ok ? static_cast<uint64_t>(st.st_size) : 0;
+    if (ok && offset < size) {
+      uint64_t end = length == 0 ? size : std::min(size, offset + length);
+      ok = readAdvise(fd, offset, end - offset);
+    }
+    break;
+  }
+  case FileAdvice::DontNeed:
+    break;
+  }
+  if (!ok) {
+    throw std::runtime_error("advise failed");
+  }
+#else
+  int native = POSIX_FADV_NORMAL;
+  switch (advice) {
+  case FileAdvice::Normal:
+    native = POSIX_FADV_NORMAL;
+    break;
+  case FileAdvice::Sequential:
+    native = POSIX_FADV_SEQUENTIAL;
+    break;
+  case FileAdvice::Random:
+    native = POSIX_FADV_RANDOM;
+    break;
+  case FileAdvice::WillNeed:
+    native = POSIX_FADV_WILLNEED;
+    break;
+  case FileAdvice::DontNeed:
+    native = POSIX_FADV_DONTNEED;
+    break;
+  }
+  // posix_fadvise returns the error instead of setting errno.
+  if (::posix_fadvise(fd, static_cast<off_t>(offset),
+                      static_cast<off_t>(length), native) != 0) {
+    throw std::runtime_error("advise failed");
+  }
+#endif
+}
+
+void advisePath(const std::string &path, uint64_t offset, uint64_t length,
+                FileAdvice advice) {
+  if (advice == FileAdvice::Sequential || advice == FileAdvice::Random) {
+    throw std::runtime_error(
+        "advise failed (sequential/random need a file descriptor): " + path);
+  }
+  UniqueFd fd = openForRead(path.c_str());
+  if (!fd) {
+    throw std::runtime_error("advise failed (open): " + path);
+  }
+  try {
+    adviseFd(fd.get(), offset, length, advice);
+  } catch (const std::exception &) {
+    throw std::runtime_error("advise failed: " + path);
+  }
+}
+
+// Issues read-ahead for all of `fd`; false if the kernel refused.
+static bool prefetchFd(int fd, uint64_t size) {
+#if defined(__APPLE__)
+  return readAdvise(fd, 0, size);
+#else
+  if (::readahead(fd, 0, static_cast<size_t>(size)) == 0) {
+    return true;
+  }
+  // readahead only works on page-cache backed files; let fadvise try.
+  return ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0;
+#endif
+}
+
+PrefetchSummary prefetchFiles(const std::vector<std::string> &paths,
+                              size_t parallelism) {
+  std::atomic<uint64_t> files{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> failed{0};
+  parallelFor(paths.size(), parallelism, [&](size_t i) {
+    UniqueFd fd = openForRead(paths[i].c_str());
+    struct stat st;
+    if (!fd || ::fstat(fd.get(), &st) != 0 || !S_ISREG(st.st_mode) ||
+        !prefetchFd(fd.get(), static_cast<uint64_t>(st.st_size))) {
+      failed.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    files.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(static_cast<uint64_t>(st.st_size),
+                    std::memory_order_relaxed);
+  });
+  PrefetchSummary summary;
+  summary.files = files.load();
+  summary.bytes = bytes.load();
+  summary.failed = failed.load();
+  return summary;
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+enum class FileAdvice { Normal, Sequential, Random, WillNeed, DontNeed };
+
+/**
+ * Page-cache hint for [offset, offset + length) of `fd`; a length of 0
+ * means up to the end of the file. posix_fadvise on Linux and Android. On
+ * Apple platforms Sequential/Random/Normal toggle read-ahead (F_RDAHEAD),
+ * WillNeed issues F_RDADVISE, and DontNeed is accepted but does nothing, as
+ * there is no way to evict a file's pages there. Throws std::runtime_error
+ * if the kernel rejects the hint.
+ */
+void adviseFd(int fd, uint64_t offset, uint64_t length, FileAdvice advice);
+
+/**
+ * adviseFd on a descriptor opened just for the call. Only WillNeed,
+ * DontNeed and Normal are allowed: Sequential and Random describe how one
+ * open file is read and would be lost when it is closed.
+ */
+void advisePath(const std::string &path, uint64_t offset, uint64_t length,
+                FileAdvice advice);
+
+struct PrefetchSummary {
+  uint64_t files = 0;  // files whose read-ahead was issued
+  uint64_t bytes = 0;  // their total size
+  uint64_t failed = 0; // paths that could not be opened or are not files
+};
+
+/**
+ * Pulls whole files into the page cache, in parallel on the worker pool
+ * (0 = pool size): readahead(2) on Linux and Android, which returns once
+ * the reads are queued, and F_RDADVISE on Apple platforms. Missing or
+ * unreadable paths are counted in `failed`; it never throws for them.
+ */
+PrefetchSummary prefetchFiles(const std::vector<std::string> &paths,
+                              size_t parallelism);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,416 @@
+#include "FileCompression.hpp"
+#include "FileIO.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+#ifdef NITRO_FS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+int windowBitsFor(CompressionCodec codec) {
+  switch (codec) {
+  case CompressionCodec::Gzip:
+    return 15 + 16;
+  case CompressionCodec::Zlib:
+    return 15;
+  case CompressionCodec::RawDeflate:
+    return -15;
+  default:
+    return 15 + 32; // zlib or gzip, detected from the header
+  }
+}
+
+// zlib counts input in uInt; feed very large spans in slices.
+constexpr size_t kMaxZlibSlice = 1u << 30;
+
+} // namespace
+
+// --- Compressor ---
+
+struct Compressor::Impl {
+  CompressionCodec codec;
+  ChunkSink sink;
+  std::vector<uint8_t> out;
+  z_stream zs{};
+  bool zInitialized = false;
+#ifdef NITRO_FS_ZSTD
+  ZSTD_CCtx *zstd = nullptr;
+#endif
+
+  ~Impl() {
+    if (zInitialized) {
+      deflateEnd(&zs);
+    }
+#ifdef NITRO_FS_ZSTD
+    if (zstd) {
+      ZSTD_freeCCtx(zstd);
+    }
+#endif
+  }
+
+  void deflateChunk(const uint8_t *data, size_t size, int flush) {
+    zs.next_in = const_cast<Bytef *>(data);
+    zs.avail_in = static_cast<uInt>(size);
+    int ret;
+    do {
+      zs.next_out = out.data();
+      zs.avail_out = static_cast<uInt>(out.size());
+      ret = deflate(&zs, flush);
+      if (ret == Z_STREAM_ERROR) {
+        throw std::runtime_error("deflate failed");
+      }
+      size_t produced = out.size() - zs.avail_out;
+      if (produced > 0) {
+        sink(out.data(), produced);
+      }
+    } while (zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+  }
+
+#ifdef NITRO_FS_ZSTD
+  void zstdChunk(const uint8_t *data, size_t size, ZSTD_EndDirective mode) {
+    ZSTD_inBuffer input = {data, size, 0};
+    size_t remaining;
+    do {
+      ZSTD_outBuffer output = {out.data(), out.size(), 0};
+      remaining = ZSTD_compressStream2(zstd, &output, &input, mode);
+      if (ZSTD_isError(remaining)) {
+        throw std::runtime_error(std::string("zstd compression failed: ") +
+                                 ZSTD_getErrorName(remaining));
+      }
+      if (output.pos > 0) {
+        sink(out.data(), output.pos);
+      }
+    } while (mode == ZSTD_e_end ? remaining != 0 : input.pos < input.size);
+  }
+#endif
+};
+
+Compressor::Compressor(CompressionCodec codec, int level, ChunkSink sink)
+    : _impl(std::make_unique<Impl>()) {
+  _impl->codec = codec;
+  _impl->sink = std::move(sink);
+  _impl->out.resize(kCompressionChunkSize);
+
+  if (codec == CompressionCodec::Zstd) {
+#ifdef NITRO_FS_ZSTD
+    _impl->zstd = ZSTD_createCCtx();
+    if (!_impl->zstd) {
+      throw std::runtime_error("zstd init failed");
+    }
+    ZSTD_CCtx_setParameter(_impl->zstd, ZSTD_c_compressionLevel,
+                           level < 0 ? ZSTD_CLEVEL_DEFAULT : level);
+    return;
+#else
+    throw std::runtime_error("zstd support is not bundled in this build");
+#endif
+  }
+
+  int zlevel = level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9);
+  if (deflateInit2(&_impl->zs, zlevel, Z_DEFLATED, windowBitsFor(codec), 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("deflate init failed");
+  }
+  _impl->zInitialized = true;
+}
+
+Compressor::~Compressor() = default;
+
+void Compressor::write(const uint8_t *data, size_t size) {
+#ifdef NITRO_FS_ZSTD
+  if (_impl->zstd) {
+    _impl->zstdChunk(data, size, ZSTD_e_continue);
+    return;
+  }
+#endif
+  while (size > 0) {
+    size_t slice = std::min(size, kMaxZlibSlice);
+    _impl->deflateChunk(data, slice, Z_NO_FLUSH);
+    data += slice;
+    size -= slice;
+  }
+}
+
+void Compressor::finish() {
+#ifdef NITRO_FS_ZSTD
+  if (_impl->zstd) {
+    _impl->zstdChunk(nullptr, 0, ZSTD_e_end);
+    return;
+  }
+#endif
+  _impl->deflateChunk(nullptr, 0, Z_FINISH);
+}
+
+// --- Decompressor ---
+
+struct Decompressor::Impl {
+  std::optional<CompressionCodec> codec;
+  ChunkSink sink;
+  std::vector<uint8_t> out;
+  std::vector<uint8_t> header; // bytes held back until the format is known
+  bool started = false;
+  bool ended = false;
+  bool gzip = false;
+  z_stream zs{};
+  bool zInitialized = false;
+#ifdef NITRO_FS_ZSTD
+  ZSTD_DCtx *zstd = nullptr;
+  bool inFrame = false;
+#endif
+
+  ~Impl() {
+    if (zInitialized) {
+      inflateEnd(&zs);
+    }
+#ifdef NITRO_FS_ZSTD
+    if (zstd) {
+      ZSTD_freeDCtx(zstd);
+    }
+#endif
+  }
+
+  static bool isZstdMagic(const uint8_t *p) {
+    return p[0] == 0x28 && p[1] == 0xB5 && p[2] == 0x2F && p[3] == 0xFD;
+  }
+
+  void start(const uint8_t *prefix, size_t size) {
+    if (!codec.has_value() && size >= 4 && isZstdMagic(prefix)) {
+      codec = CompressionCodec::Zstd;
+    }
+    if (codec == CompressionCodec::Zstd) {
+#ifdef NITRO_FS_ZSTD
+      zstd = ZSTD_createDCtx();
+      if (!zstd) {
+        throw std::runtime_error("zstd init failed");
+      }
+#else
+      throw std::runtime_error("zstd support is not bundled in this build");
+#endif
+    } else {
+      gzip = codec.has_value() ? codec == CompressionCodec::Gzip
+                               : size >= 2 && prefix[0] == 0x1F && prefix[1] == 0x8B;
+      int windowBits = codec.has_value() ? windowBitsFor(*codec) : 15 + 32;
+      if (inflateInit2(&zs, windowBits) != Z_OK) {
+        throw std::runtime_error("inflate init failed");
+      }
+      zInitialized = true;
+    }
+    started = true;
+  }
+
+  void inflateChunk(const uint8_t *data, size_t size) {
+    zs.next_in = const_cast<Bytef *>(data);
+    zs.avail_in = static_cast<uInt>(size);
+    while (zs.avail_in > 0) {
+      if (ended) {
+        // gzip allows several members back to back, and a member may end
+        // exactly on a chunk boundary, so the next member can start in a
+        // later write. The reset demands a gzip header: anything else after a
+        // member is an error. After a zlib/raw stream it is ignored.
+        if (!gzip) {
+          break;
+        }
+        inflateReset2(&zs, 15 + 16);
+        ended = false;
+      }
+      zs.next_out = out.data();
+      zs.avail_out = static_cast<uInt>(out.size());
+      int ret = inflate(&zs, Z_NO_FLUSH);
+      size_t produced = out.size() - zs.avail_out;
+      if (produced > 0) {
+        sink(out.data(), produced);
+      }
+      if (ret == Z_STREAM_END) {
+        ended = true;
+      } else if (ret == Z_BUF_ERROR) {
+        if (produced == 0) {
+          break; // needs more input
+        }
+      } else if (ret != Z_OK) {
+        throw std::runtime_error(std::string("inflate failed: ") +
+                                 (zs.msg ? zs.msg : "corrupt data"));
+      }
+    }
+    // Drain output that did not fit into the last buffer.
+    while (!ended && zs.avail_out == 0) {
+      zs.next_out = out.data();
+      zs.avail_out = static_cast<uInt>(out.size());
+      int ret = inflate(&zs, Z_NO_FLUSH);
+      size_t produced = out.size() - zs.avail_out;
+      if (produced > 0) {
+        sink(out.data(), produced);
+      }
+      if (ret == Z_STREAM_END) {
+        ended = true;
+      } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        throw std::runtime_error("inflate failed");
+      }
+    }
+  }
+
+#ifdef NITRO_FS_ZSTD
+  void zstdChunk(const uint8_t *data, size_t size) {
+    ZSTD_inBuffer input = {data, size, 0};
+    while (input.pos < input.size) {
+      ZSTD_outBuffer output = {out.data(), out.size(), 0};
+      size_t ret = ZSTD_decompressStream(zstd, &output, &input);
+      if (ZSTD_isError(ret)) {
+        throw std::runtime_error(std::string("zstd decompression failed: ") +
+                                 ZSTD_getErrorName(ret));
+      }
+      if (output.pos > 0) {
+        sink(out.data(), output.pos);
+      }
+      inFrame = ret != 0;
+    }
+    ended = !inFrame;
+  }
+#endif
+
+  void feed(const uint8_t *data, size_t size) {
+#ifdef NITRO_FS_ZSTD
+    if (zstd) {
+      zstdChunk(data, size);
+      return;
+    }
+#endif
+    while (size > 0) {
+      size_t slice = std::min(size, kMaxZlibSlice);
+      inflateChunk(data, slice);
+      data += slice;
+      size -= slice;
+    }
+  }
+};
+
+Decompressor::Decompressor(ChunkSink sink,
+                           std::optional<CompressionCodec> codec)
+    : _impl(std::make_unique<Impl>()) {
+  _impl->codec = codec;
+  _impl->sink = std::move(sink);
+  _impl->out.resize(kCompressionChunkSize);
+}
+
+Decompressor::~Decompressor() = default;
+
+void Decompressor::write(const uint8_t *data, size_t size) {
+  if (!_impl->started) {
+    if (!_impl->codec.has_value() && _impl->header.size() + size < 4) {
+      _impl->header.insert(_impl->header.end(), data, data + size);
+      return;
+    }
+    if (!_impl->header.empty()) {
+      _impl->header.insert(_impl->header.end(), data, data + size);
+      _impl->start(_impl->header.data(), _impl->header.size());
+      std::vector<uint8_t> buffered;
+      buffered.swap(_impl->header);
+      _impl->feed(buffered.data(), buffered.size());
+      return;
+    }
+    _impl->start(data, size);
+  }
+  _impl->feed(data, size);
+}
+
+void Decompressor::finish() {
+  if (!_impl->started && !_impl->header.empty()) {
+    std::vector<uint8_t> buffered;
+    buffered.swap(_impl->header);
+    _impl->start(buffered.data(), buffered.size());
+    _impl->feed(buffered.data(), buffered.size());
+  }
+  if (!_impl->ended) {
+    throw std::runtime_error("unexpected end of compressed data");
+  }
+}
+
+bool Decompressor::done() const { return _impl->ended; }
+
+bool isCodecAvailable(CompressionCodec codec) {
+#ifdef NITRO_FS_ZSTD
+  return true;
+#else
+  return codec != CompressionCodec::Zstd;
+#endif
+}
+
+// --- File helpers ---
+
+namespace {
+
+template <typename Stream>
+void streamFile(const std::string &src, const std::string &dest,
+                const char *op,
+                const std::function<std::unique_ptr<Stream>(ChunkSink)> &make) {
+  UniqueFd in = openForRead(src.c_str());
+  if (!in) {
+    throw std::runtime_error(std::string(op) + " failed (open): " + src);
+  }
+  // Not O_TRUNC yet: truncating `dest` must not destroy `src` when both are
+  // the same file.
+  UniqueFd out(::open(dest.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666));
+  if (!out) {
+    throw std::runtime_error(std::string(op) + " failed (open): " + dest);
+  }
+  struct stat srcSt;
+  struct stat destSt;
+  if (::fstat(in.get(), &srcSt) != 0 || ::fstat(out.get(), &destSt) != 0) {
+    throw std::runtime_error(std::string(op) + " failed (stat): " + dest);
+  }
+  if (srcSt.st_dev == destSt.st_dev && srcSt.st_ino == destSt.st_ino) {
+    throw std::runtime_error(std::string(op) + " failed (same file): " + dest);
+  }
+
+  try {
+    if (::ftruncate(out.get(), 0) != 0) {
+      throw std::runtime_error(std::string(op) + " failed (truncate): " + dest);
+    }
+    int outFd = out.get();
+    auto stream = make([outFd, &dest, op](const uint8_t *data, size_t size) {
+      if (!writeFully(outFd, data, size)) {
+        throw std::runtime_error(std::string(op) + " failed (write): " + dest);
+      }
+    });
+    std::vector<uint8_t> chunk(kCompressionChunkSize);
+    while (true) {
+      ssize_t n = readFully(in.get(), chunk.data(), chunk.size());
+      if (n < 0) {
+        throw std::runtime_error(std::string(op) + " failed (read): " + src);
+      }
+      if (n == 0) {
+        break;
+      }
+      stream->write(chunk.data(), static_cast<size_t>(n));
+    }
+    stream->finish();
+  } catch (...) {
+    out.reset();
+    rn_fs_unlink(dest.c_str());
+    throw;
+  }
+}
+
+} // namespace
+
+void compressFile(const std::string &src, const std::string &dest,
+                  CompressionCodec codec, int level) {
+  streamFile<Compressor>(src, dest, "compressFile", [&](ChunkSink sink) {
+    return std::make_unique<Compressor>(codec, level, std::move(sink));
+  });
+}
+
+void decompressFile(const std::string &src, const std::string &dest) {
+  streamFile<Decompressor>(src, dest, "decompressFile", [](ChunkSink sink) {
+    return std::make_unique<Decompressor>(std::move(sink));
+  });
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+// Codecs understood by the streaming (de)compressors. Zstd is only available
+// when the library is built with NITRO_FS_ZSTD and linked against libzstd.
+enum class CompressionCodec { Gzip, Zlib, RawDeflate, Zstd };
+
+using ChunkSink = std::function<void(const uint8_t *data, size_t size)>;
+
+// Chunk size used for file-to-file streaming; neither side is ever held in
+// memory as a whole.
+constexpr size_t kCompressionChunkSize = 256 * 1024;
+
+/**
+ * Push-style compressor. Every produced output chunk is handed to `sink`.
+ * Errors are reported by throwing std::runtime_error.
+ */
+class Compressor {
+public:
+  Compressor(CompressionCodec codec, int level, ChunkSink sink);
+  ~Compressor();
+  Compressor(const Compressor &) = delete;
+  Compressor &operator=(const Compressor &) = delete;
+
+  void write(const uint8_t *data, size_t size);
+  void finish();
+
+  struct Impl;
+
+private:
+  std::unique_ptr<Impl> _impl;
+};
+
+/**
+ * Push-style decompressor. Without an explicit codec the format is detected
+ * from the first bytes (gzip, zlib or zstd). Concatenated gzip members are
+ * decoded as one stream, like gunzip does.
+ */
+class Decompressor {
+public:
+  explicit Decompressor(ChunkSink sink,
+                        std::optional<CompressionCodec> codec = std::nullopt);
+  ~Decompressor();
+  Decompressor(const Decompressor &) = delete;
+  Decompressor &operator=(const Decompressor &) = delete;
+
+  void write(const uint8_t *data, size_t size);
+  // Throws if the stream ended early.
+  void finish();
+  bool done() const;
+
+  struct Impl;
+
+private:
+  std::unique_ptr<Impl> _impl;
+};
+
+bool isCodecAvailable(CompressionCodec codec);
+
+// File-to-file streaming. `dest` is replaced; it must not be `src` (or a
+// link to it), which is rejected before anything is truncated.
+void compressFile(const std::string &src, const std::string &dest,
+                  CompressionCodec codec, int level);
+void decompressFile(const std::string &src, const std::string &dest);
+
+} // namespace margelo::nitro::node_fs
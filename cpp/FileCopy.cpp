@@ -0,0 +1,297 @@
+#include "FileCopy.hpp"
+#include "AtomicWrite.hpp"
+#include "FileIO.hpp"
+#include "SparseFile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <vector>
+#if defined(__APPLE__)
+#include <copyfile.h>
+#elif defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+[[noreturn]] void fail(const std::string &message, int error = errno) {
+  throw CopyFileError(message, error != 0 ? error : EIO);
+}
+
+void setTimes(int fd, const struct stat &st) {
+#if defined(__APPLE__)
+  struct timespec times[2] = {st.st_atimespec, st.st_mtimespec};
+#else
+  struct timespec times[2] = {st.st_atim, st.st_mtim};
+#endif
+  ::futimens(fd, times);
+}
+
+#if !defined(__APPLE__)
+
+constexpr size_t kChunkSize = 1 << 20;
+
+bool isSparse(int fd, const struct stat &st) {
+  // Fewer allocated blocks than the size is the cheap hint; SEEK_HOLE
+  // confirms it (compressed or inline files can look the same).
+  uint64_t size = static_cast<uint64_t>(st.st_size);
+  if (static_cast<uint64_t>(st.st_blocks) * 512 >= size) {
+    return false;
+  }
+  int64_t hole = seekHole(fd, 0);
+  return hole >= 0 && static_cast<uint64_t>(hole) < size;
+}
+
+enum class RangeCopy { Kernel, Sendfile, Buffered };
+
+// Copies [offset, end) to the same offsets of `out`, stepping down from
+// copy_file_range to sendfile to pread/pwrite as the kernel or filesystem
+// refuses. Returns the offset reached, which is short of `end` only if the
+// source shrank.
+uint64_t copyRange(int in, int out, uint64_t offset, uint64_t end,
+                   RangeCopy &method, std::vector<uint8_t> &buffer) {
+  while (offset < end) {
+    size_t want =
+        static_cast<size_t>(std::min<uint64_t>(end - offset, 1u << 30));
+    ssize_t n = -1;
+#if defined(__linux__)
+#if defined(__NR_copy_file_range)
+    if (method == RangeCopy::Kernel) {
+      // The raw syscall: bionic only wraps copy_file_range from API 34.
+      loff_t inOffset = static_cast<loff_t>(offset);
+      loff_t outOffset = static_cast<loff_t>(offset);
+      n = ::syscall(__NR_copy_file_range, in, &inOffset, out, &outOffset,
+                    want, 0u);
+      if (n < 0 && errno != EINTR) {
+        if (errno != ENOSYS && errno != EXDEV && errno != EINVAL &&
+            errno != EOPNOTSUPP && errno != EPERM) {
+          fail("copyFile failed (copy_file_range)");
+        }
+        method = RangeCopy::Sendfile;
+        continue;
+      }
+    }
+#else
+    if (method == RangeCopy::Kernel) {
+      method = RangeCopy::Sendfile;
+    }
+#endif
+    if (method == RangeCopy::Sendfile) {
+      off_t inOffset = static_cast<off_t>(offset);
+      if (::lseek(out, static_cast<off_t>(offset), SEEK_SET) < 0) {
+        fail("copyFile failed (seek)");
+      }
+      n = ::sendfile(out, in, &inOffset, want);
+      if (n < 0 && errno != EINTR) {
+        if (errno != EINVAL && errno != ENOSYS) {
+          fail("copyFile failed (sendfile)");
+        }
+        method = RangeCopy::Buffered;
+        continue;
+      }
+    }
+#else
+    method = RangeCopy::Buffered;
+#endif
+    if (method == RangeCopy::Buffered) {
+      if (buffer.empty()) {
+        buffer.resize(kChunkSize);
+      }
+      n = preadFully(in, buffer.data(),
+                     std::min<size_t>(want, buffer.size()), offset);
+      if (n < 0) {
+        fail("copyFile failed (read)");
+      }
+      if (n > 0 &&
+          !pwriteFully(out, buffer.data(), static_cast<size_t>(n), offset)) {
+        fail("copyFile failed (write)");
+      }
+    }
+    if (n < 0) {
+      continue; // EINTR
+    }
+    if (n == 0) {
+      break; // the source shrank while copying
+    }
+    offset += static_cast<uint64_t>(n);
+  }
+  return offset;
+}
+
+// Reflinks the whole of `in` into `out` when the mode asks for it. Runs
+// before `out` is truncated, so a clone that fails leaves an existing
+// destination as it was. Returns false if the data still has to be copied.
+bool cloneContents(int in, int out, const struct stat &st, int mode) {
+  if (!(mode & (kCopyFileClone | kCopyFileCloneForce))) {
+    return false;
+  }
+  int error = EOPNOTSUPP;
+#if defined(FICLONE)
+  if (::ioctl(out, FICLONE, in) == 0) {
+    // The clone replaces the first st_size bytes; drop a longer old tail.
+    if (::ftruncate(out, st.st_size) != 0) {
+      fail("copyFile failed (truncate)");
+    }
+    return true;
+  }
+  error = errno;
+#endif
+  if (mode & kCopyFileCloneForce) {
+    fail("copyFile failed (clone not supported)", error);
+  }
+  return false;
+}
+
+void copyContents(int in, int out, const struct stat &st) {
+  uint64_t size = static_cast<uint64_t>(st.st_size);
+  RangeCopy method = RangeCopy::Kernel;
+  std::vector<uint8_t> buffer;
+  if (!isSparse(in, st)) {
+    copyRange(in, out, 0, size, method, buffer);
+    return;
+  }
+  uint64_t offset = 0;
+  while (offset < size) {
+    int64_t data = seekData(in, offset);
+    if (data < 0) {
+      break; // only a trailing hole is left
+    }
+    int64_t hole = seekHole(in, static_cast<uint64_t>(data));
+    uint64_t end = hole < 0 ? size : std::min<uint64_t>(hole, size);
+    uint64_t reached =
+        copyRange(in, out, static_cast<uint64_t>(data), end, method, buffer);
+    offset = std::max<uint64_t>(reached, static_cast<uint64_t>(data) + 1);
+  }
+  // Extends over a trailing hole without allocating it.
+  if (::ftruncate(out, static_cast<off_t>(size)) != 0) {
+    fail("copyFile failed (truncate)");
+  }
+}
+
+#endif
+
+} // namespace
+
+#if defined(__APPLE__)
+
+bool copyRegularFile(const std::string &src, const std::string &dest,
+                     int mode, bool preserveTimestamps) {
+  struct stat st;
+  if (::stat(src.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  struct stat destSt;
+  bool existed = ::stat(dest.c_str(), &destSt) == 0;
+  if (existed && destSt.st_dev == st.st_dev && destSt.st_ino == st.st_ino) {
+    fail("copyFile failed (same file): " + dest, EINVAL);
+  }
+  // clonefile needs a fresh destination, so a clone over an existing file
+  // goes to a sibling temp file that is renamed over it on success; a clone
+  // that fails leaves `dest` as it was. COPYFILE_CLONE falls back to a data
+  // copy (which keeps holes) when cloning is not possible, e.g. across
+  // volumes.
+  bool clone = (mode & (kCopyFileClone | kCopyFileCloneForce)) != 0;
+  std::string target = dest;
+  if (clone && existed && !(mode & kCopyFileExcl)) {
+    target = tempPathFor(dest);
+  }
+  copyfile_flags_t flags = COPYFILE_DATA | COPYFILE_SECURITY;
+  if (mode & kCopyFileCloneForce) {
+    flags |= COPYFILE_CLONE_FORCE;
+  } else if (mode & kCopyFileClone) {
+    flags |= COPYFILE_CLONE;
+  }
+#if defined(COPYFILE_DATA_SPARSE)
+  flags |= COPYFILE_DATA_SPARSE;
+#endif
+  if (mode & kCopyFileExcl) {
+    flags |= COPYFILE_EXCL;
+  }
+  if (::copyfile(src.c_str(), target.c_str(), nullptr, flags) != 0) {
+    int error = errno;
+    if (target != dest ||
+        (!existed && !((mode & kCopyFileExcl) && errno == EEXIST))) {
+      ::unlink(target.c_str());
+    }
+    fail("copyFile failed: " + src + " -> " + dest, error);
+  }
+  if (target != dest && ::rename(target.c_str(), dest.c_str()) != 0) {
+    int error = errno;
+    ::unlink(target.c_str());
+    fail("copyFile failed (rename): " + src + " -> " + dest, error);
+  }
+  if (preserveTimestamps) {
+    UniqueFd out(::open(dest.c_str(), O_WRONLY | O_CLOEXEC));
+    if (out) {
+      setTimes(out.get(), st);
+    }
+  }
+  return true;
+}
+
+#else
+
+bool copyRegularFile(const std::string &src, const std::string &dest,
+                     int mode, bool preserveTimestamps) {
+  UniqueFd in = openForRead(src.c_str());
+  struct stat st;
+  // Size 0 also covers procfs-style files whose contents have no size.
+  if (!in || ::fstat(in.get(), &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size == 0) {
+    return false;
+  }
+
+  // Not O_TRUNC yet: truncating `dest` must not destroy `src` when both are
+  // the same file.
+  int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+  mode_t perms = st.st_mode & 07777;
+  UniqueFd out(::open(dest.c_str(), flags | O_EXCL, perms));
+  bool created = static_cast<bool>(out);
+  if (!created && errno == EEXIST && !(mode & kCopyFileExcl)) {
+    out.reset(::open(dest.c_str(), flags, perms));
+  }
+  if (!out) {
+    fail("copyFile failed (open): " + dest);
+  }
+  try {
+    struct stat destSt;
+    if (::fstat(out.get(), &destSt) != 0) {
+      fail("copyFile failed (stat)");
+    }
+    if (destSt.st_dev == st.st_dev && destSt.st_ino == st.st_ino) {
+      fail("copyFile failed (same file)", EINVAL);
+    }
+    if (!cloneContents(in.get(), out.get(), st, mode)) {
+      if (::ftruncate(out.get(), 0) != 0) {
+        fail("copyFile failed (truncate)");
+      }
+      copyContents(in.get(), out.get(), st);
+    }
+    // An existing dest keeps its own mode otherwise, and a created one may
+    // have lost bits to the umask.
+    if (::fchmod(out.get(), perms) != 0) {
+      fail("copyFile failed (chmod)");
+    }
+  } catch (const std::exception &e) {
+    const auto *failure = dynamic_cast<const CopyFileError *>(&e);
+    int error = failure != nullptr ? failure->error() : EIO;
+    if (created) {
+      ::unlink(dest.c_str());
+    }
+    fail(std::string(e.what()) + ": " + src + " -> " + dest, error);
+  }
+  if (preserveTimestamps) {
+    setTimes(out.get(), st);
+  }
+  return true;
+}
+
+#endif
+
+} // namespace margelo::nitro::node_fs
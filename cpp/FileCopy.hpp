@@ -0,0 +1,44 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+// fs.constants.COPYFILE_* (the `mode` of copyFile and cp).
+constexpr int kCopyFileExcl = 1;
+constexpr int kCopyFileClone = 2;      // try a reflink, fall back to copying
+constexpr int kCopyFileCloneForce = 4; // fail if a reflink is not possible
+
+// What copyRegularFile throws. error() is the errno of the call that failed,
+// taken before any cleanup could overwrite it.
+class CopyFileError : public std::runtime_error {
+public:
+  CopyFileError(const std::string &message, int error)
+      : std::runtime_error(message), _error(error) {}
+  int error() const { return _error; }
+
+private:
+  int _error;
+};
+
+/**
+ * Copies the regular file `src` to `dest` without streaming the bytes
+ * through user space where the platform allows:
+ *
+ * - with kCopyFileClone(Force), a copy-on-write clone (FICLONE on btrfs and
+ *   XFS, clonefile on APFS) that shares the source's blocks;
+ * - otherwise copy_file_range, then sendfile, then a read/write loop; a
+ *   sparse source is copied region by region so the copy keeps its holes.
+ *
+ * The copy gets the source's permission bits and, with preserveTimestamps,
+ * its access and modification times. Returns false without touching `dest`
+ * if `src` is not a regular file with a size (or cannot be opened), leaving
+ * the caller's regular copy path to handle it. Throws CopyFileError if
+ * `dest` exists with kCopyFileExcl, if `dest` is `src`, if a forced clone
+ * is not possible, or on I/O errors; a `dest` created by the failed call is
+ * removed, and an existing one is left untouched by a failed clone.
+ */
+bool copyRegularFile(const std::string &src, const std::string &dest,
+                     int mode, bool preserveTimestamps);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,145 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace margelo::nitro::node_fs {
+
+// 32-bit Android gets a 64-bit off_t from _FILE_OFFSET_BITS=64 (see
+// android/CMakeLists.txt); every other target has one natively.
+static_assert(sizeof(off_t) == 8, "build with -D_FILE_OFFSET_BITS=64");
+
+// Whether [offset, offset + length) is addressable through off_t. Offsets
+// from JS arrive as uint64_t and would turn negative when cast.
+inline bool fitsFileRange(uint64_t offset, uint64_t length = 0) {
+  constexpr uint64_t kMax = static_cast<uint64_t>(INT64_MAX);
+  return offset <= kMax && length <= kMax - offset;
+}
+
+// Small POSIX helpers for file descriptors that never leave native code.
+// Descriptors handed to JS still go through rn_fs_open/rn_fs_close.
+
+class UniqueFd {
+public:
+  UniqueFd() = default;
+  explicit UniqueFd(int fd) : _fd(fd) {}
+  UniqueFd(const UniqueFd &) = delete;
+  UniqueFd &operator=(const UniqueFd &) = delete;
+  UniqueFd(UniqueFd &&other) noexcept : _fd(other.release()) {}
+  UniqueFd &operator=(UniqueFd &&other) noexcept {
+    if (this != &other) {
+      reset(other.release());
+    }
+    return *this;
+  }
+  ~UniqueFd() { reset(); }
+
+  int get() const { return _fd; }
+  explicit operator bool() const { return _fd >= 0; }
+
+  int release() {
+    int fd = _fd;
+    _fd = -1;
+    return fd;
+  }
+
+  void reset(int fd = -1) {
+    if (_fd >= 0) {
+      ::close(_fd);
+    }
+    _fd = fd;
+  }
+
+private:
+  int _fd = -1;
+};
+
+inline UniqueFd openForRead(const char *path) {
+  return UniqueFd(::open(path, O_RDONLY | O_CLOEXEC));
+}
+
+inline UniqueFd openForWrite(const char *path, mode_t mode = 0666) {
+  return UniqueFd(
+      ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode));
+}
+
+// Writes all bytes, retrying on EINTR and short writes.
+inline bool writeFully(int fd, const uint8_t *data, size_t size) {
+  while (size > 0) {
+    ssize_t r = ::write(fd, data, size);
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += r;
+    size -= static_cast<size_t>(r);
+  }
+  return true;
+}
+
+// Reads until `size` bytes or EOF. Returns the byte count, or -1 on error.
+inline ssize_t readFully(int fd, uint8_t *data, size_t size) {
+  size_t total = 0;
+  while (total < size) {
+    ssize_t r = ::read(fd, data + total, size - total);
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (r == 0)
+      break;
+    total += static_cast<size_t>(r);
+  }
+  return static_cast<ssize_t>(total);
+}
+
+// Positional variant of readFully; does not move the file offset.
+inline ssize_t preadFully(int fd, uint8_t *data, size_t size,
+                          uint64_t offset) {
+  if (!fitsFileRange(offset, size)) {
+    errno = EOVERFLOW;
+    return -1;
+  }
+  size_t total = 0;
+  while (total < size) {
+    ssize_t r = ::pread(fd, data + total, size - total,
+                        static_cast<off_t>(offset + total));
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (r == 0)
+      break;
+    total += static_cast<size_t>(r);
+  }
+  return static_cast<ssize_t>(total);
+}
+
+// Positional variant of writeFully; does not move the file offset.
+inline bool pwriteFully(int fd, const uint8_t *data, size_t size,
+                        uint64_t offset) {
+  if (!fitsFileRange(offset, size)) {
+    errno = EOVERFLOW;
+    return false;
+  }
+  while (size > 0) {
+    ssize_t r = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += r;
+    size -= static_cast<size_t>(r);
+    offset += static_cast<uint64_t>(r);
+  }
+  return true;
+}
+
+} // namespace margelo::nitro::node_fs
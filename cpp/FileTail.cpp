@@ -0,0 +1,198 @@
+#include "FileTail.hpp"
+#include "PathUtils.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace margelo::nitro::node_fs {
+
+static void onParentChange(void *context, const char *, int32_t) {
+  // Any event in the directory is only a hint: check() stats the path, so
+  // events for other files cost one stat.
+  auto *tail = static_cast<FileTail *>(context);
+  tail->notifyChanged();
+}
+
+FileTail::FileTail(std::string path, const TailConfig &config, Sink sink)
+    : _path(std::move(path)), _config(config), _sink(std::move(sink)) {
+  _config.maxBatchBytes = std::max<size_t>(_config.maxBatchBytes, 4096);
+  _config.pollIntervalMs = std::max<uint32_t>(_config.pollIntervalMs, 10);
+  _buffer.resize(_config.maxBatchBytes);
+  if (openCurrent() && _config.fromEnd) {
+    RNStats st;
+    if (rn_fs_fstat(_fd.get(), &st) == 0) {
+      _offset.store(st.size, std::memory_order_relaxed);
+    }
+  }
+
+  // The parent directory, so that rotation and re-creation are seen too.
+  std::string dir = parentOf(_path);
+  if (dir.empty()) {
+    dir = _path.compare(0, 1, "/") == 0 ? "/" : ".";
+  }
+  // Without a watcher the thread still polls.
+  _watcher = rn_fs_watch(dir.c_str(), this, onParentChange);
+  _thread = std::thread([this]() { run(); });
+}
+
+FileTail::~FileTail() { close(); }
+
+void FileTail::notifyChanged() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _changed = true;
+  _wake.notify_one();
+}
+
+void FileTail::close() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_closing) {
+      return;
+    }
+    _closing = true;
+    _wake.notify_one();
+  }
+  if (_watcher != nullptr) {
+    rn_fs_unwatch(_watcher);
+    _watcher = nullptr;
+  }
+  if (_thread.joinable()) {
+    if (_thread.get_id() == std::this_thread::get_id()) {
+      _thread.detach(); // called from the sink; run() exits on return
+    } else {
+      _thread.join();
+    }
+  }
+}
+
+void FileTail::run() {
+  check();
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_closing) {
+    _wake.wait_for(lock, std::chrono::milliseconds(_config.pollIntervalMs),
+                   [this]() { return _closing || _changed; });
+    if (_closing) {
+      break;
+    }
+    _changed = false;
+    lock.unlock();
+    check();
+    lock.lock();
+  }
+}
+
+bool FileTail::openCurrent() {
+  UniqueFd fd = openForRead(_path.c_str());
+  RNStats st;
+  if (!fd || rn_fs_fstat(fd.get(), &st) != 0) {
+    return false;
+  }
+  _fd = std::move(fd);
+  _dev = st.dev;
+  _ino = st.ino;
+  _offset.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+void FileTail::check() {
+  RNStats st;
+  bool exists = rn_fs_stat(_path.c_str(), &st) == 0;
+  if (!_fd) {
+    if (exists && openCurrent()) {
+      drain();
+    }
+    return;
+  }
+  if (exists && st.dev == _dev && st.ino == _ino) {
+    if (st.size < offset()) {
+      _offset.store(0, std::memory_order_relaxed);
+      _partial.clear();
+      _pendingChange = TailChange::Truncated;
+    }
+    drain();
+    if (_pendingChange != TailChange::None) {
+      emit(nullptr, 0, false); // truncated to empty
+    }
+    return;
+  }
+  // Renamed or removed: whatever was appended to the old file before that
+  // still belongs to the stream. The old descriptor is kept until a new
+  // file appears, in case its writer has not reopened yet.
+  drain();
+  if (!exists) {
+    return;
+  }
+  emit(nullptr, 0, true);
+  if (!openCurrent()) {
+    return;
+  }
+  _pendingChange = TailChange::Rotated;
+  drain();
+  if (_pendingChange != TailChange::None) {
+    emit(nullptr, 0, false); // the new file is still empty
+  }
+}
+
+void FileTail::drain() {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_closing) {
+        return;
+      }
+    }
+    uint64_t offset = this->offset();
+    ssize_t n = preadFully(_fd.get(), _buffer.data(), _buffer.size(), offset);
+    if (n <= 0) {
+      return; // read errors are retried on the next event
+    }
+    _offset.store(offset + static_cast<uint64_t>(n), std::memory_order_relaxed);
+    emit(_buffer.data(), static_cast<size_t>(n), false);
+    if (static_cast<size_t>(n) < _buffer.size()) {
+      return;
+    }
+  }
+}
+
+// Hands `data` to the sink. In line mode an unterminated tail is held back
+// until its newline arrives, unless `flushPartial` (the file is finished) or
+// it has grown to maxBatchBytes.
+void FileTail::emit(const uint8_t *data, size_t size, bool flushPartial) {
+  TailChunk chunk;
+  chunk.offset = offset();
+  chunk.change = _pendingChange;
+  if (!_config.lines) {
+    chunk.bytes.assign(data, data + size);
+  } else {
+    if (size > 0) {
+      _partial.append(reinterpret_cast<const char *>(data), size);
+    }
+    size_t start = 0;
+    while (true) {
+      size_t newline = _partial.find('\n', start);
+      if (newline == std::string::npos) {
+        break;
+      }
+      size_t end = newline > start && _partial[newline - 1] == '\r'
+                       ? newline - 1
+                       : newline;
+      chunk.lines.emplace_back(_partial, start, end - start);
+      start = newline + 1;
+    }
+    _partial.erase(0, start);
+    if (!_partial.empty() &&
+        (flushPartial || _partial.size() >= _config.maxBatchBytes)) {
+      chunk.lines.push_back(std::move(_partial));
+      _partial.clear();
+    }
+  }
+  if (chunk.bytes.empty() && chunk.lines.empty() &&
+      chunk.change == TailChange::None) {
+    return;
+  }
+  _pendingChange = TailChange::None;
+  _sink(std::move(chunk));
+}
+
+} // namespace margelo::nitro::node_fs
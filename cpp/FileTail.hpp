@@ -0,0 +1,90 @@
+#pragma once
+#include "FileIO.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct WatcherHandle;
+
+namespace margelo::nitro::node_fs {
+
+enum class TailChange : uint8_t { None, Truncated, Rotated };
+
+struct TailConfig {
+  bool fromEnd = true; // start at the current end instead of offset 0
+  bool lines = false;  // deliver complete lines instead of raw bytes
+  uint32_t pollIntervalMs = 1000;
+  size_t maxBatchBytes = 1 << 20;
+};
+
+struct TailChunk {
+  uint64_t offset = 0; // offset in the current file after this chunk
+  TailChange change = TailChange::None;
+  std::vector<uint8_t> bytes;     // raw mode
+  std::vector<std::string> lines; // line mode, without "\n" / "\r\n"
+};
+
+/**
+ * Follows a growing file, like `tail -F`.
+ *
+ * A background thread sleeps until the watcher on the parent directory
+ * reports an event (or `pollIntervalMs` passes, for backends that coalesce
+ * or drop events), then compares the path's inode and size with the open
+ * descriptor and preads only the bytes past the last offset. A smaller size
+ * on the same inode is a truncation (restart at 0); another inode at the
+ * path is a rotation: the rest of the old file is delivered first, then the
+ * new file is read from 0. The sink runs on the background thread.
+ */
+class FileTail {
+public:
+  using Sink = std::function<void(TailChunk &&chunk)>;
+
+  FileTail(std::string path, const TailConfig &config, Sink sink);
+  ~FileTail();
+
+  FileTail(const FileTail &) = delete;
+  FileTail &operator=(const FileTail &) = delete;
+
+  uint64_t offset() const { return _offset.load(std::memory_order_relaxed); }
+
+  // Stops the thread and the watcher. Idempotent; may be called from the
+  // sink as long as the FileTail outlives the call.
+  void close();
+
+  // Wakes the thread for a check; called by the directory watcher.
+  void notifyChanged();
+
+private:
+  void run();
+  void check();
+  bool openCurrent();
+  void drain();
+  void emit(const uint8_t *data, size_t size, bool flushPartial);
+
+  std::string _path;
+  TailConfig _config;
+  Sink _sink;
+
+  // Only touched by the tail thread after construction.
+  UniqueFd _fd;
+  uint64_t _dev = 0;
+  uint64_t _ino = 0;
+  TailChange _pendingChange = TailChange::None;
+  std::string _partial;
+  std::vector<uint8_t> _buffer;
+  std::atomic<uint64_t> _offset{0};
+
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  bool _changed = false;
+  bool _closing = false;
+  WatcherHandle *_watcher = nullptr;
+  std::thread _thread;
+};
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,240 @@
+#include "FsMetrics.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+const char *fsOpName(FsOp op) {
+  static const char *const kNames[] = {
+#define NITRO_FS_OP_NAME(id, name) name,
+      NITRO_FS_OPS(NITRO_FS_OP_NAME)
+#undef NITRO_FS_OP_NAME
+  };
+  size_t index = static_cast<size_t>(op);
+  return index < kFsOpCount ? kNames[index] : "unknown";
+}
+
+uint64_t FsOpSnapshot::percentileNs(double q) const {
+  if (calls == 0 || buckets.empty()) {
+    return 0;
+  }
+  uint64_t target = static_cast<uint64_t>(
+      std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(calls)));
+  target = std::max<uint64_t>(target, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+    if (seen >= target) {
+      return std::min(LatencyBuckets::upperBound(i), maxNs);
+    }
+  }
+  return maxNs;
+}
+
+namespace {
+
+// Counters are only incremented by the owning thread, so increments are a
+// plain relaxed load + store (no locked read-modify-write on the hot path).
+// Atomics keep the concurrent reads in snapshot() and the zeroing in reset()
+// well defined; a reset racing with an increment may keep that one sample.
+struct OpCounters {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> errors{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> totalNs{0};
+  std::atomic<uint64_t> maxNs{0};
+  std::array<std::atomic<uint64_t>, LatencyBuckets::kCount> buckets{};
+
+  void mergeInto(FsOpSnapshot &out) const {
+    out.calls += calls.load(std::memory_order_relaxed);
+    out.errors += errors.load(std::memory_order_relaxed);
+    out.bytes += bytes.load(std::memory_order_relaxed);
+    out.totalNs += totalNs.load(std::memory_order_relaxed);
+    out.maxNs = std::max(out.maxNs, maxNs.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < buckets.size(); i++) {
+      out.buckets[i] += buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  void add(const OpCounters &other) {
+    calls.fetch_add(other.calls.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+    errors.fetch_add(other.errors.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    bytes.fetch_add(other.bytes.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+    totalNs.fetch_add(other.totalNs.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    uint64_t otherMax = other.maxNs.load(std::memory_order_relaxed);
+    if (otherMax > maxNs.load(std::memory_order_relaxed)) {
+      maxNs.store(otherMax, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < buckets.size(); i++) {
+      buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    }
+  }
+
+  void clear() {
+    calls.store(0, std::memory_order_relaxed);
+    errors.store(0, std::memory_order_relaxed);
+    bytes.store(0, std::memory_order_relaxed);
+    totalNs.store(0, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+    for (auto &bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+};
+
+// One shard per thread. Counters for an operation are allocated the first
+// time that thread performs it.
+struct Shard {
+  std::array<std::atomic<OpCounters *>, kFsOpCount> ops{};
+
+  ~Shard() {
+    for (auto &op : ops) {
+      delete op.load(std::memory_order_relaxed);
+    }
+  }
+
+  OpCounters &countersFor(FsOp op);
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<Shard *> shards;
+  Shard retired; // totals of threads that have exited
+};
+
+Registry &registry() {
+  // Leaked: thread_local shards may retire during static destruction.
+  static Registry *instance = new Registry();
+  return *instance;
+}
+
+OpCounters &Shard::countersFor(FsOp op) {
+  auto &slot = ops[static_cast<size_t>(op)];
+  OpCounters *counters = slot.load(std::memory_order_acquire);
+  if (counters == nullptr) {
+    counters = new OpCounters();
+    // Only this thread allocates for its own shard, but the retired shard is
+    // shared, so publish with a CAS.
+    OpCounters *expected = nullptr;
+    if (!slot.compare_exchange_strong(expected, counters,
+                                      std::memory_order_acq_rel)) {
+      delete counters;
+      counters = expected;
+    }
+  }
+  return *counters;
+}
+
+struct ShardOwner {
+  Shard *shard;
+
+  ShardOwner() : shard(new Shard()) {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.shards.push_back(shard);
+  }
+
+  ~ShardOwner() {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (size_t i = 0; i < kFsOpCount; i++) {
+      OpCounters *counters = shard->ops[i].load(std::memory_order_acquire);
+      if (counters != nullptr) {
+        reg.retired.countersFor(static_cast<FsOp>(i)).add(*counters);
+      }
+    }
+    reg.shards.erase(std::remove(reg.shards.begin(), reg.shards.end(), shard),
+                     reg.shards.end());
+    delete shard;
+  }
+};
+
+Shard &localShard() {
+  thread_local ShardOwner owner;
+  return *owner.shard;
+}
+
+inline void bump(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+} // namespace
+
+namespace metrics {
+
+void record(FsOp op, uint64_t ns, uint64_t bytes, bool error) {
+  OpCounters &counters = localShard().countersFor(op);
+  bump(counters.calls, 1);
+  if (error) {
+    bump(counters.errors, 1);
+  }
+  if (bytes > 0) {
+    bump(counters.bytes, bytes);
+  }
+  bump(counters.totalNs, ns);
+  if (ns > counters.maxNs.load(std::memory_order_relaxed)) {
+    counters.maxNs.store(ns, std::memory_order_relaxed);
+  }
+  bump(counters.buckets[LatencyBuckets::indexOf(ns)], 1);
+}
+
+std::vector<FsOpSnapshot> snapshot() {
+  std::vector<FsOpSnapshot> merged(kFsOpCount);
+  for (size_t i = 0; i < kFsOpCount; i++) {
+    merged[i].op = static_cast<FsOp>(i);
+    merged[i].buckets.assign(LatencyBuckets::kCount, 0);
+  }
+
+  auto mergeShard = [&](const Shard &shard) {
+    for (size_t i = 0; i < kFsOpCount; i++) {
+      OpCounters *counters = shard.ops[i].load(std::memory_order_acquire);
+      if (counters != nullptr) {
+        counters->mergeInto(merged[i]);
+      }
+    }
+  };
+  {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (Shard *shard : reg.shards) {
+      mergeShard(*shard);
+    }
+    mergeShard(reg.retired);
+  }
+
+  merged.erase(std::remove_if(merged.begin(), merged.end(),
+                              [](const FsOpSnapshot &s) { return s.calls == 0; }),
+               merged.end());
+  return merged;
+}
+
+void reset() {
+  auto clearShard = [](Shard &shard) {
+    for (auto &slot : shard.ops) {
+      OpCounters *counters = slot.load(std::memory_order_acquire);
+      if (counters != nullptr) {
+        counters->clear();
+      }
+    }
+  };
+  auto &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (Shard *shard : reg.shards) {
+    clearShard(*shard);
+  }
+  clearShard(reg.retired);
+}
+
+} // namespace metrics
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,266 @@
+#pragma once
+#include "FsTrace.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string_view>
+#include <vector>
+
+// Compile-time switch for per-operation metrics and tracing. Build with
+// NITRO_FS_METRICS=0 to compile every probe down to nothing.
+#ifndef NITRO_FS_METRICS
+#define NITRO_FS_METRICS 1
+#endif
+
+namespace margelo::nitro::node_fs {
+
+// Every instrumented operation: enum id and the name reported to JS.
+#define NITRO_FS_OPS(X)                                                        \
+  X(Open, "open")                                                              \
+  X(Close, "close")                                                            \
+  X(Read, "read")                                                              \
+  X(Write, "write")                                                            \
+  X(Access, "access")                                                          \
+  X(Truncate, "truncate")                                                      \
+  X(Ftruncate, "ftruncate")                                                    \
+  X(Fsync, "fsync")                                                            \
+  X(Fallocate, "fallocate")                                                    \
+  X(SeekData, "seekData")                                                      \
+  X(SeekHole, "seekHole")                                                      \
+  X(Chmod, "chmod")                                                            \
+  X(Lchmod, "lchmod")                                                          \
+  X(Fchmod, "fchmod")                                                          \
+  X(Chown, "chown")                                                            \
+  X(Lchown, "lchown")                                                          \
+  X(Fchown, "fchown")                                                          \
+  X(Utimes, "utimes")                                                          \
+  X(Lutimes, "lutimes")                                                        \
+  X(Futimes, "futimes")                                                        \
+  X(Link, "link")                                                              \
+  X(Symlink, "symlink")                                                        \
+  X(Readlink, "readlink")                                                      \
+  X(Realpath, "realpath")                                                      \
+  X(Mkdtemp, "mkdtemp")                                                        \
+  X(Rm, "rm")                                                                  \
+  X(Stat, "stat")                                                              \
+  X(Lstat, "lstat")                                                            \
+  X(Fstat, "fstat")                                                            \
+  X(Statfs, "statfs")                                                          \
+  X(Mkdir, "mkdir")                                                            \
+  X(Rmdir, "rmdir")                                                            \
+  X(Readdir, "readdir")                                                        \
+  X(Unlink, "unlink")                                                          \
+  X(Rename, "rename")                                                          \
+  X(CopyFile, "copyFile")                                                      \
+  X(Cp, "cp")                                                                  \
+  X(Opendir, "opendir")                                                        \
+  X(Watch, "watch")                                                            \
+  X(CreateLogWriter, "createLogWriter")                                        \
+  X(OpenZip, "openZip")                                                        \
+  X(ReadFile, "readFile")                                                      \
+  X(WriteFile, "writeFile")                                                    \
+  X(WriteFileAtomic, "writeFileAtomic")                                        \
+  X(WriteFilesAtomic, "writeFilesAtomic")                                      \
+  X(Readv, "readv")                                                            \
+  X(Writev, "writev")                                                          \
+  X(CompressFile, "compressFile")                                              \
+  X(DecompressFile, "decompressFile")                                          \
+  X(TarCreate, "tarCreate")                                                    \
+  X(TarExtract, "tarExtract")                                                  \
+  X(FileSignature, "fileSignature")                                            \
+  X(FileDelta, "fileDelta")                                                    \
+  X(ApplyPatch, "applyPatch")                                                  \
+  X(StoreFile, "storeFile")                                                    \
+  X(RestoreFile, "restoreFile")                                                \
+  X(RemoveStoredFile, "removeStoredFile")                                      \
+  X(ListStoredFiles, "listStoredFiles")                                        \
+  X(GcChunkStore, "gcChunkStore")                                              \
+  X(SearchFiles, "searchFiles")                                                \
+  X(CompareFiles, "compareFiles")                                              \
+  X(DiffTrees, "diffTrees")                                                    \
+  X(ReadJSON, "readJSON")                                                      \
+  X(WriteJSON, "writeJSON")                                                    \
+  X(BuildLineIndex, "buildLineIndex")                                          \
+  X(ReadLines, "readLines")                                                    \
+  X(Tail, "tail")                                                              \
+  X(Du, "du")                                                                  \
+  X(MonitorSpace, "monitorSpace")                                              \
+  X(Advise, "advise")                                                          \
+  X(Prefetch, "prefetch")                                                      \
+  X(Batch, "batch")                                                            \
+  X(StatMany, "statMany")                                                      \
+  X(ReadFileMany, "readFileMany")                                              \
+  X(ReadRanges, "readRanges")                                                  \
+  X(DirNext, "dir.next")                                                       \
+  X(DirClose, "dir.close")                                                     \
+  X(WatcherEvent, "watcher.event")                                             \
+  X(WatcherClose, "watcher.close")                                             \
+  X(TailBatch, "tail.batch")                                                   \
+  X(TailClose, "tail.close")                                                   \
+  X(SpaceMonitorChange, "spaceMonitor.change")
+
+enum class FsOp : uint8_t {
+#define NITRO_FS_OP_ENUM(id, name) id,
+  NITRO_FS_OPS(NITRO_FS_OP_ENUM)
+#undef NITRO_FS_OP_ENUM
+      Count
+};
+
+constexpr size_t kFsOpCount = static_cast<size_t>(FsOp::Count);
+
+const char *fsOpName(FsOp op);
+
+/**
+ * Log-linear latency histogram layout (HDR style): values below 8ns get a
+ * bucket each, every power of two above that is split into 8 sub-buckets,
+ * so any recorded value is reported within 12.5%. Values beyond ~18 minutes
+ * land in the last bucket.
+ */
+struct LatencyBuckets {
+  static constexpr unsigned kSubBits = 3;
+  static constexpr unsigned kSubCount = 1u << kSubBits;
+  static constexpr unsigned kMaxExponent = 40;
+  static constexpr size_t kCount =
+      kSubCount + (kMaxExponent - kSubBits + 1) * kSubCount;
+
+  static size_t indexOf(uint64_t ns) {
+    if (ns < kSubCount) {
+      return static_cast<size_t>(ns);
+    }
+    unsigned exponent = 63u - static_cast<unsigned>(__builtin_clzll(ns));
+    if (exponent > kMaxExponent) {
+      return kCount - 1;
+    }
+    uint64_t sub = (ns >> (exponent - kSubBits)) & (kSubCount - 1);
+    return kSubCount + (exponent - kSubBits) * kSubCount +
+           static_cast<size_t>(sub);
+  }
+
+  // Highest value that maps to bucket `index`.
+  static uint64_t upperBound(size_t index) {
+    if (index < kSubCount) {
+      return index;
+    }
+    unsigned exponent =
+        static_cast<unsigned>((index - kSubCount) / kSubCount) + kSubBits;
+    uint64_t sub = (index - kSubCount) % kSubCount;
+    return ((kSubCount + sub + 1) << (exponent - kSubBits)) - 1;
+  }
+};
+
+struct FsOpSnapshot {
+  FsOp op;
+  uint64_t calls = 0;
+  uint64_t errors = 0;
+  uint64_t bytes = 0;
+  uint64_t totalNs = 0;
+  uint64_t maxNs = 0;
+  std::vector<uint64_t> buckets;
+
+  // Latency at quantile q (0..1), from the histogram.
+  uint64_t percentileNs(double q) const;
+};
+
+/**
+ * Process-wide operation metrics. Each thread records into its own shard, so
+ * the hot path touches only thread-local cache lines; snapshot() merges all
+ * shards. Shards of exited threads are folded into a global one.
+ */
+namespace metrics {
+void record(FsOp op, uint64_t ns, uint64_t bytes, bool error);
+// Only operations with at least one call are returned.
+std::vector<FsOpSnapshot> snapshot();
+void reset();
+} // namespace metrics
+
+#if NITRO_FS_METRICS
+
+// Times the enclosing scope and records it for `op`. A scope left through an
+// exception counts as an error. While tracing is active the scope is also
+// emitted as a trace event, tagged with the first path passed to
+// tracePath() on this thread during the scope.
+class FsOpScope {
+public:
+  explicit FsOpScope(FsOp op)
+      : _op(op), _start(std::chrono::steady_clock::now()),
+        _exceptions(std::uncaught_exceptions()), _traced(trace::active()) {
+    if (_traced) {
+      _previous = _current;
+      _current = this;
+    }
+  }
+  FsOpScope(const FsOpScope &) = delete;
+  FsOpScope &operator=(const FsOpScope &) = delete;
+
+  ~FsOpScope() {
+    auto end = std::chrono::steady_clock::now();
+    uint64_t ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - _start)
+            .count());
+    bool error = _failed || std::uncaught_exceptions() > _exceptions;
+    metrics::record(_op, ns, _bytes, error);
+    if (_traced) {
+      _current = _previous;
+      uint64_t startNs = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              _start.time_since_epoch())
+              .count());
+      trace::record(_op, startNs, ns, _bytes, error,
+                    std::string_view(_path, _pathLength));
+    }
+  }
+
+  void addBytes(uint64_t bytes) { _bytes += bytes; }
+  void fail() { _failed = true; }
+
+  static void tracePath(std::string_view path) {
+    if (_current != nullptr && _current->_pathLength == 0) {
+      if (path.size() > kTracePathCapacity) {
+        path.remove_prefix(path.size() - kTracePathCapacity);
+      }
+      std::memcpy(_current->_path, path.data(), path.size());
+      _current->_pathLength = path.size();
+    }
+  }
+
+private:
+  // Innermost traced scope of this thread.
+  static inline thread_local FsOpScope *_current = nullptr;
+
+  FsOp _op;
+  std::chrono::steady_clock::time_point _start;
+  int _exceptions;
+  bool _traced;
+  bool _failed = false;
+  uint64_t _bytes = 0;
+  FsOpScope *_previous = nullptr;
+  size_t _pathLength = 0;
+  char _path[kTracePathCapacity];
+};
+
+#define NITRO_FS_OP(id)                                                        \
+  ::margelo::nitro::node_fs::FsOpScope _fsOpScope(                             \
+      ::margelo::nitro::node_fs::FsOp::id)
+#define NITRO_FS_BYTES(n) _fsOpScope.addBytes(static_cast<uint64_t>(n))
+#define NITRO_FS_FAIL() _fsOpScope.fail()
+// For calls that report failure through a negative result instead of
+// throwing: counts bytes on success, an error otherwise.
+#define NITRO_FS_RESULT(r)                                                     \
+  ((r) < 0 ? _fsOpScope.fail()                                                 \
+           : _fsOpScope.addBytes(static_cast<uint64_t>(r)))
+// Names the path an operation works on, for trace events.
+#define NITRO_FS_TRACE_PATH(path)                                              \
+  ::margelo::nitro::node_fs::FsOpScope::tracePath(path)
+
+#else
+
+#define NITRO_FS_OP(id) ((void)0)
+#define NITRO_FS_BYTES(n) ((void)0)
+#define NITRO_FS_FAIL() ((void)0)
+#define NITRO_FS_RESULT(r) ((void)0)
+#define NITRO_FS_TRACE_PATH(path) ((void)0)
+
+#endif
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,292 @@
+#include "FsTrace.hpp"
+#include "AtomicWrite.hpp"
+#include "FsMetrics.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace margelo::nitro::node_fs::trace {
+
+namespace detail {
+std::atomic<bool> active{false};
+}
+
+namespace {
+
+struct TraceEvent {
+  uint64_t startNs;
+  uint64_t durationNs;
+  uint64_t bytes;
+  FsOp op;
+  bool error;
+  uint8_t pathLength;
+  char path[kTracePathCapacity];
+};
+
+// Each slot carries a sequence number (odd while being written) so dump()
+// can read concurrently with the owning thread and drop torn events. The
+// payload is copied as relaxed atomic words, which compile to plain moves.
+struct Slot {
+  static constexpr size_t kWords =
+      (sizeof(TraceEvent) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> sequence{0};
+  std::array<std::atomic<uint64_t>, kWords> words{};
+
+  void store(const TraceEvent &event) {
+    uint64_t raw[kWords] = {};
+    std::memcpy(raw, &event, sizeof(event));
+    for (size_t i = 0; i < kWords; i++) {
+      words[i].store(raw[i], std::memory_order_relaxed);
+    }
+  }
+
+  void load(TraceEvent &event) const {
+    uint64_t raw[kWords];
+    for (size_t i = 0; i < kWords; i++) {
+      raw[i] = words[i].load(std::memory_order_relaxed);
+    }
+    std::memcpy(&event, raw, sizeof(event));
+  }
+};
+
+struct Ring {
+  Ring(size_t capacity, uint32_t generation)
+      : slots(new Slot[capacity]), capacity(capacity), generation(generation) {}
+
+  std::unique_ptr<Slot[]> slots;
+  const size_t capacity;
+  const uint32_t generation;
+  std::atomic<uint64_t> head{0};
+  uint64_t tid = 0;
+  std::string threadName;
+
+  // Owning thread only.
+  void push(const TraceEvent &event) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    Slot &slot = slots[index % capacity];
+    slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.store(event);
+    slot.sequence.store(index * 2 + 2, std::memory_order_release);
+    head.store(index + 1, std::memory_order_release);
+  }
+
+  bool read(uint64_t index, TraceEvent &out) const {
+    const Slot &slot = slots[index % capacity];
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before != index * 2 + 2) {
+      return false;
+    }
+    slot.load(out);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == before;
+  }
+};
+
+struct Session {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Ring>> rings;
+  std::atomic<uint32_t> generation{0};
+  std::atomic<size_t> capacity{kDefaultEventsPerThread};
+};
+
+Session &session() {
+  // Leaked: threads may still record during static destruction.
+  static Session *instance = new Session();
+  return *instance;
+}
+
+uint64_t currentThreadId() {
+#if defined(__APPLE__)
+  uint64_t tid = 0;
+  pthread_threadid_np(nullptr, &tid);
+  return tid;
+#elif defined(__linux__)
+  return static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+  return reinterpret_cast<uintptr_t>(pthread_self());
+#endif
+}
+
+std::string currentThreadName() {
+  char name[64] = {0};
+#if defined(__APPLE__)
+  pthread_getname_np(pthread_self(), name, sizeof(name));
+#elif defined(__linux__)
+  ::prctl(PR_GET_NAME, name, 0, 0, 0);
+#endif
+  return name;
+}
+
+// A new ring is created whenever the thread first records in a session, so
+// a ring never changes size while dump() may be reading it.
+Ring &localRing() {
+  thread_local std::shared_ptr<Ring> ring;
+  auto &s = session();
+  uint32_t generation = s.generation.load(std::memory_order_acquire);
+  if (!ring || ring->generation != generation) {
+    ring = std::make_shared<Ring>(
+        std::max<size_t>(s.capacity.load(std::memory_order_relaxed), 1),
+        generation);
+    ring->tid = currentThreadId();
+    ring->threadName = currentThreadName();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.generation.load(std::memory_order_relaxed) == generation) {
+      s.rings.push_back(ring);
+    }
+  }
+  return *ring;
+}
+
+void appendJsonString(std::string &out, std::string_view value) {
+  out += '"';
+  for (char c : value) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      } else {
+        out += c;
+      }
+    }
+  }
+  out += '"';
+}
+
+// Chrome trace timestamps are microseconds; keep nanosecond precision.
+void appendMicros(std::string &out, uint64_t ns) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+                static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned long long>(ns % 1000));
+  out += buffer;
+}
+
+} // namespace
+
+void start(size_t eventsPerThread) {
+  auto &s = session();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.capacity.store(eventsPerThread, std::memory_order_relaxed);
+  s.generation.fetch_add(1, std::memory_order_acq_rel);
+  s.rings.clear();
+  detail::active.store(true, std::memory_order_release);
+}
+
+void stop() { detail::active.store(false, std::memory_order_release); }
+
+void record(FsOp op, uint64_t startNs, uint64_t durationNs, uint64_t bytes,
+            bool error, std::string_view path) {
+  TraceEvent event;
+  event.startNs = startNs;
+  event.durationNs = durationNs;
+  event.bytes = bytes;
+  event.op = op;
+  event.error = error;
+  if (path.size() > kTracePathCapacity) {
+    path.remove_prefix(path.size() - kTracePathCapacity);
+  }
+  event.pathLength = static_cast<uint8_t>(path.size());
+  std::memcpy(event.path, path.data(), path.size());
+  localRing().push(event);
+}
+
+size_t dump(const std::string &path) {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    auto &s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    rings = s.rings;
+  }
+
+  std::string pid = std::to_string(::getpid());
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto beginEvent = [&]() {
+    if (!first) {
+      json += ',';
+    }
+    first = false;
+    json += "\n";
+  };
+
+  size_t written = 0;
+  TraceEvent event;
+  for (const auto &ring : rings) {
+    std::string tid = std::to_string(ring->tid);
+    if (!ring->threadName.empty()) {
+      beginEvent();
+      json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid +
+              ",\"tid\":" + tid + ",\"args\":{\"name\":";
+      appendJsonString(json, ring->threadName);
+      json += "}}";
+    }
+
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t begin = head > ring->capacity ? head - ring->capacity : 0;
+    for (uint64_t i = begin; i < head; i++) {
+      if (!ring->read(i, event)) {
+        continue; // overwritten while we were reading
+      }
+      beginEvent();
+      json += "{\"ph\":\"X\",\"cat\":\"fs\",\"name\":\"";
+      json += fsOpName(event.op);
+      json += "\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"ts\":";
+      appendMicros(json, event.startNs);
+      json += ",\"dur\":";
+      appendMicros(json, event.durationNs);
+      json += ",\"args\":{";
+      bool hasArgs = false;
+      if (event.pathLength > 0) {
+        json += "\"path\":";
+        appendJsonString(json, std::string_view(event.path, event.pathLength));
+        hasArgs = true;
+      }
+      if (event.bytes > 0) {
+        json += hasArgs ? "," : "";
+        json += "\"bytes\":" + std::to_string(event.bytes);
+        hasArgs = true;
+      }
+      if (event.error) {
+        json += hasArgs ? "," : "";
+        json += "\"error\":true";
+      }
+      json += "}}";
+      written++;
+    }
+  }
+  json += "\n]}\n";
+
+  atomicWriteFiles({{path, reinterpret_cast<const uint8_t *>(json.data()),
+                     json.size()}},
+                   SyncLevel::None);
+  return written;
+}
+
+} // namespace margelo::nitro::node_fs::trace
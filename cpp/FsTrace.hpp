@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace margelo::nitro::node_fs {
+
+enum class FsOp : uint8_t;
+
+// Paths longer than this are stored with their leading part cut off, the
+// file name end being the useful one on a timeline.
+constexpr size_t kTracePathCapacity = 112;
+
+/**
+ * Opt-in timeline tracing of fs operations. While active, every completed
+ * operation is appended to a fixed-size ring buffer owned by the calling
+ * thread (single producer, no locks on the hot path; the oldest events are
+ * overwritten when a ring is full). dump() writes all rings as Chrome trace
+ * JSON, which chrome://tracing and Perfetto can open next to other traces.
+ *
+ * Timestamps come from the monotonic clock, the same one used by systrace and
+ * Instruments, so events line up with traces captured alongside.
+ */
+namespace trace {
+
+constexpr size_t kDefaultEventsPerThread = 8192;
+
+namespace detail {
+extern std::atomic<bool> active;
+}
+
+inline bool active() {
+  return detail::active.load(std::memory_order_relaxed);
+}
+
+// Starts a new session, discarding all previously recorded events.
+void start(size_t eventsPerThread = kDefaultEventsPerThread);
+// Stops recording; the recorded events stay available to dump().
+void stop();
+
+void record(FsOp op, uint64_t startNs, uint64_t durationNs, uint64_t bytes,
+            bool error, std::string_view path);
+
+// Writes the current session to `path` atomically. Returns the number of
+// events written.
+size_t dump(const std::string &path);
+
+} // namespace trace
+
+} // namespace margelo::nitro::node_fs
@@ -1,8 +1,10 @@
 #include "HybridDirIterator.hpp"
+#include "FsMetrics.hpp"
 
 namespace margelo::nitro::node_fs {
 
 std::optional<std::string> HybridDirIterator::next() {
+  NITRO_FS_OP(DirNext);
   if (_iter == nullptr) {
     return std::nullopt;
   }
@@ -16,6 +18,7 @@ std::optional<std::string> HybridDirIterator::next() {
 }
 
 void HybridDirIterator::close() {
+  NITRO_FS_OP(DirClose);
   if (_iter != nullptr) {
     rn_fs_readdir_close(_iter);
     _iter = nullptr;
@@ -1,10 +1,36 @@
 #include "HybridFileSystem.hpp"
+#include "AtomicWrite.hpp"
+#include "BatchOps.hpp"
+#include "BufferPool.hpp"
+#include "BulkIo.hpp"
+#include "ChunkStore.hpp"
+#include "ContentSearch.hpp"
+#include "DeltaSync.hpp"
+#include "DiskUsage.hpp"
+#include "FileAdvice.hpp"
+#include "FileCompression.hpp"
+#include "FileCopy.hpp"
+#include "FsMetrics.hpp"
 #include "HybridDirIterator.hpp"
+#include "HybridFileTail.hpp"
 #include "HybridFileWatcher.hpp"
+#include "HybridJsonDocument.hpp"
+#include "HybridLogWriter.hpp"
+#include "HybridSpaceMonitor.hpp"
+#include "HybridZipArchive.hpp"
+#include "JsonTape.hpp"
+#include "LineIndex.hpp"
+#include "PortableFileSystem.hpp"
+#include "SparseFile.hpp"
+#include "TarArchive.hpp"
+#include "TreeDiff.hpp"
 #include "rust_c_file_system.h"
+#include <NitroModules/JSIConverter.hpp>
+#include <algorithm>
 #include <cstdio>
 #include <fcntl.h>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <sys/stat.h>
 #include <stdexcept>
@@ -34,6 +60,11 @@ Java_com_margelo_nitro_node_1fs_NitroFileSystemUtils_nSetAssetManager(JNIEnv* en
     }
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_margelo_nitro_node_1fs_NitroFileSystemUtils_nTrimBufferPool(JNIEnv*, jclass) {
+    margelo::nitro::node_fs::BufferPool::shared().trim();
+}
+
 std::string getAndroidDirectoryPath(const std::string& type) {
     // ...
     JNIEnv *env = getJNIEnv();
@@ -80,24 +111,24 @@ std::shared_ptr<ArrayBuffer> readAssetBuffer(const std::string& assetPath) {
         throw std::runtime_error("Could not open asset: " + assetPath);
     }
     
-    off_t size = AAsset_getLength(asset);
+    off64_t size = AAsset_getLength64(asset);
     if (size <= 0) {
         AAsset_close(asset);
         return ArrayBuffer::allocate(0);
     }
 
-    uint8_t* rawData = new uint8_t[size];
+    auto& pool = margelo::nitro::node_fs::BufferPool::shared();
+    size_t capacity = 0;
+    uint8_t* rawData = pool.acquire(static_cast<size_t>(size), capacity);
     int readCount = AAsset_read(asset, rawData, size);
     AAsset_close(asset);
 
     if (readCount < 0) {
-        delete[] rawData;
+        pool.recycle(rawData, capacity);
         throw std::runtime_error("Failed to read asset: " + assetPath);
     }
-    
-    auto buffer = ArrayBuffer::copy(rawData, readCount);
-    delete[] rawData;
-    return buffer;
+
+    return pool.adopt(rawData, static_cast<size_t>(readCount), capacity);
 }
 
 Stats statAsset(const std::string& assetPath) {
@@ -119,7 +150,7 @@ Stats statAsset(const std::string& assetPath) {
         throw std::runtime_error("Asset not found: " + assetPath);
     }
     
-    off_t size = AAsset_getLength(asset);
+    off64_t size = AAsset_getLength64(asset);
     AAsset_close(asset);
     
     // mode: S_IFREG (regular file) | S_IRUSR (read access)
@@ -155,6 +186,7 @@ Stats toStats(const RNStats &s) {
 
 double HybridFileSystem::open(const std::string &rawPath, double flags,
                               double mode) {
+  NITRO_FS_OP(Open);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -219,11 +251,15 @@ double HybridFileSystem::open(const std::string &rawPath, double flags,
                     static_cast<int>(mode));
 }
 
-void HybridFileSystem::close(double fd) { rn_fs_close(static_cast<int>(fd)); }
+void HybridFileSystem::close(double fd) {
+  NITRO_FS_OP(Close);
+  rn_fs_close(static_cast<int>(fd));
+}
 
 double HybridFileSystem::read(double fd,
                               const std::shared_ptr<ArrayBuffer> &buffer,
                               double offset, double length, double position) {
+  NITRO_FS_OP(Read);
   if (!buffer)
     return -1;
 
@@ -232,13 +268,17 @@ double HybridFileSystem::read(double fd,
   }
 
   uint8_t *data = buffer->data() + static_cast<size_t>(offset);
-  return rn_fs_read(static_cast<int>(fd), data, static_cast<size_t>(length),
-                    static_cast<int64_t>(position));
+  int64_t bytesRead = rn_fs_read(static_cast<int>(fd), data,
+                                 static_cast<size_t>(length),
+                                 static_cast<int64_t>(position));
+  NITRO_FS_RESULT(bytesRead);
+  return bytesRead;
 }
 
 double HybridFileSystem::write(double fd,
                                const std::shared_ptr<ArrayBuffer> &buffer,
                                double offset, double length, double position) {
+  NITRO_FS_OP(Write);
   if (!buffer)
     return -1;
 
@@ -248,11 +288,15 @@ double HybridFileSystem::write(double fd,
 
   uint8_t *data = buffer->data() + static_cast<size_t>(offset);
 
-  return rn_fs_write(static_cast<int>(fd), data, static_cast<size_t>(length),
-                     static_cast<int64_t>(position));
+  int64_t bytesWritten = rn_fs_write(static_cast<int>(fd), data,
+                                     static_cast<size_t>(length),
+                                     static_cast<int64_t>(position));
+  NITRO_FS_RESULT(bytesWritten);
+  return bytesWritten;
 }
 
 void HybridFileSystem::access(const std::string &rawPath, double mode) {
+  NITRO_FS_OP(Access);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -289,6 +333,7 @@ void HybridFileSystem::access(const std::string &rawPath, double mode) {
 }
 
 void HybridFileSystem::truncate(const std::string &rawPath, double len) {
+  NITRO_FS_OP(Truncate);
   std::string path = normalizePath(rawPath);
   if (rn_fs_truncate(path.c_str(), static_cast<size_t>(len)) != 0) {
     throw std::runtime_error("truncate failed: " + path);
@@ -296,18 +341,43 @@ void HybridFileSystem::truncate(const std::string &rawPath, double len) {
 }
 
 void HybridFileSystem::ftruncate(double fd, double len) {
+  NITRO_FS_OP(Ftruncate);
   if (rn_fs_ftruncate(static_cast<int>(fd), static_cast<size_t>(len)) != 0) {
     throw std::runtime_error("ftruncate failed");
   }
 }
 
 void HybridFileSystem::fsync(double fd) {
+  NITRO_FS_OP(Fsync);
   if (rn_fs_fsync(static_cast<int>(fd)) != 0) {
     throw std::runtime_error("fsync failed");
   }
 }
 
+void HybridFileSystem::fallocate(double fd, double offset, double length,
+                                 const std::optional<FallocateOptions> &options) {
+  NITRO_FS_OP(Fallocate);
+  fallocateRange(static_cast<int>(fd),
+                 static_cast<uint64_t>(std::max(0.0, offset)),
+                 static_cast<uint64_t>(std::max(0.0, length)),
+                 options.has_value() && options->keepSize.value_or(false),
+                 options.has_value() && options->punchHole.value_or(false));
+}
+
+double HybridFileSystem::seekData(double fd, double offset) {
+  NITRO_FS_OP(SeekData);
+  return static_cast<double>(::margelo::nitro::node_fs::seekData(
+      static_cast<int>(fd), static_cast<uint64_t>(std::max(0.0, offset))));
+}
+
+double HybridFileSystem::seekHole(double fd, double offset) {
+  NITRO_FS_OP(SeekHole);
+  return static_cast<double>(::margelo::nitro::node_fs::seekHole(
+      static_cast<int>(fd), static_cast<uint64_t>(std::max(0.0, offset))));
+}
+
 void HybridFileSystem::chmod(const std::string &rawPath, double mode) {
+  NITRO_FS_OP(Chmod);
   std::string path = normalizePath(rawPath);
   if (rn_fs_chmod(path.c_str(), static_cast<int>(mode)) != 0) {
     throw std::runtime_error("chmod failed: " + path);
@@ -315,6 +385,7 @@ void HybridFileSystem::chmod(const std::string &rawPath, double mode) {
 }
 
 void HybridFileSystem::lchmod(const std::string &rawPath, double mode) {
+  NITRO_FS_OP(Lchmod);
   std::string path = normalizePath(rawPath);
   if (rn_fs_lchmod(path.c_str(), static_cast<uint32_t>(mode)) != 0) {
     throw std::runtime_error("lchmod failed: " + path);
@@ -322,12 +393,14 @@ void HybridFileSystem::lchmod(const std::string &rawPath, double mode) {
 }
 
 void HybridFileSystem::fchmod(double fd, double mode) {
+  NITRO_FS_OP(Fchmod);
   if (rn_fs_fchmod(static_cast<int>(fd), static_cast<int>(mode)) != 0) {
     throw std::runtime_error("fchmod failed");
   }
 }
 
 void HybridFileSystem::chown(const std::string &rawPath, double uid, double gid) {
+  NITRO_FS_OP(Chown);
   std::string path = normalizePath(rawPath);
   if (rn_fs_chown(path.c_str(), static_cast<int>(uid), static_cast<int>(gid)) !=
       0) {
@@ -336,6 +409,7 @@ void HybridFileSystem::chown(const std::string &rawPath, double uid, double gid)
 }
 
 void HybridFileSystem::lchown(const std::string &rawPath, double uid, double gid) {
+  NITRO_FS_OP(Lchown);
   std::string path = normalizePath(rawPath);
   if (rn_fs_lchown(path.c_str(), static_cast<uint32_t>(uid),
                    static_cast<uint32_t>(gid)) != 0) {
@@ -344,6 +418,7 @@ void HybridFileSystem::lchown(const std::string &rawPath, double uid, double gid
 }
 
 void HybridFileSystem::fchown(double fd, double uid, double gid) {
+  NITRO_FS_OP(Fchown);
   if (rn_fs_fchown(static_cast<int>(fd), static_cast<int>(uid),
                    static_cast<int>(gid)) != 0) {
     throw std::runtime_error("fchown failed");
@@ -352,6 +427,7 @@ void HybridFileSystem::fchown(double fd, double uid, double gid) {
 
 void HybridFileSystem::utimes(const std::string &rawPath, double atime,
                               double mtime) {
+  NITRO_FS_OP(Utimes);
   std::string path = normalizePath(rawPath);
   if (rn_fs_utimes(path.c_str(), atime, mtime) != 0) {
 
@@ -361,6 +437,7 @@ void HybridFileSystem::utimes(const std::string &rawPath, double atime,
 
 void HybridFileSystem::lutimes(const std::string &rawPath, double atime,
                                double mtime) {
+  NITRO_FS_OP(Lutimes);
   std::string path = normalizePath(rawPath);
   if (rn_fs_lutimes(path.c_str(), static_cast<int64_t>(atime),
                     static_cast<int64_t>(mtime)) != 0) {
@@ -369,6 +446,7 @@ void HybridFileSystem::lutimes(const std::string &rawPath, double atime,
 }
 
 void HybridFileSystem::futimes(double fd, double atime, double mtime) {
+  NITRO_FS_OP(Futimes);
   if (rn_fs_futimes(static_cast<int>(fd), atime, mtime) != 0) {
     throw std::runtime_error("futimes failed");
   }
@@ -376,6 +454,7 @@ void HybridFileSystem::futimes(double fd, double atime, double mtime) {
 
 void HybridFileSystem::link(const std::string &rawExistingPath,
                             const std::string &rawNewPath) {
+  NITRO_FS_OP(Link);
   std::string existingPath = normalizePath(rawExistingPath);
   std::string newPath = normalizePath(rawNewPath);
   if (rn_fs_link(existingPath.c_str(), newPath.c_str()) != 0) {
@@ -386,6 +465,7 @@ void HybridFileSystem::link(const std::string &rawExistingPath,
 
 void HybridFileSystem::symlink(const std::string &rawTarget,
                                const std::string &rawPath) {
+  NITRO_FS_OP(Symlink);
   std::string target = normalizePath(rawTarget);
   std::string path = normalizePath(rawPath);
   if (rn_fs_symlink(target.c_str(), path.c_str()) != 0) {
@@ -394,6 +474,7 @@ void HybridFileSystem::symlink(const std::string &rawTarget,
 }
 
 std::string HybridFileSystem::readlink(const std::string &rawPath) {
+  NITRO_FS_OP(Readlink);
   std::string path = normalizePath(rawPath);
   char *res = rn_fs_readlink(path.c_str());
 
@@ -406,6 +487,7 @@ std::string HybridFileSystem::readlink(const std::string &rawPath) {
 }
 
 std::string HybridFileSystem::realpath(const std::string &rawPath) {
+  NITRO_FS_OP(Realpath);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -429,6 +511,7 @@ std::string HybridFileSystem::realpath(const std::string &rawPath) {
 }
 
 std::string HybridFileSystem::mkdtemp(const std::string &prefix) {
+  NITRO_FS_OP(Mkdtemp);
   char *res = rn_fs_mkdtemp(prefix.c_str());
   if (res == nullptr) {
     throw std::runtime_error("mkdtemp failed");
@@ -439,6 +522,7 @@ std::string HybridFileSystem::mkdtemp(const std::string &prefix) {
 }
 
 void HybridFileSystem::rm(const std::string &rawPath, bool recursive) {
+  NITRO_FS_OP(Rm);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -461,6 +545,7 @@ void HybridFileSystem::rm(const std::string &rawPath, bool recursive) {
 }
 
 Stats HybridFileSystem::stat(const std::string &rawPath) {
+  NITRO_FS_OP(Stat);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -513,15 +598,11 @@ Stats HybridFileSystem::stat(const std::string &rawPath) {
     throw std::runtime_error("Failed to stat bookmark URI: " + path);
   }
 #endif
-  RNStats s;
-  if (rn_fs_stat(path.c_str(), &s) == 0) {
-    return toStats(s);
-  }
-  // Throw error or return empty? Nitro methods can throw exceptions.
-  throw std::runtime_error("stat failed: " + path);
+  return toStats(portable::stat(path));
 }
 
 Stats HybridFileSystem::lstat(const std::string &rawPath) {
+  NITRO_FS_OP(Lstat);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -536,23 +617,38 @@ Stats HybridFileSystem::lstat(const std::string &rawPath) {
     return stat(path);
   }
 #endif
-  RNStats s;
-  if (rn_fs_lstat(path.c_str(), &s) == 0) {
-    return toStats(s);
-  }
-  throw std::runtime_error("lstat failed: " + path);
+  return toStats(portable::lstat(path));
 }
 
 Stats HybridFileSystem::fstat(double fd) {
-  RNStats s;
-  if (rn_fs_fstat(static_cast<int>(fd), &s) == 0) {
-    return toStats(s);
+  NITRO_FS_OP(Fstat);
+  return toStats(portable::fstat(static_cast<int>(fd)));
+}
+
+StatFs HybridFileSystem::statfs(const std::string &rawPath) {
+  NITRO_FS_OP(Statfs);
+  std::string path = normalizePath(rawPath);
+  return toStatFs(portable::statfs(path));
+}
+
+std::shared_ptr<HybridHybridSpaceMonitorSpec> HybridFileSystem::monitorSpace(
+    const std::string &rawPath, double thresholdBytes,
+    const std::function<void(bool, const StatFs &)> &onChange,
+    const std::optional<SpaceMonitorOptions> &options) {
+  NITRO_FS_OP(MonitorSpace);
+  std::string path = normalizePath(rawPath);
+  SpaceMonitorConfig config;
+  config.thresholdBytes = static_cast<uint64_t>(std::max(0.0, thresholdBytes));
+  if (options.has_value() && options->intervalMs.has_value()) {
+    config.intervalMs =
+        static_cast<uint32_t>(std::max(0.0, options->intervalMs.value()));
   }
-  throw std::runtime_error("fstat failed");
+  return std::make_shared<HybridSpaceMonitor>(path, config, onChange);
 }
 
 void HybridFileSystem::mkdir(const std::string &rawPath, double mode,
                              bool recursive) {
+  NITRO_FS_OP(Mkdir);
   std::string path = normalizePath(rawPath);
   if (!rn_fs_mkdir(path.c_str(), static_cast<uint32_t>(mode), recursive)) {
     throw std::runtime_error("mkdir failed: " + path);
@@ -560,6 +656,7 @@ void HybridFileSystem::mkdir(const std::string &rawPath, double mode,
 }
 
 void HybridFileSystem::rmdir(const std::string &rawPath) {
+  NITRO_FS_OP(Rmdir);
   std::string path = normalizePath(rawPath);
   if (rn_fs_rmdir(path.c_str()) != 0) {
     throw std::runtime_error("rmdir failed: " + path);
@@ -567,6 +664,7 @@ void HybridFileSystem::rmdir(const std::string &rawPath) {
 }
 
 std::vector<std::string> HybridFileSystem::readdir(const std::string &rawPath) {
+  NITRO_FS_OP(Readdir);
   std::string path = normalizePath(rawPath);
   std::vector<std::string> results;
 
@@ -621,22 +719,11 @@ std::vector<std::string> HybridFileSystem::readdir(const std::string &rawPath) {
   }
 #endif
 
-  DirIter *iter = rn_fs_readdir_open(path.c_str());
-  if (!iter) {
-    throw std::runtime_error("readdir failed (open): " + path);
-  }
-
-  char *name;
-  while ((name = rn_fs_readdir_next(iter)) != nullptr) {
-    results.push_back(std::string(name));
-    rn_fs_free_string(name);
-  }
-
-  rn_fs_readdir_close(iter);
-  return results;
+  return portable::readdir(path);
 }
 
 void HybridFileSystem::unlink(const std::string &rawPath) {
+  NITRO_FS_OP(Unlink);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -674,6 +761,7 @@ void HybridFileSystem::unlink(const std::string &rawPath) {
 
 void HybridFileSystem::rename(const std::string &rawOldPath,
                                const std::string &rawNewPath) {
+  NITRO_FS_OP(Rename);
   std::string oldPath = normalizePath(rawOldPath);
   std::string newPath = normalizePath(rawNewPath);
   if (rn_fs_rename(oldPath.c_str(), newPath.c_str()) != 0) {
@@ -683,6 +771,7 @@ void HybridFileSystem::rename(const std::string &rawOldPath,
 
 void HybridFileSystem::copyFile(const std::string &rawSrc, const std::string &rawDest,
                                 double flags) {
+  NITRO_FS_OP(CopyFile);
   std::string src = normalizePath(rawSrc);
   std::string dest = normalizePath(rawDest);
 
@@ -728,6 +817,11 @@ void HybridFileSystem::copyFile(const std::string &rawSrc, const std::string &ra
     throw std::runtime_error("copyFile (bookmark://) failed");
   }
 #endif
+  // Regular files are cloned or copied in the kernel; anything else is
+  // left to rn_fs_copy_file.
+  if (copyRegularFile(src, dest, static_cast<int>(flags), false)) {
+    return;
+  }
   if (rn_fs_copy_file(src.c_str(), dest.c_str(), static_cast<int>(flags)) !=
       0) {
     throw std::runtime_error("copyFile failed: " + src + " -> " + dest);
@@ -736,7 +830,9 @@ void HybridFileSystem::copyFile(const std::string &rawSrc, const std::string &ra
 
 void HybridFileSystem::cp(const std::string &rawSrc, const std::string &rawDest,
                           bool recursive, bool force, bool dereference,
-                          bool errorOnExist, bool preserveTimestamps) {
+                          bool errorOnExist, bool preserveTimestamps,
+                          double mode) {
+  NITRO_FS_OP(Cp);
   std::string src = normalizePath(rawSrc);
   std::string dest = normalizePath(rawDest);
 
@@ -747,6 +843,19 @@ void HybridFileSystem::cp(const std::string &rawSrc, const std::string &rawDest,
   }
 #endif
 
+  // A single regular file is copied here so it can be cloned or copied in
+  // the kernel; an existing destination without `force` is left to rn_fs_cp
+  // to report.
+  RNStats srcStat;
+  RNStats destStat;
+  int statResult = dereference ? rn_fs_stat(src.c_str(), &srcStat)
+                               : rn_fs_lstat(src.c_str(), &srcStat);
+  if (statResult == 0 && (srcStat.mode & S_IFMT) == S_IFREG &&
+      (force || rn_fs_lstat(dest.c_str(), &destStat) != 0) &&
+      copyRegularFile(src, dest, static_cast<int>(mode), preserveTimestamps)) {
+    return;
+  }
+
   int result = rn_fs_cp(src.c_str(), dest.c_str(), recursive, force,
                         dereference, errorOnExist, preserveTimestamps);
   if (result != 0) {
@@ -761,8 +870,31 @@ void HybridFileSystem::cp(const std::string &rawSrc, const std::string &rawDest,
   }
 }
 
+#if defined(__ANDROID__) || defined(__APPLE__)
+// Reads up to `len` bytes from the current offset of `fd` (a content:// or
+// bookmark:// descriptor) into a pooled buffer. Null on read failure.
+static std::shared_ptr<ArrayBuffer> readIntoPooledBuffer(int fd, size_t len) {
+  BufferPool &pool = BufferPool::shared();
+  size_t capacity = 0;
+  uint8_t *data = pool.acquire(len, capacity);
+  size_t totalRead = 0;
+  while (totalRead < len) {
+    int64_t r = rn_fs_read(fd, data + totalRead, len - totalRead, -1);
+    if (r < 0) {
+      pool.recycle(data, capacity);
+      return nullptr;
+    }
+    if (r == 0)
+      break; // EOF
+    totalRead += static_cast<size_t>(r);
+  }
+  return pool.adopt(data, totalRead, capacity);
+}
+#endif
+
 std::shared_ptr<ArrayBuffer>
 HybridFileSystem::readFile(const std::string &rawPath) {
+  NITRO_FS_OP(ReadFile);
   std::string path = normalizePath(rawPath);
 
 #ifdef __ANDROID__
@@ -771,49 +903,19 @@ HybridFileSystem::readFile(const std::string &rawPath) {
   }
 
   if (path.find("content://") == 0) {
-    // 1. Open
     double fd = this->open(path, O_RDONLY, 0);
-    // 2. Stat size
     RNStats stats;
     if (rn_fs_fstat(static_cast<int>(fd), &stats) != 0) {
       this->close(fd);
       throw std::runtime_error("readFile(content://) fstat failed");
     }
-    size_t len = static_cast<size_t>(stats.size);
-
-    // 3. Allocate buffer
-    // We can't use ArrayBuffer::copy directly from nullptr.
-    // We need to alloc temp buffer then copy?
-    // Or ArrayBuffer::wrap if we have a way to alloc via it?
-    // Nitro's ArrayBuffer likely copies data.
-    // Let's allocate raw, read, then wrap.
-    uint8_t *rawData = new uint8_t[len];
-
-    // 4. Read
-    // Loop to ensure full read? ContentResolver streams usually support atomic
-    // read but loop is safer.
-    size_t totalRead = 0;
-    while (totalRead < len) {
-      int64_t r = rn_fs_read(static_cast<int>(fd), rawData + totalRead,
-                         len - totalRead, -1); // -1 for current pos
-      if (r < 0) {
-        delete[] rawData;
-        this->close(fd);
-        throw std::runtime_error("readFile(content://) read failed");
-      }
-      if (r == 0)
-        break; // EOF
-      totalRead += r;
-    }
-
-    // 5. Close
+    auto buffer = readIntoPooledBuffer(static_cast<int>(fd),
+                                       static_cast<size_t>(stats.size));
     this->close(fd);
-
-    // 6. Wrap/Copy
-    // Nitro ArrayBuffer might take ownership or copy.
-    // ArrayBuffer::copy takes (data, len) and makes a copy.
-    auto buffer = ArrayBuffer::copy(rawData, totalRead);
-    delete[] rawData;
+    if (!buffer) {
+      throw std::runtime_error("readFile(content://) read failed");
+    }
+    NITRO_FS_BYTES(buffer->size());
     return buffer;
   }
 #endif
@@ -825,41 +927,25 @@ HybridFileSystem::readFile(const std::string &rawPath) {
       this->close(fd);
       throw std::runtime_error("readFile(bookmark://) fstat failed");
     }
-    size_t len = static_cast<size_t>(stats.size);
-    uint8_t *rawData = new uint8_t[len];
-    size_t totalRead = 0;
-    while (totalRead < len) {
-      int64_t r = rn_fs_read(static_cast<int>(fd), rawData + totalRead,
-                         len - totalRead, -1);
-      if (r < 0) {
-        delete[] rawData;
-        this->close(fd);
-        throw std::runtime_error("readFile(bookmark://) read failed");
-      }
-      if (r == 0)
-        break;
-      totalRead += r;
-    }
+    auto buffer = readIntoPooledBuffer(static_cast<int>(fd),
+                                       static_cast<size_t>(stats.size));
     this->close(fd);
-    auto buffer = ArrayBuffer::copy(rawData, totalRead);
-    delete[] rawData;
+    if (!buffer) {
+      throw std::runtime_error("readFile(bookmark://) read failed");
+    }
+    NITRO_FS_BYTES(buffer->size());
     return buffer;
   }
 #endif
 
-  size_t len = 0;
-  uint8_t *data = rn_fs_read_file(path.c_str(), &len);
-  if (!data) {
-    throw std::runtime_error("readFile failed: " + path);
-  }
-
-  auto buffer = ArrayBuffer::copy(data, len);
-  rn_fs_read_file_free(data, len);
+  auto buffer = portable::readFile(path);
+  NITRO_FS_BYTES(buffer->size());
   return buffer;
 }
 
 void HybridFileSystem::writeFile(const std::string &rawPath,
                                  const std::shared_ptr<ArrayBuffer> &buffer) {
+  NITRO_FS_OP(WriteFile);
   std::string path = normalizePath(rawPath);
   if (!buffer) {
     throw std::runtime_error("buffer is null");
@@ -892,9 +978,866 @@ void HybridFileSystem::writeFile(const std::string &rawPath,
     return;
   }
 #endif
-  if (rn_fs_write_file(path.c_str(), buffer->data(), buffer->size()) != 0) {
-    throw std::runtime_error("writeFile failed: " + path);
+  portable::writeFile(path, buffer->data(), buffer->size());
+  NITRO_FS_BYTES(buffer->size());
+}
+
+static SyncLevel toSyncLevel(const std::optional<Durability> &option) {
+  switch (option.value_or(Durability::FULL)) {
+  case Durability::NONE:
+    return SyncLevel::None;
+  case Durability::DATA:
+    return SyncLevel::Data;
+  case Durability::FULL:
+  default:
+    return SyncLevel::Full;
+  }
+}
+
+static SyncLevel toSyncLevel(const std::optional<AtomicWriteOptions> &options) {
+  return toSyncLevel(options.has_value() ? options->durability : std::nullopt);
+}
+
+void HybridFileSystem::writeFileAtomic(
+    const std::string &rawPath, const std::shared_ptr<ArrayBuffer> &buffer,
+    const std::optional<AtomicWriteOptions> &options) {
+  NITRO_FS_OP(WriteFileAtomic);
+  std::string path = normalizePath(rawPath);
+  if (!buffer) {
+    throw std::runtime_error("buffer is null");
+  }
+  // content:// and bookmark:// resources cannot be renamed over, so they get
+  // a plain in-place write.
+  if (path.find("content://") == 0 || path.find("bookmark://") == 0) {
+    this->writeFile(path, buffer);
+    return;
+  }
+  atomicWriteFiles({{path, buffer->data(), buffer->size()}},
+                   toSyncLevel(options));
+  NITRO_FS_BYTES(buffer->size());
+}
+
+void HybridFileSystem::writeFilesAtomic(
+    const std::vector<AtomicWriteEntry> &entries,
+    const std::optional<AtomicWriteOptions> &options) {
+  NITRO_FS_OP(WriteFilesAtomic);
+  std::vector<AtomicWriteItem> items;
+  items.reserve(entries.size());
+  for (const auto &entry : entries) {
+    if (!entry.data) {
+      throw std::runtime_error("buffer is null: " + entry.path);
+    }
+    std::string path = normalizePath(entry.path);
+    if (path.find("content://") == 0 || path.find("bookmark://") == 0) {
+      this->writeFile(path, entry.data);
+      continue;
+    }
+    items.push_back({path, entry.data->data(), entry.data->size()});
+    NITRO_FS_BYTES(entry.data->size());
+  }
+  if (!items.empty()) {
+    atomicWriteFiles(items, toSyncLevel(options));
+  }
+}
+
+std::shared_ptr<Promise<void>>
+HybridFileSystem::compressFile(const std::string &rawSrc,
+                               const std::string &rawDest,
+                               const std::optional<CompressOptions> &options) {
+  std::string src = normalizePath(rawSrc);
+  std::string dest = normalizePath(rawDest);
+  CompressionCodec codec = CompressionCodec::Gzip;
+  int level = -1;
+  if (options.has_value()) {
+    if (options->format.has_value()) {
+      switch (options->format.value()) {
+      case CompressionFormat::GZIP:
+        codec = CompressionCodec::Gzip;
+        break;
+      case CompressionFormat::DEFLATE:
+        codec = CompressionCodec::Zlib;
+        break;
+      case CompressionFormat::ZSTD:
+        codec = CompressionCodec::Zstd;
+        break;
+      }
+    }
+    if (options->level.has_value()) {
+      level = static_cast<int>(options->level.value());
+    }
   }
+  return Promise<void>::async([src, dest, codec, level]() {
+    NITRO_FS_OP(CompressFile);
+    NITRO_FS_TRACE_PATH(src);
+    ::margelo::nitro::node_fs::compressFile(src, dest, codec, level);
+  });
+}
+
+std::shared_ptr<Promise<void>>
+HybridFileSystem::decompressFile(const std::string &rawSrc,
+                                 const std::string &rawDest) {
+  std::string src = normalizePath(rawSrc);
+  std::string dest = normalizePath(rawDest);
+  return Promise<void>::async([src, dest]() {
+    NITRO_FS_OP(DecompressFile);
+    NITRO_FS_TRACE_PATH(src);
+    ::margelo::nitro::node_fs::decompressFile(src, dest);
+  });
+}
+
+std::shared_ptr<Promise<void>>
+HybridFileSystem::tarCreate(const std::string &rawSrcDir,
+                            const std::string &rawDestFile,
+                            const std::optional<TarCreateOptions> &options) {
+  std::string srcDir = normalizePath(rawSrcDir);
+  std::string destFile = normalizePath(rawDestFile);
+  TarCreateConfig config;
+  if (options.has_value()) {
+    config.gzip = options->compress.value_or(false);
+    if (options->level.has_value()) {
+      config.level = static_cast<int>(options->level.value());
+    }
+  }
+  return Promise<void>::async([srcDir, destFile, config]() {
+    NITRO_FS_OP(TarCreate);
+    NITRO_FS_TRACE_PATH(srcDir);
+    ::margelo::nitro::node_fs::tarCreate(srcDir, destFile, config);
+  });
+}
+
+std::shared_ptr<Promise<void>>
+HybridFileSystem::tarExtract(const std::string &rawSrcFile,
+                             const std::string &rawDestDir) {
+  std::string srcFile = normalizePath(rawSrcFile);
+  std::string destDir = normalizePath(rawDestDir);
+  return Promise<void>::async([srcFile, destDir]() {
+    NITRO_FS_OP(TarExtract);
+    NITRO_FS_TRACE_PATH(srcFile);
+    ::margelo::nitro::node_fs::tarExtract(srcFile, destDir);
+  });
+}
+
+std::shared_ptr<Promise<std::shared_ptr<ArrayBuffer>>>
+HybridFileSystem::fileSignature(const std::string &rawPath,
+                                const std::optional<double> &blockSize) {
+  std::string path = normalizePath(rawPath);
+  size_t size = static_cast<size_t>(std::max(0.0, blockSize.value_or(0)));
+  return Promise<std::shared_ptr<ArrayBuffer>>::async([path, size]() {
+    NITRO_FS_OP(FileSignature);
+    NITRO_FS_TRACE_PATH(path);
+    std::vector<uint8_t> signature =
+        ::margelo::nitro::node_fs::fileSignature(path, size);
+    NITRO_FS_BYTES(signature.size());
+    return ArrayBuffer::copy(signature.data(), signature.size());
+  });
+}
+
+std::shared_ptr<Promise<DeltaStats>>
+HybridFileSystem::fileDelta(const std::string &rawPath,
+                            const std::shared_ptr<ArrayBuffer> &signature,
+                            const std::string &rawPatchPath) {
+  std::string path = normalizePath(rawPath);
+  std::string patchPath = normalizePath(rawPatchPath);
+  // The JS buffer must not be read off the JS thread.
+  std::vector<uint8_t> sig(signature->data(),
+                           signature->data() + signature->size());
+  return Promise<DeltaStats>::async(
+      [path, patchPath, sig = std::move(sig)]() {
+        NITRO_FS_OP(FileDelta);
+        NITRO_FS_TRACE_PATH(path);
+        DeltaResult result = ::margelo::nitro::node_fs::fileDelta(
+            path, sig.data(), sig.size(), patchPath);
+        NITRO_FS_BYTES(result.patchSize);
+        return DeltaStats(static_cast<double>(result.targetSize),
+                          static_cast<double>(result.copiedBytes),
+                          static_cast<double>(result.literalBytes),
+                          static_cast<double>(result.patchSize));
+      });
+}
+
+std::shared_ptr<Promise<void>>
+HybridFileSystem::applyPatch(const std::string &rawBasePath,
+                             const std::string &rawPatchPath,
+                             const std::string &rawDestPath) {
+  std::string basePath = normalizePath(rawBasePath);
+  std::string patchPath = normalizePath(rawPatchPath);
+  std::string destPath = normalizePath(rawDestPath);
+  return Promise<void>::async([basePath, patchPath, destPath]() {
+    NITRO_FS_OP(ApplyPatch);
+    NITRO_FS_TRACE_PATH(destPath);
+    ::margelo::nitro::node_fs::applyPatch(basePath, patchPath, destPath);
+  });
+}
+
+std::shared_ptr<Promise<StoreFileResult>>
+HybridFileSystem::storeFile(const std::string &rawRoot,
+                            const std::string &rawPath, const std::string &name,
+                            const std::optional<ChunkStoreOptions> &options) {
+  std::string root = normalizePath(rawRoot);
+  std::string path = normalizePath(rawPath);
+  ChunkStoreConfig config;
+  if (options.has_value()) {
+    config.level = toSyncLevel(options->durability);
+    if (options->averageChunkSize.has_value()) {
+      config.averageChunkSize = static_cast<size_t>(
+          std::max(0.0, options->averageChunkSize.value()));
+    }
+    config.parallelism =
+        static_cast<size_t>(std::max(0.0, options->parallelism.value_or(0)));
+  }
+  return Promise<StoreFileResult>::async([root, path, name, config]() {
+    NITRO_FS_OP(StoreFile);
+    NITRO_FS_TRACE_PATH(path);
+    StoredFileInfo info =
+        ::margelo::nitro::node_fs::storeFile(root, path, name, config);
+    NITRO_FS_BYTES(info.writtenBytes);
+    return StoreFileResult(static_cast<double>(info.size),
+                           static_cast<double>(info.chunks),
+                           static_cast<double>(info.newChunks),
+                           static_cast<double>(info.writtenBytes));
+  });
+}
+
+std::shared_ptr<Promise<void>>
+HybridFileSystem::restoreFile(const std::string &rawRoot,
+                              const std::string &name,
+                              const std::string &rawDest) {
+  std::string root = normalizePath(rawRoot);
+  std::string dest = normalizePath(rawDest);
+  return Promise<void>::async([root, name, dest]() {
+    NITRO_FS_OP(RestoreFile);
+    NITRO_FS_TRACE_PATH(dest);
+    ::margelo::nitro::node_fs::restoreFile(root, name, dest);
+  });
+}
+
+std::shared_ptr<Promise<bool>>
+HybridFileSystem::removeStoredFile(const std::string &rawRoot,
+                                   const std::string &name) {
+  std::string root = normalizePath(rawRoot);
+  return Promise<bool>::async([root, name]() {
+    NITRO_FS_OP(RemoveStoredFile);
+    return ::margelo::nitro::node_fs::removeStoredFile(root, name);
+  });
+}
+
+std::shared_ptr<Promise<std::vector<std::string>>>
+HybridFileSystem::listStoredFiles(const std::string &rawRoot) {
+  std::string root = normalizePath(rawRoot);
+  return Promise<std::vector<std::string>>::async([root]() {
+    NITRO_FS_OP(ListStoredFiles);
+    return ::margelo::nitro::node_fs::listStoredFiles(root);
+  });
+}
+
+std::shared_ptr<Promise<ChunkStoreGcResult>>
+HybridFileSystem::gcChunkStore(const std::string &rawRoot) {
+  std::string root = normalizePath(rawRoot);
+  return Promise<ChunkStoreGcResult>::async([root]() {
+    NITRO_FS_OP(GcChunkStore);
+    NITRO_FS_TRACE_PATH(root);
+    ChunkGcSummary summary = collectChunkGarbage(root);
+    return ChunkStoreGcResult(static_cast<double>(summary.files),
+                              static_cast<double>(summary.liveChunks),
+                              static_cast<double>(summary.removedChunks),
+                              static_cast<double>(summary.freedBytes));
+  });
+}
+
+std::shared_ptr<Promise<SearchResult>>
+HybridFileSystem::searchFiles(const std::vector<std::string> &rawPaths,
+                              const std::string &pattern,
+                              const std::optional<SearchOptions> &options) {
+  std::vector<std::string> paths;
+  paths.reserve(rawPaths.size());
+  for (const auto &rawPath : rawPaths) {
+    paths.push_back(normalizePath(rawPath));
+  }
+  SearchConfig config;
+  if (options.has_value()) {
+    config.regex = options->regex.value_or(false);
+    config.ignoreCase = options->caseInsensitive.value_or(false);
+    if (options->maxResults.has_value()) {
+      config.maxResults =
+          static_cast<size_t>(std::max(1.0, *options->maxResults));
+    }
+    config.parallelism =
+        static_cast<size_t>(std::max(0.0, options->parallelism.value_or(0)));
+  }
+  return Promise<SearchResult>::async([paths = std::move(paths), pattern,
+                                       config]() {
+    NITRO_FS_OP(SearchFiles);
+    if (!paths.empty()) {
+      NITRO_FS_TRACE_PATH(paths.front());
+    }
+    SearchSummary summary =
+        ::margelo::nitro::node_fs::searchFiles(paths, pattern, config);
+    std::vector<SearchMatch> matches;
+    matches.reserve(summary.hits.size());
+    for (auto &hit : summary.hits) {
+      matches.emplace_back(std::move(hit.path), static_cast<double>(hit.offset),
+                           static_cast<double>(hit.line),
+                           static_cast<double>(hit.column),
+                           std::move(hit.text));
+    }
+    return SearchResult(std::move(matches),
+                        static_cast<double>(summary.filesSearched),
+                        static_cast<double>(summary.filesSkipped),
+                        summary.truncated);
+  });
+}
+
+std::shared_ptr<Promise<bool>>
+HybridFileSystem::compareFiles(const std::string &rawA,
+                               const std::string &rawB) {
+  std::string a = normalizePath(rawA);
+  std::string b = normalizePath(rawB);
+  return Promise<bool>::async([a, b]() {
+    NITRO_FS_OP(CompareFiles);
+    NITRO_FS_TRACE_PATH(a);
+    return filesEqual(a, b);
+  });
+}
+
+static TreeCompare toTreeCompare(const std::optional<TreeCompareMode> &mode) {
+  switch (mode.value_or(TreeCompareMode::MTIME)) {
+  case TreeCompareMode::SIZE:
+    return TreeCompare::Size;
+  case TreeCompareMode::CONTENT:
+    return TreeCompare::Content;
+  case TreeCompareMode::MTIME:
+  default:
+    return TreeCompare::Mtime;
+  }
+}
+
+std::shared_ptr<Promise<TreeDiffResult>>
+HybridFileSystem::diffTrees(const std::string &rawA, const std::string &rawB,
+                            const std::optional<TreeDiffOptions> &options) {
+  std::string a = normalizePath(rawA);
+  std::string b = normalizePath(rawB);
+  TreeDiffConfig config;
+  if (options.has_value()) {
+    config.compare = toTreeCompare(options->compare);
+    config.parallelism =
+        static_cast<size_t>(std::max(0.0, options->parallelism.value_or(0)));
+  }
+  return Promise<TreeDiffResult>::async([a, b, config]() {
+    NITRO_FS_OP(DiffTrees);
+    NITRO_FS_TRACE_PATH(a);
+    TreeDiffSummary summary = ::margelo::nitro::node_fs::diffTrees(a, b, config);
+    return TreeDiffResult(std::move(summary.added), std::move(summary.removed),
+                          std::move(summary.changed));
+  });
+}
+
+std::shared_ptr<Promise<std::shared_ptr<HybridHybridJsonDocumentSpec>>>
+HybridFileSystem::parseJSONFile(const std::string &rawPath) {
+  std::string path = normalizePath(rawPath);
+  return Promise<std::shared_ptr<HybridHybridJsonDocumentSpec>>::async(
+      [path]() -> std::shared_ptr<HybridHybridJsonDocumentSpec> {
+        NITRO_FS_OP(ReadJSON);
+        NITRO_FS_TRACE_PATH(path);
+        std::shared_ptr<JsonTape> tape = readJsonFile(path);
+        size_t size = tape->inputSize();
+        NITRO_FS_BYTES(size);
+        return std::make_shared<HybridJsonDocument>(std::move(tape), size);
+      });
+}
+
+void HybridFileSystem::loadHybridMethods() {
+  HybridHybridFileSystemSpec::loadHybridMethods();
+  registerHybrids(this, [](Prototype &prototype) {
+    prototype.registerRawHybridMethod("writeJSON", 2,
+                                      &HybridFileSystem::writeJSON);
+  });
+}
+
+jsi::Value HybridFileSystem::writeJSON(jsi::Runtime &runtime,
+                                       const jsi::Value &, const jsi::Value *args,
+                                       size_t count) {
+  if (count < 2 || !args[0].isString()) {
+    throw std::invalid_argument("writeJSON: expected (path, value, options?)");
+  }
+  std::string path = normalizePath(args[0].getString(runtime).utf8(runtime));
+  SyncLevel level = SyncLevel::Full;
+  if (count > 2 && args[2].isObject()) {
+    jsi::Value durability =
+        args[2].getObject(runtime).getProperty(runtime, "durability");
+    if (durability.isString()) {
+      std::string name = durability.getString(runtime).utf8(runtime);
+      level = name == "none" ? SyncLevel::None
+              : name == "data" ? SyncLevel::Data
+                               : SyncLevel::Full;
+    }
+  }
+  auto json = std::make_shared<std::string>();
+  appendJsonValue(runtime, args[1], *json);
+  auto promise = Promise<void>::async([path, json, level]() {
+    NITRO_FS_OP(WriteJSON);
+    NITRO_FS_TRACE_PATH(path);
+    atomicWriteFiles(
+        {{path, reinterpret_cast<const uint8_t *>(json->data()), json->size()}},
+        level);
+    NITRO_FS_BYTES(json->size());
+  });
+  return JSIConverter<std::shared_ptr<Promise<void>>>::toJSI(runtime, promise);
+}
+
+static LineIndexConfig
+toLineIndexConfig(const std::optional<LineIndexOptions> &options) {
+  LineIndexConfig config;
+  if (options.has_value()) {
+    if (options->stride.has_value() && *options->stride >= 1) {
+      config.stride = static_cast<size_t>(*options->stride);
+    }
+    if (options->indexPath.has_value()) {
+      config.indexPath = *options->indexPath;
+    }
+  }
+  return config;
+}
+
+std::shared_ptr<Promise<LineIndexResult>>
+HybridFileSystem::buildLineIndex(const std::string &rawPath,
+                                 const std::optional<LineIndexOptions> &options) {
+  std::string path = normalizePath(rawPath);
+  LineIndexConfig config = toLineIndexConfig(options);
+  return Promise<LineIndexResult>::async([path, config]() {
+    NITRO_FS_OP(BuildLineIndex);
+    NITRO_FS_TRACE_PATH(path);
+    LineIndexStats stats =
+        ::margelo::nitro::node_fs::buildLineIndex(path, config);
+    NITRO_FS_BYTES(stats.scannedBytes);
+    return LineIndexResult(static_cast<double>(stats.lines),
+                           static_cast<double>(stats.size),
+                           static_cast<double>(stats.checkpoints),
+                           static_cast<double>(stats.scannedBytes));
+  });
+}
+
+std::shared_ptr<Promise<std::vector<std::string>>>
+HybridFileSystem::readLines(const std::string &rawPath, double startLine,
+                            double count,
+                            const std::optional<LineIndexOptions> &options) {
+  std::string path = normalizePath(rawPath);
+  LineIndexConfig config = toLineIndexConfig(options);
+  uint64_t first = static_cast<uint64_t>(std::max(0.0, startLine));
+  size_t lines = static_cast<size_t>(std::max(0.0, count));
+  return Promise<std::vector<std::string>>::async([path, first, lines,
+                                                   config]() {
+    NITRO_FS_OP(ReadLines);
+    NITRO_FS_TRACE_PATH(path);
+    std::vector<std::string> result =
+        ::margelo::nitro::node_fs::readLines(path, first, lines, config);
+    size_t bytes = 0;
+    for (const auto &line : result) {
+      bytes += line.size();
+    }
+    NITRO_FS_BYTES(bytes);
+    return result;
+  });
+}
+
+std::shared_ptr<Promise<DiskUsageResult>>
+HybridFileSystem::du(const std::string &rawPath,
+                     const std::optional<DiskUsageOptions> &options) {
+  std::string path = normalizePath(rawPath);
+  DiskUsageConfig config;
+  if (options.has_value()) {
+    config.followSymlinks = options->followSymlinks.value_or(false);
+    config.countHardlinksOnce = options->countHardlinksOnce.value_or(true);
+    config.perChild = options->perChild.value_or(false);
+    config.parallelism =
+        static_cast<size_t>(std::max(0.0, options->parallelism.value_or(0)));
+  }
+  return Promise<DiskUsageResult>::async([path, config]() {
+    NITRO_FS_OP(Du);
+    NITRO_FS_TRACE_PATH(path);
+    DiskUsageSummary summary = diskUsage(path, config);
+    std::optional<std::vector<DiskUsageChild>> children;
+    if (config.perChild) {
+      children.emplace();
+      children->reserve(summary.children.size());
+      for (auto &[name, totals] : summary.children) {
+        children->emplace_back(std::move(name),
+                               static_cast<double>(totals.size),
+                               static_cast<double>(totals.allocated),
+                               static_cast<double>(totals.files),
+                               static_cast<double>(totals.dirs));
+      }
+    }
+    return DiskUsageResult(static_cast<double>(summary.total.size),
+                           static_cast<double>(summary.total.allocated),
+                           static_cast<double>(summary.total.files),
+                           static_cast<double>(summary.total.dirs),
+                           static_cast<double>(summary.skipped),
+                           std::move(children));
+  });
+}
+
+static FileAdvice toFileAdvice(FileAdviceType advice) {
+  switch (advice) {
+  case FileAdviceType::NORMAL:
+    return FileAdvice::Normal;
+  case FileAdviceType::SEQUENTIAL:
+    return FileAdvice::Sequential;
+  case FileAdviceType::RANDOM:
+    return FileAdvice::Random;
+  case FileAdviceType::WILLNEED:
+    return FileAdvice::WillNeed;
+  case FileAdviceType::DONTNEED:
+    return FileAdvice::DontNeed;
+  }
+  throw std::runtime_error("advise: unknown advice");
+}
+
+void HybridFileSystem::advise(const std::string &rawPath, double offset,
+                              double length, FileAdviceType advice) {
+  NITRO_FS_OP(Advise);
+  std::string path = normalizePath(rawPath);
+  advisePath(path, static_cast<uint64_t>(std::max(0.0, offset)),
+             static_cast<uint64_t>(std::max(0.0, length)),
+             toFileAdvice(advice));
+}
+
+void HybridFileSystem::fadvise(double fd, double offset, double length,
+                               FileAdviceType advice) {
+  NITRO_FS_OP(Advise);
+  adviseFd(static_cast<int>(fd), static_cast<uint64_t>(std::max(0.0, offset)),
+           static_cast<uint64_t>(std::max(0.0, length)), toFileAdvice(advice));
+}
+
+std::shared_ptr<Promise<PrefetchResult>>
+HybridFileSystem::prefetch(const std::vector<std::string> &rawPaths,
+                           const std::optional<PrefetchOptions> &options) {
+  std::vector<std::string> paths;
+  paths.reserve(rawPaths.size());
+  for (const auto &rawPath : rawPaths) {
+    paths.push_back(normalizePath(rawPath));
+  }
+  size_t parallelism =
+      options.has_value()
+          ? static_cast<size_t>(
+                std::max(0.0, options->parallelism.value_or(0)))
+          : 0;
+  return Promise<PrefetchResult>::async(
+      [paths = std::move(paths), parallelism]() {
+        NITRO_FS_OP(Prefetch);
+        PrefetchSummary summary = prefetchFiles(paths, parallelism);
+        return PrefetchResult(static_cast<double>(summary.files),
+                              static_cast<double>(summary.bytes),
+                              static_cast<double>(summary.failed));
+      });
+}
+
+static BatchKind toBatchKind(BatchOpType type) {
+  switch (type) {
+  case BatchOpType::STAT:
+    return BatchKind::Stat;
+  case BatchOpType::LSTAT:
+    return BatchKind::Lstat;
+  case BatchOpType::EXISTS:
+    return BatchKind::Exists;
+  case BatchOpType::ACCESS:
+    return BatchKind::Access;
+  case BatchOpType::MKDIR:
+    return BatchKind::Mkdir;
+  case BatchOpType::READFILE:
+    return BatchKind::ReadFile;
+  case BatchOpType::WRITEFILE:
+    return BatchKind::WriteFile;
+  case BatchOpType::READDIR:
+    return BatchKind::Readdir;
+  case BatchOpType::UNLINK:
+    return BatchKind::Unlink;
+  case BatchOpType::RMDIR:
+    return BatchKind::Rmdir;
+  case BatchOpType::RM:
+    return BatchKind::Rm;
+  case BatchOpType::RENAME:
+    return BatchKind::Rename;
+  case BatchOpType::COPYFILE:
+    return BatchKind::CopyFile;
+  case BatchOpType::CHMOD:
+    return BatchKind::Chmod;
+  }
+  throw std::runtime_error("batch: unknown operation");
+}
+
+static BatchConfig toBatchConfig(const std::optional<BatchOptions> &options) {
+  BatchConfig config;
+  if (options.has_value()) {
+    config.parallel = options->parallel.value_or(false);
+    config.parallelism =
+        static_cast<size_t>(std::max(0.0, options->parallelism.value_or(0)));
+    config.stopOnError = options->stopOnError.value_or(false);
+  }
+  return config;
+}
+
+static std::vector<BatchResult>
+toBatchResults(std::vector<BatchOutcome> &&outcomes) {
+  std::vector<BatchResult> results;
+  results.reserve(outcomes.size());
+  for (auto &outcome : outcomes) {
+    bool ok = outcome.error == 0;
+    std::optional<Stats> stats;
+    if (outcome.stats.has_value()) {
+      stats = toStats(outcome.stats.value());
+    }
+    std::optional<std::shared_ptr<ArrayBuffer>> data;
+    if (outcome.data) {
+      data = std::move(outcome.data);
+    }
+    results.push_back(BatchResult(
+        ok, static_cast<double>(outcome.error),
+        ok ? std::nullopt : std::optional<std::string>(errnoName(outcome.error)),
+        ok ? std::nullopt : std::optional<std::string>(outcome.message),
+        std::move(stats), std::move(data), std::move(outcome.entries),
+        outcome.exists));
+  }
+  return results;
+}
+
+// Paths are normalized here, on the calling thread. Only plain paths (and
+// file:// URIs) are supported; content://, asset and bookmark URIs fail with
+// the error of the underlying call.
+std::vector<BatchRequest>
+HybridFileSystem::toBatchRequests(const std::vector<BatchOp> &ops,
+                                  bool copyData) {
+  std::vector<BatchRequest> requests;
+  requests.reserve(ops.size());
+  for (const auto &op : ops) {
+    BatchRequest request;
+    request.kind = toBatchKind(op.op);
+    request.path = normalizePath(op.path);
+    if (op.dest.has_value()) {
+      request.dest = normalizePath(op.dest.value());
+    }
+    if (op.data.has_value() && op.data.value()) {
+      const auto &buffer = op.data.value();
+      // JS-owned buffers must not be touched once we leave the JS thread.
+      request.data = copyData ? ArrayBuffer::copy(buffer->data(), buffer->size())
+                              : buffer;
+    }
+    int defaultMode = request.kind == BatchKind::Mkdir ? 0777 : 0;
+    request.mode = static_cast<int>(op.mode.value_or(defaultMode));
+    request.recursive = op.recursive.value_or(false);
+    requests.push_back(std::move(request));
+  }
+  return requests;
+}
+
+std::vector<BatchResult>
+HybridFileSystem::batch(const std::vector<BatchOp> &ops,
+                        const std::optional<BatchOptions> &options) {
+  NITRO_FS_OP(Batch);
+  BatchConfig config = toBatchConfig(options);
+  // A parallel batch fans out to worker threads, so its buffers need the
+  // same copy as batchAsync.
+  auto requests = toBatchRequests(ops, config.parallel);
+  return toBatchResults(runBatch(requests, config));
+}
+
+std::shared_ptr<Promise<std::vector<BatchResult>>>
+HybridFileSystem::batchAsync(const std::vector<BatchOp> &ops,
+                             const std::optional<BatchOptions> &options) {
+  auto requests = toBatchRequests(ops, true);
+  BatchConfig config = toBatchConfig(options);
+  return Promise<std::vector<BatchResult>>::async(
+      [requests = std::move(requests), config]() {
+        NITRO_FS_OP(Batch);
+        return toBatchResults(runBatch(requests, config));
+      });
+}
+
+std::shared_ptr<Promise<std::vector<BatchResult>>>
+HybridFileSystem::statMany(const std::vector<std::string> &rawPaths,
+                           const std::optional<StatManyOptions> &options) {
+  std::vector<std::string> paths;
+  paths.reserve(rawPaths.size());
+  for (const auto &rawPath : rawPaths) {
+    paths.push_back(normalizePath(rawPath));
+  }
+  bool followLinks = !options.has_value() ||
+                     options->followSymlinks.value_or(true);
+  return Promise<std::vector<BatchResult>>::async(
+      [paths = std::move(paths), followLinks]() {
+        NITRO_FS_OP(StatMany);
+        return toBatchResults(
+            ::margelo::nitro::node_fs::statMany(paths, followLinks));
+      });
+}
+
+std::shared_ptr<Promise<std::vector<BatchResult>>>
+HybridFileSystem::readFileMany(const std::vector<std::string> &rawPaths) {
+  std::vector<std::string> paths;
+  paths.reserve(rawPaths.size());
+  for (const auto &rawPath : rawPaths) {
+    paths.push_back(normalizePath(rawPath));
+  }
+  return Promise<std::vector<BatchResult>>::async(
+      [paths = std::move(paths)]() {
+        NITRO_FS_OP(ReadFileMany);
+        auto outcomes = ::margelo::nitro::node_fs::readFileMany(paths);
+        for (const auto &outcome : outcomes) {
+          if (outcome.data) {
+            NITRO_FS_BYTES(outcome.data->size());
+          }
+        }
+        return toBatchResults(std::move(outcomes));
+      });
+}
+
+static std::vector<ByteRange> toByteRanges(const std::vector<ReadRange> &ranges) {
+  std::vector<ByteRange> result;
+  result.reserve(ranges.size());
+  for (const auto &range : ranges) {
+    if (!(range.position >= 0) || !(range.length >= 0)) {
+      throw std::runtime_error("readRanges: position and length must be "
+                               "non-negative numbers");
+    }
+    result.push_back({static_cast<uint64_t>(range.position),
+                      static_cast<size_t>(range.length)});
+  }
+  return result;
+}
+
+static size_t toMaxGap(const std::optional<ReadRangesOptions> &options) {
+  if (!options.has_value() || !options->maxGap.has_value()) {
+    return 0;
+  }
+  return static_cast<size_t>(std::max(0.0, options->maxGap.value()));
+}
+
+static ReadRangesResult toReadRangesResult(std::shared_ptr<ArrayBuffer> buffer,
+                                           const RangeReadPlan &plan,
+                                           const RangeReadResult &read) {
+  std::vector<double> offsets(plan.offsets.begin(), plan.offsets.end());
+  std::vector<double> lengths(read.lengths.begin(), read.lengths.end());
+  return ReadRangesResult(std::move(buffer), std::move(offsets),
+                          std::move(lengths),
+                          static_cast<double>(read.bytesRead));
+}
+
+ReadRangesResult HybridFileSystem::readRanges(
+    double fd, const std::vector<ReadRange> &ranges,
+    const std::optional<std::shared_ptr<ArrayBuffer>> &dest,
+    const std::optional<ReadRangesOptions> &options) {
+  NITRO_FS_OP(ReadRanges);
+  std::vector<ByteRange> byteRanges = toByteRanges(ranges);
+  RangeReadPlan plan = planRangeRead(byteRanges, toMaxGap(options));
+  std::shared_ptr<ArrayBuffer> buffer;
+  if (dest.has_value() && dest.value()) {
+    buffer = dest.value();
+    if (buffer->size() < plan.totalSize) {
+      throw std::runtime_error("readRanges: destination buffer too small, " +
+                               std::to_string(plan.totalSize) +
+                               " bytes needed");
+    }
+  } else {
+    buffer = ArrayBuffer::allocate(plan.totalSize);
+  }
+  RangeReadResult read = ::margelo::nitro::node_fs::readRanges(
+      static_cast<int>(fd), byteRanges, plan, buffer->data());
+  NITRO_FS_BYTES(read.bytesRead);
+  return toReadRangesResult(std::move(buffer), plan, read);
+}
+
+std::shared_ptr<Promise<ReadRangesResult>> HybridFileSystem::readRangesAsync(
+    double fd, const std::vector<ReadRange> &ranges,
+    const std::optional<ReadRangesOptions> &options) {
+  std::vector<ByteRange> byteRanges = toByteRanges(ranges);
+  size_t maxGap = toMaxGap(options);
+  return Promise<ReadRangesResult>::async(
+      [fd = static_cast<int>(fd), byteRanges = std::move(byteRanges),
+       maxGap]() {
+        NITRO_FS_OP(ReadRanges);
+        RangeReadPlan plan = planRangeRead(byteRanges, maxGap);
+        std::shared_ptr<ArrayBuffer> buffer =
+            ArrayBuffer::allocate(plan.totalSize);
+        RangeReadResult read = ::margelo::nitro::node_fs::readRanges(
+            fd, byteRanges, plan, buffer->data());
+        NITRO_FS_BYTES(read.bytesRead);
+        return toReadRangesResult(std::move(buffer), plan, read);
+      });
+}
+
+std::string HybridFileSystem::getIoEngine() {
+  return ioEngineName(IoEngine::Auto);
+}
+
+std::shared_ptr<ArrayBuffer> HybridFileSystem::leaseBuffer(double size) {
+  if (!(size >= 0)) {
+    throw std::runtime_error("leaseBuffer: size must be a non-negative number");
+  }
+  return BufferPool::shared().lease(static_cast<size_t>(size));
+}
+
+void HybridFileSystem::trimBufferPool() { BufferPool::shared().trim(); }
+
+void HybridFileSystem::setBufferPoolLimit(double bytes) {
+  BufferPool::shared().setLimit(static_cast<size_t>(std::max(0.0, bytes)));
+}
+
+BufferPoolStats HybridFileSystem::getBufferPoolStats() {
+  BufferPool::Stats s = BufferPool::shared().stats();
+  return BufferPoolStats(
+      static_cast<double>(s.hits), static_cast<double>(s.misses),
+      static_cast<double>(s.trims), static_cast<double>(s.cachedBytes),
+      static_cast<double>(s.leasedBytes), static_cast<double>(s.activeLeases),
+      static_cast<double>(s.limitBytes));
+}
+
+void HybridFileSystem::observeMemoryPressure() {
+  // Android forwards onTrimMemory from NitroFileSystemUtils instead.
+#ifdef __APPLE__
+  static std::once_flag once;
+  std::call_once(once, []() {
+    ::nitro::fs::observeMemoryWarningsIOS(
+        []() { BufferPool::shared().trim(); });
+  });
+#endif
+}
+
+std::vector<OpMetrics> HybridFileSystem::getMetrics() {
+  constexpr double kNsPerMs = 1e6;
+  std::vector<OpMetrics> result;
+  for (const auto &s : metrics::snapshot()) {
+    result.push_back(OpMetrics(
+        fsOpName(s.op), static_cast<double>(s.calls),
+        static_cast<double>(s.errors), static_cast<double>(s.bytes),
+        s.totalNs / kNsPerMs, s.totalNs / kNsPerMs / s.calls,
+        s.maxNs / kNsPerMs, s.percentileNs(0.5) / kNsPerMs,
+        s.percentileNs(0.9) / kNsPerMs, s.percentileNs(0.99) / kNsPerMs,
+        s.percentileNs(0.999) / kNsPerMs));
+  }
+  return result;
+}
+
+void HybridFileSystem::resetMetrics() { metrics::reset(); }
+
+void HybridFileSystem::startTracing(const std::optional<TraceOptions> &options) {
+  size_t eventsPerThread = trace::kDefaultEventsPerThread;
+  if (options.has_value() && options->eventsPerThread.has_value()) {
+    double requested = options->eventsPerThread.value();
+    if (requested < 1) {
+      throw std::runtime_error("eventsPerThread must be at least 1");
+    }
+    eventsPerThread = static_cast<size_t>(requested);
+  }
+  trace::start(eventsPerThread);
+}
+
+void HybridFileSystem::stopTracing() { trace::stop(); }
+
+std::shared_ptr<Promise<double>>
+HybridFileSystem::dumpTrace(const std::string &rawPath) {
+  std::string path = normalizePath(rawPath);
+  return Promise<double>::async([path]() {
+    return static_cast<double>(trace::dump(path));
+  });
 }
 
 std::string HybridFileSystem::getBookmark(const std::string &rawPath) {
@@ -1024,6 +1967,7 @@ std::unordered_map<std::string, std::string> HybridFileSystem::getFileProtection
 
 std::shared_ptr<HybridHybridDirIteratorSpec>
 HybridFileSystem::opendir(const std::string &rawPath) {
+  NITRO_FS_OP(Opendir);
   std::string path = normalizePath(rawPath);
 
 #ifdef __APPLE__
@@ -1054,98 +1998,159 @@ std::shared_ptr<HybridHybridFileWatcherSpec> HybridFileSystem::watch(
     const std::string &rawPath,
     const std::function<void(const std::string &, const std::string &)>
         &onChange) {
+  NITRO_FS_OP(Watch);
   std::string path = normalizePath(rawPath);
   return std::make_shared<HybridFileWatcher>(path, onChange);
 }
 
+// JS numbers are doubles; a negative, NaN or oversized option would wrap (or be
+// undefined behavior) when cast to the unsigned config fields.
+static double toLogWriterOption(const char *name, double value, double max) {
+  if (!(value >= 0) || value > max) {
+    throw std::runtime_error(std::string("createLogWriter: ") + name +
+                             " must be a number between 0 and " +
+                             std::to_string(static_cast<uint64_t>(max)));
+  }
+  return value;
+}
+
+static LogWriterConfig
+toLogWriterConfig(const std::optional<LogWriterOptions> &options) {
+  LogWriterConfig config;
+  if (!options.has_value()) {
+    return config;
+  }
+  constexpr double kMaxUint32 = 4294967295.0;
+  if (options->bufferSize.has_value())
+    config.bufferSize = static_cast<size_t>(toLogWriterOption(
+        "bufferSize", *options->bufferSize, LogWriterConfig::kMaxBufferSize));
+  if (options->flushBytes.has_value())
+    config.flushBytes = static_cast<size_t>(toLogWriterOption(
+        "flushBytes", *options->flushBytes, LogWriterConfig::kMaxBufferSize));
+  if (options->flushIntervalMs.has_value())
+    config.flushIntervalMs = static_cast<uint32_t>(toLogWriterOption(
+        "flushIntervalMs", *options->flushIntervalMs, kMaxUint32));
+  if (options->maxFileSize.has_value())
+    config.maxFileSize = static_cast<uint64_t>(toLogWriterOption(
+        "maxFileSize", *options->maxFileSize, 9007199254740991.0));
+  if (options->maxFiles.has_value())
+    config.maxFiles = static_cast<uint32_t>(
+        toLogWriterOption("maxFiles", *options->maxFiles, kMaxUint32));
+  return config;
+}
+
+std::shared_ptr<HybridHybridLogWriterSpec> HybridFileSystem::createLogWriter(
+    const std::string &rawPath,
+    const std::optional<LogWriterOptions> &options) {
+  NITRO_FS_OP(CreateLogWriter);
+  std::string path = normalizePath(rawPath);
+  return std::make_shared<HybridLogWriter>(path, toLogWriterConfig(options));
+}
+
+std::shared_ptr<HybridHybridFileTailSpec>
+HybridFileSystem::tail(const std::string &rawPath,
+                       const std::function<void(const TailBatch &)> &onBatch,
+                       const std::optional<TailOptions> &options) {
+  NITRO_FS_OP(Tail);
+  std::string path = normalizePath(rawPath);
+  TailConfig config;
+  if (options.has_value()) {
+    config.fromEnd = options->fromEnd.value_or(true);
+    config.lines = options->lines.value_or(false);
+    if (options->pollIntervalMs.has_value())
+      config.pollIntervalMs =
+          static_cast<uint32_t>(std::max(0.0, options->pollIntervalMs.value()));
+    if (options->maxBatchBytes.has_value())
+      config.maxBatchBytes =
+          static_cast<size_t>(std::max(0.0, options->maxBatchBytes.value()));
+  }
+  return std::make_shared<HybridFileTail>(path, config, onBatch);
+}
+
+std::shared_ptr<HybridHybridZipArchiveSpec>
+HybridFileSystem::openZip(const std::string &rawPath) {
+  NITRO_FS_OP(OpenZip);
+  std::string path = normalizePath(rawPath);
+  return std::make_shared<HybridZipArchive>(path);
+}
+
 std::string HybridFileSystem::normalizePath(const std::string &path) {
-  if (path.find("file://") == 0) {
-    return path.substr(7);
-  } else if (path.find("file:/") == 0) {
-    return path.substr(5);
-  } else if (path.find("asset://") == 0) {
+  std::string normalized = [&]() -> std::string {
+    if (path.find("file://") == 0) {
+      return path.substr(7);
+    } else if (path.find("file:/") == 0) {
+      return path.substr(5);
+    } else if (path.find("asset://") == 0) {
 #ifdef __APPLE__
-    std::string relPath = path.substr(8);
-    std::string bundlePath = this->getMainBundlePath();
-    if (relPath.empty() || relPath == "/")
-      return bundlePath;
-    if (relPath[0] == '/')
-      return bundlePath + relPath;
-    return bundlePath + "/" + relPath;
+      std::string relPath = path.substr(8);
+      std::string bundlePath = this->getMainBundlePath();
+      if (relPath.empty() || relPath == "/")
+        return bundlePath;
+      if (relPath[0] == '/')
+        return bundlePath + relPath;
+      return bundlePath + "/" + relPath;
 #endif
+    }
+    return path;
+  }();
+  NITRO_FS_TRACE_PATH(normalized);
+  return normalized;
+}
+
+
+// Builds the iovecs for buffer slices in the thread's scratch array, so
+// vectored I/O on Buffer views neither copies nor allocates.
+static std::vector<RNIovec> &
+toIovecs(const char *op,
+         const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
+         const std::vector<double> &offsets,
+         const std::vector<double> &lengths) {
+  if (offsets.size() != buffers.size() || lengths.size() != buffers.size()) {
+    throw std::runtime_error(std::string(op) +
+                             ": buffers, offsets and lengths differ in size");
+  }
+  std::vector<RNIovec> &iovecs = portable::iovecScratch();
+  iovecs.clear();
+  for (size_t i = 0; i < buffers.size(); i++) {
+    const auto &buffer = buffers[i];
+    size_t size = buffer ? buffer->size() : 0;
+    double offset = offsets[i];
+    double length = lengths[i];
+    if (!(offset >= 0) || !(length >= 0) ||
+        offset + length > static_cast<double>(size)) {
+      throw std::runtime_error(std::string(op) + ": slice " +
+                               std::to_string(i) + " is out of bounds");
+    }
+    if (length > 0) {
+      iovecs.push_back({buffer->data() + static_cast<size_t>(offset),
+                        static_cast<size_t>(length)});
+    }
   }
-  return path;
+  return iovecs;
 }
 
-
 double HybridFileSystem::readv(
     double fd, const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
+    const std::vector<double> &offsets, const std::vector<double> &lengths,
     double position) {
-  if (buffers.empty()) {
-    return 0;
-  }
-
-  // Build iovec array
-  std::vector<RNIovec> iovecs;
-  iovecs.reserve(buffers.size());
-
-  for (const auto &buf : buffers) {
-    if (buf) {
-      RNIovec iov;
-      iov.base = buf->data();
-      iov.len = buf->size();
-      iovecs.push_back(iov);
-    }
-  }
-
-  if (iovecs.empty()) {
-    return 0;
-  }
-
-  intptr_t result = rn_fs_readv(static_cast<int>(fd), iovecs.data(),
-                                static_cast<int>(iovecs.size()),
-                                static_cast<int64_t>(position));
-
-  if (result < 0) {
-    throw std::runtime_error("readv failed");
-  }
-
-  return static_cast<double>(result);
+  NITRO_FS_OP(Readv);
+  std::vector<RNIovec> &iovecs = toIovecs("readv", buffers, offsets, lengths);
+  size_t bytes = portable::readv(static_cast<int>(fd), iovecs.data(),
+                                 iovecs.size(), static_cast<int64_t>(position));
+  NITRO_FS_BYTES(bytes);
+  return static_cast<double>(bytes);
 }
 
 double HybridFileSystem::writev(
     double fd, const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
+    const std::vector<double> &offsets, const std::vector<double> &lengths,
     double position) {
-  if (buffers.empty()) {
-    return 0;
-  }
-
-  // Build iovec array
-  std::vector<RNIovec> iovecs;
-  iovecs.reserve(buffers.size());
-
-  for (const auto &buf : buffers) {
-    if (buf) {
-      RNIovec iov;
-      iov.base = buf->data();
-      iov.len = buf->size();
-      iovecs.push_back(iov);
-    }
-  }
-
-  if (iovecs.empty()) {
-    return 0;
-  }
-
-  intptr_t result = rn_fs_writev(static_cast<int>(fd), iovecs.data(),
-                                 static_cast<int>(iovecs.size()),
-                                 static_cast<int64_t>(position));
-
-  if (result < 0) {
-    throw std::runtime_error("writev failed");
-  }
-
-  return static_cast<double>(result);
+  NITRO_FS_OP(Writev);
+  std::vector<RNIovec> &iovecs = toIovecs("writev", buffers, offsets, lengths);
+  size_t bytes = portable::writev(static_cast<int>(fd), iovecs.data(),
+                                  iovecs.size(), static_cast<int64_t>(position));
+  NITRO_FS_BYTES(bytes);
+  return static_cast<double>(bytes);
 }
 
 std::shared_ptr<Promise<std::vector<PickedFile>>> HybridFileSystem::pickFiles(const FilePickerOptions& options) {
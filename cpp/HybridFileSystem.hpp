@@ -1,5 +1,6 @@
 #pragma once
 #include "HybridHybridFileSystemSpec.hpp"
+#include "BatchOps.hpp"
 #include "rust_c_file_system.h"
 #include <NitroModules/ArrayBuffer.hpp>
 #include <NitroModules/HybridObject.hpp>
@@ -17,6 +18,7 @@ public:
     // Debug: constructor called successfully
     std::cout << "[HybridFileSystem] Constructor called successfully"
               << std::endl;
+    observeMemoryPressure();
   }
 
   // Properties
@@ -43,6 +45,10 @@ public:
   void truncate(const std::string &path, double len) override;
   void ftruncate(double fd, double len) override;
   void fsync(double fd) override;
+  void fallocate(double fd, double offset, double length,
+                 const std::optional<FallocateOptions> &options) override;
+  double seekData(double fd, double offset) override;
+  double seekHole(double fd, double offset) override;
 
   void chmod(const std::string &path, double mode) override;
   void lchmod(const std::string &path, double mode) override;
@@ -68,6 +74,11 @@ public:
   Stats stat(const std::string &path) override;
   Stats lstat(const std::string &path) override;
   Stats fstat(double fd) override;
+  StatFs statfs(const std::string &path) override;
+  std::shared_ptr<HybridHybridSpaceMonitorSpec>
+  monitorSpace(const std::string &path, double thresholdBytes,
+               const std::function<void(bool, const StatFs &)> &onChange,
+               const std::optional<SpaceMonitorOptions> &options) override;
 
   void mkdir(const std::string &path, double mode, bool recursive) override;
   void rmdir(const std::string &path) override;
@@ -79,7 +90,7 @@ public:
                 double flags) override;
   void cp(const std::string &src, const std::string &dest, bool recursive,
           bool force, bool dereference, bool errorOnExist,
-          bool preserveTimestamps) override;
+          bool preserveTimestamps, double mode) override;
 
   std::shared_ptr<HybridHybridDirIteratorSpec>
   opendir(const std::string &path) override;
@@ -87,18 +98,154 @@ public:
   watch(const std::string &path,
         const std::function<void(const std::string &, const std::string &)>
             &onChange) override;
+  std::shared_ptr<HybridHybridLogWriterSpec>
+  createLogWriter(const std::string &path,
+                  const std::optional<LogWriterOptions> &options) override;
+  std::shared_ptr<HybridHybridFileTailSpec>
+  tail(const std::string &path,
+       const std::function<void(const TailBatch &)> &onBatch,
+       const std::optional<TailOptions> &options) override;
+  std::shared_ptr<HybridHybridZipArchiveSpec>
+  openZip(const std::string &path) override;
 
   std::shared_ptr<ArrayBuffer> readFile(const std::string &path) override;
   void writeFile(const std::string &path,
                  const std::shared_ptr<ArrayBuffer> &buffer) override;
 
+  // Atomic writes
+  void writeFileAtomic(const std::string &path,
+                       const std::shared_ptr<ArrayBuffer> &buffer,
+                       const std::optional<AtomicWriteOptions> &options) override;
+  void writeFilesAtomic(const std::vector<AtomicWriteEntry> &entries,
+                        const std::optional<AtomicWriteOptions> &options) override;
+
   // Vector I/O
   double readv(double fd,
                const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
-               double position) override;
+               const std::vector<double> &offsets,
+               const std::vector<double> &lengths, double position) override;
   double writev(double fd,
                 const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
-                double position) override;
+                const std::vector<double> &offsets,
+                const std::vector<double> &lengths, double position) override;
+
+  // Compression
+  std::shared_ptr<Promise<void>>
+  compressFile(const std::string &src, const std::string &dest,
+               const std::optional<CompressOptions> &options) override;
+  std::shared_ptr<Promise<void>>
+  decompressFile(const std::string &src, const std::string &dest) override;
+
+  // Tar archives
+  std::shared_ptr<Promise<void>>
+  tarCreate(const std::string &srcDir, const std::string &destFile,
+            const std::optional<TarCreateOptions> &options) override;
+  std::shared_ptr<Promise<void>> tarExtract(const std::string &srcFile,
+                                            const std::string &destDir) override;
+
+  // Delta sync
+  std::shared_ptr<Promise<std::shared_ptr<ArrayBuffer>>>
+  fileSignature(const std::string &path,
+                const std::optional<double> &blockSize) override;
+  std::shared_ptr<Promise<DeltaStats>>
+  fileDelta(const std::string &path,
+            const std::shared_ptr<ArrayBuffer> &signature,
+            const std::string &patchPath) override;
+  std::shared_ptr<Promise<void>> applyPatch(const std::string &basePath,
+                                            const std::string &patchPath,
+                                            const std::string &destPath) override;
+
+  // Chunk store
+  std::shared_ptr<Promise<StoreFileResult>>
+  storeFile(const std::string &root, const std::string &path,
+            const std::string &name,
+            const std::optional<ChunkStoreOptions> &options) override;
+  std::shared_ptr<Promise<void>> restoreFile(const std::string &root,
+                                             const std::string &name,
+                                             const std::string &dest) override;
+  std::shared_ptr<Promise<bool>>
+  removeStoredFile(const std::string &root, const std::string &name) override;
+  std::shared_ptr<Promise<std::vector<std::string>>>
+  listStoredFiles(const std::string &root) override;
+  std::shared_ptr<Promise<ChunkStoreGcResult>>
+  gcChunkStore(const std::string &root) override;
+
+  // Content search
+  std::shared_ptr<Promise<SearchResult>>
+  searchFiles(const std::vector<std::string> &paths, const std::string &pattern,
+              const std::optional<SearchOptions> &options) override;
+
+  // Comparison
+  std::shared_ptr<Promise<bool>> compareFiles(const std::string &a,
+                                              const std::string &b) override;
+  std::shared_ptr<Promise<TreeDiffResult>>
+  diffTrees(const std::string &a, const std::string &b,
+            const std::optional<TreeDiffOptions> &options) override;
+
+  // JSON files
+  std::shared_ptr<Promise<std::shared_ptr<HybridHybridJsonDocumentSpec>>>
+  parseJSONFile(const std::string &path) override;
+  // Raw JSI: writeJSON(path, value, options?) -> Promise<void>. The value is
+  // serialized on the JS thread straight into a native string.
+  jsi::Value writeJSON(jsi::Runtime &runtime, const jsi::Value &thisValue,
+                       const jsi::Value *args, size_t count);
+
+  // Line index
+  std::shared_ptr<Promise<LineIndexResult>>
+  buildLineIndex(const std::string &path,
+                 const std::optional<LineIndexOptions> &options) override;
+  std::shared_ptr<Promise<std::vector<std::string>>>
+  readLines(const std::string &path, double startLine, double count,
+            const std::optional<LineIndexOptions> &options) override;
+
+  // Disk usage
+  std::shared_ptr<Promise<DiskUsageResult>>
+  du(const std::string &path,
+     const std::optional<DiskUsageOptions> &options) override;
+
+  // Page cache hints
+  void advise(const std::string &path, double offset, double length,
+              FileAdviceType advice) override;
+  void fadvise(double fd, double offset, double length,
+               FileAdviceType advice) override;
+  std::shared_ptr<Promise<PrefetchResult>>
+  prefetch(const std::vector<std::string> &paths,
+           const std::optional<PrefetchOptions> &options) override;
+
+  // Batched operations
+  std::vector<BatchResult> batch(const std::vector<BatchOp> &ops,
+                                 const std::optional<BatchOptions> &options) override;
+  std::shared_ptr<Promise<std::vector<BatchResult>>>
+  batchAsync(const std::vector<BatchOp> &ops,
+             const std::optional<BatchOptions> &options) override;
+
+  // Bulk I/O
+  std::shared_ptr<Promise<std::vector<BatchResult>>>
+  statMany(const std::vector<std::string> &paths,
+           const std::optional<StatManyOptions> &options) override;
+  std::shared_ptr<Promise<std::vector<BatchResult>>>
+  readFileMany(const std::vector<std::string> &paths) override;
+  ReadRangesResult
+  readRanges(double fd, const std::vector<ReadRange> &ranges,
+             const std::optional<std::shared_ptr<ArrayBuffer>> &dest,
+             const std::optional<ReadRangesOptions> &options) override;
+  std::shared_ptr<Promise<ReadRangesResult>>
+  readRangesAsync(double fd, const std::vector<ReadRange> &ranges,
+                  const std::optional<ReadRangesOptions> &options) override;
+  std::string getIoEngine() override;
+
+  // Buffer pool
+  std::shared_ptr<ArrayBuffer> leaseBuffer(double size) override;
+  void trimBufferPool() override;
+  void setBufferPoolLimit(double bytes) override;
+  BufferPoolStats getBufferPoolStats() override;
+
+  // Diagnostics
+  std::vector<OpMetrics> getMetrics() override;
+  void resetMetrics() override;
+  void startTracing(const std::optional<TraceOptions> &options) override;
+  void stopTracing() override;
+  std::shared_ptr<Promise<double>> dumpTrace(const std::string &path) override;
 
   std::string getBookmark(const std::string &path) override;
   std::string resolveBookmark(const std::string &bookmark) override;
@@ -108,8 +255,15 @@ public:
   std::shared_ptr<Promise<std::vector<PickedFile>>> pickFiles(const FilePickerOptions& options) override;
   std::shared_ptr<Promise<PickedDirectory>> pickDirectory(const std::optional<DirectoryPickerOptions>& options) override;
 
+protected:
+  void loadHybridMethods() override;
+
 private:
+  // Trims the buffer pool on system memory warnings. Once per process.
+  static void observeMemoryPressure();
   std::string normalizePath(const std::string &path);
+  std::vector<BatchRequest> toBatchRequests(const std::vector<BatchOp> &ops,
+                                            bool copyData);
 #ifdef __ANDROID__
   void copyAssetRecursive(const std::string& assetPath, const std::string& destPath, bool recursive, bool force);
 #endif
@@ -0,0 +1,60 @@
+#include "HybridFileTail.hpp"
+#include "FsMetrics.hpp"
+#include <NitroModules/ArrayBuffer.hpp>
+#include <iostream>
+
+namespace margelo::nitro::node_fs {
+
+static std::optional<TailReset> toTailReset(TailChange change) {
+  switch (change) {
+  case TailChange::Truncated:
+    return TailReset::TRUNCATED;
+  case TailChange::Rotated:
+    return TailReset::ROTATED;
+  case TailChange::None:
+  default:
+    return std::nullopt;
+  }
+}
+
+HybridFileTail::HybridFileTail(const std::string &path,
+                               const TailConfig &config,
+                               std::function<void(const TailBatch &)> onBatch)
+    : HybridObject(HybridHybridFileTailSpec::TAG), HybridHybridFileTailSpec() {
+  bool lines = config.lines;
+  _tail = std::make_unique<FileTail>(
+      path, config, [onBatch, lines](TailChunk &&chunk) {
+        NITRO_FS_OP(TailBatch);
+        NITRO_FS_BYTES(chunk.bytes.size());
+        std::optional<std::shared_ptr<ArrayBuffer>> data;
+        std::optional<std::vector<std::string>> batchLines;
+        if (lines) {
+          batchLines = std::move(chunk.lines);
+        } else {
+          data = ArrayBuffer::copy(chunk.bytes.data(), chunk.bytes.size());
+        }
+        try {
+          onBatch(TailBatch(static_cast<double>(chunk.offset),
+                            toTailReset(chunk.change), data, batchLines));
+        } catch (const std::exception &e) {
+          NITRO_FS_FAIL();
+          std::cerr << "HybridFileTail: Error calling JS callback: " << e.what()
+                    << std::endl;
+        }
+      });
+}
+
+HybridFileTail::~HybridFileTail() { close(); }
+
+double HybridFileTail::getOffset() {
+  return _tail ? static_cast<double>(_tail->offset()) : 0;
+}
+
+void HybridFileTail::close() {
+  NITRO_FS_OP(TailClose);
+  if (_tail) {
+    _tail->close();
+  }
+}
+
+} // namespace margelo::nitro::node_fs
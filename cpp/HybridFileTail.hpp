@@ -0,0 +1,30 @@
+#pragma once
+#include "FileTail.hpp"
+#include "HybridHybridFileTailSpec.hpp"
+#include "TailBatch.hpp"
+#include <NitroModules/HybridObject.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * JS handle for a FileTail. Batches are converted to TailBatch (an
+ * ArrayBuffer or a string array) on the tail thread and handed to the JS
+ * callback, which Nitro dispatches to the JS thread.
+ */
+class HybridFileTail : public HybridHybridFileTailSpec {
+public:
+  HybridFileTail(const std::string &path, const TailConfig &config,
+                 std::function<void(const TailBatch &)> onBatch);
+  virtual ~HybridFileTail();
+
+  double getOffset() override;
+  void close() override;
+
+private:
+  std::unique_ptr<FileTail> _tail;
+};
+
+} // namespace margelo::nitro::node_fs
@@ -1,4 +1,5 @@
 #include "HybridFileWatcher.hpp"
+#include "FsMetrics.hpp"
 #include <iostream>
 
 namespace margelo::nitro::node_fs {
@@ -22,6 +23,7 @@ HybridFileWatcher::HybridFileWatcher(
 HybridFileWatcher::~HybridFileWatcher() { close(); }
 
 void HybridFileWatcher::close() {
+  NITRO_FS_OP(WatcherClose);
   if (_watcher != nullptr) {
     rn_fs_unwatch(_watcher);
     _watcher = nullptr;
@@ -29,6 +31,8 @@ void HybridFileWatcher::close() {
 }
 
 void HybridFileWatcher::onChange(const std::string &path, int event) {
+  NITRO_FS_OP(WatcherEvent);
+  NITRO_FS_TRACE_PATH(path);
   // Event: 1=Rename, 2=Change
   std::string eventName = (event == 2) ? "change" : "rename";
   // Call JS callback.
@@ -39,6 +43,7 @@ void HybridFileWatcher::onChange(const std::string &path, int event) {
   try {
     _jsCallback(eventName, path);
   } catch (const std::exception &e) {
+    NITRO_FS_FAIL();
     std::cerr << "HybridFileWatcher: Error calling JS callback: " << e.what()
               << std::endl;
   }
@@ -0,0 +1,238 @@
+#include "HybridJsonDocument.hpp"
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+constexpr size_t kMaxJsonDepth = 1024;
+
+// Walks the tape in preorder. Each distinct key gets one PropNameID.
+class Materializer {
+public:
+  Materializer(jsi::Runtime &runtime, const JsonTape &tape)
+      : _runtime(runtime), _tape(tape), _nodes(tape.nodes()),
+        _keys(tape.keyCount()) {}
+
+  jsi::Value next() {
+    const JsonTape::Node &node = _nodes[_index++];
+    switch (node.kind) {
+    case JsonTape::Kind::Null:
+      return jsi::Value::null();
+    case JsonTape::Kind::True:
+      return jsi::Value(true);
+    case JsonTape::Kind::False:
+      return jsi::Value(false);
+    case JsonTape::Kind::Number:
+      return jsi::Value(node.number);
+    case JsonTape::Kind::String:
+      return makeString(_tape.string(node), node.flags & JsonTape::kAscii);
+    case JsonTape::Kind::Array: {
+      jsi::Array array(_runtime, node.length);
+      for (uint32_t i = 0; i < node.length; i++) {
+        array.setValueAtIndex(_runtime, i, next());
+      }
+      return jsi::Value(std::move(array));
+    }
+    case JsonTape::Kind::Object: {
+      jsi::Object object(_runtime);
+      for (uint32_t i = 0; i < node.length; i++) {
+        size_t key = static_cast<size_t>(_nodes[_index++].offset);
+        jsi::Value value = next();
+        if (_tape.key(key) == "__proto__") {
+          defineOwn(object, std::move(value));
+        } else {
+          object.setProperty(_runtime, propName(key), std::move(value));
+        }
+      }
+      return jsi::Value(std::move(object));
+    }
+    case JsonTape::Kind::Key:
+      break;
+    }
+    throw std::runtime_error("readJSON: corrupt tape");
+  }
+
+private:
+  jsi::Value makeString(std::string_view text, bool ascii) {
+    if (ascii) {
+      return jsi::String::createFromAscii(_runtime, text.data(), text.size());
+    }
+    return jsi::String::createFromUtf8(
+        _runtime, reinterpret_cast<const uint8_t *>(text.data()), text.size());
+  }
+
+  const jsi::PropNameID &propName(size_t key) {
+    if (!_keys[key].has_value()) {
+      std::string_view text = _tape.key(key);
+      if (_tape.keyIsAscii(key)) {
+        _keys[key] = jsi::PropNameID::forAscii(_runtime, text.data(), text.size());
+      } else {
+        _keys[key] = jsi::PropNameID::forUtf8(
+            _runtime, reinterpret_cast<const uint8_t *>(text.data()),
+            text.size());
+      }
+    }
+    return *_keys[key];
+  }
+
+  // JSON.parse makes "__proto__" an own property; assigning it would set
+  // the prototype instead.
+  void defineOwn(jsi::Object &object, jsi::Value value) {
+    jsi::Object descriptor(_runtime);
+    descriptor.setProperty(_runtime, "value", std::move(value));
+    descriptor.setProperty(_runtime, "writable", true);
+    descriptor.setProperty(_runtime, "enumerable", true);
+    descriptor.setProperty(_runtime, "configurable", true);
+    _runtime.global()
+        .getPropertyAsObject(_runtime, "Object")
+        .getPropertyAsFunction(_runtime, "defineProperty")
+        .call(_runtime, object,
+              jsi::String::createFromAscii(_runtime, "__proto__"), descriptor);
+  }
+
+  jsi::Runtime &_runtime;
+  const JsonTape &_tape;
+  const std::vector<JsonTape::Node> &_nodes;
+  std::vector<std::optional<jsi::PropNameID>> _keys;
+  size_t _index = 0;
+};
+
+class Serializer {
+public:
+  Serializer(jsi::Runtime &runtime, std::string &out)
+      : _runtime(runtime), _out(out) {}
+
+  // False if the value is skipped (undefined, a function or a symbol).
+  bool write(const jsi::Value &value) {
+    if (value.isUndefined() || value.isSymbol()) {
+      return false;
+    }
+    if (value.isNull()) {
+      _out.append("null");
+    } else if (value.isBool()) {
+      _out.append(value.getBool() ? "true" : "false");
+    } else if (value.isNumber()) {
+      appendJsonNumber(_out, value.getNumber());
+    } else if (value.isString()) {
+      appendJsonString(_out, value.getString(_runtime).utf8(_runtime));
+    } else if (value.isBigInt()) {
+      throw std::runtime_error("writeJSON: BigInt value can't be serialized");
+    } else {
+      jsi::Object object = value.getObject(_runtime);
+      if (object.isFunction(_runtime)) {
+        return false;
+      }
+      jsi::Value toJSON = object.getProperty(_runtime, "toJSON");
+      if (toJSON.isObject() && toJSON.getObject(_runtime).isFunction(_runtime)) {
+        jsi::Value replaced =
+            toJSON.getObject(_runtime).getFunction(_runtime).callWithThis(
+                _runtime, object, jsi::String::createFromAscii(_runtime, ""));
+        return write(replaced);
+      }
+      writeObject(std::move(object));
+    }
+    return true;
+  }
+
+private:
+  void writeObject(jsi::Object object) {
+    if (_stack.size() >= kMaxJsonDepth) {
+      throw std::runtime_error("writeJSON: value is nested too deeply");
+    }
+    for (const auto &ancestor : _stack) {
+      if (jsi::Object::strictEquals(_runtime, ancestor, object)) {
+        throw std::runtime_error("writeJSON: value contains a cycle");
+      }
+    }
+    _stack.push_back(jsi::Value(_runtime, object).getObject(_runtime));
+
+    if (object.isArray(_runtime)) {
+      jsi::Array array = object.getArray(_runtime);
+      size_t length = array.size(_runtime);
+      _out.push_back('[');
+      for (size_t i = 0; i < length; i++) {
+        if (i > 0) {
+          _out.push_back(',');
+        }
+        if (!write(array.getValueAtIndex(_runtime, i))) {
+          _out.append("null");
+        }
+      }
+      _out.push_back(']');
+    } else {
+      jsi::Array names = object.getPropertyNames(_runtime);
+      size_t length = names.size(_runtime);
+      _out.push_back('{');
+      bool first = true;
+      for (size_t i = 0; i < length; i++) {
+        jsi::String name =
+            names.getValueAtIndex(_runtime, i).getString(_runtime);
+        jsi::Value member = object.getProperty(
+            _runtime, jsi::PropNameID::forString(_runtime, name));
+        size_t mark = _out.size();
+        if (!first) {
+          _out.push_back(',');
+        }
+        appendJsonString(_out, name.utf8(_runtime));
+        _out.push_back(':');
+        if (write(member)) {
+          first = false;
+        } else {
+          _out.resize(mark); // skipped member
+        }
+      }
+      _out.push_back('}');
+    }
+    _stack.pop_back();
+  }
+
+  jsi::Runtime &_runtime;
+  std::string &_out;
+  std::vector<jsi::Object> _stack;
+};
+
+} // namespace
+
+HybridJsonDocument::HybridJsonDocument(std::shared_ptr<JsonTape> tape,
+                                       size_t byteLength)
+    : HybridObject(HybridHybridJsonDocumentSpec::TAG),
+      HybridHybridJsonDocumentSpec(), _tape(std::move(tape)),
+      _byteLength(byteLength) {}
+
+double HybridJsonDocument::getByteLength() {
+  return static_cast<double>(_byteLength);
+}
+
+size_t HybridJsonDocument::getExternalMemorySize() noexcept {
+  return _tape ? _tape->memorySize() : 0;
+}
+
+void HybridJsonDocument::loadHybridMethods() {
+  HybridHybridJsonDocumentSpec::loadHybridMethods();
+  registerHybrids(this, [](Prototype &prototype) {
+    prototype.registerRawHybridMethod("toValue", 0,
+                                      &HybridJsonDocument::toValue);
+  });
+}
+
+jsi::Value HybridJsonDocument::toValue(jsi::Runtime &runtime,
+                                       const jsi::Value &, const jsi::Value *,
+                                       size_t) {
+  if (!_tape) {
+    throw std::runtime_error("readJSON: the document was already converted");
+  }
+  std::shared_ptr<JsonTape> tape = std::move(_tape);
+  return Materializer(runtime, *tape).next();
+}
+
+void appendJsonValue(jsi::Runtime &runtime, const jsi::Value &value,
+                     std::string &out) {
+  if (!Serializer(runtime, out).write(value)) {
+    throw std::runtime_error("writeJSON: value can't be serialized");
+  }
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,43 @@
+#pragma once
+#include "HybridHybridJsonDocumentSpec.hpp"
+#include "JsonTape.hpp"
+#include <NitroModules/HybridObject.hpp>
+#include <memory>
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * JS handle for a JSON file parsed on a worker thread. The raw JSI method
+ * toValue() builds the JS value from the tape in one pass on the JS thread
+ * and then frees the tape, so it can be called once.
+ */
+class HybridJsonDocument : public HybridHybridJsonDocumentSpec {
+public:
+  explicit HybridJsonDocument(std::shared_ptr<JsonTape> tape, size_t byteLength);
+
+  double getByteLength() override;
+  size_t getExternalMemorySize() noexcept override;
+
+  jsi::Value toValue(jsi::Runtime &runtime, const jsi::Value &thisValue,
+                     const jsi::Value *args, size_t count);
+
+protected:
+  void loadHybridMethods() override;
+
+private:
+  std::shared_ptr<JsonTape> _tape;
+  size_t _byteLength;
+};
+
+/**
+ * Appends `value` to `out` as JSON.stringify(value) would: toJSON() is
+ * honoured, undefined, functions and symbols are dropped from objects and
+ * become null in arrays, and non-finite numbers become null. Throws
+ * std::runtime_error for cycles, BigInts and an unserializable top level.
+ * Must run on the JS thread.
+ */
+void appendJsonValue(jsi::Runtime &runtime, const jsi::Value &value,
+                     std::string &out);
+
+} // namespace margelo::nitro::node_fs
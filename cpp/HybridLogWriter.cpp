@@ -0,0 +1,297 @@
+#include "HybridLogWriter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace margelo::nitro::node_fs {
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+  size_t result = 4096;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+HybridLogWriter::HybridLogWriter(const std::string &path,
+                                 const LogWriterConfig &config)
+    : HybridObject(HybridHybridLogWriterSpec::TAG),
+      HybridHybridLogWriterSpec(), _path(path), _config(config) {
+  size_t capacity = roundUpToPowerOfTwo(
+      std::min(_config.bufferSize, LogWriterConfig::kMaxBufferSize));
+  _ring = std::make_unique<uint8_t[]>(capacity);
+  _mask = capacity - 1;
+  _config.flushBytes = std::min(std::max<size_t>(_config.flushBytes, 1), capacity);
+
+  openFile();
+  if (_fd < 0) {
+    throw std::runtime_error("createLogWriter failed: " + _path);
+  }
+  _thread = std::thread([this]() { run(); });
+}
+
+HybridLogWriter::~HybridLogWriter() { stop(); }
+
+void HybridLogWriter::openFile() {
+  _fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+  if (_fd < 0) {
+    return;
+  }
+  rn_fs_import_fd(_fd);
+  RNStats s;
+  _fileSize = rn_fs_fstat(_fd, &s) == 0 ? s.size : 0;
+}
+
+void HybridLogWriter::append(const std::string &data) {
+  push(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+}
+
+void HybridLogWriter::appendBuffer(const std::shared_ptr<ArrayBuffer> &buffer) {
+  if (!buffer) {
+    throw std::runtime_error("buffer is null");
+  }
+  push(buffer->data(), buffer->size());
+}
+
+void HybridLogWriter::push(const uint8_t *data, size_t len) {
+  if (_closed.load(std::memory_order_relaxed)) {
+    throw std::runtime_error("LogWriter is closed: " + _path);
+  }
+  if (_failed.load(std::memory_order_relaxed)) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    throw std::runtime_error(_error);
+  }
+  const size_t capacity = _mask + 1;
+  const uint64_t pendingBefore =
+      _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire);
+
+  while (len > 0) {
+    uint64_t head = _head.load(std::memory_order_relaxed);
+    uint64_t tail = _tail.load(std::memory_order_acquire);
+    size_t free = capacity - static_cast<size_t>(head - tail);
+
+    if (free == 0) {
+      // Ring is full: hand the flusher work and wait for it to make room.
+      std::unique_lock<std::mutex> lock(_mutex);
+      if (_closing) {
+        throw std::runtime_error("LogWriter is closed: " + _path);
+      }
+      if (!_error.empty()) {
+        throw std::runtime_error(_error);
+      }
+      _flushRequested = true;
+      _wakeFlusher.notify_one();
+      _spaceAvailable.wait(lock, [&] {
+        return _tail.load(std::memory_order_acquire) != tail || _closing ||
+               !_error.empty();
+      });
+      continue;
+    }
+
+    size_t n = std::min(len, free);
+    size_t start = static_cast<size_t>(head) & _mask;
+    size_t first = std::min(n, capacity - start);
+    std::memcpy(_ring.get() + start, data, first);
+    std::memcpy(_ring.get(), data + first, n - first);
+    _head.store(head + n, std::memory_order_release);
+    data += n;
+    len -= n;
+  }
+
+  const uint64_t pendingAfter =
+      _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire);
+  if (pendingBefore < _config.flushBytes && pendingAfter >= _config.flushBytes) {
+    // Taking the lock orders this against the flusher's predicate check, so
+    // the wakeup cannot be lost; it matters when there is no timed flush.
+    { std::lock_guard<std::mutex> lock(_mutex); }
+    _wakeFlusher.notify_one();
+  }
+}
+
+std::shared_ptr<Promise<void>> HybridLogWriter::flush() {
+  auto promise = Promise<void>::create();
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (!_error.empty()) {
+    lock.unlock();
+    promise->reject(std::make_exception_ptr(std::runtime_error(_error)));
+    return promise;
+  }
+  uint64_t target = _head.load(std::memory_order_acquire);
+  if (_stopped || _tail.load(std::memory_order_acquire) >= target) {
+    lock.unlock();
+    promise->resolve();
+    return promise;
+  }
+  _pendingFlushes.emplace_back(target, promise);
+  _flushRequested = true;
+  _wakeFlusher.notify_one();
+  return promise;
+}
+
+std::shared_ptr<Promise<void>> HybridLogWriter::close() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (!_closePromise) {
+    _closePromise = Promise<void>::create();
+    _closing = true;
+    _closed.store(true, std::memory_order_relaxed);
+    _wakeFlusher.notify_one();
+    _spaceAvailable.notify_all();
+  }
+  return _closePromise;
+}
+
+void HybridLogWriter::stop() {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _closing = true;
+    _closed.store(true, std::memory_order_relaxed);
+  }
+  _wakeFlusher.notify_one();
+  _spaceAvailable.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+bool HybridLogWriter::drain() {
+  const size_t capacity = _mask + 1;
+  uint64_t tail = _tail.load(std::memory_order_relaxed);
+  const uint64_t head = _head.load(std::memory_order_acquire);
+
+  while (tail < head) {
+    size_t n = static_cast<size_t>(head - tail);
+    size_t start = static_cast<size_t>(tail) & _mask;
+    size_t first = std::min(n, capacity - start);
+
+    RNIovec iov[2];
+    iov[0].base = _ring.get() + start;
+    iov[0].len = first;
+    int iovcnt = 1;
+    if (n > first) {
+      iov[1].base = _ring.get();
+      iov[1].len = n - first;
+      iovcnt = 2;
+    }
+
+    intptr_t written = rn_fs_writev(_fd, iov, iovcnt, -1);
+    if (written <= 0) {
+      // Drop what cannot be written so a blocked producer is released; the
+      // error is reported through flush()/close() and later appends.
+      _tail.store(head, std::memory_order_release);
+      return false;
+    }
+    tail += static_cast<uint64_t>(written);
+    _tail.store(tail, std::memory_order_release);
+    _fileSize += static_cast<uint64_t>(written);
+
+    if (_config.maxFileSize > 0 && _fileSize >= _config.maxFileSize) {
+      rotate();
+      if (_fd < 0) {
+        _tail.store(head, std::memory_order_release);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void HybridLogWriter::rotate() {
+  rn_fs_close(_fd);
+  _fd = -1;
+  // path.(n-1) -> path.n, ..., path -> path.1; the oldest file is replaced.
+  for (uint32_t i = _config.maxFiles; i > 1; i--) {
+    std::string from = _path + "." + std::to_string(i - 1);
+    std::string to = _path + "." + std::to_string(i);
+    rn_fs_rename(from.c_str(), to.c_str());
+  }
+  if (_config.maxFiles > 0) {
+    rn_fs_rename(_path.c_str(), (_path + ".1").c_str());
+  } else {
+    rn_fs_unlink(_path.c_str());
+  }
+  openFile();
+}
+
+void HybridLogWriter::run() {
+  const auto interval = std::chrono::milliseconds(_config.flushIntervalMs);
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while (true) {
+    auto wake = [&] {
+      return _closing || _flushRequested ||
+             _head.load(std::memory_order_acquire) -
+                     _tail.load(std::memory_order_acquire) >=
+                 _config.flushBytes;
+    };
+    if (_config.flushIntervalMs == 0) {
+      _wakeFlusher.wait(lock, wake);
+    } else {
+      _wakeFlusher.wait_for(lock, interval, wake);
+    }
+    const bool closing = _closing;
+    _flushRequested = false;
+
+    lock.unlock();
+    bool ok = _error.empty() && drain();
+    lock.lock();
+
+    if (!ok && _error.empty()) {
+      _error = "LogWriter write failed: " + _path;
+      _failed.store(true, std::memory_order_relaxed);
+    }
+
+    // Settle flush() calls whose data is now on disk (or failed).
+    std::vector<std::shared_ptr<Promise<void>>> resolved;
+    std::vector<std::shared_ptr<Promise<void>>> rejected;
+    const uint64_t tail = _tail.load(std::memory_order_acquire);
+    auto it = _pendingFlushes.begin();
+    while (it != _pendingFlushes.end()) {
+      if (!_error.empty()) {
+        rejected.push_back(it->second);
+        it = _pendingFlushes.erase(it);
+      } else if (it->first <= tail) {
+        resolved.push_back(it->second);
+        it = _pendingFlushes.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    _spaceAvailable.notify_all();
+    std::string error = _error;
+
+    lock.unlock();
+    for (auto &promise : resolved) {
+      promise->resolve();
+    }
+    for (auto &promise : rejected) {
+      promise->reject(std::make_exception_ptr(std::runtime_error(error)));
+    }
+    lock.lock();
+
+    if (closing) {
+      break;
+    }
+  }
+
+  if (_fd >= 0) {
+    rn_fs_close(_fd);
+    _fd = -1;
+  }
+  _stopped = true;
+  auto closePromise = _closePromise;
+  std::string error = _error;
+  lock.unlock();
+
+  if (closePromise) {
+    if (error.empty()) {
+      closePromise->resolve();
+    } else {
+      closePromise->reject(std::make_exception_ptr(std::runtime_error(error)));
+    }
+  }
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,83 @@
+#pragma once
+#include "HybridHybridLogWriterSpec.hpp"
+#include "rust_c_file_system.h"
+#include <NitroModules/ArrayBuffer.hpp>
+#include <NitroModules/HybridObject.hpp>
+#include <NitroModules/Promise.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+struct LogWriterConfig {
+  static constexpr size_t kMaxBufferSize = 1u << 30;
+
+  size_t bufferSize = 1024 * 1024;
+  size_t flushBytes = 64 * 1024;
+  uint32_t flushIntervalMs = 1000; // 0 disables timed flushes
+  uint64_t maxFileSize = 0; // 0 disables rotation
+  uint32_t maxFiles = 5;
+};
+
+/**
+ * Append-only log file writer.
+ *
+ * Appends are copied into a single-producer/single-consumer byte ring from the
+ * JS thread without taking a lock. A background thread drains the ring with
+ * rn_fs_writev (two iovecs when the data wraps) whenever `flushBytes` are
+ * pending or `flushIntervalMs` elapsed (never, when it is 0), and rotates
+ * the file by size.
+ * The producer only blocks when the ring is full.
+ */
+class HybridLogWriter : public HybridHybridLogWriterSpec {
+public:
+  HybridLogWriter(const std::string &path, const LogWriterConfig &config);
+  virtual ~HybridLogWriter();
+
+  void append(const std::string &data) override;
+  void appendBuffer(const std::shared_ptr<ArrayBuffer> &buffer) override;
+  std::shared_ptr<Promise<void>> flush() override;
+  std::shared_ptr<Promise<void>> close() override;
+
+private:
+  void push(const uint8_t *data, size_t len);
+  void run();
+  bool drain();
+  void rotate();
+  void openFile();
+  void settleFlushes();
+  void stop();
+
+  std::string _path;
+  LogWriterConfig _config;
+  int _fd = -1;
+  uint64_t _fileSize = 0;
+
+  std::unique_ptr<uint8_t[]> _ring;
+  size_t _mask;
+  // _head is only written by the producer, _tail only by the flusher.
+  std::atomic<uint64_t> _head{0};
+  std::atomic<uint64_t> _tail{0};
+
+  std::mutex _mutex;
+  std::condition_variable _wakeFlusher;
+  std::condition_variable _spaceAvailable;
+  bool _flushRequested = false;
+  bool _closing = false;
+  bool _stopped = false;
+  // Mirrors of _closing/_error for the lock-free append path.
+  std::atomic<bool> _closed{false};
+  std::atomic<bool> _failed{false};
+  std::string _error;
+  std::vector<std::pair<uint64_t, std::shared_ptr<Promise<void>>>> _pendingFlushes;
+  std::shared_ptr<Promise<void>> _closePromise;
+
+  std::thread _thread;
+};
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,48 @@
+#include "HybridSpaceMonitor.hpp"
+#include "FsMetrics.hpp"
+#include <iostream>
+
+namespace margelo::nitro::node_fs {
+
+StatFs toStatFs(const portable::VolumeStats &stats) {
+  return StatFs(static_cast<double>(stats.type), static_cast<double>(stats.bsize),
+                static_cast<double>(stats.blocks), static_cast<double>(stats.bfree),
+                static_cast<double>(stats.bavail), static_cast<double>(stats.files),
+                static_cast<double>(stats.ffree));
+}
+
+HybridSpaceMonitor::HybridSpaceMonitor(
+    const std::string &path, const SpaceMonitorConfig &config,
+    std::function<void(bool, const StatFs &)> onChange)
+    : HybridObject(HybridHybridSpaceMonitorSpec::TAG),
+      HybridHybridSpaceMonitorSpec() {
+  _monitor = std::make_unique<SpaceMonitor>(
+      path, config,
+      [onChange](bool low, const portable::VolumeStats &stats) {
+        NITRO_FS_OP(SpaceMonitorChange);
+        try {
+          onChange(low, toStatFs(stats));
+        } catch (const std::exception &e) {
+          NITRO_FS_FAIL();
+          std::cerr << "HybridSpaceMonitor: Error calling JS callback: "
+                    << e.what() << std::endl;
+        }
+      });
+}
+
+HybridSpaceMonitor::~HybridSpaceMonitor() { close(); }
+
+bool HybridSpaceMonitor::getLow() { return _monitor && _monitor->isLow(); }
+
+StatFs HybridSpaceMonitor::check() {
+  NITRO_FS_OP(Statfs);
+  return toStatFs(_monitor->check());
+}
+
+void HybridSpaceMonitor::close() {
+  if (_monitor) {
+    _monitor->close();
+  }
+}
+
+} // namespace margelo::nitro::node_fs
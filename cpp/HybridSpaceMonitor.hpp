@@ -0,0 +1,32 @@
+#pragma once
+#include "HybridHybridSpaceMonitorSpec.hpp"
+#include "SpaceMonitor.hpp"
+#include "StatFs.hpp"
+#include <NitroModules/HybridObject.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+StatFs toStatFs(const portable::VolumeStats &stats);
+
+/**
+ * JS handle for a SpaceMonitor. Transitions are reported from the monitor
+ * thread to the JS callback, which Nitro dispatches to the JS thread.
+ */
+class HybridSpaceMonitor : public HybridHybridSpaceMonitorSpec {
+public:
+  HybridSpaceMonitor(const std::string &path, const SpaceMonitorConfig &config,
+                     std::function<void(bool, const StatFs &)> onChange);
+  virtual ~HybridSpaceMonitor();
+
+  bool getLow() override;
+  StatFs check() override;
+  void close() override;
+
+private:
+  std::unique_ptr<SpaceMonitor> _monitor;
+};
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,109 @@
+#include "HybridZipArchive.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace margelo::nitro::node_fs {
+
+static ZipEntry toZipEntry(const ZipEntryInfo &info) {
+  return ZipEntry(info.name, static_cast<double>(info.uncompressedSize),
+                  static_cast<double>(info.compressedSize), info.isDirectory,
+                  static_cast<double>(info.crc32), info.mtimeMs);
+}
+
+static std::shared_ptr<ArrayBuffer> readEntry(const ZipReader &reader,
+                                              const ZipEntryInfo &entry) {
+  size_t size = ZipReader::readSize(entry);
+  auto buffer = ArrayBuffer::allocate(size);
+  reader.readInto(entry, buffer->data(), size);
+  return buffer;
+}
+
+HybridZipArchive::HybridZipArchive(const std::string &path)
+    : HybridObject(HybridHybridZipArchiveSpec::TAG),
+      HybridHybridZipArchiveSpec(), _path(path),
+      _reader(std::make_shared<ZipReader>(path)) {}
+
+std::shared_ptr<ZipReader> HybridZipArchive::reader() {
+  if (!_reader) {
+    throw std::runtime_error("ZipArchive is closed: " + _path);
+  }
+  return _reader;
+}
+
+const ZipEntryInfo &HybridZipArchive::require(const ZipReader &reader,
+                                              const std::string &name) {
+  const ZipEntryInfo *entry = reader.find(name);
+  if (entry == nullptr) {
+    throw std::runtime_error("zip: no such entry: " + name);
+  }
+  return *entry;
+}
+
+std::string HybridZipArchive::getPath() { return _path; }
+
+double HybridZipArchive::getEntryCount() {
+  return static_cast<double>(reader()->entries().size());
+}
+
+std::vector<ZipEntry> HybridZipArchive::entries() {
+  auto zip = reader();
+  std::vector<ZipEntry> result;
+  result.reserve(zip->entries().size());
+  for (const auto &info : zip->entries()) {
+    result.push_back(toZipEntry(info));
+  }
+  return result;
+}
+
+std::optional<ZipEntry> HybridZipArchive::getEntry(const std::string &name) {
+  const ZipEntryInfo *info = reader()->find(name);
+  if (info == nullptr) {
+    return std::nullopt;
+  }
+  return toZipEntry(*info);
+}
+
+bool HybridZipArchive::has(const std::string &name) {
+  return reader()->find(name) != nullptr;
+}
+
+std::shared_ptr<ArrayBuffer> HybridZipArchive::read(const std::string &name) {
+  auto zip = reader();
+  return readEntry(*zip, require(*zip, name));
+}
+
+std::shared_ptr<Promise<std::shared_ptr<ArrayBuffer>>>
+HybridZipArchive::readAsync(const std::string &name) {
+  auto zip = reader();
+  const ZipEntryInfo *entry = &require(*zip, name);
+  return Promise<std::shared_ptr<ArrayBuffer>>::async(
+      [zip, entry]() { return readEntry(*zip, *entry); });
+}
+
+std::shared_ptr<Promise<void>>
+HybridZipArchive::extract(const std::string &name, const std::string &dest) {
+  auto zip = reader();
+  const ZipEntryInfo *entry = &require(*zip, name);
+  if (entry->isDirectory) {
+    throw std::runtime_error("zip: cannot extract a directory entry: " + name);
+  }
+  return Promise<void>::async(
+      [zip, entry, dest]() { zip->extractTo(*entry, dest); });
+}
+
+std::shared_ptr<Promise<void>>
+HybridZipArchive::extractAll(const std::string &dest,
+                             const std::optional<ZipExtractOptions> &options) {
+  auto zip = reader();
+  size_t parallelism = 0;
+  if (options.has_value() && options->parallelism.has_value()) {
+    parallelism = static_cast<size_t>(
+        std::max(1.0, options->parallelism.value()));
+  }
+  return Promise<void>::async(
+      [zip, dest, parallelism]() { zip->extractAll(dest, parallelism); });
+}
+
+void HybridZipArchive::close() { _reader.reset(); }
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,45 @@
+#pragma once
+#include "HybridHybridZipArchiveSpec.hpp"
+#include "ZipReader.hpp"
+#include <NitroModules/ArrayBuffer.hpp>
+#include <NitroModules/HybridObject.hpp>
+#include <NitroModules/Promise.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * JS handle for an open zip archive. The reader is shared with in-flight
+ * async operations, so close() only releases the archive once they finish.
+ */
+class HybridZipArchive : public HybridHybridZipArchiveSpec {
+public:
+  explicit HybridZipArchive(const std::string &path);
+
+  std::string getPath() override;
+  double getEntryCount() override;
+
+  std::vector<ZipEntry> entries() override;
+  std::optional<ZipEntry> getEntry(const std::string &name) override;
+  bool has(const std::string &name) override;
+  std::shared_ptr<ArrayBuffer> read(const std::string &name) override;
+  std::shared_ptr<Promise<std::shared_ptr<ArrayBuffer>>>
+  readAsync(const std::string &name) override;
+  std::shared_ptr<Promise<void>> extract(const std::string &name,
+                                         const std::string &dest) override;
+  std::shared_ptr<Promise<void>>
+  extractAll(const std::string &dest,
+             const std::optional<ZipExtractOptions> &options) override;
+  void close() override;
+
+private:
+  std::shared_ptr<ZipReader> reader();
+  const ZipEntryInfo &require(const ZipReader &reader, const std::string &name);
+
+  std::string _path;
+  std::shared_ptr<ZipReader> _reader;
+};
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,249 @@
+#include "IoUring.hpp"
+
+#if NITRO_FS_HAS_IO_URING
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params *params) {
+#ifdef __NR_io_uring_setup
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void *arg, unsigned count) {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// Every opcode prep* can queue. All of them exist since Linux 5.6, which is
+// also the first kernel with IORING_REGISTER_PROBE.
+constexpr uint8_t kRequiredOps[] = {
+    IORING_OP_OPENAT,
+    IORING_OP_STATX,
+    IORING_OP_READ,
+    IORING_OP_CLOSE,
+};
+
+bool supportsRequiredOps(int fd) {
+  constexpr unsigned kProbeOps = 256;
+  std::vector<uint8_t> storage(sizeof(io_uring_probe) +
+                               kProbeOps * sizeof(io_uring_probe_op));
+  auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+  if (ioUringRegister(fd, IORING_REGISTER_PROBE, probe, kProbeOps) < 0) {
+    return false;
+  }
+  for (uint8_t op : kRequiredOps) {
+    if (op > probe->last_op ||
+        !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T> T *at(void *base, unsigned offset) {
+  return reinterpret_cast<T *>(static_cast<uint8_t *>(base) + offset);
+}
+
+} // namespace
+
+std::unique_ptr<IoUring> IoUring::create(unsigned entries) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  int fd = ioUringSetup(entries, &params);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  std::unique_ptr<IoUring> ring(new IoUring());
+  ring->_fd = fd;
+  if (!supportsRequiredOps(fd)) {
+    return nullptr;
+  }
+
+  ring->_sqRingSize =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->_cqRingSize =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap) {
+    ring->_sqRingSize = ring->_cqRingSize =
+        std::max(ring->_sqRingSize, ring->_cqRingSize);
+  }
+
+  void *sqRing = ::mmap(nullptr, ring->_sqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED) {
+    return nullptr;
+  }
+  ring->_sqRing = sqRing;
+  if (singleMmap) {
+    ring->_cqRing = sqRing;
+  } else {
+    void *cqRing = ::mmap(nullptr, ring->_cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED) {
+      return nullptr;
+    }
+    ring->_cqRing = cqRing;
+  }
+
+  ring->_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = ::mmap(nullptr, ring->_sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return nullptr;
+  }
+  ring->_sqes = static_cast<io_uring_sqe *>(sqes);
+
+  ring->_sqHead = at<unsigned>(sqRing, params.sq_off.head);
+  ring->_sqTail = at<unsigned>(sqRing, params.sq_off.tail);
+  ring->_sqMask = *at<unsigned>(sqRing, params.sq_off.ring_mask);
+  ring->_sqEntries = *at<unsigned>(sqRing, params.sq_off.ring_entries);
+  ring->_sqLocalTail = ring->_sqSubmitted = *ring->_sqTail;
+  // SQE slots are used in ring order, so the index array is the identity.
+  unsigned *array = at<unsigned>(sqRing, params.sq_off.array);
+  for (unsigned i = 0; i < ring->_sqEntries; i++) {
+    array[i] = i;
+  }
+
+  ring->_cqHead = at<unsigned>(ring->_cqRing, params.cq_off.head);
+  ring->_cqTail = at<unsigned>(ring->_cqRing, params.cq_off.tail);
+  ring->_cqMask = *at<unsigned>(ring->_cqRing, params.cq_off.ring_mask);
+  ring->_cqEntries = *at<unsigned>(ring->_cqRing, params.cq_off.ring_entries);
+  ring->_cqes = at<io_uring_cqe>(ring->_cqRing, params.cq_off.cqes);
+  return ring;
+}
+
+bool IoUring::available() {
+  static const bool kAvailable = create(8) != nullptr;
+  return kAvailable;
+}
+
+IoUring::~IoUring() {
+  if (_sqes != nullptr) {
+    ::munmap(_sqes, _sqesSize);
+  }
+  if (_cqRing != nullptr && _cqRing != _sqRing) {
+    ::munmap(_cqRing, _cqRingSize);
+  }
+  if (_sqRing != nullptr) {
+    ::munmap(_sqRing, _sqRingSize);
+  }
+  if (_fd >= 0) {
+    ::close(_fd);
+  }
+}
+
+unsigned IoUring::submissionSpace() const {
+  return _sqEntries - (_sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE));
+}
+
+io_uring_sqe *IoUring::nextSqe(uint8_t opcode, uint64_t userData) {
+  if (submissionSpace() == 0) {
+    return nullptr;
+  }
+  io_uring_sqe *sqe = &_sqes[_sqLocalTail & _sqMask];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->user_data = userData;
+  _sqLocalTail++;
+  return sqe;
+}
+
+bool IoUring::prepOpenat(const char *path, int flags, mode_t mode,
+                         uint64_t userData) {
+  io_uring_sqe *sqe = nextSqe(IORING_OP_OPENAT, userData);
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->fd = AT_FDCWD;
+  sqe->addr = reinterpret_cast<uintptr_t>(path);
+  sqe->len = mode;
+  sqe->open_flags = static_cast<uint32_t>(flags);
+  return true;
+}
+
+bool IoUring::prepStatx(const char *path, int flags, unsigned mask,
+                        struct statx *out, uint64_t userData) {
+  io_uring_sqe *sqe = nextSqe(IORING_OP_STATX, userData);
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->fd = AT_FDCWD;
+  sqe->addr = reinterpret_cast<uintptr_t>(path);
+  sqe->len = mask;
+  sqe->off = reinterpret_cast<uintptr_t>(out);
+  sqe->statx_flags = static_cast<uint32_t>(flags);
+  return true;
+}
+
+bool IoUring::prepRead(int fd, void *buffer, size_t length, uint64_t offset,
+                       uint64_t userData) {
+  io_uring_sqe *sqe = nextSqe(IORING_OP_READ, userData);
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+  sqe->len = static_cast<uint32_t>(length);
+  sqe->off = offset;
+  return true;
+}
+
+bool IoUring::prepClose(int fd, uint64_t userData) {
+  io_uring_sqe *sqe = nextSqe(IORING_OP_CLOSE, userData);
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->fd = fd;
+  return true;
+}
+
+void IoUring::submitAndWait(unsigned waitFor) {
+  __atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+  unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+  for (;;) {
+    unsigned pending = _sqLocalTail - _sqSubmitted;
+    int result = ioUringEnter(_fd, pending, waitFor, flags);
+    if (result >= 0) {
+      _sqSubmitted += static_cast<unsigned>(result);
+      return;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EBUSY) {
+      // Out of kernel resources or completion space: the caller drains
+      // completions and calls again with whatever is still pending.
+      return;
+    }
+    throw std::runtime_error(std::string("io_uring_enter failed: ") +
+                             std::strerror(errno));
+  }
+}
+
+} // namespace margelo::nitro::node_fs
+
+#endif
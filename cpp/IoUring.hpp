@@ -0,0 +1,106 @@
+#pragma once
+
+// Android's app seccomp filter does not allow io_uring_setup; the call kills
+// the process with SIGSYS instead of failing with ENOSYS, so it must never be
+// issued there, not even as an availability probe.
+#if defined(__linux__) && !defined(__ANDROID__) &&                              \
+    __has_include(<linux/io_uring.h>)
+#define NITRO_FS_HAS_IO_URING 1
+#else
+#define NITRO_FS_HAS_IO_URING 0
+#endif
+
+#if NITRO_FS_HAS_IO_URING
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <memory>
+#include <sys/types.h>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * Minimal io_uring submission/completion ring driven through the raw
+ * syscalls (no liburing). A ring is not thread-safe; use one per thread.
+ *
+ * Linux only; Android builds never compile it (see above) and always use
+ * the worker pool. The kernel interface may still be missing (kernels
+ * before 5.6) or filtered (container seccomp profiles), so callers must
+ * treat create() returning nullptr as normal and fall back to blocking
+ * syscalls.
+ */
+class IoUring {
+public:
+  // Returns nullptr if io_uring is unusable or lacks an opcode used below.
+  static std::unique_ptr<IoUring> create(unsigned entries);
+  // Whether create() can succeed in this process. Probed once.
+  static bool available();
+
+  ~IoUring();
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  unsigned submissionCapacity() const { return _sqEntries; }
+  unsigned completionCapacity() const { return _cqEntries; }
+  // Free submission slots.
+  unsigned submissionSpace() const;
+
+  // Each prep* queues one operation and returns false when the submission
+  // queue is full. `userData` comes back with the completion. Pointers must
+  // stay valid until the operation completes.
+  bool prepOpenat(const char *path, int flags, mode_t mode, uint64_t userData);
+  bool prepStatx(const char *path, int flags, unsigned mask,
+                 struct statx *out, uint64_t userData);
+  bool prepRead(int fd, void *buffer, size_t length, uint64_t offset,
+                uint64_t userData);
+  bool prepClose(int fd, uint64_t userData);
+
+  // Submits everything queued and blocks until at least `waitFor`
+  // completions are available. Throws on ring failure.
+  void submitAndWait(unsigned waitFor);
+
+  // Calls fn(userData, result) for every available completion, where result
+  // is the syscall return value or -errno. Returns the number consumed.
+  template <typename Fn> unsigned drain(Fn &&fn) {
+    unsigned head = *_cqHead;
+    unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    unsigned count = tail - head;
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = _cqes[head & _cqMask];
+      fn(cqe.user_data, cqe.res);
+    }
+    __atomic_store_n(_cqHead, tail, __ATOMIC_RELEASE);
+    return count;
+  }
+
+private:
+  IoUring() = default;
+  io_uring_sqe *nextSqe(uint8_t opcode, uint64_t userData);
+
+  int _fd = -1;
+  void *_sqRing = nullptr;
+  size_t _sqRingSize = 0;
+  void *_cqRing = nullptr; // == _sqRing with IORING_FEAT_SINGLE_MMAP
+  size_t _cqRingSize = 0;
+  io_uring_sqe *_sqes = nullptr;
+  size_t _sqesSize = 0;
+
+  unsigned *_sqHead = nullptr;
+  unsigned *_sqTail = nullptr;
+  unsigned _sqMask = 0;
+  unsigned _sqEntries = 0;
+  unsigned _sqLocalTail = 0; // queued, not yet published
+  unsigned _sqSubmitted = 0; // published and handed to the kernel
+
+  unsigned *_cqHead = nullptr;
+  unsigned *_cqTail = nullptr;
+  unsigned _cqMask = 0;
+  unsigned _cqEntries = 0;
+  io_uring_cqe *_cqes = nullptr;
+};
+
+} // namespace margelo::nitro::node_fs
+
+#endif
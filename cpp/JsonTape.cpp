@@ -0,0 +1,678 @@
+#include "JsonTape.hpp"
+#include "FileIO.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unordered_map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define NITRO_FS_JSON_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NITRO_FS_JSON_NEON 1
+#endif
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+// Zero bytes after the input: a 16-byte load at any position up to the end
+// stays in bounds, and a zero (a control character) stops every scan.
+constexpr size_t kPadding = 32;
+constexpr size_t kMaxDepth = 1024;
+
+// Advances `p` to the first '"', '\\' or control character, clearing
+// `ascii` if a byte >= 0x80 is passed on the way.
+inline const uint8_t *scanString(const uint8_t *p, bool &ascii) {
+#if defined(NITRO_FS_JSON_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  while (true) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+        _mm_cmpeq_epi8(_mm_min_epu8(v, control), v)); // v <= 0x1f
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+    unsigned high = static_cast<unsigned>(_mm_movemask_epi8(v));
+    if (mask != 0) {
+      unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+      if (high & ((1u << bit) - 1)) {
+        ascii = false;
+      }
+      return p + bit;
+    }
+    if (high != 0) {
+      ascii = false;
+    }
+    p += 16;
+  }
+#elif defined(NITRO_FS_JSON_NEON)
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  const uint8x16_t control = vdupq_n_u8(0x20);
+  const uint8x16_t highBit = vdupq_n_u8(0x80);
+  // One nibble per byte lane, as in SubstringFinder.
+  auto nibbles = [](uint8x16_t lanes) {
+    return vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(lanes), 4)), 0);
+  };
+  while (true) {
+    uint8x16_t v = vld1q_u8(p);
+    uint64_t mask = nibbles(vorrq_u8(
+        vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+        vcltq_u8(v, control)));
+    uint64_t high = nibbles(vcgeq_u8(v, highBit));
+    if (mask != 0) {
+      unsigned bit = static_cast<unsigned>(__builtin_ctzll(mask)) >> 2;
+      if (bit != 0 && (high & ((1ull << (bit * 4)) - 1))) {
+        ascii = false;
+      }
+      return p + bit;
+    }
+    if (high != 0) {
+      ascii = false;
+    }
+    p += 16;
+  }
+#else
+  while (*p != '"' && *p != '\\' && *p >= 0x20) {
+    if (*p >= 0x80) {
+      ascii = false;
+    }
+    p++;
+  }
+  return p;
+#endif
+}
+
+bool isValidUtf8(const uint8_t *data, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    // Skip ASCII a word at a time.
+    while (i + 8 <= size) {
+      uint64_t word;
+      std::memcpy(&word, data + i, 8);
+      if (word & 0x8080808080808080ull) {
+        break;
+      }
+      i += 8;
+    }
+    if (i >= size) {
+      break;
+    }
+    uint8_t c = data[i];
+    if (c < 0x80) {
+      i++;
+      continue;
+    }
+    size_t length;
+    uint32_t cp;
+    if ((c & 0xe0) == 0xc0) {
+      length = 2;
+      cp = c & 0x1f;
+    } else if ((c & 0xf0) == 0xe0) {
+      length = 3;
+      cp = c & 0x0f;
+    } else if ((c & 0xf8) == 0xf0) {
+      length = 4;
+      cp = c & 0x07;
+    } else {
+      return false;
+    }
+    if (i + length > size) {
+      return false;
+    }
+    for (size_t k = 1; k < length; k++) {
+      if ((data[i + k] & 0xc0) != 0x80) {
+        return false;
+      }
+      cp = (cp << 6) | (data[i + k] & 0x3f);
+    }
+    if ((length == 2 && cp < 0x80) || (length == 3 && cp < 0x800) ||
+        (length == 4 && (cp < 0x10000 || cp > 0x10ffff)) ||
+        (cp >= 0xd800 && cp <= 0xdfff)) {
+      return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+void appendUtf8(std::string &out, uint32_t cp) {
+  if (cp < 0x80) {
+    out.push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else if (cp < 0x10000) {
+    out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else {
+    out.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  }
+}
+
+int hexValue(uint8_t c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+inline bool isDigit(uint8_t c) { return c >= '0' && c <= '9'; }
+
+} // namespace
+
+class JsonParser {
+public:
+  explicit JsonParser(JsonTape &tape)
+      : _tape(tape), _begin(tape._input.data()),
+        _end(_begin + tape._input.size() - kPadding), _p(_begin) {}
+
+  void parse() {
+    skipWhitespace();
+    if (_p == _end) {
+      fail("unexpected end of input");
+    }
+    parseValue(0);
+    skipWhitespace();
+    if (_p != _end) {
+      fail("unexpected data after JSON value");
+    }
+  }
+
+private:
+  [[noreturn]] void fail(const char *what) {
+    if (_p >= _end) {
+      what = "unexpected end of input";
+    }
+    throw std::runtime_error(std::string(what) + " at byte " +
+                             std::to_string(std::min(_p, _end) - _begin));
+  }
+
+  void skipWhitespace() {
+    while (*_p == ' ' || *_p == '\n' || *_p == '\r' || *_p == '\t') {
+      _p++;
+    }
+  }
+
+  size_t push(JsonTape::Kind kind) {
+    JsonTape::Node node{};
+    node.kind = kind;
+    _tape._nodes.push_back(node);
+    return _tape._nodes.size() - 1;
+  }
+
+  void expectLiteral(const char *literal, size_t length) {
+    if (std::memcmp(_p, literal, length) != 0) {
+      fail("invalid literal");
+    }
+    _p += length;
+  }
+
+  void parseValue(size_t depth) {
+    switch (*_p) {
+    case '{':
+      parseObject(depth + 1);
+      return;
+    case '[':
+      parseArray(depth + 1);
+      return;
+    case '"': {
+      _p++;
+      JsonTape::Node node{};
+      node.kind = JsonTape::Kind::String;
+      parseString(node);
+      _tape._nodes.push_back(node);
+      return;
+    }
+    case 't':
+      expectLiteral("true", 4);
+      push(JsonTape::Kind::True);
+      return;
+    case 'f':
+      expectLiteral("false", 5);
+      push(JsonTape::Kind::False);
+      return;
+    case 'n':
+      expectLiteral("null", 4);
+      push(JsonTape::Kind::Null);
+      return;
+    default:
+      if (*_p == '-' || isDigit(*_p)) {
+        parseNumber();
+        return;
+      }
+      fail("unexpected character");
+    }
+  }
+
+  void parseArray(size_t depth) {
+    if (depth > kMaxDepth) {
+      fail("nesting too deep");
+    }
+    _p++;
+    size_t index = push(JsonTape::Kind::Array);
+    uint32_t count = 0;
+    skipWhitespace();
+    if (*_p == ']') {
+      _p++;
+      return;
+    }
+    while (true) {
+      skipWhitespace();
+      parseValue(depth);
+      count++;
+      skipWhitespace();
+      if (*_p == ',') {
+        _p++;
+      } else if (*_p == ']') {
+        _p++;
+        break;
+      } else {
+        fail("expected ',' or ']'");
+      }
+    }
+    _tape._nodes[index].length = count;
+  }
+
+  void parseObject(size_t depth) {
+    if (depth > kMaxDepth) {
+      fail("nesting too deep");
+    }
+    _p++;
+    size_t index = push(JsonTape::Kind::Object);
+    uint32_t count = 0;
+    skipWhitespace();
+    if (*_p == '}') {
+      _p++;
+      return;
+    }
+    while (true) {
+      skipWhitespace();
+      if (*_p != '"') {
+        fail("expected string key");
+      }
+      _p++;
+      JsonTape::Node key{};
+      parseString(key);
+      size_t keyIndex = push(JsonTape::Kind::Key);
+      _tape._nodes[keyIndex].offset = internKey(key);
+      skipWhitespace();
+      if (*_p != ':') {
+        fail("expected ':'");
+      }
+      _p++;
+      skipWhitespace();
+      parseValue(depth);
+      count++;
+      skipWhitespace();
+      if (*_p == ',') {
+        _p++;
+      } else if (*_p == '}') {
+        _p++;
+        break;
+      } else {
+        fail("expected ',' or '}'");
+      }
+    }
+    _tape._nodes[index].length = count;
+  }
+
+  uint32_t internKey(const JsonTape::Node &key) {
+    std::string_view text = _tape.string(key);
+    // Records repeat the same few keys, so a direct-mapped cache on a cheap
+    // hash answers most lookups without hashing the whole key.
+    size_t slot = 0;
+    if (!text.empty()) {
+      slot = (text.size() * 31 + static_cast<uint8_t>(text.front()) * 7 +
+              static_cast<uint8_t>(text[text.size() / 2]) * 3 +
+              static_cast<uint8_t>(text.back())) %
+             kKeyCacheSize;
+    }
+    KeyCacheEntry &cached = _keyCache[slot];
+    if (cached.index != UINT32_MAX && cached.text == text) {
+      return cached.index;
+    }
+    auto found = _keyIndex.find(text);
+    if (found != _keyIndex.end()) {
+      cached = {found->second, _tape._keys[found->second]};
+      return found->second;
+    }
+    if (key.flags & JsonTape::kEscaped) {
+      // The pool may still move; keep a stable copy.
+      text = _tape._escapedKeys.emplace_back(text);
+    }
+    uint32_t index = static_cast<uint32_t>(_tape._keys.size());
+    _tape._keys.push_back(text);
+    _tape._keyAscii.push_back((key.flags & JsonTape::kAscii) != 0);
+    _keyIndex.emplace(text, index);
+    cached = {index, text};
+    return index;
+  }
+
+  // `_p` is just past the opening quote; leaves it past the closing one.
+  void parseString(JsonTape::Node &node) {
+    const uint8_t *start = _p;
+    bool ascii = true;
+    _p = scanString(_p, ascii);
+    if (*_p == '"') {
+      node.offset = static_cast<uint64_t>(start - _begin);
+      setLength(node, static_cast<size_t>(_p - start));
+      node.flags = ascii ? JsonTape::kAscii : 0;
+      _p++;
+      return;
+    }
+
+    std::string &pool = _tape._pool;
+    size_t poolStart = pool.size();
+    pool.append(reinterpret_cast<const char *>(start),
+                static_cast<size_t>(_p - start));
+    while (true) {
+      if (*_p != '\\') {
+        fail("control character in string");
+      }
+      _p++;
+      switch (*_p) {
+      case '"':
+      case '\\':
+      case '/':
+        pool.push_back(static_cast<char>(*_p));
+        break;
+      case 'b':
+        pool.push_back('\b');
+        break;
+      case 'f':
+        pool.push_back('\f');
+        break;
+      case 'n':
+        pool.push_back('\n');
+        break;
+      case 'r':
+        pool.push_back('\r');
+        break;
+      case 't':
+        pool.push_back('\t');
+        break;
+      case 'u': {
+        uint32_t cp = parseHex4(_p + 1);
+        _p += 4;
+        if (cp >= 0xd800 && cp <= 0xdbff && _p[1] == '\\' && _p[2] == 'u') {
+          uint32_t low = parseHex4(_p + 3);
+          if (low >= 0xdc00 && low <= 0xdfff) {
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            _p += 6;
+          }
+        }
+        if (cp >= 0xd800 && cp <= 0xdfff) {
+          cp = 0xfffd; // a lone surrogate has no UTF-8 encoding
+        }
+        if (cp >= 0x80) {
+          ascii = false;
+        }
+        appendUtf8(pool, cp);
+        break;
+      }
+      default:
+        fail("invalid escape");
+      }
+      _p++;
+      const uint8_t *run = _p;
+      _p = scanString(_p, ascii);
+      pool.append(reinterpret_cast<const char *>(run),
+                  static_cast<size_t>(_p - run));
+      if (*_p == '"') {
+        _p++;
+        break;
+      }
+    }
+    node.offset = poolStart;
+    setLength(node, pool.size() - poolStart);
+    node.flags = JsonTape::kEscaped | (ascii ? JsonTape::kAscii : 0);
+  }
+
+  uint32_t parseHex4(const uint8_t *p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+      int digit = hexValue(p[i]);
+      if (digit < 0) {
+        fail("invalid \\u escape");
+      }
+      value = (value << 4) | static_cast<uint32_t>(digit);
+    }
+    return value;
+  }
+
+  void setLength(JsonTape::Node &node, size_t length) {
+    if (length > UINT32_MAX) {
+      fail("string too long");
+    }
+    node.length = static_cast<uint32_t>(length);
+  }
+
+  void parseNumber() {
+    const uint8_t *start = _p;
+    bool negative = *_p == '-';
+    if (negative) {
+      _p++;
+    }
+    // Significant digits go into `mantissa` while they fit exactly.
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    auto digit = [&](int fraction) {
+      unsigned d = static_cast<unsigned>(*_p++ - '0');
+      if (mantissa == 0 && d == 0) {
+        exponent -= fraction; // leading zero
+      } else if (significant < 19) {
+        mantissa = mantissa * 10 + d;
+        significant++;
+        exponent -= fraction;
+      } else {
+        significant = INT32_MAX; // too many digits for the fast path
+      }
+    };
+    if (*_p == '0') {
+      _p++;
+    } else if (isDigit(*_p)) {
+      while (isDigit(*_p)) {
+        digit(0);
+      }
+    } else {
+      fail("invalid number");
+    }
+    if (*_p == '.') {
+      _p++;
+      if (!isDigit(*_p)) {
+        fail("invalid number");
+      }
+      while (isDigit(*_p)) {
+        digit(1);
+      }
+    }
+    if (*_p == 'e' || *_p == 'E') {
+      _p++;
+      bool negativeExponent = *_p == '-';
+      if (*_p == '+' || *_p == '-') {
+        _p++;
+      }
+      if (!isDigit(*_p)) {
+        fail("invalid number");
+      }
+      int explicitExponent = 0;
+      while (isDigit(*_p)) {
+        if (explicitExponent < 100000) {
+          explicitExponent = explicitExponent * 10 + (*_p - '0');
+        }
+        _p++;
+      }
+      exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    static const double kPowersOf10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    size_t index = push(JsonTape::Kind::Number);
+    double value;
+    if (significant <= 15 && exponent >= -22 && exponent <= 22) {
+      // Clinger's fast path: the mantissa and the power of ten are exact
+      // doubles, so one multiplication or division rounds correctly.
+      value = static_cast<double>(mantissa);
+      value = exponent < 0 ? value / kPowersOf10[-exponent]
+                           : value * kPowersOf10[exponent];
+    } else {
+      // The grammar was checked above and the padding terminates the input.
+      // strtod assumes the "C" locale, which apps do not change for C code.
+      value = std::strtod(
+          reinterpret_cast<const char *>(start + (negative ? 1 : 0)), nullptr);
+    }
+    _tape._nodes[index].number = negative ? -value : value;
+  }
+
+  JsonTape &_tape;
+  const uint8_t *_begin;
+  const uint8_t *_end;
+  const uint8_t *_p;
+  std::unordered_map<std::string_view, uint32_t> _keyIndex;
+  static constexpr size_t kKeyCacheSize = 256;
+  struct KeyCacheEntry {
+    uint32_t index = UINT32_MAX;
+    std::string_view text;
+  };
+  KeyCacheEntry _keyCache[kKeyCacheSize];
+};
+
+std::string_view JsonTape::string(const Node &node) const {
+  const char *base = (node.flags & kEscaped)
+                         ? _pool.data()
+                         : reinterpret_cast<const char *>(_input.data());
+  return std::string_view(base + node.offset, node.length);
+}
+
+size_t JsonTape::memorySize() const {
+  size_t keys = 0;
+  for (const auto &key : _escapedKeys) {
+    keys += key.size();
+  }
+  return _input.capacity() + _pool.capacity() +
+         _nodes.capacity() * sizeof(Node) +
+         _keys.capacity() * sizeof(std::string_view) + keys;
+}
+
+std::shared_ptr<JsonTape> parseJson(std::vector<uint8_t> input) {
+  if (!isValidUtf8(input.data(), input.size())) {
+    throw std::runtime_error("invalid UTF-8");
+  }
+  auto tape = std::make_shared<JsonTape>();
+  // Roughly one node per 8 bytes of typical API responses.
+  tape->_nodes.reserve(input.size() / 8 + 1);
+  tape->_inputSize = input.size();
+  input.resize(input.size() + kPadding, 0);
+  tape->_input = std::move(input);
+  JsonParser(*tape).parse();
+  return tape;
+}
+
+std::shared_ptr<JsonTape> readJsonFile(const std::string &path) {
+  UniqueFd fd = openForRead(path.c_str());
+  if (!fd) {
+    throw std::runtime_error("readJSON failed (open): " + path);
+  }
+  struct stat st;
+  if (::fstat(fd.get(), &st) != 0) {
+    throw std::runtime_error("readJSON failed (stat): " + path);
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  std::vector<uint8_t> input;
+  input.reserve(size + kPadding);
+  input.resize(size);
+  ssize_t n = readFully(fd.get(), input.data(), size);
+  if (n < 0) {
+    throw std::runtime_error("readJSON failed (read): " + path);
+  }
+  input.resize(static_cast<size_t>(n));
+  try {
+    return parseJson(std::move(input));
+  } catch (const std::runtime_error &error) {
+    throw std::runtime_error(std::string("readJSON failed (") + error.what() +
+                             "): " + path);
+  }
+}
+
+void appendJsonString(std::string &out, std::string_view value) {
+  static const char kHex[] = "0123456789abcdef";
+  out.push_back('"');
+  size_t run = 0;
+  for (size_t i = 0; i < value.size(); i++) {
+    auto c = static_cast<uint8_t>(value[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    out.append(value.data() + run, i - run);
+    run = i + 1;
+    switch (c) {
+    case '"':
+      out.append("\\\"");
+      break;
+    case '\\':
+      out.append("\\\\");
+      break;
+    case '\b':
+      out.append("\\b");
+      break;
+    case '\f':
+      out.append("\\f");
+      break;
+    case '\n':
+      out.append("\\n");
+      break;
+    case '\r':
+      out.append("\\r");
+      break;
+    case '\t':
+      out.append("\\t");
+      break;
+    default:
+      out.append("\\u00");
+      out.push_back(kHex[c >> 4]);
+      out.push_back(kHex[c & 0xf]);
+    }
+  }
+  out.append(value.data() + run, value.size() - run);
+  out.push_back('"');
+}
+
+void appendJsonNumber(std::string &out, double value) {
+  if (!std::isfinite(value)) {
+    out.append("null");
+    return;
+  }
+  char buffer[32];
+  int length;
+  if (value == std::trunc(value) && std::fabs(value) < 9.0e18) {
+    // Integral values print in full, as JS does below 1e21. -0 prints as 0.
+    length = std::snprintf(buffer, sizeof(buffer), "%lld",
+                           static_cast<long long>(value));
+  } else {
+    // Shortest of the two precisions that round-trips.
+    length = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    if (std::strtod(buffer, nullptr) != value) {
+      length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+  }
+  out.append(buffer, static_cast<size_t>(length));
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * A parsed JSON document as a flat preorder list of nodes, built off the JS
+ * thread so that turning it into JS values is a single linear pass.
+ *
+ * An Array node is followed by its `length` elements; an Object node by
+ * `length` members, each a Key node and then the value. Strings without
+ * escapes point into the input, which the tape keeps; unescaped copies of
+ * the others live in a pool. Object keys are interned, so a key repeated
+ * across thousands of objects is one entry.
+ */
+class JsonTape {
+public:
+  enum class Kind : uint8_t { Null, False, True, Number, String, Array, Object, Key };
+
+  // String node flags.
+  static constexpr uint8_t kEscaped = 1; // bytes are in the pool
+  static constexpr uint8_t kAscii = 2;   // no byte >= 0x80
+
+  struct Node {
+    Kind kind;
+    uint8_t flags;
+    uint32_t length; // String: bytes. Array: elements. Object: members.
+    union {
+      double number;
+      uint64_t offset; // String: into the input or pool. Key: key index.
+    };
+  };
+
+  const std::vector<Node> &nodes() const { return _nodes; }
+  std::string_view string(const Node &node) const;
+  std::string_view key(size_t index) const { return _keys[index]; }
+  bool keyIsAscii(size_t index) const { return _keyAscii[index]; }
+  size_t keyCount() const { return _keys.size(); }
+  size_t inputSize() const { return _inputSize; }
+  // Bytes held by the tape, for the JS garbage collector.
+  size_t memorySize() const;
+
+private:
+  friend class JsonParser;
+  friend std::shared_ptr<JsonTape> parseJson(std::vector<uint8_t> input);
+
+  std::vector<uint8_t> _input; // zero-padded past the end
+  size_t _inputSize = 0;
+  std::string _pool;
+  std::vector<Node> _nodes;
+  std::vector<std::string_view> _keys; // into _input or _escapedKeys
+  std::vector<bool> _keyAscii;
+  std::deque<std::string> _escapedKeys;
+};
+
+/**
+ * Parses `input` (RFC 8259, UTF-8) into a tape. Strings are scanned 16 bytes
+ * at a time (SSE2 or NEON). Lone surrogate escapes become U+FFFD. Throws
+ * std::runtime_error naming the byte offset of a syntax error.
+ */
+std::shared_ptr<JsonTape> parseJson(std::vector<uint8_t> input);
+// Reads and parses a file; errors name the path.
+std::shared_ptr<JsonTape> readJsonFile(const std::string &path);
+
+// Appends `value` as a JSON string literal, escaping as JSON.stringify does.
+void appendJsonString(std::string &out, std::string_view value);
+// Appends `value` so that it parses back to the same double. Non-finite
+// values become null, as in JSON.stringify.
+void appendJsonNumber(std::string &out, double value);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,350 @@
+#include "LineIndex.hpp"
+#include "AtomicWrite.hpp"
+#include "FileIO.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unordered_map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define NITRO_FS_LINES_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NITRO_FS_LINES_NEON 1
+#endif
+
+namespace margelo::nitro::node_fs {
+
+size_t countNewlines(const uint8_t *data, size_t size) {
+  size_t total = 0;
+  size_t i = 0;
+#if defined(NITRO_FS_LINES_SSE2)
+  const __m128i newline = _mm_set1_epi8('\n');
+  while (i + 16 <= size) {
+    // Byte lanes count up to 255 matches before they are summed.
+    __m128i counts = _mm_setzero_si128();
+    for (int k = 0; k < 255 && i + 16 <= size; k++, i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(v, newline));
+    }
+    __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+    total += static_cast<size_t>(_mm_extract_epi16(sums, 0)) +
+             static_cast<size_t>(_mm_extract_epi16(sums, 4));
+  }
+#elif defined(NITRO_FS_LINES_NEON)
+  const uint8x16_t newline = vdupq_n_u8('\n');
+  while (i + 16 <= size) {
+    uint8x16_t counts = vdupq_n_u8(0);
+    for (int k = 0; k < 255 && i + 16 <= size; k++, i += 16) {
+      counts = vsubq_u8(counts, vceqq_u8(vld1q_u8(data + i), newline));
+    }
+    uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(counts)));
+    total += static_cast<size_t>(vgetq_lane_u64(sums, 0) +
+                                 vgetq_lane_u64(sums, 1));
+  }
+#endif
+  for (; i < size; i++) {
+    total += data[i] == '\n';
+  }
+  return total;
+}
+
+namespace {
+
+constexpr size_t kScanChunkSize = 1 << 20;
+constexpr size_t kCountBlockSize = 4 << 10;
+constexpr size_t kMaxCachedIndexes = 32;
+constexpr uint32_t kSidecarVersion = 1;
+constexpr size_t kSidecarHeaderSize = 64;
+
+void putU32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = static_cast<uint8_t>(v >> (i * 8));
+  }
+}
+
+void putU64(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    p[i] = static_cast<uint8_t>(v >> (i * 8));
+  }
+}
+
+uint32_t getU32(const uint8_t *p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+         (uint32_t(p[3]) << 24);
+}
+
+uint64_t getU64(const uint8_t *p) {
+  return uint64_t(getU32(p)) | (uint64_t(getU32(p + 4)) << 32);
+}
+
+struct LineIndexState {
+  uint64_t stride = 0;
+  uint64_t dev = 0;
+  uint64_t ino = 0;
+  uint64_t size = 0;      // bytes indexed
+  uint64_t newlines = 0;  // '\n' bytes in them
+  uint64_t tailStart = 0; // start of the line after the last '\n'
+  // checkpoints[i] = offset of line i * stride; checkpoints[0] = 0.
+  std::vector<uint64_t> checkpoints{0};
+
+  uint64_t lines() const { return newlines + (size > tailStart ? 1 : 0); }
+};
+
+struct CachedIndex {
+  std::mutex mutex;
+  LineIndexState state;
+  uint64_t lastUse = 0;
+};
+
+std::shared_ptr<CachedIndex> cachedIndex(const std::string &path) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::shared_ptr<CachedIndex>> indexes;
+  static uint64_t clock = 0;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto &entry = indexes[path];
+  if (!entry) {
+    if (indexes.size() > kMaxCachedIndexes) {
+      auto oldest = indexes.end();
+      for (auto it = indexes.begin(); it != indexes.end(); ++it) {
+        if (it->second && (oldest == indexes.end() ||
+                           it->second->lastUse < oldest->second->lastUse)) {
+          oldest = it;
+        }
+      }
+      indexes.erase(oldest); // callers holding it keep their copy
+    }
+    entry = std::make_shared<CachedIndex>();
+  }
+  entry->lastUse = ++clock;
+  return entry;
+}
+
+// Sidecar layout (little-endian): "NFSL", version, stride, reserved, then
+// dev, ino, size, newlines, tailStart, checkpoint count, reserved (u64),
+// then the checkpoints as u64.
+bool loadSidecar(const std::string &indexPath, LineIndexState &state) {
+  UniqueFd fd = openForRead(indexPath.c_str());
+  if (!fd) {
+    return false;
+  }
+  uint8_t header[kSidecarHeaderSize];
+  if (readFully(fd.get(), header, sizeof(header)) !=
+          static_cast<ssize_t>(sizeof(header)) ||
+      std::memcmp(header, "NFSL", 4) != 0 ||
+      getU32(header + 4) != kSidecarVersion ||
+      getU32(header + 8) != state.stride) {
+    return false;
+  }
+  LineIndexState loaded;
+  loaded.stride = state.stride;
+  loaded.dev = getU64(header + 16);
+  loaded.ino = getU64(header + 24);
+  loaded.size = getU64(header + 32);
+  loaded.newlines = getU64(header + 40);
+  loaded.tailStart = getU64(header + 48);
+  uint64_t count = getU64(header + 56);
+  if (loaded.dev != state.dev || loaded.ino != state.ino || count == 0 ||
+      count != loaded.newlines / loaded.stride + 1 || count > (1u << 28)) {
+    return false;
+  }
+  std::vector<uint8_t> data(static_cast<size_t>(count) * 8);
+  if (readFully(fd.get(), data.data(), data.size()) !=
+      static_cast<ssize_t>(data.size())) {
+    return false;
+  }
+  loaded.checkpoints.resize(static_cast<size_t>(count));
+  for (size_t i = 0; i < loaded.checkpoints.size(); i++) {
+    loaded.checkpoints[i] = getU64(data.data() + i * 8);
+  }
+  state = std::move(loaded);
+  return true;
+}
+
+void saveSidecar(const std::string &indexPath, const LineIndexState &state) {
+  std::vector<uint8_t> data(kSidecarHeaderSize + state.checkpoints.size() * 8, 0);
+  std::memcpy(data.data(), "NFSL", 4);
+  putU32(data.data() + 4, kSidecarVersion);
+  putU32(data.data() + 8, static_cast<uint32_t>(state.stride));
+  putU64(data.data() + 16, state.dev);
+  putU64(data.data() + 24, state.ino);
+  putU64(data.data() + 32, state.size);
+  putU64(data.data() + 40, state.newlines);
+  putU64(data.data() + 48, state.tailStart);
+  putU64(data.data() + 56, state.checkpoints.size());
+  for (size_t i = 0; i < state.checkpoints.size(); i++) {
+    putU64(data.data() + kSidecarHeaderSize + i * 8, state.checkpoints[i]);
+  }
+  // A lost sidecar only costs a rescan, so skip the fsyncs.
+  atomicWriteFiles({{indexPath, data.data(), data.size()}}, SyncLevel::None);
+}
+
+// Scans [state.size, size) of `fd`, extending the index.
+void scanFrom(int fd, uint64_t size, LineIndexState &state,
+              const std::string &path, const char *op) {
+  std::vector<uint8_t> buffer(kScanChunkSize);
+  const uint64_t stride = state.stride;
+  while (state.size < size) {
+    size_t want =
+        static_cast<size_t>(std::min<uint64_t>(buffer.size(), size - state.size));
+    ssize_t n = preadFully(fd, buffer.data(), want, state.size);
+    if (n < 0) {
+      throw std::runtime_error(std::string(op) + " failed (read): " + path);
+    }
+    if (n == 0) {
+      break; // truncated while scanning
+    }
+    const uint8_t *data = buffer.data();
+    size_t length = static_cast<size_t>(n);
+    for (size_t block = 0; block < length; block += kCountBlockSize) {
+      size_t blockLength = std::min(kCountBlockSize, length - block);
+      size_t count = countNewlines(data + block, blockLength);
+      uint64_t nextCheckpoint = state.checkpoints.size() * stride;
+      if (state.newlines + count < nextCheckpoint) {
+        state.newlines += count;
+        continue;
+      }
+      // A checkpoint falls in this block: find the exact newline.
+      const uint8_t *p = data + block;
+      const uint8_t *end = p + blockLength;
+      while (true) {
+        p = static_cast<const uint8_t *>(
+            std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (p == nullptr) {
+          break;
+        }
+        p++;
+        if (++state.newlines % stride == 0) {
+          state.checkpoints.push_back(state.size +
+                                      static_cast<uint64_t>(p - data));
+        }
+      }
+    }
+    for (size_t i = length; i > 0; i--) {
+      if (data[i - 1] == '\n') {
+        state.tailStart = state.size + i;
+        break;
+      }
+    }
+    state.size += length;
+  }
+}
+
+LineIndexStats statsOf(const LineIndexState &state, uint64_t scanned) {
+  LineIndexStats stats;
+  stats.lines = state.lines();
+  stats.size = state.size;
+  stats.checkpoints = state.checkpoints.size();
+  stats.scannedBytes = scanned;
+  return stats;
+}
+
+// Brings `state` up to date with the file behind `fd`. Returns the bytes
+// scanned.
+uint64_t refresh(int fd, const std::string &path, const char *op,
+                 const LineIndexConfig &config, LineIndexState &state) {
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    throw std::runtime_error(std::string(op) + " failed (stat): " + path);
+  }
+  uint64_t stride = std::max<uint64_t>(config.stride, 1);
+  uint64_t dev = static_cast<uint64_t>(st.st_dev);
+  uint64_t ino = static_cast<uint64_t>(st.st_ino);
+  uint64_t size = static_cast<uint64_t>(st.st_size);
+  bool fresh = state.stride != stride || state.dev != dev ||
+               state.ino != ino || state.size > size;
+  if (fresh) {
+    state = LineIndexState();
+    state.stride = stride;
+    state.dev = dev;
+    state.ino = ino;
+    if (!config.indexPath.empty() && loadSidecar(config.indexPath, state) &&
+        state.size > size) {
+      state = LineIndexState();
+      state.stride = stride;
+      state.dev = dev;
+      state.ino = ino;
+    }
+  }
+  uint64_t before = state.size;
+  if (state.size < size) {
+    scanFrom(fd, size, state, path, op);
+  }
+  if (!config.indexPath.empty() && (fresh || state.size != before)) {
+    saveSidecar(config.indexPath, state);
+  }
+  return state.size - before;
+}
+
+UniqueFd openIndexed(const std::string &path, const char *op) {
+  UniqueFd fd = openForRead(path.c_str());
+  if (!fd) {
+    throw std::runtime_error(std::string(op) + " failed (open): " + path);
+  }
+  return fd;
+}
+
+} // namespace
+
+LineIndexStats buildLineIndex(const std::string &path,
+                              const LineIndexConfig &config) {
+  UniqueFd fd = openIndexed(path, "buildLineIndex");
+  auto index = cachedIndex(path);
+  std::lock_guard<std::mutex> guard(index->mutex);
+  uint64_t scanned =
+      refresh(fd.get(), path, "buildLineIndex", config, index->state);
+  return statsOf(index->state, scanned);
+}
+
+std::vector<std::string> readLines(const std::string &path, uint64_t startLine,
+                                   size_t count,
+                                   const LineIndexConfig &config) {
+  UniqueFd fd = openIndexed(path, "readLines");
+  auto index = cachedIndex(path);
+  std::lock_guard<std::mutex> guard(index->mutex);
+  refresh(fd.get(), path, "readLines", config, index->state);
+  const LineIndexState &state = index->state;
+
+  std::vector<std::string> lines;
+  uint64_t total = state.lines();
+  if (startLine >= total || count == 0) {
+    return lines;
+  }
+  uint64_t endLine = std::min<uint64_t>(total, startLine + count);
+  uint64_t first = startLine / state.stride;
+  uint64_t last = (endLine + state.stride - 1) / state.stride;
+  uint64_t begin = state.checkpoints[first];
+  uint64_t end = last < state.checkpoints.size() ? state.checkpoints[last]
+                                                 : state.size;
+
+  std::vector<uint8_t> buffer(static_cast<size_t>(end - begin));
+  ssize_t n = preadFully(fd.get(), buffer.data(), buffer.size(), begin);
+  if (n < 0) {
+    throw std::runtime_error("readLines failed (read): " + path);
+  }
+  const char *p = reinterpret_cast<const char *>(buffer.data());
+  const char *bufferEnd = p + n;
+  uint64_t line = first * state.stride;
+  lines.reserve(static_cast<size_t>(endLine - startLine));
+  while (line < endLine && p < bufferEnd) {
+    const char *newline = static_cast<const char *>(
+        std::memchr(p, '\n', static_cast<size_t>(bufferEnd - p)));
+    const char *lineEnd = newline != nullptr ? newline : bufferEnd;
+    if (line >= startLine) {
+      const char *textEnd = lineEnd;
+      if (textEnd > p && textEnd[-1] == '\r') {
+        textEnd--;
+      }
+      lines.emplace_back(p, textEnd);
+    }
+    line++;
+    p = newline != nullptr ? newline + 1 : bufferEnd;
+  }
+  return lines;
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+// Number of '\n' bytes in data[0, size), 16 bytes per step (SSE2 or NEON).
+size_t countNewlines(const uint8_t *data, size_t size);
+
+struct LineIndexConfig {
+  size_t stride = 256;   // lines between checkpoints
+  std::string indexPath; // sidecar file to load and save; empty = memory only
+};
+
+struct LineIndexStats {
+  uint64_t lines = 0; // a final line without '\n' counts
+  uint64_t size = 0;  // bytes indexed
+  size_t checkpoints = 0;
+  uint64_t scannedBytes = 0; // read by this call
+};
+
+/**
+ * Sparse line index of a text file: the offset of every stride-th line.
+ * Indexes are cached per path in memory (a few dozen, least recently used
+ * evicted) and optionally in a sidecar file. When the file has grown, only
+ * the new bytes are scanned; when it shrank or was replaced (another inode),
+ * it is rescanned. A rewrite that keeps the inode and does not shrink the
+ * file is not detected. Throws std::runtime_error on I/O errors.
+ */
+LineIndexStats buildLineIndex(const std::string &path,
+                              const LineIndexConfig &config);
+
+/**
+ * Lines [startLine, startLine + count) (0-based), without their terminators
+ * ("\n" or "\r\n"). The index is built or extended first; the lines are then
+ * read with one pread between the surrounding checkpoints. Fewer lines are
+ * returned at the end of the file.
+ */
+std::vector<std::string> readLines(const std::string &path, uint64_t startLine,
+                                   size_t count, const LineIndexConfig &config);
+
+} // namespace margelo::nitro::node_fs
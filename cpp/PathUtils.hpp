@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+// Path helpers for native code that writes archive/tree entries below a
+// destination directory. Paths are '/'-separated on every platform we ship.
+
+inline std::string joinPath(const std::string &dir, const std::string &name) {
+  if (dir.empty() || dir.back() == '/')
+    return dir + name;
+  return dir + "/" + name;
+}
+
+inline std::string parentOf(const std::string &path) {
+  size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+// True for non-empty relative names without ".." segments or backslashes,
+// i.e. names that cannot resolve outside the directory they are joined to.
+inline bool isSafeRelativePath(const std::string &name) {
+  if (name.empty() || name[0] == '/' || name.find('\\') != std::string::npos) {
+    return false;
+  }
+  size_t start = 0;
+  while (start <= name.size()) {
+    size_t end = name.find('/', start);
+    if (end == std::string::npos)
+      end = name.size();
+    if (end - start == 2 && name.compare(start, 2, "..") == 0) {
+      return false;
+    }
+    start = end + 1;
+  }
+  return true;
+}
+
+} // namespace margelo::nitro::node_fs
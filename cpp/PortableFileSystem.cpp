@@ -0,0 +1,218 @@
+#include "PortableFileSystem.hpp"
+#include "BufferPool.hpp"
+#include "FileIO.hpp"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#if defined(__APPLE__)
+#include <sys/mount.h>
+#elif defined(__linux__)
+#include <sys/vfs.h>
+#endif
+
+namespace margelo::nitro::node_fs::portable {
+
+std::shared_ptr<ArrayBuffer> readFile(const std::string &path) {
+  // Regular files are read straight into their final buffer: pooled slabs
+  // from one page up, an exact allocation below that. Files without a
+  // usable size (procfs, devices) take the Rust path.
+  UniqueFd fd = openForRead(path.c_str());
+  struct stat st;
+  if (fd && ::fstat(fd.get(), &st) == 0 && S_ISREG(st.st_mode) &&
+      st.st_size > 0) {
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size >= BufferPool::kMinClassSize) {
+      BufferPool &pool = BufferPool::shared();
+      size_t capacity = 0;
+      uint8_t *data = pool.acquire(size, capacity);
+      ssize_t got = readFully(fd.get(), data, size);
+      if (got < 0) {
+        pool.recycle(data, capacity);
+        throw std::runtime_error("readFile failed: " + path);
+      }
+      return pool.adopt(data, static_cast<size_t>(got), capacity);
+    }
+    auto buffer = ArrayBuffer::allocate(size);
+    ssize_t got = readFully(fd.get(), buffer->data(), size);
+    if (got < 0) {
+      throw std::runtime_error("readFile failed: " + path);
+    }
+    if (static_cast<size_t>(got) < size) {
+      return ArrayBuffer::copy(buffer->data(), static_cast<size_t>(got));
+    }
+    return buffer;
+  }
+  fd.reset();
+
+  size_t len = 0;
+  uint8_t *data = rn_fs_read_file(path.c_str(), &len);
+  if (!data) {
+    throw std::runtime_error("readFile failed: " + path);
+  }
+
+  auto buffer = ArrayBuffer::copy(data, len);
+  rn_fs_read_file_free(data, len);
+  return buffer;
+}
+
+void writeFile(const std::string &path, const uint8_t *data, size_t size) {
+  if (rn_fs_write_file(path.c_str(), data, size) != 0) {
+    throw std::runtime_error("writeFile failed: " + path);
+  }
+}
+
+RNStats stat(const std::string &path) {
+  RNStats s;
+  if (rn_fs_stat(path.c_str(), &s) != 0) {
+    throw std::runtime_error("stat failed: " + path);
+  }
+  return s;
+}
+
+RNStats lstat(const std::string &path) {
+  RNStats s;
+  if (rn_fs_lstat(path.c_str(), &s) != 0) {
+    throw std::runtime_error("lstat failed: " + path);
+  }
+  return s;
+}
+
+RNStats fstat(int fd) {
+  RNStats s;
+  if (rn_fs_fstat(fd, &s) != 0) {
+    throw std::runtime_error("fstat failed");
+  }
+  return s;
+}
+
+VolumeStats statfs(const std::string &path) {
+  struct statvfs vfs;
+  if (::statvfs(path.c_str(), &vfs) != 0) {
+    throw std::runtime_error("statfs failed: " + path);
+  }
+  VolumeStats v;
+  v.bsize = vfs.f_frsize != 0 ? vfs.f_frsize : vfs.f_bsize;
+  v.blocks = vfs.f_blocks;
+  v.bfree = vfs.f_bfree;
+  v.bavail = vfs.f_bavail;
+  v.files = vfs.f_files;
+  v.ffree = vfs.f_ffree;
+#if defined(__APPLE__) || defined(__linux__)
+  // statvfs has no file system type; statfs does.
+  struct ::statfs fs;
+  if (::statfs(path.c_str(), &fs) == 0) {
+    v.type = static_cast<uint32_t>(fs.f_type); // 32-bit magic
+  }
+#endif
+  return v;
+}
+
+std::vector<std::string> readdir(const std::string &path) {
+  DirIter *iter = rn_fs_readdir_open(path.c_str());
+  if (!iter) {
+    throw std::runtime_error("readdir failed (open): " + path);
+  }
+
+  std::vector<std::string> results;
+  char *name;
+  while ((name = rn_fs_readdir_next(iter)) != nullptr) {
+    results.push_back(std::string(name));
+    rn_fs_free_string(name);
+  }
+
+  rn_fs_readdir_close(iter);
+  return results;
+}
+
+#ifdef IOV_MAX
+constexpr size_t kIovMax = IOV_MAX;
+#else
+constexpr size_t kIovMax = 1024;
+#endif
+
+std::vector<RNIovec> &iovecScratch() {
+  thread_local std::vector<RNIovec> iovecs;
+  return iovecs;
+}
+
+size_t readv(int fd, RNIovec *iovecs, size_t count, int64_t position) {
+  size_t total = 0;
+  while (count > 0) {
+    size_t n = std::min(count, kIovMax);
+    size_t wanted = 0;
+    for (size_t i = 0; i < n; i++) {
+      wanted += iovecs[i].len;
+    }
+    intptr_t result = rn_fs_readv(fd, iovecs, static_cast<int>(n), position);
+    if (result < 0) {
+      throw std::runtime_error("readv failed");
+    }
+    total += static_cast<size_t>(result);
+    if (static_cast<size_t>(result) < wanted) {
+      break;
+    }
+    if (position >= 0) {
+      position += result;
+    }
+    iovecs += n;
+    count -= n;
+  }
+  return total;
+}
+
+size_t writev(int fd, RNIovec *iovecs, size_t count, int64_t position) {
+  size_t total = 0;
+  while (count > 0) {
+    size_t n = std::min(count, kIovMax);
+    intptr_t result = rn_fs_writev(fd, iovecs, static_cast<int>(n), position);
+    if (result < 0) {
+      throw std::runtime_error("writev failed");
+    }
+    total += static_cast<size_t>(result);
+    if (position >= 0) {
+      position += result;
+    }
+    // Skip what was written, trimming a partially written iovec.
+    size_t left = static_cast<size_t>(result);
+    while (count > 0 && left >= iovecs->len) {
+      left -= iovecs->len;
+      iovecs++;
+      count--;
+    }
+    if (left > 0) {
+      iovecs->base += left;
+      iovecs->len -= left;
+    } else if (result == 0 && count > 0 && iovecs->len > 0) {
+      throw std::runtime_error("writev failed: no progress");
+    }
+  }
+  return total;
+}
+
+static std::vector<RNIovec> &
+toIovecs(const std::vector<std::shared_ptr<ArrayBuffer>> &buffers) {
+  std::vector<RNIovec> &iovecs = iovecScratch();
+  iovecs.clear();
+  for (const auto &buf : buffers) {
+    if (buf) {
+      iovecs.push_back({buf->data(), buf->size()});
+    }
+  }
+  return iovecs;
+}
+
+size_t readv(int fd, const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
+             int64_t position) {
+  std::vector<RNIovec> &iovecs = toIovecs(buffers);
+  return readv(fd, iovecs.data(), iovecs.size(), position);
+}
+
+size_t writev(int fd, const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
+              int64_t position) {
+  std::vector<RNIovec> &iovecs = toIovecs(buffers);
+  return writev(fd, iovecs.data(), iovecs.size(), position);
+}
+
+} // namespace margelo::nitro::node_fs::portable
@@ -0,0 +1,58 @@
+#pragma once
+#include "rust_c_file_system.h"
+#include <NitroModules/ArrayBuffer.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs::portable {
+
+// Platform-independent implementations behind HybridFileSystem, i.e. the
+// paths taken once content://, bookmark:// and asset handling is ruled out.
+// They only depend on rn_fs_* and ArrayBuffer, so they can also be built on
+// a host machine (see benchmarks/). Errors throw std::runtime_error.
+
+std::shared_ptr<ArrayBuffer> readFile(const std::string &path);
+void writeFile(const std::string &path, const uint8_t *data, size_t size);
+
+RNStats stat(const std::string &path);
+RNStats lstat(const std::string &path);
+RNStats fstat(int fd);
+
+// Volume statistics as in Node's fs.statfs. Block counts are in units of
+// `bsize` (the fragment size), so bavail * bsize is the space available to
+// unprivileged writers. `type` is the f_type magic (0 where unsupported).
+struct VolumeStats {
+  uint64_t type = 0;
+  uint64_t bsize = 0;
+  uint64_t blocks = 0;
+  uint64_t bfree = 0;
+  uint64_t bavail = 0;
+  uint64_t files = 0;
+  uint64_t ffree = 0;
+
+  uint64_t availableBytes() const { return bavail * bsize; }
+};
+
+VolumeStats statfs(const std::string &path);
+
+std::vector<std::string> readdir(const std::string &path);
+
+// Per-thread iovec array for building vectored I/O without allocating.
+// Callers clear() it; the capacity is kept across calls.
+std::vector<RNIovec> &iovecScratch();
+
+// Vectored I/O on prepared iovecs, issued in chunks of at most IOV_MAX.
+// readv stops at the first short read (EOF); writev resumes partial writes
+// and so may modify `iovecs`. A position of -1 uses the file offset.
+size_t readv(int fd, RNIovec *iovecs, size_t count, int64_t position);
+size_t writev(int fd, RNIovec *iovecs, size_t count, int64_t position);
+
+// Whole-buffer variants.
+size_t readv(int fd, const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
+             int64_t position);
+size_t writev(int fd, const std::vector<std::shared_ptr<ArrayBuffer>> &buffers,
+              int64_t position);
+
+} // namespace margelo::nitro::node_fs::portable
@@ -0,0 +1,34 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * Incremental SHA-256 (FIPS 180-4). Used where native code needs a strong,
+ * stable content hash; zlib only provides CRC32 and Adler-32.
+ */
+class Sha256 {
+public:
+  static constexpr size_t kDigestSize = 32;
+  using Digest = std::array<uint8_t, kDigestSize>;
+
+  Sha256();
+
+  void update(const uint8_t *data, size_t size);
+  // Finalizes the hash. The object must not be updated afterwards.
+  Digest finish();
+
+  static Digest hash(const uint8_t *data, size_t size);
+
+private:
+  void compress(const uint8_t *block);
+
+  uint32_t _state[8];
+  uint64_t _length = 0;
+  uint8_t _buffer[64];
+  size_t _buffered = 0;
+};
+
+} // namespace margelo::nitro::node_fs
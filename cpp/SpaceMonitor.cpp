@@ -0,0 +1,90 @@
+#include "SpaceMonitor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace margelo::nitro::node_fs {
+
+static uint64_t recoveryMargin(uint64_t threshold) {
+  return std::min<uint64_t>(threshold / 10, 64ull << 20);
+}
+
+SpaceMonitor::SpaceMonitor(std::string path, const SpaceMonitorConfig &config,
+                           Callback onChange)
+    : _path(std::move(path)), _config(config), _onChange(std::move(onChange)) {
+  _config.intervalMs = std::max<uint32_t>(_config.intervalMs, 100);
+  // Fail early on a path that cannot be queried at all.
+  portable::statfs(_path);
+  _thread = std::thread([this]() { run(); });
+}
+
+SpaceMonitor::~SpaceMonitor() { close(); }
+
+void SpaceMonitor::close() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_closing) {
+      return;
+    }
+    _closing = true;
+    _wake.notify_one();
+  }
+  if (_thread.joinable()) {
+    if (_thread.get_id() == std::this_thread::get_id()) {
+      _thread.detach(); // closed from the callback
+    } else {
+      _thread.join();
+    }
+  }
+}
+
+bool SpaceMonitor::isLow() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _low;
+}
+
+portable::VolumeStats SpaceMonitor::check() {
+  portable::VolumeStats stats = portable::statfs(_path);
+  evaluate(stats);
+  return stats;
+}
+
+void SpaceMonitor::evaluate(const portable::VolumeStats &stats) {
+  std::lock_guard<std::mutex> serial(_evaluateMutex);
+  uint64_t available = stats.availableBytes();
+  bool low;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_closing) {
+      return;
+    }
+    if (!_low && available < _config.thresholdBytes) {
+      _low = true;
+    } else if (_low && available >= _config.thresholdBytes &&
+               available - _config.thresholdBytes >=
+                   recoveryMargin(_config.thresholdBytes)) {
+      _low = false;
+    } else {
+      return;
+    }
+    low = _low;
+  }
+  _onChange(low, stats);
+}
+
+void SpaceMonitor::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_closing) {
+    lock.unlock();
+    try {
+      evaluate(portable::statfs(_path));
+    } catch (const std::exception &) {
+      // The volume may be unmounted for a moment; try again next interval.
+    }
+    lock.lock();
+    _wake.wait_for(lock, std::chrono::milliseconds(_config.intervalMs),
+                   [this]() { return _closing; });
+  }
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,64 @@
+#pragma once
+#include "PortableFileSystem.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace margelo::nitro::node_fs {
+
+struct SpaceMonitorConfig {
+  uint64_t thresholdBytes = 0; // low below this many available bytes
+  uint32_t intervalMs = 30000;
+};
+
+/**
+ * Watches the free space of the volume holding `path`. A background thread
+ * runs statvfs every `intervalMs` and calls `onChange(true, stats)` when the
+ * available bytes drop below the threshold, and `onChange(false, stats)`
+ * once they are back above it by a margin (a tenth of the threshold, at
+ * most 64 MiB), so a volume hovering around the threshold does not flap. A
+ * volume that is already low when the monitor starts is reported right
+ * away. A check whose statvfs fails is skipped.
+ */
+class SpaceMonitor {
+public:
+  using Callback =
+      std::function<void(bool low, const portable::VolumeStats &stats)>;
+
+  SpaceMonitor(std::string path, const SpaceMonitorConfig &config,
+               Callback onChange);
+  ~SpaceMonitor();
+
+  SpaceMonitor(const SpaceMonitor &) = delete;
+  SpaceMonitor &operator=(const SpaceMonitor &) = delete;
+
+  // Evaluates now, on the calling thread (the callback may run on it too).
+  // Throws std::runtime_error if statvfs fails.
+  portable::VolumeStats check();
+
+  bool isLow() const;
+
+  // Stops the thread. Idempotent.
+  void close();
+
+private:
+  void run();
+  void evaluate(const portable::VolumeStats &stats);
+
+  std::string _path;
+  SpaceMonitorConfig _config;
+  Callback _onChange;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _wake;
+  bool _low = false;
+  bool _closing = false;
+  // Serializes evaluate() so transitions are reported in order.
+  std::mutex _evaluateMutex;
+  std::thread _thread;
+};
+
+} // namespace margelo::nitro::node_fs
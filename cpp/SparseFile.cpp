@@ -0,0 +1,119 @@
+#include "SparseFile.hpp"
+#include "FileIO.hpp"
+#include <stdexcept>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <linux/falloc.h>
+#endif
+
+namespace margelo::nitro::node_fs {
+
+void fallocateRange(int fd, uint64_t offset, uint64_t length, bool keepSize,
+                    bool punchHole) {
+  if (length == 0) {
+    return;
+  }
+  if (!fitsFileRange(offset, length)) {
+    throw std::runtime_error("fallocate failed (range too large)");
+  }
+#if defined(__linux__)
+  int mode = 0;
+  if (punchHole) {
+    mode = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+  } else if (keepSize) {
+    mode = FALLOC_FL_KEEP_SIZE;
+  }
+  int r;
+  do {
+    r = ::fallocate(fd, mode, static_cast<off_t>(offset),
+                    static_cast<off_t>(length));
+  } while (r != 0 && errno == EINTR);
+  if (r == 0) {
+    return;
+  }
+  if (errno == EOPNOTSUPP && mode == 0) {
+    // glibc emulates this by writing a byte per block.
+    if (::posix_fallocate(fd, static_cast<off_t>(offset),
+                          static_cast<off_t>(length)) == 0) {
+      return;
+    }
+  }
+  throw std::runtime_error(punchHole ? "fallocate failed (punch hole)"
+                                     : "fallocate failed");
+#elif defined(__APPLE__)
+  if (punchHole) {
+    fpunchhole_t hole = {};
+    hole.fp_offset = static_cast<off_t>(offset);
+    hole.fp_length = static_cast<off_t>(length);
+    if (::fcntl(fd, F_PUNCHHOLE, &hole) != 0) {
+      throw std::runtime_error("fallocate failed (punch hole)");
+    }
+    return;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    throw std::runtime_error("fallocate failed (stat)");
+  }
+  uint64_t end = offset + length;
+  // F_PREALLOCATE works on the blocks past the physical end of file; blocks
+  // already allocated below st_size are left alone.
+  uint64_t allocated = static_cast<uint64_t>(st.st_blocks) * 512;
+  if (end > allocated) {
+    fstore_t store = {};
+    store.fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL;
+    store.fst_posmode = F_PEOFPOSMODE;
+    store.fst_length = static_cast<off_t>(end - allocated);
+    if (::fcntl(fd, F_PREALLOCATE, &store) != 0) {
+      store.fst_flags = F_ALLOCATEALL; // fragmented is better than nothing
+      if (::fcntl(fd, F_PREALLOCATE, &store) != 0) {
+        throw std::runtime_error("fallocate failed");
+      }
+    }
+  }
+  if (!keepSize && end > static_cast<uint64_t>(st.st_size) &&
+      ::ftruncate(fd, static_cast<off_t>(end)) != 0) {
+    throw std::runtime_error("fallocate failed (truncate)");
+  }
+#else
+  if (punchHole || keepSize ||
+      ::posix_fallocate(fd, static_cast<off_t>(offset),
+                        static_cast<off_t>(length)) != 0) {
+    throw std::runtime_error("fallocate failed");
+  }
+#endif
+}
+
+static int64_t seekTo(int fd, uint64_t offset, bool data) {
+  if (!fitsFileRange(offset)) {
+    return -1; // past the end of any file
+  }
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  off_t r =
+      ::lseek(fd, static_cast<off_t>(offset), data ? SEEK_DATA : SEEK_HOLE);
+  if (r >= 0) {
+    return static_cast<int64_t>(r);
+  }
+  if (errno == ENXIO) {
+    return -1;
+  }
+  if (errno != EINVAL && errno != ENOTSUP) {
+    throw std::runtime_error(data ? "seekData failed" : "seekHole failed");
+  }
+#endif
+  // No hole tracking: one data region up to the end of file.
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    throw std::runtime_error(data ? "seekData failed" : "seekHole failed");
+  }
+  uint64_t size = static_cast<uint64_t>(st.st_size);
+  if (offset >= size) {
+    return data || offset > size ? -1 : static_cast<int64_t>(size);
+  }
+  return static_cast<int64_t>(data ? offset : size);
+}
+
+int64_t seekData(int fd, uint64_t offset) { return seekTo(fd, offset, true); }
+
+int64_t seekHole(int fd, uint64_t offset) { return seekTo(fd, offset, false); }
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * Reserves (or, with punchHole, deallocates) the byte range
+ * [offset, offset + length) of `fd`, so later writes into it cannot fail
+ * with ENOSPC and the file is laid out contiguously where the filesystem
+ * can. Without keepSize a range past the end grows the file; punchHole
+ * always keeps the size and reads back as zeros. Uses fallocate on Linux
+ * and Android and F_PREALLOCATE / F_PUNCHHOLE on Apple platforms. Throws
+ * std::runtime_error if the filesystem cannot do it.
+ */
+void fallocateRange(int fd, uint64_t offset, uint64_t length, bool keepSize,
+                    bool punchHole);
+
+// Start of the next data region at or after `offset`, or -1 if only holes
+// follow (lseek SEEK_DATA). Filesystems without hole tracking report the
+// whole file as data.
+int64_t seekData(int fd, uint64_t offset);
+
+// Start of the next hole at or after `offset`; the end of the file counts
+// as one. -1 if `offset` is past the end (lseek SEEK_HOLE).
+int64_t seekHole(int fd, uint64_t offset);
+
+} // namespace margelo::nitro::node_fs
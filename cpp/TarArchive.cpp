@@ -0,0 +1,955 @@
+#include "TarArchive.hpp"
+#include "FileCompression.hpp"
+#include "PathUtils.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fcntl.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+constexpr size_t kBlockSize = 512;
+constexpr size_t kPipeBufferSize = 1024 * 1024;
+constexpr uint64_t kMaxOctalSize = 077777777777ULL;
+// Pax headers and GNU long names are read into memory whole; real ones are
+// a few hundred bytes, so anything this large is a corrupt or hostile
+// archive.
+constexpr uint64_t kMaxMetadataSize = 1024 * 1024;
+
+size_t paddingFor(uint64_t size) {
+  return static_cast<size_t>((kBlockSize - size % kBlockSize) % kBlockSize);
+}
+
+bool writeAllAt(int fd, const uint8_t *data, size_t size, uint64_t offset) {
+  while (size > 0) {
+    RNIovec iov = {const_cast<uint8_t *>(data), size};
+    intptr_t written = rn_fs_writev(fd, &iov, 1, static_cast<int64_t>(offset));
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+  return true;
+}
+
+intptr_t readAt(int fd, uint8_t *data, size_t size, uint64_t offset) {
+  RNIovec iov = {data, size};
+  return rn_fs_readv(fd, &iov, 1, static_cast<int64_t>(offset));
+}
+
+// Thrown on the producer side once the consumer has stopped or failed.
+struct PipeClosed {};
+
+struct PipeBuffer {
+  std::unique_ptr<uint8_t[]> data;
+  size_t size = 0;
+};
+
+/**
+ * Two buffers handed back and forth between a producer and a consumer
+ * thread, so one side fills a buffer while the other drains the previous
+ * one. The first error reported by either side wins and stops both.
+ */
+class BufferPipe {
+public:
+  BufferPipe() {
+    for (auto &buffer : _buffers) {
+      buffer.data = std::make_unique<uint8_t[]>(kPipeBufferSize);
+      _free.push_back(&buffer);
+    }
+  }
+
+  // Producer: blocks until a buffer is free. Null once the pipe is closed.
+  PipeBuffer *acquire() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait(lock, [&] { return !_free.empty() || _error || _cancelled; });
+    if (_error || _cancelled) {
+      return nullptr;
+    }
+    PipeBuffer *buffer = _free.front();
+    _free.pop_front();
+    buffer->size = 0;
+    return buffer;
+  }
+
+  void submit(PipeBuffer *buffer) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _full.push_back(buffer);
+    }
+    _cv.notify_all();
+  }
+
+  void finish() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _finished = true;
+    }
+    _cv.notify_all();
+  }
+
+  // Consumer: blocks for the next full buffer. Null at the end of the stream
+  // or after a failure.
+  PipeBuffer *next() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait(lock, [&] { return !_full.empty() || _finished || _error; });
+    if (_error || _full.empty()) {
+      return nullptr;
+    }
+    PipeBuffer *buffer = _full.front();
+    _full.pop_front();
+    return buffer;
+  }
+
+  void release(PipeBuffer *buffer) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _free.push_back(buffer);
+    }
+    _cv.notify_all();
+  }
+
+  // Consumer is done; unblocks a producer that still has data.
+  void cancel() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cancelled = true;
+    }
+    _cv.notify_all();
+  }
+
+  void fail(std::exception_ptr error) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_error) {
+        _error = error;
+      }
+    }
+    _cv.notify_all();
+  }
+
+  std::exception_ptr error() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error;
+  }
+
+private:
+  PipeBuffer _buffers[2];
+  std::deque<PipeBuffer *> _free;
+  std::deque<PipeBuffer *> _full;
+  bool _finished = false;
+  bool _cancelled = false;
+  std::exception_ptr _error;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+};
+
+// Producer-side byte stream over a BufferPipe.
+class PipeWriter {
+public:
+  explicit PipeWriter(BufferPipe &pipe) : _pipe(pipe) {}
+  ~PipeWriter() {
+    if (_current) {
+      _pipe.release(_current);
+    }
+  }
+
+  // Writable tail of the current buffer, for reading straight into it.
+  std::pair<uint8_t *, size_t> space() {
+    if (!_current) {
+      _current = _pipe.acquire();
+      if (!_current) {
+        throw PipeClosed();
+      }
+    }
+    return {_current->data.get() + _current->size,
+            kPipeBufferSize - _current->size};
+  }
+
+  void commit(size_t size) {
+    _current->size += size;
+    if (_current->size == kPipeBufferSize) {
+      _pipe.submit(_current);
+      _current = nullptr;
+    }
+  }
+
+  void write(const uint8_t *data, size_t size) {
+    while (size > 0) {
+      auto [dest, available] = space();
+      size_t n = std::min(size, available);
+      std::memcpy(dest, data, n);
+      commit(n);
+      data += n;
+      size -= n;
+    }
+  }
+
+  void zeros(size_t size) {
+    while (size > 0) {
+      auto [dest, available] = space();
+      size_t n = std::min(size, available);
+      std::memset(dest, 0, n);
+      commit(n);
+      size -= n;
+    }
+  }
+
+  void flush() {
+    if (_current) {
+      if (_current->size > 0) {
+        _pipe.submit(_current);
+      } else {
+        _pipe.release(_current);
+      }
+      _current = nullptr;
+    }
+  }
+
+private:
+  BufferPipe &_pipe;
+  PipeBuffer *_current = nullptr;
+};
+
+// Consumer-side byte stream over a BufferPipe.
+class PipeReader {
+public:
+  explicit PipeReader(BufferPipe &pipe) : _pipe(pipe) {}
+  ~PipeReader() {
+    if (_current) {
+      _pipe.release(_current);
+    }
+  }
+
+  size_t read(uint8_t *dest, size_t size) {
+    size_t total = 0;
+    stream(size, [&](const uint8_t *data, size_t n) {
+      std::memcpy(dest + total, data, n);
+      total += n;
+    });
+    return total;
+  }
+
+  // Hands up to `size` bytes to `sink` in contiguous spans without copying.
+  // Returns the number of bytes delivered (less than `size` at the end).
+  template <typename Sink> uint64_t stream(uint64_t size, Sink &&sink) {
+    uint64_t delivered = 0;
+    while (delivered < size && fill()) {
+      size_t n = static_cast<size_t>(
+          std::min<uint64_t>(size - delivered, _current->size - _pos));
+      sink(_current->data.get() + _pos, n);
+      _pos += n;
+      delivered += n;
+    }
+    return delivered;
+  }
+
+  uint64_t skip(uint64_t size) {
+    return stream(size, [](const uint8_t *, size_t) {});
+  }
+
+private:
+  bool fill() {
+    while (!_current || _pos == _current->size) {
+      if (_current) {
+        _pipe.release(_current);
+      }
+      _current = _pipe.next();
+      _pos = 0;
+      if (!_current) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  BufferPipe &_pipe;
+  PipeBuffer *_current = nullptr;
+  size_t _pos = 0;
+};
+
+// Runs `produce` on a helper thread and `consume` on the calling thread.
+void runPipeline(BufferPipe &pipe, const std::function<void()> &produce,
+                 const std::function<void()> &consume) {
+  std::thread producer([&]() {
+    try {
+      produce();
+      pipe.finish();
+    } catch (const PipeClosed &) {
+      // The consumer stopped first; its outcome decides the result.
+    } catch (...) {
+      pipe.fail(std::current_exception());
+    }
+  });
+  try {
+    consume();
+  } catch (...) {
+    pipe.fail(std::current_exception());
+  }
+  pipe.cancel();
+  producer.join();
+  if (auto error = pipe.error()) {
+    std::rethrow_exception(error);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Headers
+
+void putString(uint8_t *field, size_t width, const std::string &value) {
+  std::memcpy(field, value.data(), std::min(width, value.size()));
+}
+
+void putOctal(uint8_t *field, size_t width, uint64_t value) {
+  // width - 1 digits followed by NUL; values that do not fit are stored as 0
+  // and carried in a pax record instead.
+  char digits[24];
+  int len = std::snprintf(digits, sizeof(digits), "%0*llo",
+                          static_cast<int>(width - 1),
+                          static_cast<unsigned long long>(value));
+  if (len == static_cast<int>(width - 1)) {
+    std::memcpy(field, digits, width - 1);
+  } else {
+    std::memset(field, '0', width - 1);
+  }
+  field[width - 1] = 0;
+}
+
+uint64_t parseNumeric(const uint8_t *field, size_t width) {
+  uint64_t value = 0;
+  if (field[0] & 0x80) { // GNU base-256
+    value = field[0] & 0x7F;
+    for (size_t i = 1; i < width; i++) {
+      value = (value << 8) | field[i];
+    }
+    return value;
+  }
+  size_t i = 0;
+  while (i < width && (field[i] == ' ' || field[i] == 0))
+    i++;
+  for (; i < width && field[i] >= '0' && field[i] <= '7'; i++) {
+    value = (value << 3) | static_cast<uint64_t>(field[i] - '0');
+  }
+  return value;
+}
+
+std::string parseString(const uint8_t *field, size_t width) {
+  const uint8_t *end = static_cast<const uint8_t *>(std::memchr(field, 0, width));
+  return std::string(reinterpret_cast<const char *>(field),
+                     end ? static_cast<size_t>(end - field) : width);
+}
+
+void computeChecksum(uint8_t *header) {
+  std::memset(header + 148, ' ', 8);
+  unsigned sum = 0;
+  for (size_t i = 0; i < kBlockSize; i++) {
+    sum += header[i];
+  }
+  std::snprintf(reinterpret_cast<char *>(header + 148), 8, "%06o", sum);
+  header[155] = ' ';
+}
+
+bool verifyChecksum(const uint8_t *header) {
+  uint64_t stored = parseNumeric(header + 148, 8);
+  unsigned unsignedSum = 0;
+  int signedSum = 0;
+  for (size_t i = 0; i < kBlockSize; i++) {
+    uint8_t byte = (i >= 148 && i < 156) ? ' ' : header[i];
+    unsignedSum += byte;
+    signedSum += static_cast<int8_t>(byte);
+  }
+  return stored == unsignedSum || static_cast<int64_t>(stored) == signedSum;
+}
+
+void addPaxRecord(std::string &out, const std::string &key,
+                  const std::string &value) {
+  // "<len> key=value\n", where <len> counts its own digits.
+  size_t body = key.size() + value.size() + 3;
+  size_t len = body + 1;
+  while (len != body + std::to_string(len).size()) {
+    len = body + std::to_string(len).size();
+  }
+  out += std::to_string(len) + " " + key + "=" + value + "\n";
+}
+
+struct HeaderFields {
+  std::string name;
+  char type = '0';
+  uint32_t mode = 0644;
+  uint32_t uid = 0;
+  uint32_t gid = 0;
+  uint64_t size = 0;
+  uint64_t mtime = 0;
+  std::string linkname;
+};
+
+void writeRawHeader(PipeWriter &out, const HeaderFields &fields) {
+  uint8_t header[kBlockSize] = {};
+  putString(header, 100, fields.name);
+  putOctal(header + 100, 8, fields.mode & 07777);
+  putOctal(header + 108, 8, fields.uid);
+  putOctal(header + 116, 8, fields.gid);
+  putOctal(header + 124, 12, fields.size);
+  putOctal(header + 136, 12, fields.mtime);
+  header[156] = static_cast<uint8_t>(fields.type);
+  putString(header + 157, 100, fields.linkname);
+  std::memcpy(header + 257, "ustar", 6);
+  std::memcpy(header + 263, "00", 2);
+  computeChecksum(header);
+  out.write(header, kBlockSize);
+}
+
+void writeHeader(PipeWriter &out, const HeaderFields &fields) {
+  std::string pax;
+  if (fields.name.size() > 100) {
+    addPaxRecord(pax, "path", fields.name);
+  }
+  if (fields.linkname.size() > 100) {
+    addPaxRecord(pax, "linkpath", fields.linkname);
+  }
+  if (fields.size > kMaxOctalSize) {
+    addPaxRecord(pax, "size", std::to_string(fields.size));
+  }
+  if (!pax.empty()) {
+    HeaderFields extended;
+    extended.name = "././@PaxHeader";
+    extended.type = 'x';
+    extended.size = pax.size();
+    extended.mtime = fields.mtime;
+    writeRawHeader(out, extended);
+    out.write(reinterpret_cast<const uint8_t *>(pax.data()), pax.size());
+    out.zeros(paddingFor(pax.size()));
+  }
+  writeRawHeader(out, fields);
+}
+
+// ---------------------------------------------------------------------------
+// Create
+
+class TarBuilder {
+public:
+  TarBuilder(PipeWriter &out, const std::string &root, const RNStats &skip)
+      : _out(out), _root(root), _skip(skip) {}
+
+  void addDirectory(const std::string &rel) {
+    std::string dir = rel.empty() ? _root : joinPath(_root, rel);
+    DirIter *iter = rn_fs_readdir_open(dir.c_str());
+    if (iter == nullptr) {
+      throw std::runtime_error("tarCreate failed (readdir): " + dir);
+    }
+    std::vector<std::string> names;
+    while (char *name = rn_fs_readdir_next(iter)) {
+      names.emplace_back(name);
+      rn_fs_free_string(name);
+    }
+    rn_fs_readdir_close(iter);
+    // Sorted for reproducible archives.
+    std::sort(names.begin(), names.end());
+
+    for (const auto &name : names) {
+      std::string childRel = rel.empty() ? name : rel + "/" + name;
+      std::string path = joinPath(_root, childRel);
+      RNStats st;
+      if (rn_fs_lstat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("tarCreate failed (lstat): " + path);
+      }
+      if (st.dev == _skip.dev && st.ino == _skip.ino) {
+        continue; // the archive itself
+      }
+
+      HeaderFields fields;
+      fields.name = childRel;
+      fields.mode = st.mode;
+      fields.uid = st.uid;
+      fields.gid = st.gid;
+      fields.mtime = static_cast<uint64_t>(std::max(0.0, st.mtime_ms / 1000.0));
+
+      switch (st.mode & S_IFMT) {
+      case S_IFDIR:
+        fields.name += "/";
+        fields.type = '5';
+        writeHeader(_out, fields);
+        addDirectory(childRel);
+        break;
+      case S_IFREG: {
+        if (st.nlink > 1) {
+          auto key = std::make_pair(st.dev, st.ino);
+          auto it = _links.find(key);
+          if (it != _links.end()) {
+            fields.type = '1';
+            fields.linkname = it->second;
+            writeHeader(_out, fields);
+            break;
+          }
+          _links.emplace(key, childRel);
+        }
+        fields.type = '0';
+        fields.size = st.size;
+        writeHeader(_out, fields);
+        addFileData(path, st.size);
+        break;
+      }
+      case S_IFLNK: {
+        char *target = rn_fs_readlink(path.c_str());
+        if (target == nullptr) {
+          throw std::runtime_error("tarCreate failed (readlink): " + path);
+        }
+        fields.type = '2';
+        fields.linkname = target;
+        rn_fs_free_string(target);
+        writeHeader(_out, fields);
+        break;
+      }
+      default:
+        break; // sockets, FIFOs and devices are not archived
+      }
+    }
+  }
+
+private:
+  void addFileData(const std::string &path, uint64_t size) {
+    int fd = rn_fs_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      throw std::runtime_error("tarCreate failed (open): " + path);
+    }
+    try {
+      uint64_t offset = 0;
+      while (offset < size) {
+        auto [dest, available] = _out.space();
+        size_t n = static_cast<size_t>(
+            std::min<uint64_t>(available, size - offset));
+        intptr_t r = readAt(fd, dest, n, offset);
+        if (r <= 0) {
+          throw std::runtime_error(
+              "tarCreate failed (file changed while archiving): " + path);
+        }
+        _out.commit(static_cast<size_t>(r));
+        offset += static_cast<uint64_t>(r);
+      }
+    } catch (...) {
+      rn_fs_close(fd);
+      throw;
+    }
+    rn_fs_close(fd);
+    _out.zeros(paddingFor(size));
+  }
+
+  PipeWriter &_out;
+  std::string _root;
+  RNStats _skip;
+  std::map<std::pair<uint64_t, uint64_t>, std::string> _links;
+};
+
+// ---------------------------------------------------------------------------
+// Extract
+
+struct PaxOverrides {
+  std::optional<std::string> path;
+  std::optional<std::string> linkpath;
+  std::optional<uint64_t> size;
+  std::optional<double> mtime;
+};
+
+void parsePaxRecords(const std::string &data, PaxOverrides &pax) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    size_t space = data.find(' ', pos);
+    if (space == std::string::npos)
+      break;
+    size_t len = std::strtoull(data.c_str() + pos, nullptr, 10);
+    if (len == 0 || pos + len > data.size())
+      break;
+    std::string record = data.substr(space + 1, pos + len - space - 2);
+    size_t eq = record.find('=');
+    if (eq != std::string::npos) {
+      std::string key = record.substr(0, eq);
+      std::string value = record.substr(eq + 1);
+      if (key == "path") {
+        pax.path = value;
+      } else if (key == "linkpath") {
+        pax.linkpath = value;
+      } else if (key == "size") {
+        pax.size = std::strtoull(value.c_str(), nullptr, 10);
+      } else if (key == "mtime") {
+        pax.mtime = std::strtod(value.c_str(), nullptr);
+      }
+    }
+    pos += len;
+  }
+}
+
+std::string normalizeEntryName(std::string name) {
+  while (name.compare(0, 2, "./") == 0) {
+    name.erase(0, 2);
+  }
+  while (!name.empty() && name.back() == '/') {
+    name.pop_back();
+  }
+  return name == "." ? std::string() : name;
+}
+
+class TarExtractor {
+public:
+  TarExtractor(PipeReader &in, const std::string &destDir)
+      : _in(in), _dest(destDir) {}
+
+  void run() {
+    ensureDirectory(_dest);
+    PaxOverrides pax;
+    uint8_t header[kBlockSize];
+    while (true) {
+      size_t n = _in.read(header, kBlockSize);
+      if (n == 0) {
+        break; // tolerate archives without end-of-archive blocks
+      }
+      if (n < kBlockSize) {
+        throw std::runtime_error("tarExtract failed (truncated archive)");
+      }
+      if (std::all_of(header, header + kBlockSize,
+                      [](uint8_t b) { return b == 0; })) {
+        break;
+      }
+      if (!verifyChecksum(header)) {
+        throw std::runtime_error("tarExtract failed (bad header checksum)");
+      }
+
+      char type = static_cast<char>(header[156]);
+      uint64_t size = parseNumeric(header + 124, 12);
+
+      if (type == 'x' || type == 'g' || type == 'L' || type == 'K') {
+        if (size > kMaxMetadataSize) {
+          throw std::runtime_error("tarExtract failed (oversized header)");
+        }
+        std::string data(static_cast<size_t>(size), '\0');
+        if (_in.read(reinterpret_cast<uint8_t *>(data.data()), data.size()) !=
+            data.size()) {
+          throw std::runtime_error("tarExtract failed (truncated archive)");
+        }
+        _in.skip(paddingFor(size));
+        if (type == 'x') {
+          parsePaxRecords(data, pax);
+        } else if (type == 'L') {
+          pax.path = data.substr(0, data.find('\0'));
+        } else if (type == 'K') {
+          pax.linkpath = data.substr(0, data.find('\0'));
+        }
+        continue;
+      }
+
+      std::string name = parseString(header, 100);
+      if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != 0) {
+        name = parseString(header + 345, 155) + "/" + name;
+      }
+      std::string linkname = parseString(header + 157, 100);
+      uint32_t mode = static_cast<uint32_t>(parseNumeric(header + 100, 8));
+      double mtime = static_cast<double>(parseNumeric(header + 136, 12));
+      if (pax.path)
+        name = *pax.path;
+      if (pax.linkpath)
+        linkname = *pax.linkpath;
+      if (pax.size)
+        size = *pax.size;
+      if (pax.mtime)
+        mtime = *pax.mtime;
+      pax = PaxOverrides();
+
+      uint64_t consumed = extractEntry(type, normalizeEntryName(name),
+                                       linkname, mode, mtime, size);
+      if (_in.skip(size - consumed) != size - consumed) {
+        throw std::runtime_error("tarExtract failed (truncated archive)");
+      }
+      _in.skip(paddingFor(size));
+    }
+    finish();
+  }
+
+private:
+  struct DeferredDir {
+    std::string path;
+    uint32_t mode;
+    double mtime;
+  };
+  struct DeferredLink {
+    std::string target;
+    std::string path;
+    double mtime;
+  };
+
+  // Returns how many bytes of the entry's data were consumed.
+  uint64_t extractEntry(char type, const std::string &name,
+                        const std::string &linkname, uint32_t mode,
+                        double mtime, uint64_t size) {
+    if (name.empty()) {
+      return 0;
+    }
+    if (!isSafeRelativePath(name)) {
+      throw std::runtime_error("tarExtract failed (unsafe entry name): " +
+                               name);
+    }
+    std::string path = joinPath(_dest, name);
+    switch (type) {
+    case '5':
+      ensureDirectory(path);
+      _dirs.push_back({path, mode, mtime});
+      return 0;
+    case '0':
+    case '\0':
+    case '7':
+      ensureDirectory(parentOf(path));
+      writeFile(path, mode, mtime, size);
+      return size;
+    case '1': {
+      std::string target = normalizeEntryName(linkname);
+      if (!isSafeRelativePath(target)) {
+        throw std::runtime_error("tarExtract failed (unsafe link target): " +
+                                 linkname);
+      }
+      ensureDirectory(parentOf(path));
+      _hardlinks.push_back({joinPath(_dest, target), path, mtime});
+      return 0;
+    }
+    case '2':
+      ensureDirectory(parentOf(path));
+      _symlinks.push_back({linkname, path, mtime});
+      return 0;
+    default:
+      return 0; // devices, FIFOs, vendor extensions: skipped
+    }
+  }
+
+  void ensureDirectory(const std::string &path) {
+    if (path.empty() || _created.count(path)) {
+      return;
+    }
+    if (!rn_fs_mkdir(path.c_str(), 0755, true)) {
+      throw std::runtime_error("tarExtract failed (mkdir): " + path);
+    }
+    _created.insert(path);
+  }
+
+  void writeFile(const std::string &path, uint32_t mode, double mtime,
+                 uint64_t size) {
+    // Replace rather than write through whatever is there (e.g. a symlink).
+    rn_fs_unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0600);
+    if (fd < 0) {
+      throw std::runtime_error("tarExtract failed (open): " + path);
+    }
+    rn_fs_import_fd(fd);
+    uint64_t offset = 0;
+    try {
+      uint64_t written =
+          _in.stream(size, [&](const uint8_t *data, size_t n) {
+            if (!writeAllAt(fd, data, n, offset)) {
+              throw std::runtime_error("tarExtract failed (write): " + path);
+            }
+            offset += n;
+          });
+      if (written != size) {
+        throw std::runtime_error("tarExtract failed (truncated archive)");
+      }
+    } catch (...) {
+      rn_fs_close(fd);
+      throw;
+    }
+    rn_fs_close(fd);
+    rn_fs_chmod(path.c_str(), static_cast<int>(mode & 0777));
+    rn_fs_utimes(path.c_str(), mtime, mtime);
+  }
+
+  void finish() {
+    // Links are created last so that no file of this archive is ever
+    // written through a symlink the archive itself planted.
+    for (const auto &link : _hardlinks) {
+      rn_fs_unlink(link.path.c_str());
+      if (rn_fs_link(link.target.c_str(), link.path.c_str()) != 0) {
+        throw std::runtime_error("tarExtract failed (link): " + link.path);
+      }
+    }
+    for (const auto &link : _symlinks) {
+      rn_fs_unlink(link.path.c_str());
+      if (rn_fs_symlink(link.target.c_str(), link.path.c_str()) != 0) {
+        throw std::runtime_error("tarExtract failed (symlink): " + link.path);
+      }
+      rn_fs_lutimes(link.path.c_str(), static_cast<int64_t>(link.mtime),
+                    static_cast<int64_t>(link.mtime));
+    }
+    // Deepest directories first: creating entries bumps the parent's mtime,
+    // and a read-only mode must not block the remaining fixups.
+    std::sort(_dirs.begin(), _dirs.end(),
+              [](const DeferredDir &a, const DeferredDir &b) {
+                return a.path.size() > b.path.size();
+              });
+    for (const auto &dir : _dirs) {
+      rn_fs_utimes(dir.path.c_str(), dir.mtime, dir.mtime);
+      rn_fs_chmod(dir.path.c_str(), static_cast<int>(dir.mode & 0777));
+    }
+  }
+
+  PipeReader &_in;
+  std::string _dest;
+  std::set<std::string> _created;
+  std::vector<DeferredDir> _dirs;
+  std::vector<DeferredLink> _hardlinks;
+  std::vector<DeferredLink> _symlinks;
+};
+
+} // namespace
+
+void tarCreate(const std::string &srcDir, const std::string &destFile,
+               const TarCreateConfig &config) {
+  RNStats srcStat;
+  if (rn_fs_stat(srcDir.c_str(), &srcStat) != 0 ||
+      (srcStat.mode & S_IFMT) != S_IFDIR) {
+    throw std::runtime_error("tarCreate failed (not a directory): " + srcDir);
+  }
+  int out = ::open(destFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0644);
+  if (out < 0) {
+    throw std::runtime_error("tarCreate failed (open): " + destFile);
+  }
+  rn_fs_import_fd(out);
+  RNStats destStat;
+  rn_fs_fstat(out, &destStat);
+
+  BufferPipe pipe;
+  try {
+    runPipeline(
+        pipe,
+        [&]() {
+          PipeWriter writer(pipe);
+          TarBuilder builder(writer, srcDir, destStat);
+          builder.addDirectory("");
+          writer.zeros(2 * kBlockSize);
+          writer.flush();
+        },
+        [&]() {
+          uint64_t offset = 0;
+          ChunkSink sink = [&](const uint8_t *data, size_t size) {
+            if (!writeAllAt(out, data, size, offset)) {
+              throw std::runtime_error("tarCreate failed (write): " +
+                                       destFile);
+            }
+            offset += size;
+          };
+          std::unique_ptr<Compressor> compressor;
+          if (config.gzip) {
+            compressor = std::make_unique<Compressor>(CompressionCodec::Gzip,
+                                                      config.level, sink);
+          }
+          while (PipeBuffer *buffer = pipe.next()) {
+            try {
+              if (compressor) {
+                compressor->write(buffer->data.get(), buffer->size);
+              } else {
+                sink(buffer->data.get(), buffer->size);
+              }
+            } catch (...) {
+              pipe.release(buffer);
+              throw;
+            }
+            pipe.release(buffer);
+          }
+          if (compressor && !pipe.error()) {
+            compressor->finish();
+          }
+        });
+  } catch (...) {
+    rn_fs_close(out);
+    rn_fs_unlink(destFile.c_str());
+    throw;
+  }
+  if (rn_fs_close(out) != 0) {
+    rn_fs_unlink(destFile.c_str());
+    throw std::runtime_error("tarCreate failed (close): " + destFile);
+  }
+}
+
+void tarExtract(const std::string &srcFile, const std::string &destDir) {
+  int in = rn_fs_open(srcFile.c_str(), O_RDONLY, 0);
+  if (in < 0) {
+    throw std::runtime_error("tarExtract failed (open): " + srcFile);
+  }
+
+  BufferPipe pipe;
+  try {
+    runPipeline(
+        pipe,
+        [&]() {
+          PipeWriter writer(pipe);
+          uint8_t magic[4] = {};
+          intptr_t magicLen = readAt(in, magic, sizeof(magic), 0);
+          bool compressed =
+              (magicLen >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) ||
+              (magicLen >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 &&
+               magic[2] == 0x2f && magic[3] == 0xfd);
+          uint64_t offset = 0;
+          if (!compressed) {
+            while (true) {
+              auto [dest, available] = writer.space();
+              intptr_t r = readAt(in, dest, available, offset);
+              if (r < 0) {
+                throw std::runtime_error("tarExtract failed (read): " +
+                                         srcFile);
+              }
+              if (r == 0) {
+                break;
+              }
+              writer.commit(static_cast<size_t>(r));
+              offset += static_cast<uint64_t>(r);
+            }
+          } else {
+            Decompressor decompressor([&](const uint8_t *data, size_t size) {
+              writer.write(data, size);
+            });
+            std::vector<uint8_t> chunk(kCompressionChunkSize);
+            while (true) {
+              intptr_t r = readAt(in, chunk.data(), chunk.size(), offset);
+              if (r < 0) {
+                throw std::runtime_error("tarExtract failed (read): " +
+                                         srcFile);
+              }
+              if (r == 0) {
+                break;
+              }
+              decompressor.write(chunk.data(), static_cast<size_t>(r));
+              offset += static_cast<uint64_t>(r);
+            }
+            decompressor.finish();
+          }
+          writer.flush();
+        },
+        [&]() {
+          PipeReader reader(pipe);
+          TarExtractor extractor(reader, destDir);
+          extractor.run();
+        });
+  } catch (...) {
+    rn_fs_close(in);
+    throw;
+  }
+  rn_fs_close(in);
+}
+
+} // namespace margelo::nitro::node_fs
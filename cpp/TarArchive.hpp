@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+
+namespace margelo::nitro::node_fs {
+
+struct TarCreateConfig {
+  bool gzip = false;
+  int level = -1; // zlib default
+};
+
+/**
+ * Streaming POSIX tar (ustar + pax) archiving.
+ *
+ * Both directions run as a two-stage pipeline over a pair of fixed-size
+ * buffers: one thread fills a buffer (reading source files, or reading and
+ * inflating the archive) while another drains the other one (compressing and
+ * writing the archive, or writing extracted files). No file is ever held in
+ * memory as a whole.
+ *
+ * Regular files, directories, symlinks and hard links are supported; modes
+ * and mtimes are stored and restored. Errors throw std::runtime_error.
+ */
+void tarCreate(const std::string &srcDir, const std::string &destFile,
+               const TarCreateConfig &config);
+
+// Extracts a plain, gzip (or, when built in, zstd) compressed tar below
+// `destDir`. Entries that would escape `destDir` make the call fail.
+void tarExtract(const std::string &srcFile, const std::string &destDir);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,193 @@
+#include "TreeDiff.hpp"
+#include "FileIO.hpp"
+#include "PathUtils.hpp"
+#include "WorkerPool.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+constexpr size_t kCompareChunkSize = 256 << 10;
+
+struct TreeEntry {
+  std::string path; // relative to the root
+  uint32_t type = 0; // S_IFMT bits
+  uint64_t size = 0;
+  double mtimeMs = 0;
+};
+
+void walkTree(const std::string &root, const std::string &rel,
+              std::vector<TreeEntry> &entries) {
+  std::string dir = rel.empty() ? root : joinPath(root, rel);
+  DirIter *iter = rn_fs_readdir_open(dir.c_str());
+  if (iter == nullptr) {
+    throw std::runtime_error("diffTrees failed (readdir): " + dir);
+  }
+  std::vector<std::string> names;
+  while (char *name = rn_fs_readdir_next(iter)) {
+    names.emplace_back(name);
+    rn_fs_free_string(name);
+  }
+  rn_fs_readdir_close(iter);
+
+  for (const auto &name : names) {
+    std::string childRel = rel.empty() ? name : rel + "/" + name;
+    RNStats st;
+    if (rn_fs_lstat(joinPath(root, childRel).c_str(), &st) != 0) {
+      continue; // removed while walking
+    }
+    uint32_t type = st.mode & S_IFMT;
+    entries.push_back({childRel, type, st.size, st.mtime_ms});
+    if (type == S_IFDIR) {
+      walkTree(root, childRel, entries);
+    }
+  }
+}
+
+std::vector<TreeEntry> listTree(const std::string &root) {
+  RNStats st;
+  if (rn_fs_stat(root.c_str(), &st) != 0) {
+    throw std::runtime_error("diffTrees failed (stat): " + root);
+  }
+  if ((st.mode & S_IFMT) != S_IFDIR) {
+    throw std::runtime_error("diffTrees failed (not a directory): " + root);
+  }
+  std::vector<TreeEntry> entries;
+  walkTree(root, "", entries);
+  std::sort(entries.begin(), entries.end(),
+            [](const TreeEntry &x, const TreeEntry &y) { return x.path < y.path; });
+  return entries;
+}
+
+std::string linkTarget(const std::string &path) {
+  char *target = rn_fs_readlink(path.c_str());
+  if (target == nullptr) {
+    throw std::runtime_error("diffTrees failed (readlink): " + path);
+  }
+  std::string result(target);
+  rn_fs_free_string(target);
+  return result;
+}
+
+} // namespace
+
+bool filesEqual(const std::string &a, const std::string &b) {
+  RNStats stA;
+  RNStats stB;
+  if (rn_fs_stat(a.c_str(), &stA) != 0) {
+    throw std::runtime_error("compareFiles failed (stat): " + a);
+  }
+  if (rn_fs_stat(b.c_str(), &stB) != 0) {
+    throw std::runtime_error("compareFiles failed (stat): " + b);
+  }
+  if ((stA.mode & S_IFMT) != S_IFREG) {
+    throw std::runtime_error("compareFiles failed (not a file): " + a);
+  }
+  if ((stB.mode & S_IFMT) != S_IFREG) {
+    throw std::runtime_error("compareFiles failed (not a file): " + b);
+  }
+  if (stA.dev == stB.dev && stA.ino == stB.ino) {
+    return true;
+  }
+  if (stA.size != stB.size) {
+    return false;
+  }
+
+  UniqueFd fdA = openForRead(a.c_str());
+  if (!fdA) {
+    throw std::runtime_error("compareFiles failed (open): " + a);
+  }
+  UniqueFd fdB = openForRead(b.c_str());
+  if (!fdB) {
+    throw std::runtime_error("compareFiles failed (open): " + b);
+  }
+  std::vector<uint8_t> bufA(kCompareChunkSize);
+  std::vector<uint8_t> bufB(kCompareChunkSize);
+  while (true) {
+    ssize_t nA = readFully(fdA.get(), bufA.data(), bufA.size());
+    if (nA < 0) {
+      throw std::runtime_error("compareFiles failed (read): " + a);
+    }
+    ssize_t nB = readFully(fdB.get(), bufB.data(), bufB.size());
+    if (nB < 0) {
+      throw std::runtime_error("compareFiles failed (read): " + b);
+    }
+    // Lengths can still differ if a file changed after the stat.
+    if (nA != nB ||
+        std::memcmp(bufA.data(), bufB.data(), static_cast<size_t>(nA)) != 0) {
+      return false;
+    }
+    if (static_cast<size_t>(nA) < bufA.size()) {
+      return true;
+    }
+  }
+}
+
+TreeDiffSummary diffTrees(const std::string &a, const std::string &b,
+                          const TreeDiffConfig &config) {
+  std::vector<TreeEntry> trees[2];
+  const std::string *roots[2] = {&a, &b};
+  parallelFor(2, config.parallelism, [&](size_t i) {
+    trees[i] = listTree(*roots[i]);
+  });
+  const auto &left = trees[0];
+  const auto &right = trees[1];
+
+  TreeDiffSummary summary;
+  // Pairs of same-sized files (or symlinks) whose contents decide.
+  std::vector<std::pair<const TreeEntry *, const TreeEntry *>> candidates;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < left.size() || j < right.size()) {
+    if (j == right.size() || (i < left.size() && left[i].path < right[j].path)) {
+      summary.removed.push_back(left[i++].path);
+      continue;
+    }
+    if (i == left.size() || right[j].path < left[i].path) {
+      summary.added.push_back(right[j++].path);
+      continue;
+    }
+    const TreeEntry &x = left[i++];
+    const TreeEntry &y = right[j++];
+    if (x.type != y.type) {
+      summary.changed.push_back(x.path);
+    } else if (x.type == S_IFDIR) {
+      continue;
+    } else if (x.size != y.size) {
+      summary.changed.push_back(x.path);
+    } else if (config.compare == TreeCompare::Mtime) {
+      if (x.mtimeMs != y.mtimeMs) {
+        summary.changed.push_back(x.path);
+      }
+    } else if (config.compare == TreeCompare::Content &&
+               (x.type == S_IFREG || x.type == S_IFLNK)) {
+      candidates.emplace_back(&x, &y);
+    }
+  }
+
+  if (!candidates.empty()) {
+    std::vector<uint8_t> differs(candidates.size(), 0);
+    parallelFor(candidates.size(), config.parallelism, [&](size_t k) {
+      std::string pathA = joinPath(a, candidates[k].first->path);
+      std::string pathB = joinPath(b, candidates[k].second->path);
+      bool equal = candidates[k].first->type == S_IFLNK
+                       ? linkTarget(pathA) == linkTarget(pathB)
+                       : filesEqual(pathA, pathB);
+      differs[k] = equal ? 0 : 1;
+    });
+    for (size_t k = 0; k < candidates.size(); k++) {
+      if (differs[k]) {
+        summary.changed.push_back(candidates[k].first->path);
+      }
+    }
+    std::sort(summary.changed.begin(), summary.changed.end());
+  }
+  return summary;
+}
+
+} // namespace margelo::nitro::node_fs
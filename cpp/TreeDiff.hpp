@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * True if `a` and `b` have the same contents. The same inode or different
+ * sizes decide without reading; otherwise both files are streamed in chunks
+ * and compared with memcmp, stopping at the first difference. Throws
+ * std::runtime_error if either path is missing or not a regular file.
+ */
+bool filesEqual(const std::string &a, const std::string &b);
+
+enum class TreeCompare {
+  Mtime,   // size and modification time, like rsync's quick check
+  Size,    // size only
+  Content, // size, then the bytes of same-sized files
+};
+
+struct TreeDiffConfig {
+  TreeCompare compare = TreeCompare::Mtime;
+  size_t parallelism = 0; // 0 = worker pool size
+};
+
+// '/'-separated paths relative to the compared roots, sorted.
+struct TreeDiffSummary {
+  std::vector<std::string> added;   // only under b
+  std::vector<std::string> removed; // only under a
+  std::vector<std::string> changed; // under both, but different
+};
+
+/**
+ * Compares the trees under directories `a` and `b`. Both are walked on the
+ * worker pool without following symlinks. Every entry below an added or
+ * removed directory is listed too. A path whose type differs is changed;
+ * directories are otherwise never changed, and symlinks compare their
+ * targets in Content mode. Content comparisons run in parallel.
+ */
+TreeDiffSummary diffTrees(const std::string &a, const std::string &b,
+                          const TreeDiffConfig &config);
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,147 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+/**
+ * Process-wide pool of worker threads for CPU/I-O fan-out inside a single
+ * native call (parallel extraction, tree walks, hashing, ...).
+ *
+ * Promise-returning methods still run their body through Promise::async;
+ * this pool is only used to split that body across cores.
+ */
+class WorkerPool {
+public:
+  static WorkerPool &shared() {
+    // Intentionally leaked: worker threads must outlive static destructors.
+    static WorkerPool *pool = new WorkerPool(
+        std::max<size_t>(2, std::thread::hardware_concurrency()));
+    return *pool;
+  }
+
+  size_t size() const { return _threads.size(); }
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _tasks.push(std::move(task));
+    }
+    _cv.notify_one();
+  }
+
+private:
+  explicit WorkerPool(size_t threads) {
+    for (size_t i = 0; i < threads; i++) {
+      _threads.emplace_back([this]() {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return !_tasks.empty(); });
+            task = std::move(_tasks.front());
+            _tasks.pop();
+          }
+          task();
+        }
+      });
+      _threads.back().detach();
+    }
+  }
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::queue<std::function<void()>> _tasks;
+};
+
+/**
+ * Runs fn(0..count-1) on up to `parallelism` threads and waits for all of
+ * them. The calling thread takes part in the work, so nested use cannot
+ * deadlock even when every pool thread is busy. The first exception thrown
+ * by `fn` stops further indices from being started and is rethrown here.
+ */
+inline void parallelFor(size_t count, size_t parallelism,
+                        const std::function<void(size_t)> &fn) {
+  if (count == 0) {
+    return;
+  }
+  if (parallelism == 0) {
+    parallelism = WorkerPool::shared().size();
+  }
+  parallelism = std::min(parallelism, count);
+  if (parallelism <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  struct State {
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    size_t active = 0;
+    bool closed = false;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+  auto state = std::make_shared<State>();
+
+  auto work = [state, count, &fn]() {
+    while (!state->failed.load(std::memory_order_relaxed)) {
+      size_t i = state->next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= count) {
+        break;
+      }
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->error) {
+          state->error = std::current_exception();
+        }
+        state->failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  for (size_t t = 1; t < parallelism; t++) {
+    WorkerPool::shared().submit([state, work]() {
+      {
+        // Helpers that only get scheduled after the caller has finished all
+        // indices must not touch `fn`, whose frame may already be gone.
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->closed) {
+          return;
+        }
+        state->active++;
+      }
+      work();
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (--state->active == 0) {
+        state->done.notify_all();
+      }
+    });
+  }
+
+  work();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->closed = true;
+  state->done.wait(lock, [&] { return state->active == 0; });
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+} // namespace margelo::nitro::node_fs
@@ -0,0 +1,369 @@
+#include "ZipReader.hpp"
+#include "FileCompression.hpp"
+#include "PathUtils.hpp"
+#include "WorkerPool.hpp"
+#include "rust_c_file_system.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <zlib.h>
+
+namespace margelo::nitro::node_fs {
+
+namespace {
+
+constexpr uint32_t kEocdSignature = 0x06054b50;
+constexpr uint32_t kZip64LocatorSignature = 0x07064b50;
+constexpr uint32_t kZip64EocdSignature = 0x06064b50;
+constexpr uint32_t kCentralSignature = 0x02014b50;
+constexpr uint32_t kLocalSignature = 0x04034b50;
+constexpr size_t kEocdSize = 22;
+constexpr size_t kCentralHeaderSize = 46;
+constexpr size_t kLocalHeaderSize = 30;
+constexpr size_t kMaxCommentSize = 0xFFFF;
+
+uint16_t le16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+uint32_t le32(const uint8_t *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+uint64_t le64(const uint8_t *p) {
+  return static_cast<uint64_t>(le32(p)) |
+         (static_cast<uint64_t>(le32(p + 4)) << 32);
+}
+
+// MS-DOS timestamps are stored in local time.
+double dosTimeToMs(uint16_t time, uint16_t date) {
+  struct tm t = {};
+  t.tm_year = ((date >> 9) & 0x7F) + 80;
+  t.tm_mon = ((date >> 5) & 0x0F) - 1;
+  t.tm_mday = date & 0x1F;
+  t.tm_hour = (time >> 11) & 0x1F;
+  t.tm_min = (time >> 5) & 0x3F;
+  t.tm_sec = (time & 0x1F) * 2;
+  t.tm_isdst = -1;
+  time_t secs = mktime(&t);
+  return secs < 0 ? 0 : static_cast<double>(secs) * 1000.0;
+}
+
+} // namespace
+
+ZipReader::ZipReader(const std::string &path) : _path(path) {
+  _fd = openForRead(path.c_str());
+  if (!_fd) {
+    throw std::runtime_error("openZip failed: " + path);
+  }
+  struct stat st;
+  if (::fstat(_fd.get(), &st) != 0) {
+    throw std::runtime_error("openZip failed (stat): " + path);
+  }
+  _fileSize = static_cast<uint64_t>(st.st_size);
+  readCentralDirectory();
+}
+
+void ZipReader::readCentralDirectory() {
+  if (_fileSize < kEocdSize) {
+    throw std::runtime_error("openZip failed (not a zip archive): " + _path);
+  }
+
+  // The end-of-central-directory record sits in the last 22 + comment bytes.
+  size_t tailSize = static_cast<size_t>(
+      std::min<uint64_t>(_fileSize, kEocdSize + kMaxCommentSize));
+  std::vector<uint8_t> tail(tailSize);
+  uint64_t tailOffset = _fileSize - tailSize;
+  if (preadFully(_fd.get(), tail.data(), tailSize, tailOffset) !=
+      static_cast<ssize_t>(tailSize)) {
+    throw std::runtime_error("openZip failed (read): " + _path);
+  }
+  ssize_t eocd = -1;
+  for (ssize_t i = static_cast<ssize_t>(tailSize - kEocdSize); i >= 0; i--) {
+    if (le32(&tail[i]) == kEocdSignature) {
+      eocd = i;
+      break;
+    }
+  }
+  if (eocd < 0) {
+    throw std::runtime_error("openZip failed (not a zip archive): " + _path);
+  }
+
+  const uint8_t *e = &tail[eocd];
+  uint64_t entryCount = le16(e + 10);
+  uint64_t cdSize = le32(e + 12);
+  uint64_t cdOffset = le32(e + 16);
+
+  // ZIP64: the classic record is saturated and a locator precedes it.
+  if (entryCount == 0xFFFF || cdSize == 0xFFFFFFFF || cdOffset == 0xFFFFFFFF) {
+    uint64_t locatorOffset = tailOffset + eocd - 20;
+    uint8_t locator[20];
+    if (tailOffset + eocd < 20 ||
+        preadFully(_fd.get(), locator, sizeof(locator), locatorOffset) != 20 ||
+        le32(locator) != kZip64LocatorSignature) {
+      throw std::runtime_error("openZip failed (bad zip64 locator): " + _path);
+    }
+    uint8_t record[56];
+    if (preadFully(_fd.get(), record, sizeof(record), le64(locator + 8)) != 56 ||
+        le32(record) != kZip64EocdSignature) {
+      throw std::runtime_error("openZip failed (bad zip64 record): " + _path);
+    }
+    entryCount = le64(record + 32);
+    cdSize = le64(record + 40);
+    cdOffset = le64(record + 48);
+  }
+
+  if (cdOffset + cdSize > _fileSize) {
+    throw std::runtime_error("openZip failed (corrupt central directory): " +
+                             _path);
+  }
+
+  std::vector<uint8_t> cd(static_cast<size_t>(cdSize));
+  if (preadFully(_fd.get(), cd.data(), cd.size(), cdOffset) !=
+      static_cast<ssize_t>(cd.size())) {
+    throw std::runtime_error("openZip failed (read): " + _path);
+  }
+
+  _entries.reserve(static_cast<size_t>(entryCount));
+  _index.reserve(static_cast<size_t>(entryCount));
+
+  size_t pos = 0;
+  while (pos + kCentralHeaderSize <= cd.size()) {
+    const uint8_t *h = &cd[pos];
+    if (le32(h) != kCentralSignature) {
+      break;
+    }
+    uint16_t madeBy = le16(h + 4);
+    uint16_t nameLen = le16(h + 28);
+    uint16_t extraLen = le16(h + 30);
+    uint16_t commentLen = le16(h + 32);
+    if (pos + kCentralHeaderSize + nameLen + extraLen + commentLen > cd.size()) {
+      throw std::runtime_error("openZip failed (corrupt central directory): " +
+                               _path);
+    }
+
+    ZipEntryInfo entry;
+    entry.flags = le16(h + 8);
+    entry.method = le16(h + 10);
+    entry.mtimeMs = dosTimeToMs(le16(h + 12), le16(h + 14));
+    entry.crc32 = le32(h + 16);
+    entry.compressedSize = le32(h + 20);
+    entry.uncompressedSize = le32(h + 24);
+    entry.localHeaderOffset = le32(h + 42);
+    entry.name.assign(reinterpret_cast<const char *>(h + kCentralHeaderSize),
+                      nameLen);
+    if ((madeBy >> 8) == 3) { // Unix
+      entry.unixMode = le32(h + 38) >> 16;
+    }
+    entry.isDirectory = !entry.name.empty() && entry.name.back() == '/';
+
+    // ZIP64 extended information replaces saturated 32-bit fields, in order.
+    const uint8_t *extra = h + kCentralHeaderSize + nameLen;
+    size_t x = 0;
+    while (x + 4 <= extraLen) {
+      uint16_t id = le16(extra + x);
+      uint16_t size = le16(extra + x + 2);
+      if (x + 4 + size > extraLen)
+        break;
+      if (id == 0x0001) {
+        const uint8_t *f = extra + x + 4;
+        const uint8_t *end = f + size;
+        if (entry.uncompressedSize == 0xFFFFFFFF && f + 8 <= end) {
+          entry.uncompressedSize = le64(f);
+          f += 8;
+        }
+        if (entry.compressedSize == 0xFFFFFFFF && f + 8 <= end) {
+          entry.compressedSize = le64(f);
+          f += 8;
+        }
+        if (entry.localHeaderOffset == 0xFFFFFFFF && f + 8 <= end) {
+          entry.localHeaderOffset = le64(f);
+        }
+      }
+      x += 4 + size;
+    }
+
+    _index.emplace(entry.name, _entries.size());
+    _entries.push_back(std::move(entry));
+    pos += kCentralHeaderSize + nameLen + extraLen + commentLen;
+  }
+}
+
+const ZipEntryInfo *ZipReader::find(const std::string &name) const {
+  auto it = _index.find(name);
+  if (it == _index.end()) {
+    return nullptr;
+  }
+  return &_entries[it->second];
+}
+
+uint64_t ZipReader::dataOffset(const ZipEntryInfo &entry) const {
+  uint8_t header[kLocalHeaderSize];
+  if (preadFully(_fd.get(), header, sizeof(header), entry.localHeaderOffset) !=
+          static_cast<ssize_t>(sizeof(header)) ||
+      le32(header) != kLocalSignature) {
+    throw std::runtime_error("zip: bad local header for " + entry.name);
+  }
+  // The local name/extra lengths may differ from the central directory.
+  uint64_t offset = entry.localHeaderOffset + kLocalHeaderSize +
+                    le16(header + 26) + le16(header + 28);
+  if (offset + entry.compressedSize > _fileSize) {
+    throw std::runtime_error("zip: truncated entry " + entry.name);
+  }
+  return offset;
+}
+
+template <typename Sink>
+void ZipReader::decode(const ZipEntryInfo &entry, Sink &&sink) const {
+  if (entry.flags & 0x1) {
+    throw std::runtime_error("zip: encrypted entries are not supported: " +
+                             entry.name);
+  }
+  if (entry.method != 0 && entry.method != 8) {
+    throw std::runtime_error("zip: unsupported compression method " +
+                             std::to_string(entry.method) + " for " +
+                             entry.name);
+  }
+
+  uint64_t offset = dataOffset(entry);
+  uint64_t produced = 0;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  auto emit = [&](const uint8_t *data, size_t size) {
+    if (produced + size > entry.uncompressedSize) {
+      throw std::runtime_error("zip: entry larger than declared: " +
+                               entry.name);
+    }
+    crc = crc32(crc, data, static_cast<uInt>(size));
+    produced += size;
+    sink(data, size);
+  };
+
+  std::vector<uint8_t> chunk(static_cast<size_t>(
+      std::min<uint64_t>(kCompressionChunkSize, std::max<uint64_t>(entry.compressedSize, 1))));
+  uint64_t remaining = entry.compressedSize;
+
+  if (entry.method == 0) {
+    while (remaining > 0) {
+      size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+      if (preadFully(_fd.get(), chunk.data(), n, offset) !=
+          static_cast<ssize_t>(n)) {
+        throw std::runtime_error("zip: read failed for " + entry.name);
+      }
+      emit(chunk.data(), n);
+      offset += n;
+      remaining -= n;
+    }
+  } else {
+    Decompressor inflater(emit, CompressionCodec::RawDeflate);
+    while (remaining > 0 && !inflater.done()) {
+      size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+      if (preadFully(_fd.get(), chunk.data(), n, offset) !=
+          static_cast<ssize_t>(n)) {
+        throw std::runtime_error("zip: read failed for " + entry.name);
+      }
+      inflater.write(chunk.data(), n);
+      offset += n;
+      remaining -= n;
+    }
+    inflater.finish();
+  }
+
+  if (produced != entry.uncompressedSize ||
+      static_cast<uint32_t>(crc) != entry.crc32) {
+    throw std::runtime_error("zip: checksum mismatch for " + entry.name);
+  }
+}
+
+size_t ZipReader::readSize(const ZipEntryInfo &entry, uint64_t maxSize) {
+  if (entry.uncompressedSize > maxSize ||
+      entry.uncompressedSize > std::numeric_limits<size_t>::max()) {
+    throw std::runtime_error("zip: entry too large to read into memory: " +
+                             entry.name);
+  }
+  return static_cast<size_t>(entry.uncompressedSize);
+}
+
+void ZipReader::readInto(const ZipEntryInfo &entry, uint8_t *dest,
+                         size_t capacity) const {
+  if (entry.uncompressedSize > capacity) {
+    throw std::runtime_error("zip: buffer too small for " + entry.name);
+  }
+  size_t written = 0;
+  decode(entry, [&](const uint8_t *data, size_t size) {
+    // decode() already bounds the total by the declared size; this also
+    // holds if a caller's buffer is smaller than that.
+    if (size > capacity - written) {
+      throw std::runtime_error("zip: entry larger than declared: " +
+                               entry.name);
+    }
+    std::memcpy(dest + written, data, size);
+    written += size;
+  });
+}
+
+void ZipReader::extractTo(const ZipEntryInfo &entry,
+                          const std::string &destPath) const {
+  mode_t mode = (entry.unixMode & 0777) ? (entry.unixMode & 0777) : 0644;
+  UniqueFd out = openForWrite(destPath.c_str(), mode);
+  if (!out) {
+    throw std::runtime_error("zip: cannot create " + destPath);
+  }
+  try {
+    int fd = out.get();
+    decode(entry, [fd, &destPath](const uint8_t *data, size_t size) {
+      if (!writeFully(fd, data, size)) {
+        throw std::runtime_error("zip: write failed for " + destPath);
+      }
+    });
+  } catch (...) {
+    out.reset();
+    rn_fs_unlink(destPath.c_str());
+    throw;
+  }
+  out.reset();
+  if (entry.mtimeMs > 0) {
+    double secs = entry.mtimeMs / 1000.0;
+    rn_fs_utimes(destPath.c_str(), secs, secs);
+  }
+}
+
+void ZipReader::extractAll(const std::string &destDir,
+                           size_t parallelism) const {
+  // Validate every name and create the directory skeleton up front so the
+  // parallel phase only writes files.
+  std::set<std::string> directories = {destDir};
+  std::vector<const ZipEntryInfo *> files;
+  files.reserve(_entries.size());
+  for (const auto &entry : _entries) {
+    if (!isSafeRelativePath(entry.name)) {
+      throw std::runtime_error("zip: refusing to extract unsafe entry name: " +
+                               entry.name);
+    }
+    std::string target = joinPath(destDir, entry.name);
+    if (entry.isDirectory) {
+      target.pop_back();
+      directories.insert(target);
+    } else {
+      directories.insert(parentOf(target));
+      files.push_back(&entry);
+    }
+  }
+  for (const auto &dir : directories) {
+    if (!dir.empty() && !rn_fs_mkdir(dir.c_str(), 0755, true)) {
+      throw std::runtime_error("zip: cannot create directory " + dir);
+    }
+  }
+
+  // Largest entries first keeps the tail of the parallel phase short.
+  std::sort(files.begin(), files.end(),
+            [](const ZipEntryInfo *a, const ZipEntryInfo *b) {
+              return a->uncompressedSize > b->uncompressedSize;
+            });
+  parallelFor(files.size(), parallelism, [&](size_t i) {
+    extractTo(*files[i], joinPath(destDir, files[i]->name));
+  });
+}
+
+} // namespace margelo::nitro::node_fs
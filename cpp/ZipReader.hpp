@@ -0,0 +1,68 @@
+#pragma once
+#include "FileIO.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace margelo::nitro::node_fs {
+
+struct ZipEntryInfo {
+  std::string name;
+  uint64_t compressedSize = 0;
+  uint64_t uncompressedSize = 0;
+  uint64_t localHeaderOffset = 0;
+  uint32_t crc32 = 0;
+  uint16_t method = 0;
+  uint16_t flags = 0;
+  uint32_t unixMode = 0; // 0 when the archive carries no Unix permissions
+  double mtimeMs = 0;
+  bool isDirectory = false;
+};
+
+/**
+ * Random-access reader for zip archives (including ZIP64).
+ *
+ * The central directory is read with a single pread when the archive is
+ * opened and indexed by name, so lookups are O(1) regardless of the entry
+ * count. Entry data is only read (and inflated) on demand. All read methods
+ * use positional I/O and may be called concurrently.
+ */
+class ZipReader {
+public:
+  explicit ZipReader(const std::string &path);
+
+  const std::vector<ZipEntryInfo> &entries() const { return _entries; }
+  const ZipEntryInfo *find(const std::string &name) const;
+
+  // Largest entry read into memory by default. Sizes come from the archive
+  // and are untrusted, so they are checked before anything is allocated.
+  static constexpr uint64_t kDefaultMaxReadSize = 1ull << 30;
+
+  // Buffer size needed to read `entry`; throws std::runtime_error if its
+  // declared size exceeds `maxSize` or does not fit in size_t.
+  static size_t readSize(const ZipEntryInfo &entry,
+                         uint64_t maxSize = kDefaultMaxReadSize);
+  // Decodes the entry into `dest` (`capacity` bytes). Throws if the data
+  // would not fit or does not match the declared size and CRC.
+  void readInto(const ZipEntryInfo &entry, uint8_t *dest,
+                size_t capacity) const;
+  void extractTo(const ZipEntryInfo &entry, const std::string &destPath) const;
+  // Extracts every entry below `destDir`. Entries whose names would escape
+  // `destDir` (absolute paths, "..") are rejected.
+  void extractAll(const std::string &destDir, size_t parallelism) const;
+
+private:
+  void readCentralDirectory();
+  uint64_t dataOffset(const ZipEntryInfo &entry) const;
+  template <typename Sink>
+  void decode(const ZipEntryInfo &entry, Sink &&sink) const;
+
+  std::string _path;
+  UniqueFd _fd;
+  uint64_t _fileSize = 0;
+  std::vector<ZipEntryInfo> _entries;
+  std::unordered_map<std::string, size_t> _index;
+};
+
+} // namespace margelo::nitro::node_fs
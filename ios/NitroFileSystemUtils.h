@@ -78,5 +78,10 @@ void stopAccessingBookmark(void *token);
 std::string getDirectoryPathIOS(const std::string& type);
 std::unordered_map<std::string, std::string> getFileProtectionKeysIOS();
 
+/**
+ * Calls `onWarning` on every UIApplicationDidReceiveMemoryWarningNotification.
+ */
+void observeMemoryWarningsIOS(std::function<void()> onWarning);
+
 } // namespace fs
 } // namespace nitro
@@ -603,6 +603,16 @@ std::unordered_map<std::string, std::string> getFileProtectionKeysIOS() {
     };
 }
 
+void observeMemoryWarningsIOS(std::function<void()> onWarning) {
+    [[NSNotificationCenter defaultCenter]
+        addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                    object:nil
+                     queue:nil
+                usingBlock:^(NSNotification *note) {
+                    onWarning();
+                }];
+}
+
 } // namespace fs
 
 } // namespace nitro
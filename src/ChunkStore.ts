@@ -0,0 +1,52 @@
+import { NitroFileSystem } from './native';
+import type { ChunkStoreOptions, StoreFileResult, ChunkStoreGcResult } from './specs/HybridFileSystem.nitro';
+
+export { ChunkStoreOptions, StoreFileResult, ChunkStoreGcResult };
+
+/**
+ * Deduplicating, content-addressed store of files under a root directory.
+ * Files are split into content-defined chunks (FastCDC), so versions of a
+ * file that differ by a few edits share almost all of their chunks. Each
+ * chunk is stored once, named by its SHA-256; every stored file is a small
+ * manifest listing its chunks. All work runs natively on worker threads.
+ */
+export class ChunkStore {
+    constructor(public root: string) {}
+
+    /**
+     * Store the contents of `path` under `name`, replacing a previous file of
+     * that name. Only chunks the store does not have yet are written.
+     */
+    storeFile(path: string, name: string, options?: ChunkStoreOptions): Promise<StoreFileResult> {
+        return NitroFileSystem.storeFile(this.root, path, name, options);
+    }
+
+    /**
+     * Write the file stored as `name` to `dest`. Every chunk is checked
+     * against its hash; `dest` is only replaced once the whole file is intact.
+     */
+    restoreFile(name: string, dest: string): Promise<void> {
+        return NitroFileSystem.restoreFile(this.root, name, dest);
+    }
+
+    /**
+     * Forget `name`. Its chunks are freed by the next `gc()` unless another
+     * stored file uses them. Resolves to false if there was no such file.
+     */
+    delete(name: string): Promise<boolean> {
+        return NitroFileSystem.removeStoredFile(this.root, name);
+    }
+
+    list(): Promise<string[]> {
+        return NitroFileSystem.listStoredFiles(this.root);
+    }
+
+    /**
+     * Delete every chunk no stored file references. Waits for stores already
+     * running in this process; do not run it while another process uses the
+     * same root.
+     */
+    gc(): Promise<ChunkStoreGcResult> {
+        return NitroFileSystem.gcChunkStore(this.root);
+    }
+}
@@ -0,0 +1,76 @@
+import { EventEmitter } from 'events';
+import { Buffer } from 'react-native-nitro-buffer';
+import { NitroFileSystem } from './native';
+import type { HybridFileTail } from './specs/HybridFileTail.nitro';
+import type { TailBatch } from './specs/HybridFileSystem.nitro';
+
+export interface TailOptions {
+    /** Start at the current end of the file (default true), like `tail -f`. */
+    fromEnd?: boolean;
+    /**
+     * 'utf8' (default) emits 'lines' with complete lines, without their
+     * "\n" / "\r\n"; 'buffer' emits 'data' with the raw appended bytes.
+     */
+    encoding?: 'utf8' | 'buffer';
+    /** Fallback check interval when the watcher reports nothing (default 1000). */
+    pollIntervalMs?: number;
+    /** Upper bound of one batch (default 1 MiB). */
+    maxBatchBytes?: number;
+}
+
+/**
+ * Follows a growing file, like `tail -F`. A native thread waits for watcher
+ * events on the file's directory and reads only the bytes appended since the
+ * last offset, delivering them in batches:
+ *
+ * - 'lines' (lines: string[]) or 'data' (chunk: Buffer), per `encoding`
+ * - 'truncate' before the first batch after the file shrank (reading
+ *   restarts at offset 0)
+ * - 'rotate' before the first batch of a new file at the path (after the
+ *   rest of the old file was delivered)
+ * - 'close'
+ */
+export class FileTail extends EventEmitter {
+    private _tail: HybridFileTail | null = null;
+
+    constructor(public path: string, options?: TailOptions) {
+        super();
+        const lines = (options?.encoding ?? 'utf8') !== 'buffer';
+        this._tail = NitroFileSystem.tail(path, (batch) => this._onBatch(batch), {
+            fromEnd: options?.fromEnd,
+            lines,
+            pollIntervalMs: options?.pollIntervalMs,
+            maxBatchBytes: options?.maxBatchBytes,
+        });
+    }
+
+    /** Offset in the current file up to which bytes have been read. */
+    get offset(): number {
+        return this._tail?.offset ?? 0;
+    }
+
+    get closed(): boolean {
+        return this._tail === null;
+    }
+
+    /** Stop following. Batches already queued for the JS thread are dropped. */
+    close(): this {
+        if (this._tail) {
+            this._tail.close();
+            this._tail = null;
+            this.emit('close');
+        }
+        return this;
+    }
+
+    private _onBatch(batch: TailBatch): void {
+        if (!this._tail) return;
+        if (batch.reset === 'truncated') this.emit('truncate');
+        else if (batch.reset === 'rotated') this.emit('rotate');
+        if (batch.lines && batch.lines.length > 0) {
+            this.emit('lines', batch.lines);
+        } else if (batch.data && batch.data.byteLength > 0) {
+            this.emit('data', Buffer.from(batch.data));
+        }
+    }
+}
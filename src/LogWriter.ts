@@ -0,0 +1,59 @@
+import { NitroFileSystem } from './native';
+import { Buffer } from 'react-native-nitro-buffer';
+import type { HybridLogWriter } from './specs/HybridLogWriter.nitro';
+import type { LogWriterOptions } from './specs/HybridFileSystem.nitro';
+
+export { LogWriterOptions };
+
+/**
+ * Append-only log file writer.
+ * Appends are buffered natively and flushed by a background thread when
+ * `flushBytes` are pending or every `flushIntervalMs`. The file is rotated to
+ * `path.1`, `path.2`, ... once it exceeds `maxFileSize`.
+ */
+export class LogWriter {
+    private _writer: HybridLogWriter;
+    private _closed = false;
+
+    constructor(public path: string, options?: LogWriterOptions) {
+        this._writer = NitroFileSystem.createLogWriter(path, options);
+    }
+
+    /**
+     * Queue raw data. Strings are written as UTF-8.
+     */
+    append(data: string | Buffer | Uint8Array): void {
+        if (typeof data === 'string') {
+            this._writer.append(data);
+            return;
+        }
+        const buf = data instanceof Buffer ? data : Buffer.from(data);
+        this._writer.appendBuffer(buf.buffer.slice(buf.byteOffset, buf.byteOffset + buf.byteLength) as ArrayBuffer);
+    }
+
+    /**
+     * Queue a line, terminated by '\n'.
+     */
+    appendLine(line: string): void {
+        this._writer.append(line + '\n');
+    }
+
+    /**
+     * Resolves once everything appended so far has been written to the file.
+     */
+    flush(): Promise<void> {
+        return this._writer.flush();
+    }
+
+    /**
+     * Flush pending data and close the file. Further appends throw.
+     */
+    close(): Promise<void> {
+        this._closed = true;
+        return this._writer.close();
+    }
+
+    get closed(): boolean {
+        return this._closed;
+    }
+}
@@ -105,8 +105,8 @@ export class ReadStream extends Readable {
             return;
         }
 
-        // Allocate buffer
-        const buffer = Buffer.allocUnsafe(toRead);
+        // Pooled native slab; recycled once the consumer drops the chunk
+        const buffer = Buffer.from(NitroFileSystem.leaseBuffer(toRead));
 
         try {
             // We use the sync read from native for now, wrapped in simple async structure of Readable
@@ -0,0 +1,53 @@
+import { EventEmitter } from 'events';
+import { NitroFileSystem } from './native';
+import type { HybridSpaceMonitor } from './specs/HybridSpaceMonitor.nitro';
+import type { SpaceMonitorOptions, StatFs } from './specs/HybridFileSystem.nitro';
+
+/**
+ * Watches the free space of one volume from a native thread, so a low disk
+ * is noticed before writes start failing with ENOSPC. Events are
+ * edge-triggered:
+ *
+ * - 'low' (stats) when the available bytes drop below the threshold,
+ *   including right after creation if the volume is already low
+ * - 'ok' (stats) once they are back above it by a margin (a tenth of the
+ *   threshold, at most 64 MiB)
+ * - 'close'
+ */
+export class SpaceMonitor extends EventEmitter {
+    private _monitor: HybridSpaceMonitor | null = null;
+
+    constructor(public path: string, public thresholdBytes: number, options?: SpaceMonitorOptions) {
+        super();
+        this._monitor = NitroFileSystem.monitorSpace(path, thresholdBytes, (low, stats) => this._onChange(low, stats), options);
+    }
+
+    /** Whether the last check found the volume low. */
+    get low(): boolean {
+        return this._monitor?.low ?? false;
+    }
+
+    get closed(): boolean {
+        return this._monitor === null;
+    }
+
+    /** Check now instead of waiting for the next interval. */
+    check(): StatFs {
+        if (!this._monitor) throw new Error('SpaceMonitor is closed');
+        return this._monitor.check();
+    }
+
+    close(): this {
+        if (this._monitor) {
+            this._monitor.close();
+            this._monitor = null;
+            this.emit('close');
+        }
+        return this;
+    }
+
+    private _onChange(low: boolean, stats: StatFs): void {
+        if (!this._monitor) return;
+        this.emit(low ? 'low' : 'ok', stats);
+    }
+}
@@ -0,0 +1,75 @@
+import { NitroFileSystem } from './native';
+import { Buffer } from 'react-native-nitro-buffer';
+import { PathLike, normalizePath } from './index';
+import type { HybridZipArchive, ZipEntry, ZipExtractOptions } from './specs/HybridZipArchive.nitro';
+
+export { ZipEntry, ZipExtractOptions };
+
+/**
+ * Read-only view of a zip archive.
+ * The central directory is indexed when the archive is opened, so entry
+ * lookups do not scan the file. Entry data is read and inflated natively on
+ * demand; `extractAll` spreads the work over a native thread pool.
+ */
+export class ZipArchive {
+    private _archive: HybridZipArchive;
+
+    constructor(public path: string) {
+        this._archive = NitroFileSystem.openZip(path);
+    }
+
+    get entryCount(): number {
+        return this._archive.entryCount;
+    }
+
+    entries(): ZipEntry[] {
+        return this._archive.entries();
+    }
+
+    getEntry(name: string): ZipEntry | undefined {
+        return this._archive.getEntry(name);
+    }
+
+    has(name: string): boolean {
+        return this._archive.has(name);
+    }
+
+    /**
+     * Read an entry synchronously on the calling thread.
+     */
+    readSync(name: string, encoding?: BufferEncoding): Buffer | string {
+        const buffer = Buffer.from(this._archive.read(name));
+        return encoding ? buffer.toString(encoding) : buffer;
+    }
+
+    /**
+     * Read an entry on a background thread.
+     */
+    async read(name: string, encoding?: BufferEncoding): Promise<Buffer | string> {
+        const buffer = Buffer.from(await this._archive.readAsync(name));
+        return encoding ? buffer.toString(encoding) : buffer;
+    }
+
+    /**
+     * Write a single entry to `dest`.
+     */
+    extract(name: string, dest: PathLike): Promise<void> {
+        return this._archive.extract(name, normalizePath(dest));
+    }
+
+    /**
+     * Extract every entry below `dest`. Entries that would escape `dest`
+     * (absolute names or `..` segments) make the whole call fail before
+     * anything is written.
+     */
+    extractAll(dest: PathLike, options?: ZipExtractOptions): Promise<void> {
+        return this._archive.extractAll(normalizePath(dest), options);
+    }
+
+    /**
+     * Release the archive. Operations already in flight still complete.
+     */
+    close(): void {
+        this._archive.close();
+    }
+}
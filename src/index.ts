@@ -1,8 +1,8 @@
-import { NitroFileSystem } from './native'
-import type { Stats as NitroStats, FilePickerOptions, DirectoryPickerOptions, PickedFile, PickedDirectory } from './specs/HybridFileSystem.nitro'
+import { NitroFileSystem, NitroJson } from './native'
+import type { Stats as NitroStats, FilePickerOptions, DirectoryPickerOptions, PickedFile, PickedDirectory, CompressOptions, CompressionFormat, TarCreateOptions, OpMetrics, TraceOptions, BatchOpType, BatchOptions, BatchResult, StatManyOptions, ReadRange, ReadRangesOptions, ReadRangesResult as NitroReadRangesResult, BufferPoolStats, DeltaStats, SearchOptions, SearchMatch, SearchResult, TreeCompareMode, TreeDiffOptions, TreeDiffResult, LineIndexOptions, LineIndexResult, DiskUsageOptions, DiskUsageResult, DiskUsageChild, StatFs as NitroStatFs, SpaceMonitorOptions, FallocateOptions, FileAdviceType, PrefetchOptions, PrefetchResult } from './specs/HybridFileSystem.nitro'
 import { Buffer } from 'react-native-nitro-buffer'
 
-export { FilePickerOptions, DirectoryPickerOptions, PickedFile, PickedDirectory }
+export { FilePickerOptions, DirectoryPickerOptions, PickedFile, PickedDirectory, CompressOptions, CompressionFormat, TarCreateOptions, OpMetrics, TraceOptions, BatchOpType, BatchOptions, StatManyOptions, ReadRange, ReadRangesOptions, BufferPoolStats, DeltaStats, SearchOptions, SearchMatch, SearchResult, TreeCompareMode, TreeDiffOptions, TreeDiffResult, LineIndexOptions, LineIndexResult, DiskUsageOptions, DiskUsageResult, DiskUsageChild, SpaceMonitorOptions, FallocateOptions, FileAdviceType, PrefetchOptions, PrefetchResult }
 
 // --- Constants ---
 export const constants = {
@@ -38,6 +38,9 @@ export const constants = {
     R_OK: 4,
     W_OK: 2,
     X_OK: 1,
+    COPYFILE_EXCL: 1,
+    COPYFILE_FICLONE: 2,
+    COPYFILE_FICLONE_FORCE: 4,
 };
 export const FileProtectionKeys = NitroFileSystem.fileProtectionKeys;
 
@@ -62,6 +65,7 @@ type ReadCallback = (err: Error | null, bytesRead?: number, buffer?: Buffer) =>
 type WriteCallback = (err: Error | null, bytesWritten?: number, buffer?: Buffer) => void;
 type WriteStringCallback = (err: Error | null, bytesWritten?: number, str?: string) => void;
 type StatsCallback = (err: Error | null, stats?: Stats | BigIntStats) => void;
+type StatFsCallback = (err: Error | null, stats?: StatFs | BigIntStatFs) => void;
 type ReaddirCallback = (err: Error | null, files?: string[]) => void;
 type MkdtempCallback = (err: Error | null, folder?: string) => void;
 type ReadvCallback = (err: Error | null, bytesRead?: number, buffers?: ArrayBufferView[]) => void;
@@ -87,6 +91,8 @@ export interface CpOptions {
     errorOnExist?: boolean;
     dereference?: boolean;
     preserveTimestamps?: boolean;
+    // COPYFILE_* flags for the file copies
+    mode?: number;
 }
 
 export interface RmdirOptions {
@@ -260,6 +266,47 @@ export class BigIntStats {
     }
 }
 
+// --- StatFs Classes ---
+export class StatFs {
+    type: number;
+    bsize: number;
+    blocks: number;
+    bfree: number;
+    bavail: number;
+    files: number;
+    ffree: number;
+
+    constructor(stats: NitroStatFs) {
+        this.type = stats.type;
+        this.bsize = stats.bsize;
+        this.blocks = stats.blocks;
+        this.bfree = stats.bfree;
+        this.bavail = stats.bavail;
+        this.files = stats.files;
+        this.ffree = stats.ffree;
+    }
+}
+
+export class BigIntStatFs {
+    type: bigint;
+    bsize: bigint;
+    blocks: bigint;
+    bfree: bigint;
+    bavail: bigint;
+    files: bigint;
+    ffree: bigint;
+
+    constructor(stats: NitroStatFs) {
+        this.type = BigInt(stats.type);
+        this.bsize = BigInt(stats.bsize);
+        this.blocks = BigInt(stats.blocks);
+        this.bfree = BigInt(stats.bfree);
+        this.bavail = BigInt(stats.bavail);
+        this.files = BigInt(stats.files);
+        this.ffree = BigInt(stats.ffree);
+    }
+}
+
 // --- Helper Functions ---
 export function getFlags(flag: string | number | undefined): number {
     if (typeof flag === 'number') return flag;
@@ -713,6 +760,44 @@ export function fstat(fd: number, optionsOrCallback: StatOptions | StatsCallback
     });
 }
 
+// Free space of the volume holding `path` (statvfs).
+export function statfsSync(path: PathLike, options?: StatOptions): StatFs | BigIntStatFs {
+    const normalizedPath = normalizePath(path);
+    try {
+        const stats = NitroFileSystem.statfs(normalizedPath);
+        if (options?.bigint) {
+            return new BigIntStatFs(stats);
+        }
+        return new StatFs(stats);
+    } catch (e) {
+        throw new Error(`ENOENT: no such file or directory, statfs '${normalizedPath}'`);
+    }
+}
+
+export function statfs(path: PathLike, callback: StatFsCallback): void;
+export function statfs(path: PathLike, options: StatOptions, callback: StatFsCallback): void;
+export function statfs(path: PathLike, optionsOrCallback: StatOptions | StatFsCallback, callback?: StatFsCallback): void {
+    let options: StatOptions | undefined;
+    let cb: StatFsCallback;
+
+    if (typeof optionsOrCallback === 'function') {
+        cb = optionsOrCallback;
+    } else {
+        options = optionsOrCallback;
+        cb = callback!;
+    }
+
+    const normalizedPath = normalizePath(path);
+    setImmediate(() => {
+        try {
+            const res = statfsSync(normalizedPath, options);
+            cb(null, res);
+        } catch (e: any) {
+            cb(e);
+        }
+    });
+}
+
 export function mkdirSync(path: PathLike, options?: { recursive?: boolean; mode?: number } | number): string | undefined {
     let mode = 0o777;
     let recursive = false;
@@ -873,7 +958,8 @@ export function cpSync(src: PathLike, dest: PathLike, options?: CpOptions): void
     const dereference = options?.dereference || false;
     const errorOnExist = options?.errorOnExist || false;
     const preserveTimestamps = options?.preserveTimestamps || false;
-    NitroFileSystem.cp(normalizedSrc, normalizedDest, recursive, force, dereference, errorOnExist, preserveTimestamps);
+    const mode = options?.mode || 0;
+    NitroFileSystem.cp(normalizedSrc, normalizedDest, recursive, force, dereference, errorOnExist, preserveTimestamps, mode);
 }
 
 export function cp(src: PathLike, dest: PathLike, options?: CpOptions | Callback, callback?: Callback): void {
@@ -960,6 +1046,39 @@ export function ftruncate(fd: number, len: number | Callback, callback?: Callbac
     });
 }
 
+// Reserve disk blocks for [offset, offset + length) so later writes there
+// cannot fail with ENOSPC; `punchHole` deallocates the range instead.
+export function fallocateSync(fd: number, offset: number, length: number, options?: FallocateOptions): void {
+    NitroFileSystem.fallocate(fd, offset, length, options);
+}
+
+export function fallocate(fd: number, offset: number, length: number, options: FallocateOptions | Callback, callback?: Callback): void {
+    if (typeof options === 'function') {
+        callback = options;
+        options = {};
+    }
+    const o = options as FallocateOptions;
+    setImmediate(() => {
+        try {
+            fallocateSync(fd, offset, length, o);
+            callback?.(null);
+        } catch (e: any) {
+            callback?.(e);
+        }
+    });
+}
+
+// Start of the next data region at or after `offset` (SEEK_DATA), or -1.
+export function seekData(fd: number, offset: number = 0): number {
+    return NitroFileSystem.seekData(fd, offset);
+}
+
+// Start of the next hole at or after `offset` (SEEK_HOLE); the end of the
+// file counts as a hole. -1 past the end.
+export function seekHole(fd: number, offset: number = 0): number {
+    return NitroFileSystem.seekHole(fd, offset);
+}
+
 export function fsyncSync(fd: number): void {
     NitroFileSystem.fsync(fd);
 }
@@ -1263,31 +1382,24 @@ export function rm(path: PathLike, options?: RmOptions | Callback, callback?: Ca
 
 // --- Vector I/O (readv/writev) ---
 
-export function readvSync(fd: number, buffers: ArrayBufferView[], position?: number | null): number {
-    const pos = position === null || position === undefined ? -1 : position;
-
-    // Convert ArrayBufferViews to ArrayBuffers for native call
-    const arrayBuffers: ArrayBuffer[] = buffers.map(buf => {
-        if (buf instanceof Buffer) {
-            return buf.buffer.slice(buf.byteOffset, buf.byteOffset + buf.byteLength) as ArrayBuffer;
-        }
-        return buf.buffer.slice(buf.byteOffset, buf.byteOffset + buf.byteLength) as ArrayBuffer;
-    });
-
-    const totalRead = NitroFileSystem.readv(fd, arrayBuffers, pos);
-
-    // Copy data back to original buffers (native writes to sliced copies)
-    let offset = 0;
-    for (let i = 0; i < buffers.length && offset < totalRead; i++) {
-        const buf = buffers[i];
-        const src = new Uint8Array(arrayBuffers[i]);
-        const dst = buf instanceof Buffer ? buf : new Uint8Array(buf.buffer, buf.byteOffset, buf.byteLength);
-        const copyLen = Math.min(dst.length, totalRead - offset);
-        (dst as Uint8Array).set(src.subarray(0, copyLen));
-        offset += copyLen;
+// Passes each view as (backing ArrayBuffer, byteOffset, byteLength) so native
+// code reads into / writes from the caller's memory directly.
+function toNativeIovecs(buffers: ArrayBufferView[]): [ArrayBuffer[], number[], number[]] {
+    const arrayBuffers: ArrayBuffer[] = new Array(buffers.length);
+    const offsets: number[] = new Array(buffers.length);
+    const lengths: number[] = new Array(buffers.length);
+    for (let i = 0; i < buffers.length; i++) {
+        arrayBuffers[i] = buffers[i].buffer as ArrayBuffer;
+        offsets[i] = buffers[i].byteOffset;
+        lengths[i] = buffers[i].byteLength;
     }
+    return [arrayBuffers, offsets, lengths];
+}
 
-    return totalRead;
+export function readvSync(fd: number, buffers: ArrayBufferView[], position?: number | null): number {
+    const pos = position === null || position === undefined ? -1 : position;
+    const [arrayBuffers, offsets, lengths] = toNativeIovecs(buffers);
+    return NitroFileSystem.readv(fd, arrayBuffers, offsets, lengths, pos);
 }
 
 export function readv(fd: number, buffers: ArrayBufferView[], callback: ReadvCallback): void;
@@ -1316,16 +1428,8 @@ export function readv(fd: number, buffers: ArrayBufferView[], positionOrCallback
 
 export function writevSync(fd: number, buffers: ArrayBufferView[], position?: number | null): number {
     const pos = position === null || position === undefined ? -1 : position;
-
-    // Convert ArrayBufferViews to ArrayBuffers for native call
-    const arrayBuffers: ArrayBuffer[] = buffers.map(buf => {
-        if (buf instanceof Buffer) {
-            return buf.buffer.slice(buf.byteOffset, buf.byteOffset + buf.byteLength) as ArrayBuffer;
-        }
-        return buf.buffer.slice(buf.byteOffset, buf.byteOffset + buf.byteLength) as ArrayBuffer;
-    });
-
-    return NitroFileSystem.writev(fd, arrayBuffers, pos);
+    const [arrayBuffers, offsets, lengths] = toNativeIovecs(buffers);
+    return NitroFileSystem.writev(fd, arrayBuffers, offsets, lengths, pos);
 }
 
 export function writev(fd: number, buffers: ArrayBufferView[], callback: WritevCallback): void;
@@ -1510,15 +1614,532 @@ export function writeFileSync(path: PathLike, data: string | Buffer | Uint8Array
     NitroFileSystem.writeFile(normalizedPath, buffer.buffer);
 }
 
+// --- Atomic Writes ---
+
+export type Durability = 'none' | 'data' | 'full';
+
+export interface WriteFileAtomicOptions {
+    encoding?: BufferEncoding;
+    /**
+     * 'none': temp file + rename only, 'data': fsync contents before the rename,
+     * 'full' (default): also fsync the parent directory so the rename survives power loss.
+     */
+    durability?: Durability;
+}
+
+export interface AtomicWriteEntry {
+    path: PathLike;
+    data: string | Buffer | Uint8Array;
+    encoding?: BufferEncoding;
+}
+
+function toArrayBuffer(data: string | Buffer | Uint8Array, encoding?: BufferEncoding): ArrayBuffer {
+    const buffer = typeof data === 'string' ? Buffer.from(data, encoding || 'utf8') :
+        (data instanceof Buffer ? data : Buffer.from(data));
+    if (buffer.byteOffset === 0 && buffer.byteLength === buffer.buffer.byteLength) {
+        return buffer.buffer as ArrayBuffer;
+    }
+    return buffer.buffer.slice(buffer.byteOffset, buffer.byteOffset + buffer.byteLength) as ArrayBuffer;
+}
+
+/**
+ * Replaces the file contents atomically: data is written to a temp file next to `path`,
+ * synced according to `durability` and renamed over the target in a single native call.
+ */
+export function writeFileAtomicSync(path: PathLike, data: string | Buffer | Uint8Array, options?: WriteFileAtomicOptions | BufferEncoding): void {
+    const opts: WriteFileAtomicOptions = typeof options === 'string' ? { encoding: options } : (options ?? {});
+    NitroFileSystem.writeFileAtomic(normalizePath(path), toArrayBuffer(data, opts.encoding), { durability: opts.durability });
+}
+
+export function writeFileAtomic(path: PathLike, data: string | Buffer | Uint8Array, options?: WriteFileAtomicOptions | BufferEncoding | Callback, callback?: Callback): void {
+    if (typeof options === 'function') {
+        callback = options;
+        options = undefined;
+    }
+    setImmediate(() => {
+        try {
+            writeFileAtomicSync(path, data, options as WriteFileAtomicOptions | BufferEncoding | undefined);
+            callback?.(null);
+        } catch (e: any) {
+            callback?.(e);
+        }
+    });
+}
+
+/**
+ * Atomically replaces many files at once (group commit). All files share the
+ * durability barriers, so saving N documents costs one directory sync per
+ * distinct parent directory instead of N.
+ */
+export function writeFilesAtomicSync(entries: AtomicWriteEntry[], options?: { durability?: Durability }): void {
+    const nativeEntries = entries.map(entry => ({
+        path: normalizePath(entry.path),
+        data: toArrayBuffer(entry.data, entry.encoding),
+    }));
+    NitroFileSystem.writeFilesAtomic(nativeEntries, { durability: options?.durability });
+}
+
+export function writeFilesAtomic(entries: AtomicWriteEntry[], options?: { durability?: Durability } | Callback, callback?: Callback): void {
+    if (typeof options === 'function') {
+        callback = options;
+        options = undefined;
+    }
+    setImmediate(() => {
+        try {
+            writeFilesAtomicSync(entries, options as { durability?: Durability } | undefined);
+            callback?.(null);
+        } catch (e: any) {
+            callback?.(e);
+        }
+    });
+}
+
+// --- JSON files ---
+
+/**
+ * Read and parse a JSON file. The file is read and parsed natively on a worker
+ * thread; the JS thread only builds the resulting objects, without the
+ * intermediate ArrayBuffer, string decode or `JSON.parse`. Throws on invalid
+ * JSON or UTF-8, naming the byte offset.
+ */
+export async function readJSON<T = any>(path: PathLike): Promise<T> {
+    const document = await NitroJson.parseJSONFile(normalizePath(path));
+    return document.toValue() as T;
+}
+
+export interface WriteJSONOptions {
+    /** As in `writeFileAtomic`; default 'full'. */
+    durability?: Durability;
+}
+
+/**
+ * Serialize `value` as `JSON.stringify` would (compact) and write it atomically
+ * to `path`. Serialization walks the value natively on the JS thread into a
+ * native buffer, so no JS string of the whole document is built; the write
+ * happens on a worker thread.
+ */
+export async function writeJSON(path: PathLike, value: unknown, options?: WriteJSONOptions): Promise<void> {
+    return NitroJson.writeJSON(normalizePath(path), value, options);
+}
+
+// --- Line index ---
+
+function lineIndexOptions(options?: LineIndexOptions): LineIndexOptions | undefined {
+    if (options?.indexPath === undefined) return options;
+    return { ...options, indexPath: normalizePath(options.indexPath) };
+}
+
+/**
+ * Index the line starts of the text file at `path`: one newline-counting pass
+ * (SIMD) that keeps the byte offset of every `stride`-th line. The index is
+ * cached natively per path and, with `indexPath`, saved to a sidecar file so a
+ * later session can reuse it. When the file has only grown (a log), just the
+ * appended bytes are scanned; if it shrank or was replaced, it is rebuilt.
+ */
+export async function buildLineIndex(path: PathLike, options?: LineIndexOptions): Promise<LineIndexResult> {
+    return NitroFileSystem.buildLineIndex(normalizePath(path), lineIndexOptions(options));
+}
+
+/**
+ * Read up to `count` lines starting at 0-based line `startLine`, without their
+ * "\n" / "\r\n" terminators. Builds or extends the index as `buildLineIndex`
+ * does, then reads only the span between the surrounding index offsets with a
+ * single `pread`. Pass the same options as to `buildLineIndex`.
+ */
+export async function readLines(path: PathLike, startLine: number, count: number, options?: LineIndexOptions): Promise<string[]> {
+    return NitroFileSystem.readLines(normalizePath(path), startLine, count, lineIndexOptions(options));
+}
+
+// --- Compression ---
+
+/**
+ * Compress `src` into `dest` on a native worker thread, streaming fixed-size chunks
+ * through zlib (or zstd when bundled). Defaults to gzip.
+ */
+export async function compressFile(src: PathLike, dest: PathLike, options?: CompressOptions): Promise<void> {
+    return NitroFileSystem.compressFile(normalizePath(src), normalizePath(dest), options);
+}
+
+/**
+ * Decompress a gzip, zlib or zstd file into `dest`. The format is detected from the file header.
+ */
+export async function decompressFile(src: PathLike, dest: PathLike): Promise<void> {
+    return NitroFileSystem.decompressFile(normalizePath(src), normalizePath(dest));
+}
+
+// --- Tar archives ---
+
+/**
+ * Pack the contents of `srcDir` into a tar archive at `destFile`, optionally gzip-compressed.
+ * Files are streamed natively; modes, mtimes, symlinks and hard links are preserved.
+ */
+export async function tarCreate(srcDir: PathLike, destFile: PathLike, options?: TarCreateOptions): Promise<void> {
+    return NitroFileSystem.tarCreate(normalizePath(srcDir), normalizePath(destFile), options);
+}
+
+/**
+ * Unpack a tar archive (plain or gzip-compressed) into `destDir`.
+ */
+export async function tarExtract(srcFile: PathLike, destDir: PathLike): Promise<void> {
+    return NitroFileSystem.tarExtract(normalizePath(srcFile), normalizePath(destDir));
+}
+
+// --- Delta sync ---
+
+/**
+ * Compute the rsync-style signature of `path`: a rolling checksum and a strong
+ * hash per `blockSize`-byte block (default about sqrt of the file size). Send it
+ * to the side holding the new version so it can run `fileDelta`. The file is
+ * streamed natively; only the signature (roughly 20 bytes per block) reaches JS.
+ */
+export async function fileSignature(path: PathLike, blockSize?: number): Promise<Buffer> {
+    return Buffer.from(await NitroFileSystem.fileSignature(normalizePath(path), blockSize));
+}
+
+/**
+ * Write a patch to `patchPath` that turns the file described by `signature`
+ * into `path`. Unchanged blocks become references, even where they moved;
+ * everything else is carried literally. Resolves to the patch statistics.
+ */
+export async function fileDelta(path: PathLike, signature: ArrayBuffer | Uint8Array, patchPath: PathLike): Promise<DeltaStats> {
+    const buffer = signature instanceof ArrayBuffer ? signature : toArrayBuffer(signature);
+    return NitroFileSystem.fileDelta(normalizePath(path), buffer, normalizePath(patchPath));
+}
+
+/**
+ * Rebuild the new file from `base` and a `fileDelta` patch into `dest`, which may
+ * be `base` itself: the result is written to a temp file and renamed into place
+ * only after its SHA-256 matches the one recorded in the patch.
+ */
+export async function applyPatch(base: PathLike, patch: PathLike, dest: PathLike): Promise<void> {
+    return NitroFileSystem.applyPatch(normalizePath(base), normalizePath(patch), normalizePath(dest));
+}
+
+// --- Content search ---
+
+/**
+ * Search the files under `rootOrPaths` for `pattern`, a literal string or, with
+ * `regex: true`, an ECMAScript regular expression matched line by line.
+ * Directories are walked recursively without following symlinks; files whose
+ * first 8 KiB contain a NUL byte are skipped as binary. Files are streamed on
+ * native worker threads and only the matching lines reach JS, one match per
+ * line, ordered by path. `truncated` is set when more than `maxResults`
+ * (default 1000) matches exist.
+ */
+export async function searchFiles(rootOrPaths: PathLike | PathLike[], pattern: string, options?: SearchOptions): Promise<SearchResult> {
+    const paths = Array.isArray(rootOrPaths) ? rootOrPaths : [rootOrPaths];
+    return NitroFileSystem.searchFiles(paths.map((p) => normalizePath(p)), pattern, options);
+}
+
+// --- Comparison ---
+
+/**
+ * Resolve to true if `a` and `b` have the same contents. Hard links to the
+ * same file and files of different sizes are decided from `stat` alone;
+ * otherwise both files are streamed natively and compared chunk by chunk,
+ * stopping at the first difference.
+ */
+export async function compareFiles(a: PathLike, b: PathLike): Promise<boolean> {
+    return NitroFileSystem.compareFiles(normalizePath(a), normalizePath(b));
+}
+
+/**
+ * Compare the trees under directories `a` and `b` in one native call. Paths in
+ * the result are relative to the roots and sorted: `added` exist only under `b`,
+ * `removed` only under `a` (including everything below an added or removed
+ * directory), and `changed` under both with a different type, size or, per
+ * `compare`, modification time (the default) or contents. Symlinks are not
+ * followed; with `compare: 'content'` their targets are compared.
+ */
+export async function diffTrees(a: PathLike, b: PathLike, options?: TreeDiffOptions): Promise<TreeDiffResult> {
+    return NitroFileSystem.diffTrees(normalizePath(a), normalizePath(b), options);
+}
+
+// --- Disk usage ---
+
+/**
+ * Total size of the tree under `path`, like `du`: apparent bytes (`size`),
+ * bytes allocated on disk (`allocated`, from `st_blocks`) and file/directory
+ * counts. Directories are read and stat'ed natively in parallel, level by
+ * level. A file with several hard links is counted once unless
+ * `countHardlinksOnce` is false. With `perChild`, `children` breaks the totals
+ * down per top-level entry, in name order. Unreadable entries are counted in
+ * `skipped` instead of failing the walk.
+ */
+export async function du(path: PathLike, options?: DiskUsageOptions): Promise<DiskUsageResult> {
+    return NitroFileSystem.du(normalizePath(path), options);
+}
+
+// --- Page cache hints ---
+
+/**
+ * Tell the kernel how a byte range will be used (`length` 0 = to the end):
+ * 'sequential' / 'random' tune read-ahead, 'willneed' starts reading it into
+ * the page cache, 'dontneed' drops it from the cache (e.g. after a large
+ * one-shot read). `target` is a file descriptor or a path; with a path only
+ * 'willneed', 'dontneed' and 'normal' are meaningful and the others throw.
+ * 'dontneed' is a no-op on iOS.
+ */
+export function advise(target: number | PathLike, offset: number, length: number, advice: FileAdviceType): void {
+    if (typeof target === 'number') {
+        NitroFileSystem.fadvise(target, offset, length, advice);
+    } else {
+        NitroFileSystem.advise(normalizePath(target), offset, length, advice);
+    }
+}
+
+/**
+ * Warm the page cache with whole files, e.g. the bundle and config files
+ * read at every launch, so later reads do not wait for the disk. Read-ahead
+ * is issued for all files in parallel on native threads; the promise
+ * resolves once it has been issued, not when the data is in memory.
+ */
+export async function prefetch(paths: PathLike[], options?: PrefetchOptions): Promise<PrefetchResult> {
+    return NitroFileSystem.prefetch(paths.map((p) => normalizePath(p)), options);
+}
+
+// --- Batched operations ---
+
+export interface BatchOperation {
+    op: BatchOpType;
+    path: PathLike;
+    /** Target of `rename` and `copyFile`. */
+    dest?: PathLike;
+    /** Contents for `writeFile`. */
+    data?: string | Buffer | Uint8Array;
+    encoding?: BufferEncoding;
+    /** Mode for `access`, permissions for `mkdir`/`chmod`, flags for `copyFile`. */
+    mode?: number;
+    /** For `mkdir` and `rm`. */
+    recursive?: boolean;
+}
+
+export interface BatchOperationResult {
+    ok: boolean;
+    /** Node-style error (with `code` and `errno`) when the operation failed. */
+    error?: Error;
+    stats?: Stats;
+    data?: Buffer;
+    entries?: string[];
+    exists?: boolean;
+}
+
+function toNativeBatchOps(ops: BatchOperation[]) {
+    return ops.map((op) => ({
+        op: op.op,
+        path: normalizePath(op.path),
+        dest: op.dest !== undefined ? normalizePath(op.dest) : undefined,
+        data: op.data !== undefined ? toArrayBuffer(op.data, op.encoding) : undefined,
+        mode: op.mode,
+        recursive: op.recursive,
+    }));
+}
+
+function fromNativeBatchResult(result: BatchResult): BatchOperationResult {
+    const out: BatchOperationResult = { ok: result.ok };
+    if (!result.ok) {
+        const error: any = new Error(result.message);
+        error.code = result.code;
+        error.errno = -result.errnum;
+        out.error = error;
+    }
+    if (result.stats) out.stats = new Stats(result.stats);
+    if (result.data) out.data = Buffer.from(result.data);
+    if (result.entries) out.entries = result.entries;
+    if (result.exists !== undefined) out.exists = result.exists;
+    return out;
+}
+
+/**
+ * Runs many fs operations in a single native call and returns one result per
+ * operation, in order. Failures don't throw; they are reported in the result.
+ * Operations run one after another unless `parallel` is set, in which case they
+ * must not depend on each other. With `stopOnError`, the operations after the
+ * first failure are skipped (ECANCELED).
+ */
+export function batchSync(ops: BatchOperation[], options?: BatchOptions): BatchOperationResult[] {
+    return NitroFileSystem.batch(toNativeBatchOps(ops), options).map(fromNativeBatchResult);
+}
+
+/**
+ * Like `batchSync`, but runs on a worker thread.
+ */
+export async function batch(ops: BatchOperation[], options?: BatchOptions): Promise<BatchOperationResult[]> {
+    const results = await NitroFileSystem.batchAsync(toNativeBatchOps(ops), options);
+    return results.map(fromNativeBatchResult);
+}
+
+// --- Bulk I/O ---
+
+/**
+ * stat (or lstat with `followSymlinks: false`) many paths in one native call.
+ * On Linux kernels that allow it the whole set goes through io_uring; elsewhere,
+ * including every Android build, it is spread over the native worker pool.
+ * Results are in input order.
+ */
+export async function statMany(paths: PathLike[], options?: StatManyOptions): Promise<BatchOperationResult[]> {
+    const results = await NitroFileSystem.statMany(paths.map((p) => normalizePath(p)), options);
+    return results.map(fromNativeBatchResult);
+}
+
+/**
+ * Read many whole files in one native call (io_uring or worker pool, like `statMany`).
+ */
+export async function readFileMany(paths: PathLike[]): Promise<BatchOperationResult[]> {
+    const results = await NitroFileSystem.readFileMany(paths.map((p) => normalizePath(p)));
+    return results.map(fromNativeBatchResult);
+}
+
+/**
+ * The engine used for bulk I/O: 'io_uring' or 'threadpool'.
+ */
+export function getIoEngine(): string {
+    return NitroFileSystem.ioEngine;
+}
+
+export interface ReadRangesResult {
+    // Holds every range; range i is buffer.subarray(offsets[i], offsets[i] + lengths[i])
+    buffer: Buffer;
+    offsets: number[];
+    // Bytes available per range; shorter than requested only past EOF
+    lengths: number[];
+    bytesRead: number;
+}
+
+function fromNativeReadRanges(result: NitroReadRangesResult, dest?: ArrayBuffer | ArrayBufferView | null): ReadRangesResult {
+    let buffer: Buffer;
+    if (dest == null) {
+        buffer = Buffer.from(result.buffer);
+    } else {
+        const view = dest instanceof ArrayBuffer ? new Uint8Array(dest) : new Uint8Array(dest.buffer, dest.byteOffset, dest.byteLength);
+        if (result.buffer !== view.buffer) {
+            if (result.buffer.byteLength > view.byteLength) {
+                throw new RangeError(`readRanges: destination buffer too small, ${result.buffer.byteLength} bytes needed`);
+            }
+            view.set(new Uint8Array(result.buffer));
+        }
+        buffer = Buffer.from(view.buffer as ArrayBuffer, view.byteOffset, view.byteLength);
+    }
+    return { buffer, offsets: result.offsets, lengths: result.lengths, bytesRead: result.bytesRead };
+}
+
+// Native code can fill `dest` in place only when it is a whole ArrayBuffer.
+function wholeArrayBuffer(dest?: ArrayBuffer | ArrayBufferView | null): ArrayBuffer | undefined {
+    if (dest == null) return undefined;
+    if (dest instanceof ArrayBuffer) return dest;
+    if (dest.byteOffset === 0 && dest.byteLength === dest.buffer.byteLength) return dest.buffer as ArrayBuffer;
+    return undefined;
+}
+
+/**
+ * Read many `{ position, length }` ranges of an open file in one native call.
+ * Overlapping and adjacent ranges (or ones at most `options.maxGap` bytes
+ * apart) are merged into a single read, and all reads are in flight at once
+ * (io_uring or worker pool). The bytes land in one buffer, `dest` if given;
+ * `offsets[i]` is where range i starts in it.
+ */
+export function readRangesSync(fd: number, ranges: ReadRange[], dest?: ArrayBuffer | ArrayBufferView | null, options?: ReadRangesOptions): ReadRangesResult {
+    return fromNativeReadRanges(NitroFileSystem.readRanges(fd, ranges, wholeArrayBuffer(dest), options), dest);
+}
+
+/**
+ * Async `readRangesSync`. The reads run off the JS thread into a native
+ * buffer, which is copied into `dest` when one is given.
+ */
+export async function readRanges(fd: number, ranges: ReadRange[], dest?: ArrayBuffer | ArrayBufferView | null, options?: ReadRangesOptions): Promise<ReadRangesResult> {
+    return fromNativeReadRanges(await NitroFileSystem.readRangesAsync(fd, ranges, options), dest);
+}
+
+// --- Buffer pool ---
+
+/**
+ * A Buffer of `size` bytes backed by a page-aligned native slab from the
+ * buffer pool. Its memory goes back to the pool when the Buffer is garbage
+ * collected. Contents are uninitialized, like `Buffer.allocUnsafe`.
+ */
+export function leaseBuffer(size: number): Buffer {
+    return Buffer.from(NitroFileSystem.leaseBuffer(size));
+}
+
+/**
+ * Free every cached slab. Runs automatically on system memory warnings.
+ */
+export function trimBufferPool(): void {
+    NitroFileSystem.trimBufferPool();
+}
+
+/**
+ * Cap the memory the pool keeps cached (default 32 MiB). 0 disables caching.
+ */
+export function setBufferPoolLimit(bytes: number): void {
+    NitroFileSystem.setBufferPoolLimit(bytes);
+}
+
+export function getBufferPoolStats(): BufferPoolStats {
+    return NitroFileSystem.getBufferPoolStats();
+}
+
+// --- Diagnostics ---
+
+/**
+ * Per-operation call/error/byte counters and latency percentiles for every native
+ * fs call since start-up or the last `resetMetrics()`. Only operations that were
+ * called are listed. Empty when the library is built with `NITRO_FS_METRICS=0`.
+ */
+export function getMetrics(): OpMetrics[] {
+    return NitroFileSystem.getMetrics();
+}
+
+/**
+ * Zero all operation metrics.
+ */
+export function resetMetrics(): void {
+    NitroFileSystem.resetMetrics();
+}
+
+/**
+ * Start recording a timeline of native fs calls (operation, thread, path, bytes,
+ * start and duration). Each thread keeps the most recent `eventsPerThread` events
+ * (default 8192). Starting again discards the previous recording.
+ */
+export function startTracing(options?: TraceOptions): void {
+    NitroFileSystem.startTracing(options);
+}
+
+/**
+ * Stop recording. Events recorded so far remain available to `dumpTrace()`.
+ */
+export function stopTracing(): void {
+    NitroFileSystem.stopTracing();
+}
+
+/**
+ * Write the recorded events to `path` as Chrome trace JSON, viewable in
+ * chrome://tracing or https://ui.perfetto.dev. Resolves to the number of events written.
+ */
+export async function dumpTrace(path: PathLike): Promise<number> {
+    return NitroFileSystem.dumpTrace(normalizePath(path));
+}
+
 // exports
 export * from './Dir';
 export * from './ReadStream';
 export * from './WriteStream';
 export * from './FSWatcher';
+export * from './LogWriter';
+export * from './FileTail';
+export * from './SpaceMonitor';
+export * from './ZipArchive';
+export * from './ChunkStore';
 
 import { ReadStream, ReadStreamOptions } from './ReadStream';
 import { WriteStream, WriteStreamOptions } from './WriteStream';
 import { Dir } from './Dir';
+import { LogWriter, LogWriterOptions } from './LogWriter';
+import { FileTail, TailOptions } from './FileTail';
+import { SpaceMonitor } from './SpaceMonitor';
+import { ZipArchive } from './ZipArchive';
+import { ChunkStore } from './ChunkStore';
 
 export function createReadStream(path: PathLike | Buffer, options?: string | ReadStreamOptions): ReadStream {
     if (typeof options === 'string') {
@@ -1559,6 +2180,47 @@ export function opendir(path: PathLike, options?: any | ((err: NodeJS.ErrnoExcep
     });
 }
 
+/**
+ * Open a native append-only log writer for `path`.
+ */
+export function createLogWriter(path: PathLike, options?: LogWriterOptions): LogWriter {
+    return new LogWriter(normalizePath(path), options);
+}
+
+/**
+ * Follow `path` as it grows, like `tail -F`: appended lines (or bytes with
+ * `encoding: 'buffer'`) are delivered in batches from a native thread driven
+ * by watcher events, without polling `stat`/`read` from JS timers.
+ * Truncation and rotation are detected from the file's inode and size.
+ */
+export function tail(path: PathLike, options?: TailOptions): FileTail {
+    return new FileTail(normalizePath(path), options);
+}
+
+/**
+ * Watch the free space of the volume holding `path`: a native thread checks
+ * it every `intervalMs` (default 30 s) and the monitor emits 'low' when the
+ * available bytes drop below `thresholdBytes` and 'ok' once they recover.
+ */
+export function monitorSpace(path: PathLike, thresholdBytes: number, options?: SpaceMonitorOptions): SpaceMonitor {
+    return new SpaceMonitor(normalizePath(path), thresholdBytes, options);
+}
+
+/**
+ * Open a zip archive for reading.
+ */
+export function openZip(path: PathLike): ZipArchive {
+    return new ZipArchive(normalizePath(path));
+}
+
+/**
+ * Open the deduplicating chunk store rooted at `root`. The directory is
+ * created on the first `storeFile`.
+ */
+export function openChunkStore(root: PathLike): ChunkStore {
+    return new ChunkStore(normalizePath(root));
+}
+
 import { FSWatcher, WatchEventType, WatchListener } from './FSWatcher';
 
 /**
@@ -1655,6 +2317,43 @@ export const promises = {
             });
         });
     },
+    writeFileAtomic: async (path: PathLike, data: string | Buffer | Uint8Array, options?: WriteFileAtomicOptions | BufferEncoding): Promise<void> => {
+        return new Promise((resolve, reject) => {
+            writeFileAtomic(path, data, options, (err) => {
+                if (err) reject(err);
+                else resolve();
+            });
+        });
+    },
+    writeFilesAtomic: async (entries: AtomicWriteEntry[], options?: { durability?: Durability }): Promise<void> => {
+        return new Promise((resolve, reject) => {
+            writeFilesAtomic(entries, options, (err) => {
+                if (err) reject(err);
+                else resolve();
+            });
+        });
+    },
+    readJSON,
+    writeJSON,
+    buildLineIndex,
+    readLines,
+    compressFile,
+    decompressFile,
+    tarCreate,
+    tarExtract,
+    fileSignature,
+    fileDelta,
+    applyPatch,
+    searchFiles,
+    compareFiles,
+    diffTrees,
+    du,
+    prefetch,
+    batch,
+    statMany,
+    readFileMany,
+    readRanges,
+    dumpTrace,
     unlink: async (path: PathLike): Promise<void> => {
         return new Promise((resolve, reject) => {
             unlink(path, (err) => {
@@ -1791,6 +2490,14 @@ export const promises = {
             });
         });
     },
+    fallocate: async (fd: number, offset: number, length: number, options?: FallocateOptions): Promise<void> => {
+        return new Promise((resolve, reject) => {
+            fallocate(fd, offset, length, options ?? {}, (err) => {
+                if (err) reject(err);
+                else resolve();
+            });
+        });
+    },
     fsync: async (fd: number): Promise<void> => {
         return new Promise((resolve, reject) => {
             fsync(fd, (err) => {
@@ -1864,6 +2571,14 @@ export const promises = {
             });
         });
     },
+    statfs: async (path: PathLike, options?: StatOptions): Promise<StatFs | BigIntStatFs> => {
+        return new Promise((resolve, reject) => {
+            statfs(path, options ?? {}, (err, stats) => {
+                if (err) reject(err);
+                else resolve(stats!);
+            });
+        });
+    },
     lchmod: async (path: PathLike, mode: number): Promise<void> => {
         return new Promise((resolve, reject) => {
             lchmod(path, mode, (err) => {
@@ -2138,10 +2853,16 @@ export default {
     fchownSync,
     fstat,
     fstatSync,
+    statfs,
+    statfsSync,
     fsync,
     fsyncSync,
     ftruncate,
     ftruncateSync,
+    fallocate,
+    fallocateSync,
+    seekData,
+    seekHole,
     futimes,
     futimesSync,
     lchmod,
@@ -2160,6 +2881,9 @@ export default {
     mkdtempSync,
     createReadStream,
     createWriteStream,
+    createLogWriter,
+    tail,
+    monitorSpace,
     open,
     openSync,
     opendir,
@@ -2197,6 +2921,59 @@ export default {
     writeFile,
     writeFileSync,
     writeSync,
+    // Atomic writes
+    writeFileAtomic,
+    writeFileAtomicSync,
+    writeFilesAtomic,
+    writeFilesAtomicSync,
+    // JSON files
+    readJSON,
+    writeJSON,
+    // Line index
+    buildLineIndex,
+    readLines,
+    // Compression
+    compressFile,
+    decompressFile,
+    // Archives
+    openZip,
+    tarCreate,
+    tarExtract,
+    // Delta sync
+    fileSignature,
+    fileDelta,
+    applyPatch,
+    // Chunk store
+    openChunkStore,
+    // Content search
+    searchFiles,
+    // Comparison
+    compareFiles,
+    diffTrees,
+    // Disk usage
+    du,
+    // Page cache hints
+    advise,
+    prefetch,
+    // Batched operations
+    batch,
+    batchSync,
+    statMany,
+    readFileMany,
+    readRanges,
+    readRangesSync,
+    getIoEngine,
+    // Buffer pool
+    leaseBuffer,
+    trimBufferPool,
+    setBufferPoolLimit,
+    getBufferPoolStats,
+    // Diagnostics
+    getMetrics,
+    resetMetrics,
+    startTracing,
+    stopTracing,
+    dumpTrace,
     // Vector I/O
     readv,
     readvSync,
@@ -2208,10 +2985,17 @@ export default {
     // Classes
     Stats,
     BigIntStats,
+    StatFs,
+    BigIntStatFs,
     Dirent,
     ReadStream,
     WriteStream,
     FSWatcher,
+    LogWriter,
+    FileTail,
+    SpaceMonitor,
+    ZipArchive,
+    ChunkStore,
     // Promisified
     promises,
     getBookmark,
@@ -1,4 +1,16 @@
 import { NitroModules } from 'react-native-nitro-modules'
 import type { HybridFileSystem } from './specs/HybridFileSystem.nitro'
+import type { HybridJsonDocument } from './specs/HybridJsonDocument.nitro'
 
 export const NitroFileSystem = NitroModules.createHybridObject<HybridFileSystem>('NitroNodeFileSystem')
+
+// Methods registered as raw JSI functions, which specs cannot describe.
+export interface JsonDocument extends HybridJsonDocument {
+    // Builds the parsed value on the JS thread; can be called once.
+    toValue(): unknown
+}
+
+export const NitroJson = NitroFileSystem as unknown as {
+    parseJSONFile(path: string): Promise<JsonDocument>
+    writeJSON(path: string, value: unknown, options?: { durability?: 'none' | 'data' | 'full' }): Promise<void>
+}
@@ -1,6 +1,11 @@
 import { HybridObject, NitroModules } from 'react-native-nitro-modules'
 import { HybridDirIterator } from './HybridDirIterator.nitro'
+import { HybridFileTail } from './HybridFileTail.nitro'
 import { HybridFileWatcher } from './HybridFileWatcher.nitro'
+import { HybridJsonDocument } from './HybridJsonDocument.nitro'
+import { HybridLogWriter } from './HybridLogWriter.nitro'
+import { HybridSpaceMonitor } from './HybridSpaceMonitor.nitro'
+import { HybridZipArchive } from './HybridZipArchive.nitro'
 
 export type PickerMode = 'open' | 'import'
 
@@ -41,12 +46,304 @@ export interface Stats {
     birthtimeMs: number;
 }
 
+// As in Node's fs.statfs; block counts are in units of bsize
+export interface StatFs {
+    type: number;
+    bsize: number;
+    blocks: number;
+    bfree: number;
+    bavail: number;
+    files: number;
+    ffree: number;
+}
+
+export interface SpaceMonitorOptions {
+    // how often the background thread checks (default 30000)
+    intervalMs?: number;
+}
+
 export interface PickedDirectory {
     path: string;
     uri: string;
     bookmark?: string;
 }
 
+export type Durability = 'none' | 'data' | 'full'
+
+export interface AtomicWriteOptions {
+    durability?: Durability;
+}
+
+export interface AtomicWriteEntry {
+    path: string;
+    data: ArrayBuffer;
+}
+
+export interface LogWriterOptions {
+    bufferSize?: number;
+    flushBytes?: number;
+    flushIntervalMs?: number;
+    maxFileSize?: number;
+    maxFiles?: number;
+}
+
+export interface TailOptions {
+    // start at the current end of the file (default true)
+    fromEnd?: boolean;
+    // deliver complete lines instead of raw bytes
+    lines?: boolean;
+    // fallback check interval when no watcher event arrives (default 1000)
+    pollIntervalMs?: number;
+    maxBatchBytes?: number;
+}
+
+export type TailReset = 'truncated' | 'rotated'
+
+export interface TailBatch {
+    // offset in the current file after this batch
+    offset: number;
+    // set on the first batch after the file was truncated or replaced
+    reset?: TailReset;
+    data?: ArrayBuffer;
+    lines?: string[];
+}
+
+export type CompressionFormat = 'gzip' | 'deflate' | 'zstd'
+
+export interface CompressOptions {
+    format?: CompressionFormat;
+    level?: number;
+}
+
+export interface OpMetrics {
+    op: string;
+    calls: number;
+    errors: number;
+    bytes: number;
+    totalMs: number;
+    meanMs: number;
+    maxMs: number;
+    p50Ms: number;
+    p90Ms: number;
+    p99Ms: number;
+    p999Ms: number;
+}
+
+export interface TraceOptions {
+    eventsPerThread?: number;
+}
+
+export type BatchOpType = 'stat' | 'lstat' | 'exists' | 'access' | 'mkdir' | 'readFile' | 'writeFile' | 'readdir' | 'unlink' | 'rmdir' | 'rm' | 'rename' | 'copyFile' | 'chmod'
+
+export interface BatchOp {
+    op: BatchOpType;
+    path: string;
+    // rename / copyFile target
+    dest?: string;
+    // writeFile contents
+    data?: ArrayBuffer;
+    // access mode, mkdir/chmod permissions, copyFile flags
+    mode?: number;
+    // mkdir / rm
+    recursive?: boolean;
+}
+
+export interface BatchOptions {
+    parallel?: boolean;
+    parallelism?: number;
+    stopOnError?: boolean;
+}
+
+export interface BatchResult {
+    ok: boolean;
+    // errno value, 0 on success
+    errnum: number;
+    code?: string;
+    message?: string;
+    stats?: Stats;
+    data?: ArrayBuffer;
+    entries?: string[];
+    exists?: boolean;
+}
+
+export interface StatManyOptions {
+    followSymlinks?: boolean;
+}
+
+export interface ReadRange {
+    position: number;
+    length: number;
+}
+
+export interface ReadRangesOptions {
+    // Also merge ranges separated by at most this many bytes (read and kept)
+    maxGap?: number;
+}
+
+export interface ReadRangesResult {
+    buffer: ArrayBuffer;
+    // start of each range in buffer
+    offsets: number[];
+    // bytes available per range; short past EOF
+    lengths: number[];
+    bytesRead: number;
+}
+
+export interface BufferPoolStats {
+    hits: number;
+    misses: number;
+    trims: number;
+    cachedBytes: number;
+    leasedBytes: number;
+    activeLeases: number;
+    limitBytes: number;
+}
+
+export interface DeltaStats {
+    targetSize: number;
+    // bytes referenced from the base
+    copiedBytes: number;
+    // bytes carried in the patch
+    literalBytes: number;
+    patchSize: number;
+}
+
+export interface ChunkStoreOptions {
+    durability?: Durability;
+    averageChunkSize?: number;
+    parallelism?: number;
+}
+
+export interface StoreFileResult {
+    size: number;
+    chunks: number;
+    newChunks: number;
+    // bytes of the new chunks
+    writtenBytes: number;
+}
+
+export interface ChunkStoreGcResult {
+    files: number;
+    liveChunks: number;
+    removedChunks: number;
+    freedBytes: number;
+}
+
+export interface SearchOptions {
+    // ECMAScript regular expression instead of a literal string
+    regex?: boolean;
+    caseInsensitive?: boolean;
+    maxResults?: number;
+    parallelism?: number;
+}
+
+export interface SearchMatch {
+    path: string;
+    // byte offset of the match in the file
+    offset: number;
+    // 1-based
+    line: number;
+    // byte offset of the match in the line
+    column: number;
+    text: string;
+}
+
+export interface SearchResult {
+    matches: SearchMatch[];
+    filesSearched: number;
+    // binary or unreadable files
+    filesSkipped: number;
+    truncated: boolean;
+}
+
+// 'mtime' compares size and modification time, 'content' the bytes of
+// same-sized files
+export type TreeCompareMode = 'mtime' | 'size' | 'content'
+
+export interface TreeDiffOptions {
+    compare?: TreeCompareMode;
+    parallelism?: number;
+}
+
+export interface TreeDiffResult {
+    // paths relative to the roots: only in the second tree
+    added: string[];
+    // only in the first tree
+    removed: string[];
+    changed: string[];
+}
+
+export interface LineIndexOptions {
+    // lines between stored offsets (default 256)
+    stride?: number;
+    // sidecar file the index is loaded from and saved to
+    indexPath?: string;
+}
+
+export interface LineIndexResult {
+    lines: number;
+    // bytes indexed
+    size: number;
+    checkpoints: number;
+    // bytes read by this call; only the new tail when the file grew
+    scannedBytes: number;
+}
+
+export interface DiskUsageOptions {
+    followSymlinks?: boolean;
+    // count a file reached through several hard links once (default true)
+    countHardlinksOnce?: boolean;
+    // also report totals per top-level entry
+    perChild?: boolean;
+    parallelism?: number;
+}
+
+export interface DiskUsageChild {
+    name: string;
+    size: number;
+    allocated: number;
+    files: number;
+    dirs: number;
+}
+
+export interface DiskUsageResult {
+    // apparent bytes of everything but directories
+    size: number;
+    // st_blocks * 512 of every entry, directories included
+    allocated: number;
+    files: number;
+    dirs: number;
+    // entries that could not be read
+    skipped: number;
+    children?: DiskUsageChild[];
+}
+
+export type FileAdviceType = 'normal' | 'sequential' | 'random' | 'willneed' | 'dontneed'
+
+export interface PrefetchOptions {
+    // threads reading ahead (default: worker pool size)
+    parallelism?: number;
+}
+
+export interface PrefetchResult {
+    files: number;
+    bytes: number;
+    // paths that could not be opened or are not regular files
+    failed: number;
+}
+
+export interface FallocateOptions {
+    // reserve blocks without changing the file size
+    keepSize?: boolean;
+    // deallocate the range instead (implies keepSize)
+    punchHole?: boolean;
+}
+
+export interface TarCreateOptions {
+    compress?: boolean;
+    level?: number;
+}
+
 export interface HybridFileSystem extends HybridObject<{ ios: 'c++', android: 'c++' }> {
     // Core FS operations
     open(path: string, flags: number, mode: number): number;
@@ -58,6 +355,10 @@ export interface HybridFileSystem extends HybridObject<{ ios: 'c++', android: 'c
     truncate(path: string, len: number): void;
     ftruncate(fd: number, len: number): void;
     fsync(fd: number): void;
+    fallocate(fd: number, offset: number, length: number, options?: FallocateOptions): void;
+    // -1 when no data follows / offset is past the end
+    seekData(fd: number, offset: number): number;
+    seekHole(fd: number, offset: number): number;
 
     // Permissions & Timestamps
     chmod(path: string, mode: number): void;
@@ -83,11 +384,16 @@ export interface HybridFileSystem extends HybridObject<{ ios: 'c++', android: 'c
     // Modern/Advanced
     opendir(path: string): HybridDirIterator;
     watch(path: string, onChange: (event: string, path: string) => void): HybridFileWatcher;
+    createLogWriter(path: string, options?: LogWriterOptions): HybridLogWriter;
+    tail(path: string, onBatch: (batch: TailBatch) => void, options?: TailOptions): HybridFileTail;
+    openZip(path: string): HybridZipArchive;
 
     // Advanced FS operations
     stat(path: string): Stats;
     lstat(path: string): Stats;
     fstat(fd: number): Stats;
+    statfs(path: string): StatFs;
+    monitorSpace(path: string, thresholdBytes: number, onChange: (low: boolean, stats: StatFs) => void, options?: SpaceMonitorOptions): HybridSpaceMonitor;
 
     mkdir(path: string, mode: number, recursive: boolean): void;
     rmdir(path: string): void;
@@ -96,19 +402,90 @@ export interface HybridFileSystem extends HybridObject<{ ios: 'c++', android: 'c
     unlink(path: string): void;
     rename(oldPath: string, newPath: string): void;
     copyFile(src: string, dest: string, flags: number): void;
-    cp(src: string, dest: string, recursive: boolean, force: boolean, dereference: boolean, errorOnExist: boolean, preserveTimestamps: boolean): void;
+    cp(src: string, dest: string, recursive: boolean, force: boolean, dereference: boolean, errorOnExist: boolean, preserveTimestamps: boolean, mode: number): void;
 
     readFile(path: string): ArrayBuffer;
     writeFile(path: string, buffer: ArrayBuffer): void;
 
+    // Atomic writes (temp file + fsync + rename)
+    writeFileAtomic(path: string, buffer: ArrayBuffer, options?: AtomicWriteOptions): void;
+    writeFilesAtomic(entries: AtomicWriteEntry[], options?: AtomicWriteOptions): void;
+
+    // Compression (streamed on a worker thread)
+    compressFile(src: string, dest: string, options?: CompressOptions): Promise<void>;
+    decompressFile(src: string, dest: string): Promise<void>;
+
+    // Tar archives (streamed on worker threads)
+    tarCreate(srcDir: string, destFile: string, options?: TarCreateOptions): Promise<void>;
+    tarExtract(srcFile: string, destDir: string): Promise<void>;
+
+    // Delta sync (rsync-style signatures and patches, streamed on worker threads)
+    fileSignature(path: string, blockSize?: number): Promise<ArrayBuffer>;
+    fileDelta(path: string, signature: ArrayBuffer, patchPath: string): Promise<DeltaStats>;
+    applyPatch(basePath: string, patchPath: string, destPath: string): Promise<void>;
+
+    // Chunk store (content-defined chunks, deduplicated by SHA-256)
+    storeFile(root: string, path: string, name: string, options?: ChunkStoreOptions): Promise<StoreFileResult>;
+    restoreFile(root: string, name: string, dest: string): Promise<void>;
+    removeStoredFile(root: string, name: string): Promise<boolean>;
+    listStoredFiles(root: string): Promise<string[]>;
+    gcChunkStore(root: string): Promise<ChunkStoreGcResult>;
+
+    // Content search (files streamed on worker threads)
+    searchFiles(paths: string[], pattern: string, options?: SearchOptions): Promise<SearchResult>;
+
+    // Comparison (streamed on worker threads)
+    compareFiles(a: string, b: string): Promise<boolean>;
+    diffTrees(a: string, b: string, options?: TreeDiffOptions): Promise<TreeDiffResult>;
+
+    // JSON files (parsed on a worker thread; writeJSON is a raw JSI method,
+    // see native.ts)
+    parseJSONFile(path: string): Promise<HybridJsonDocument>;
+
+    // Line index (sparse offsets, cached in memory or a sidecar file)
+    buildLineIndex(path: string, options?: LineIndexOptions): Promise<LineIndexResult>;
+    readLines(path: string, startLine: number, count: number, options?: LineIndexOptions): Promise<string[]>;
+
+    // Disk usage (parallel tree walk)
+    du(path: string, options?: DiskUsageOptions): Promise<DiskUsageResult>;
+
+    // Page cache hints (length 0 = to the end of the file)
+    advise(path: string, offset: number, length: number, advice: FileAdviceType): void;
+    fadvise(fd: number, offset: number, length: number, advice: FileAdviceType): void;
+    prefetch(paths: string[], options?: PrefetchOptions): Promise<PrefetchResult>;
+
+    // Batched operations (one call for many ops)
+    batch(ops: BatchOp[], options?: BatchOptions): BatchResult[];
+    batchAsync(ops: BatchOp[], options?: BatchOptions): Promise<BatchResult[]>;
+
+    // Bulk I/O (io_uring where available, worker pool otherwise)
+    statMany(paths: string[], options?: StatManyOptions): Promise<BatchResult[]>;
+    readFileMany(paths: string[]): Promise<BatchResult[]>;
+    readRanges(fd: number, ranges: ReadRange[], dest?: ArrayBuffer, options?: ReadRangesOptions): ReadRangesResult;
+    readRangesAsync(fd: number, ranges: ReadRange[], options?: ReadRangesOptions): Promise<ReadRangesResult>;
+    readonly ioEngine: string;
+
+    // Buffer pool (page-aligned slabs reused by native reads)
+    leaseBuffer(size: number): ArrayBuffer;
+    trimBufferPool(): void;
+    setBufferPoolLimit(bytes: number): void;
+    getBufferPoolStats(): BufferPoolStats;
+
+    // Diagnostics
+    getMetrics(): OpMetrics[];
+    resetMetrics(): void;
+    startTracing(options?: TraceOptions): void;
+    stopTracing(): void;
+    dumpTrace(path: string): Promise<number>;
+
     // Persistence
     getBookmark(path: string): string;
     resolveBookmark(bookmark: string): string;
     getTempPath(): string;
 
-    // Vector I/O
-    readv(fd: number, buffers: ArrayBuffer[], position: number): number;
-    writev(fd: number, buffers: ArrayBuffer[], position: number): number;
+    // Vector I/O: iovec i is buffers[i][offsets[i], offsets[i] + lengths[i])
+    readv(fd: number, buffers: ArrayBuffer[], offsets: number[], lengths: number[], position: number): number;
+    writev(fd: number, buffers: ArrayBuffer[], offsets: number[], lengths: number[], position: number): number;
 
     // Picker API
     pickFiles(options: FilePickerOptions): Promise<PickedFile[]>;
@@ -0,0 +1,11 @@
+import { HybridObject } from 'react-native-nitro-modules'
+
+/**
+ * A file followed by a native background thread; batches are delivered to
+ * the `onBatch` callback passed to `tail()`.
+ */
+export interface HybridFileTail extends HybridObject<{ ios: 'c++', android: 'c++' }> {
+    // offset in the current file up to which bytes have been read
+    readonly offset: number;
+    close(): void;
+}
@@ -0,0 +1,11 @@
+import { HybridObject } from 'react-native-nitro-modules'
+
+/**
+ * A JSON file parsed natively, not yet turned into JS values. `toValue()`
+ * is registered as a raw JSI method (it returns an arbitrary JS value, which
+ * specs cannot express); see `JsonDocument` in native.ts.
+ */
+export interface HybridJsonDocument extends HybridObject<{ ios: 'c++', android: 'c++' }> {
+    // size of the parsed file
+    readonly byteLength: number;
+}
@@ -0,0 +1,8 @@
+import { HybridObject } from 'react-native-nitro-modules'
+
+export interface HybridLogWriter extends HybridObject<{ ios: 'c++', android: 'c++' }> {
+    append(data: string): void;
+    appendBuffer(buffer: ArrayBuffer): void;
+    flush(): Promise<void>;
+    close(): Promise<void>;
+}
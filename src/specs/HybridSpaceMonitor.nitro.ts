@@ -0,0 +1,13 @@
+import { HybridObject } from 'react-native-nitro-modules'
+import type { StatFs } from './HybridFileSystem.nitro'
+
+/**
+ * Free-space watch on one volume, evaluated by a native background thread;
+ * transitions are delivered to the callback passed to `monitorSpace()`.
+ */
+export interface HybridSpaceMonitor extends HybridObject<{ ios: 'c++', android: 'c++' }> {
+    readonly low: boolean;
+    // evaluate now (a transition also fires the callback)
+    check(): StatFs;
+    close(): void;
+}
@@ -0,0 +1,27 @@
+import { HybridObject } from 'react-native-nitro-modules'
+
+export interface ZipEntry {
+    name: string;
+    size: number;
+    compressedSize: number;
+    isDirectory: boolean;
+    crc32: number;
+    mtimeMs: number;
+}
+
+export interface ZipExtractOptions {
+    parallelism?: number;
+}
+
+export interface HybridZipArchive extends HybridObject<{ ios: 'c++', android: 'c++' }> {
+    readonly path: string;
+    readonly entryCount: number;
+    entries(): ZipEntry[];
+    getEntry(name: string): ZipEntry | undefined;
+    has(name: string): boolean;
+    read(name: string): ArrayBuffer;
+    readAsync(name: string): Promise<ArrayBuffer>;
+    extract(name: string, dest: string): Promise<void>;
+    extractAll(dest: string, options?: ZipExtractOptions): Promise<void>;
+    close(): void;
+}